@@ -246,8 +246,8 @@ public:
 
 		// Last 10 log lines
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = log::history();
-		for (auto a = log.size() - 10; a < log.size(); a++)
+		auto log = log::history();
+		for (auto a = log.size() - std::min<size_t>(log.size(), 10); a < log.size(); a++)
 			trace_ += log[a].message + "\n";
 
 		// Add stack trace text area
@@ -977,14 +977,13 @@ bool Configuration::openConfig(const string& game, const string& port, MapFormat
 // -----------------------------------------------------------------------------
 const ActionSpecial& Configuration::actionSpecial(unsigned id)
 {
-	auto& as = action_specials_[id];
-
 	// Defined Action Special
-	if (as.defined())
-		return as;
+	auto i = action_specials_.find(id);
+	if (i != action_specials_.end() && i->second.defined())
+		return i->second;
 
 	// Boom Generalised Special
-	if (supported_features_[Feature::Boom] && id >= 0x2f80)
+	if (featureSupported(Feature::Boom) && id >= 0x2f80)
 	{
 		if ((id & 7) >= 6)
 			return ActionSpecial::generalManual();
@@ -1007,9 +1006,10 @@ string Configuration::actionSpecialName(int special)
 	else if (special == 0)
 		return "None";
 
-	if (action_specials_[special].defined())
-		return action_specials_[special].name();
-	else if (special >= 0x2F80 && supported_features_[Feature::Boom])
+	auto i = action_specials_.find(special);
+	if (i != action_specials_.end() && i->second.defined())
+		return i->second.name();
+	else if (special >= 0x2F80 && featureSupported(Feature::Boom))
 		return genlinespecial::parseLineType(special);
 	else
 		return "Unknown";
@@ -1020,9 +1020,9 @@ string Configuration::actionSpecialName(int special)
 // -----------------------------------------------------------------------------
 const ThingType& Configuration::thingType(unsigned type)
 {
-	auto& ttype = thing_types_[type];
-	if (ttype.defined())
-		return ttype;
+	auto i = thing_types_.find(type);
+	if (i != thing_types_.end() && i->second.defined())
+		return i->second;
 	else
 		return ThingType::unknown();
 }
@@ -1119,7 +1119,7 @@ bool Configuration::thingBasicFlagSet(string_view flag, MapThing* thing, MapForm
 		if (hexen)
 			return thing->flagSet(512);
 		// *Not* Not In Coop
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 			return !thing->flagSet(64);
 		else
 			return true;
@@ -1130,7 +1130,7 @@ bool Configuration::thingBasicFlagSet(string_view flag, MapThing* thing, MapForm
 		if (hexen)
 			return thing->flagSet(1024);
 		// *Not* Not In DM
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 			return !thing->flagSet(32);
 		else
 			return true;
@@ -1282,7 +1282,7 @@ void Configuration::setThingBasicFlag(string_view flag, MapThing* thing, MapForm
 		if (hexen)
 			flag_val = 512;
 		// *Not* Not In Coop
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 		{
 			flag_val = 64;
 			set      = !set;
@@ -1297,7 +1297,7 @@ void Configuration::setThingBasicFlag(string_view flag, MapThing* thing, MapForm
 		if (hexen)
 			flag_val = 1024;
 		// *Not* Not In DM
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 		{
 			flag_val = 32;
 			set      = !set;
@@ -1733,24 +1733,32 @@ const string& Configuration::spacTriggerUDMFName(unsigned trigger_index)
 }
 
 // -----------------------------------------------------------------------------
-// Returns the UDMF property definition matching [name] for MapObject [type]
+// Returns the UDMF property definition matching [name] for MapObject [type],
+// or nullptr if it isn't defined
 // -----------------------------------------------------------------------------
 UDMFProperty* Configuration::getUDMFProperty(const string& name, MapObject::Type type)
 {
 	using Type = MapObject::Type;
 
+	// Get properties for type
+	UDMFPropMap* props;
 	if (type == Type::Vertex)
-		return &udmf_vertex_props_[name];
+		props = &udmf_vertex_props_;
 	else if (type == Type::Line)
-		return &udmf_linedef_props_[name];
+		props = &udmf_linedef_props_;
 	else if (type == Type::Side)
-		return &udmf_sidedef_props_[name];
+		props = &udmf_sidedef_props_;
 	else if (type == Type::Sector)
-		return &udmf_sector_props_[name];
+		props = &udmf_sector_props_;
 	else if (type == Type::Thing)
-		return &udmf_thing_props_[name];
+		props = &udmf_thing_props_;
 	else
 		return nullptr;
+
+	// Look up property (without adding it, since this can be called from
+	// several threads at once, eg. when running map checks)
+	auto i = props->find(name);
+	return i != props->end() ? &i->second : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -1881,7 +1889,8 @@ string Configuration::sectorTypeName(int type)
 	}
 
 	// Get base type name
-	auto name = sector_types_[type];
+	auto   i    = sector_types_.find(type);
+	string name = i != sector_types_.end() ? i->second : "";
 	if (name.empty())
 		name = "Unknown";
 
@@ -94,8 +94,16 @@ namespace game
 		const std::map<int, string>&        allSectorTypes() const { return sector_types_; }
 
 		// Feature Support
-		bool featureSupported(Feature feature) { return supported_features_[feature]; }
-		bool featureSupported(UDMFFeature feature) { return udmf_features_[feature]; }
+		bool featureSupported(Feature feature) const
+		{
+			auto i = supported_features_.find(feature);
+			return i != supported_features_.end() && i->second;
+		}
+		bool featureSupported(UDMFFeature feature) const
+		{
+			auto i = udmf_features_.find(feature);
+			return i != udmf_features_.end() && i->second;
+		}
 
 		// Configuration reading
 		void readActionSpecials(
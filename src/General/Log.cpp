@@ -34,6 +34,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fstream>
+#include <mutex>
 
 using namespace slade;
 
@@ -47,6 +48,7 @@ namespace slade::log
 {
 vector<Message> log;
 std::ofstream   log_file;
+std::mutex      log_mutex; // Messages can be logged from any thread
 } // namespace slade::log
 CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
 
@@ -75,6 +77,32 @@ template<> struct formatter<log::MessageType>
 } // namespace fmt
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Adds a message [text] of [type] to the log history (and log file).
+// The log mutex is held throughout, which also protects the (non-reentrant)
+// std::localtime call
+// -----------------------------------------------------------------------------
+void addMessage(log::MessageType type, string_view text)
+{
+	std::lock_guard lock(log::log_mutex);
+
+	auto t = std::time(nullptr);
+	log::log.emplace_back(text, type, *std::localtime(&t));
+
+	// Write to log file
+	if (log::log_file.is_open() && type != log::MessageType::Console)
+		sf::err() << log::log.back().formattedMessageLine() << "\n";
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // FreeImage Error Handler
@@ -158,11 +186,16 @@ void log::init()
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Returns a copy of the log message history, starting from message [from]
 // -----------------------------------------------------------------------------
-const vector<log::Message>& log::history()
+vector<log::Message> log::history(size_t from)
 {
-	return log;
+	std::lock_guard lock(log_mutex);
+
+	if (from >= log.size())
+		return {};
+
+	return { log.begin() + from, log.end() };
 }
 
 // -----------------------------------------------------------------------------
@@ -187,13 +220,7 @@ void log::setVerbosity(int verbosity)
 // -----------------------------------------------------------------------------
 void log::message(MessageType type, string_view text)
 {
-	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console)
-		sf::err() << log.back().formattedMessageLine() << "\n";
+	addMessage(type, text);
 }
 
 void log::message(MessageType type, int level, string_view text, fmt::format_args args)
@@ -209,12 +236,14 @@ void log::message(MessageType type, string_view text, fmt::format_args args)
 // -----------------------------------------------------------------------------
 // Returns a list of log messages of [type] that have been recorded since [time]
 // -----------------------------------------------------------------------------
-vector<log::Message*> log::since(time_t time, MessageType type)
+vector<log::Message> log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
+	std::lock_guard lock(log_mutex);
+
+	vector<Message> list;
 	for (auto& msg : log)
 		if (mktime(&msg.timestamp) >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -256,11 +285,5 @@ void log::message(MessageType type, int level, string_view text)
 	if (level > log_verbosity)
 		return;
 
-	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console)
-		sf::err() << log.back().formattedMessageLine() << "\n";
+	addMessage(type, text);
 }
@@ -31,6 +31,8 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "General/UndoRedo.h"
+#include "App.h"
+#include "Utility/FileUtils.h"
 
 using namespace slade;
 
@@ -43,7 +45,9 @@ using namespace slade;
 namespace
 {
 UndoManager* current_undo_manager = nullptr;
+unsigned     n_unloaded_files     = 0;
 } // namespace
+CVAR(Int, undo_memory_budget, 256, CVar::Flag::Save) // In MB, 0 = unlimited
 
 
 // -----------------------------------------------------------------------------
@@ -58,6 +62,16 @@ UndoManager* current_undo_manager = nullptr;
 // -----------------------------------------------------------------------------
 UndoLevel::UndoLevel(string_view name) : name_{ name }, timestamp_{ wxDateTime::Now() } {}
 
+// -----------------------------------------------------------------------------
+// UndoLevel class destructor
+// -----------------------------------------------------------------------------
+UndoLevel::~UndoLevel()
+{
+	// Clean up temp file if unloaded
+	if (!unloaded_file_.empty())
+		fileutil::removeFile(unloaded_file_);
+}
+
 // -----------------------------------------------------------------------------
 // Returns a string representation of the time at which the undo level was
 // recorded
@@ -78,6 +92,9 @@ string UndoLevel::timeStamp(bool date, bool time) const
 bool UndoLevel::doUndo()
 {
 	log::info(3, "Performing undo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (!reload())
+		return false;
+
 	bool ok = true;
 	for (int a = (int)undo_steps_.size() - 1; a >= 0; a--)
 	{
@@ -94,6 +111,9 @@ bool UndoLevel::doUndo()
 bool UndoLevel::doRedo()
 {
 	log::info(3, "Performing redo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (!reload())
+		return false;
+
 	bool ok = true;
 	for (auto& undo_step : undo_steps_)
 	{
@@ -105,10 +125,36 @@ bool UndoLevel::doRedo()
 }
 
 // -----------------------------------------------------------------------------
-// Reads the undo level from a file
+// Reads the undo level from a file (previously written by writeFile)
 // -----------------------------------------------------------------------------
 bool UndoLevel::readFile(string_view filename) const
 {
+	MemChunk mc;
+	if (!mc.importFile(filename))
+		return false;
+
+	// Check step count matches
+	uint32_t n_steps = 0;
+	mc.seekFromStart(0);
+	if (!mc.read(&n_steps, sizeof(uint32_t)) || n_steps != undo_steps_.size())
+	{
+		log::error("Undo level \"{}\": Invalid undo data in file {}", name_, filename);
+		return false;
+	}
+
+	// Read steps
+	for (auto& step : undo_steps_)
+	{
+		uint32_t size = 0;
+		if (!mc.read(&size, sizeof(uint32_t)) || mc.currentPos() + size > mc.size())
+			return false;
+
+		MemChunk step_mc(mc.data() + mc.currentPos(), size);
+		mc.seek(size);
+		if (!step->readFile(step_mc))
+			return false;
+	}
+
 	return true;
 }
 
@@ -117,7 +163,23 @@ bool UndoLevel::readFile(string_view filename) const
 // -----------------------------------------------------------------------------
 bool UndoLevel::writeFile(string_view filename) const
 {
-	return true;
+	MemChunk mc;
+	uint32_t n_steps = undo_steps_.size();
+	mc.write(&n_steps, sizeof(uint32_t));
+
+	for (auto& step : undo_steps_)
+	{
+		MemChunk step_mc;
+		if (!step->writeFile(step_mc))
+			return false;
+
+		uint32_t size = step_mc.size();
+		mc.write(&size, sizeof(uint32_t));
+		if (size > 0)
+			mc.write(step_mc.data(), size);
+	}
+
+	return mc.exportFile(filename);
 }
 
 // -----------------------------------------------------------------------------
@@ -127,6 +189,9 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 {
 	for (auto& level : levels)
 	{
+		if (!level->reload())
+			continue;
+
 		for (auto& undo_step : level->undo_steps_)
 		{
 			auto ptr = undo_step.release();
@@ -137,6 +202,64 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 }
 
 
+// -----------------------------------------------------------------------------
+// Returns the approximate amount of memory (in bytes) used by the undo level's
+// steps
+// -----------------------------------------------------------------------------
+size_t UndoLevel::memoryUsage() const
+{
+	size_t usage = 0;
+	for (auto& step : undo_steps_)
+		usage += step->memoryUsage();
+
+	return usage;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the undo level to [filename] and frees the memory used by its steps.
+// The level will be reloaded from the file the next time it is needed
+// -----------------------------------------------------------------------------
+bool UndoLevel::unloadTo(string_view filename)
+{
+	if (isUnloaded())
+		return true;
+
+	if (!writeFile(filename))
+	{
+		log::warning("Unable to write undo level \"{}\" to {}", name_, filename);
+		fileutil::removeFile(filename);
+		return false;
+	}
+
+	for (auto& step : undo_steps_)
+		step->unload();
+
+	unloaded_file_ = filename;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reloads the undo level's steps if it was previously unloaded (see unloadTo)
+// -----------------------------------------------------------------------------
+bool UndoLevel::reload()
+{
+	if (!isUnloaded())
+		return true;
+
+	if (!readFile(unloaded_file_))
+	{
+		log::error("Unable to reload undo level \"{}\" from {}", name_, unloaded_file_);
+		return false;
+	}
+
+	fileutil::removeFile(unloaded_file_);
+	unloaded_file_.clear();
+
+	return true;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // UndoManager Class Functions
@@ -198,6 +321,9 @@ void UndoManager::endRecord(bool success)
 	// Clear current undo manager
 	current_undo_manager = nullptr;
 
+	// Unload old levels if needed
+	enforceMemoryBudget();
+
 	signals_.level_recorded();
 }
 
@@ -338,9 +464,70 @@ bool UndoManager::createMergedLevel(UndoManager* manager, string_view name)
 	current_level_.reset(nullptr);
 	current_level_index_ = undo_levels_.size() - 1;
 
+	// Unload old levels if needed
+	enforceMemoryBudget();
+
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the approximate amount of memory (in bytes) used by all undo levels
+// currently in memory
+// -----------------------------------------------------------------------------
+size_t UndoManager::memoryUsage() const
+{
+	size_t usage = 0;
+	for (auto& level : undo_levels_)
+		usage += level->memoryUsage();
+
+	return usage;
+}
+
+// -----------------------------------------------------------------------------
+// Unloads undo levels to temp files until the memory used by all undo levels
+// is within the undo_memory_budget cvar. Levels furthest from the current
+// level are unloaded first, the current level and the next redo level are
+// always kept in memory
+// -----------------------------------------------------------------------------
+void UndoManager::enforceMemoryBudget()
+{
+	if (undo_memory_budget <= 0)
+		return;
+
+	uint64_t budget = static_cast<uint64_t>(undo_memory_budget) * 1024 * 1024;
+	uint64_t usage  = memoryUsage();
+	if (usage <= budget)
+		return;
+
+	// Determine unload order (oldest undo levels first, then newest redo levels)
+	vector<int> order;
+	for (int a = 0; a < current_level_index_; a++)
+		order.push_back(a);
+	for (int a = (int)undo_levels_.size() - 1; a > current_level_index_ + 1; a--)
+		order.push_back(a);
+
+	// Unload levels until we're within the budget
+	for (auto index : order)
+	{
+		auto& level = undo_levels_[index];
+		if (level->isUnloaded())
+			continue;
+
+		auto level_usage = level->memoryUsage();
+		if (level_usage == 0)
+			continue;
+
+		// Temp file name is unique to this process and undo manager
+		auto filename = fmt::format(
+			"undo_{}_{}_{}.dat", wxGetProcessId(), static_cast<const void*>(this), ++n_unloaded_files);
+		if (level->unloadTo(app::path(filename, app::Dir::Temp)))
+			usage -= std::min<uint64_t>(usage, level_usage);
+
+		if (usage <= budget)
+			break;
+	}
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -8,18 +8,20 @@ public:
 	UndoStep()          = default;
 	virtual ~UndoStep() = default;
 
-	virtual bool doUndo() { return true; }
-	virtual bool doRedo() { return true; }
-	virtual bool writeFile(MemChunk& mc) { return true; }
-	virtual bool readFile(MemChunk& mc) { return true; }
-	virtual bool isOk() { return true; }
+	virtual bool   doUndo() { return true; }
+	virtual bool   doRedo() { return true; }
+	virtual bool   writeFile(MemChunk& mc) { return true; }
+	virtual bool   readFile(MemChunk& mc) { return true; }
+	virtual bool   isOk() { return true; }
+	virtual size_t memoryUsage() const { return 0; }
+	virtual void   unload() {}
 };
 
 class UndoLevel
 {
 public:
 	UndoLevel(string_view name);
-	~UndoLevel() = default;
+	~UndoLevel();
 
 	string name() const { return name_; }
 	bool   doUndo();
@@ -31,10 +33,17 @@ public:
 	bool readFile(string_view filename) const;
 	void createMerged(vector<unique_ptr<UndoLevel>>& levels);
 
+	// Memory usage/spilling to disk
+	size_t memoryUsage() const;
+	bool   isUnloaded() const { return !unloaded_file_.empty(); }
+	bool   unloadTo(string_view filename);
+	bool   reload();
+
 private:
 	string                       name_;
 	vector<unique_ptr<UndoStep>> undo_steps_;
 	wxDateTime                   timestamp_;
+	string                       unloaded_file_;
 };
 
 class SLADEMap;
@@ -62,6 +71,8 @@ public:
 	void clear();
 	bool createMergedLevel(UndoManager* manager, string_view name);
 
+	size_t memoryUsage() const;
+
 	// Signals
 	struct Signals
 	{
@@ -79,6 +90,8 @@ private:
 	bool                          undo_running_        = false;
 	SLADEMap*                     map_                 = nullptr;
 	Signals                       signals_;
+
+	void enforceMemoryBudget();
 };
 
 namespace undoredo
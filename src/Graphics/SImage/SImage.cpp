@@ -1276,6 +1276,29 @@ bool SImage::setImageData(const vector<uint8_t>& ndata, int nwidth, int nheight,
 	return false;
 }
 
+// -----------------------------------------------------------------------------
+// Sets the image data, size, and type from raw [ndata], and the mask from
+// [nmask] if given (for paletted images only)
+// -----------------------------------------------------------------------------
+bool SImage::setImageData(const uint8_t* ndata, const uint8_t* nmask, int nwidth, int nheight, Type ntype)
+{
+	if (!ndata || nwidth <= 0 || nheight <= 0)
+		return false;
+
+	clearData();
+	type_   = ntype;
+	width_  = nwidth;
+	height_ = nheight;
+	data_.importMem(ndata, nwidth * nheight * bpp());
+	if (nmask && ntype == Type::PalMask)
+		mask_.importMem(nmask, nwidth * nheight);
+
+	// Announce change
+	signals_.image_changed();
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Applies a palette translation to the image
 // -----------------------------------------------------------------------------
@@ -97,6 +97,10 @@ public:
 	SIFormat* format() const { return format_; }
 	Info      info() const;
 
+	// Raw image data, in the format given by type()
+	const MemChunk& pixelData() const { return data_; }
+	const MemChunk& maskData() const { return mask_; }
+
 	void setXOffset(int offset);
 	void setYOffset(int offset);
 	void setPalette(Palette* pal)
@@ -148,6 +152,7 @@ public:
 	bool crop(long x1, long y1, long x2, long y2);
 	bool resize(int nwidth, int nheight);
 	bool setImageData(const vector<uint8_t>& ndata, int nwidth, int nheight, Type ntype);
+	bool setImageData(const uint8_t* ndata, const uint8_t* nmask, int nwidth, int nheight, Type ntype);
 	bool applyTranslation(Translation* tr, Palette* pal = nullptr, bool truecolor = false);
 	bool applyTranslation(string_view tr, Palette* pal = nullptr, bool truecolor = false);
 	bool drawPixel(int x, int y, ColRGBA colour, DrawProps& properties, Palette* pal);
@@ -819,6 +819,11 @@ void importEntryDataKeepType(ArchiveEntry* entry, const void* data, unsigned siz
 	entry->importMem(data, size);
 	entry->setType(type, type->reliability());
 }
+template<typename T> void importLumpKeepType(ArchiveEntry* entry, vector<T>& items)
+{
+	maplump::convertByteOrder(items);
+	importEntryDataKeepType(entry, items.data(), items.size() * sizeof(T));
+}
 size_t replaceThingsDoom(ArchiveEntry* entry, int oldtype, int newtype)
 {
 	if (entry == nullptr)
@@ -1552,16 +1557,12 @@ size_t replaceFlatsDoomHexen(
 	if (entry == nullptr)
 		return 0;
 
-	size_t size       = entry->size();
-	size_t numsectors = size / sizeof(DoomMapFormat::Sector);
+	auto   sectors = maplump::decode<DoomMapFormat::Sector>(entry);
 	bool   fchanged, cchanged;
 	size_t changed = 0;
 
-	auto sectors = new DoomMapFormat::Sector[numsectors];
-	memcpy(sectors, entry->rawData(), size);
-
 	// Perform replacement
-	for (size_t s = 0; s < numsectors; ++s)
+	for (size_t s = 0; s < sectors.size(); ++s)
 	{
 		fchanged = cchanged = false;
 		if (floor)
@@ -1573,8 +1574,7 @@ size_t replaceFlatsDoomHexen(
 	}
 	// Import the changes if needed
 	if (changed > 0)
-		importEntryDataKeepType(entry, sectors, size);
-	delete[] sectors;
+		importLumpKeepType(entry, sectors);
 
 	return changed;
 }
@@ -1589,18 +1589,12 @@ size_t replaceWallsDoomHexen(
 	if (entry == nullptr)
 		return 0;
 
-	size_t size     = entry->size();
-	size_t numsides = size / sizeof(DoomMapFormat::SideDef);
+	auto   sides = maplump::decode<DoomMapFormat::SideDef>(entry);
 	bool   lchanged, mchanged, uchanged;
 	size_t changed = 0;
 
-	DoomMapFormat::SideDef* sides = new DoomMapFormat::SideDef[numsides];
-	memcpy(sides, entry->rawData(), size);
-	char compare[9];
-	compare[8] = 0;
-
 	// Perform replacement
-	for (size_t s = 0; s < numsides; ++s)
+	for (size_t s = 0; s < sides.size(); ++s)
 	{
 		lchanged = mchanged = uchanged = false;
 		if (lower)
@@ -1614,8 +1608,7 @@ size_t replaceWallsDoomHexen(
 	}
 	// Import the changes if needed
 	if (changed > 0)
-		importEntryDataKeepType(entry, sides, size);
-	delete[] sides;
+		importLumpKeepType(entry, sides);
 
 	return changed;
 }
@@ -1624,19 +1617,15 @@ size_t replaceFlatsDoom64(ArchiveEntry* entry, const wxString& oldtex, const wxS
 	if (entry == nullptr)
 		return 0;
 
-	size_t size       = entry->size();
-	size_t numsectors = size / sizeof(Doom64MapFormat::Sector);
+	auto   sectors = maplump::decode<Doom64MapFormat::Sector>(entry);
 	bool   fchanged, cchanged;
 	size_t changed = 0;
 
 	uint16_t oldhash = app::resources().getTextureHash(oldtex.ToStdString());
 	uint16_t newhash = app::resources().getTextureHash(newtex.ToStdString());
 
-	auto sectors = new Doom64MapFormat::Sector[numsectors];
-	memcpy(sectors, entry->rawData(), size);
-
 	// Perform replacement
-	for (size_t s = 0; s < numsectors; ++s)
+	for (size_t s = 0; s < sectors.size(); ++s)
 	{
 		fchanged = cchanged = false;
 		if (floor && oldhash == sectors[s].f_tex)
@@ -1654,8 +1643,7 @@ size_t replaceFlatsDoom64(ArchiveEntry* entry, const wxString& oldtex, const wxS
 	}
 	// Import the changes if needed
 	if (changed > 0)
-		importEntryDataKeepType(entry, sectors, size);
-	delete[] sectors;
+		importLumpKeepType(entry, sectors);
 
 	return changed;
 }
@@ -1670,19 +1658,15 @@ size_t replaceWallsDoom64(
 	if (entry == nullptr)
 		return 0;
 
-	size_t size     = entry->size();
-	size_t numsides = size / sizeof(Doom64MapFormat::SideDef);
+	auto   sides = maplump::decode<Doom64MapFormat::SideDef>(entry);
 	bool   lchanged, mchanged, uchanged;
 	size_t changed = 0;
 
 	uint16_t oldhash = app::resources().getTextureHash(oldtex.ToStdString());
 	uint16_t newhash = app::resources().getTextureHash(newtex.ToStdString());
 
-	auto sides = new Doom64MapFormat::SideDef[numsides];
-	memcpy(sides, entry->rawData(), size);
-
 	// Perform replacement
-	for (size_t s = 0; s < numsides; ++s)
+	for (size_t s = 0; s < sides.size(); ++s)
 	{
 		lchanged = mchanged = uchanged = false;
 		if (lower && oldhash == sides[s].tex_lower)
@@ -1705,8 +1689,7 @@ size_t replaceWallsDoom64(
 	}
 	// Import the changes if needed
 	if (changed > 0)
-		importEntryDataKeepType(entry, sides, size);
-	delete[] sides;
+		importLumpKeepType(entry, sides);
 
 	return changed;
 }
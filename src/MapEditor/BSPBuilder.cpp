@@ -0,0 +1,1129 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    BSPBuilder.cpp
+// Description: BSPBuilder class - a built-in node builder that generates BSP
+//              (and GL) nodes, blockmap and reject data directly from a
+//              SLADEMap, without needing to run an external program.
+//              Partition selection is spread across multiple threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "BSPBuilder.h"
+#include "App.h"
+#include "Archive/Archive.h"
+#include "SLADEMap/SLADEMap.h"
+#include "Utility/MathStuff.h"
+#include <numeric>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr double   DIST_EPSILON    = 1. / 1024.;
+constexpr double   VERTEX_EPSILON  = 1. / 64.; // GL vertices closer than this are merged
+constexpr double   SPLIT_COST      = 8.;
+constexpr double   INVALID_SCORE   = std::numeric_limits<double>::max();
+constexpr unsigned MAX_CANDIDATES  = 256;
+constexpr unsigned FAST_CANDIDATES = 16;
+constexpr unsigned PARALLEL_MIN    = 1 << 16; // Min segs * candidates to split scoring across threads
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Appends [value] to [data] as raw (little-endian) bytes
+// -----------------------------------------------------------------------------
+template<typename T> void writeValue(vector<uint8_t>& data, T value)
+{
+	auto pos = data.size();
+	data.resize(pos + sizeof(T));
+	memcpy(data.data() + pos, &value, sizeof(T));
+}
+
+// -----------------------------------------------------------------------------
+// Returns [value] rounded to the nearest integer and clamped to the range of
+// int16_t
+// -----------------------------------------------------------------------------
+int16_t toInt16(double value)
+{
+	return static_cast<int16_t>(std::clamp(std::round(value), -32768., 32767.));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the key of the 1x1 grid cell at [x,y]
+// -----------------------------------------------------------------------------
+uint64_t gridKey(int64_t x, int64_t y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+// -----------------------------------------------------------------------------
+// Extends [bbox] to include [vertex]
+// -----------------------------------------------------------------------------
+void extendBounds(BSPBuilder::Bounds& bbox, const BSPBuilder::Vertex& vertex, bool first)
+{
+	if (first)
+	{
+		bbox.min_x = bbox.max_x = vertex.x;
+		bbox.min_y = bbox.max_y = vertex.y;
+		return;
+	}
+
+	bbox.min_x = std::min(bbox.min_x, vertex.x);
+	bbox.min_y = std::min(bbox.min_y, vertex.y);
+	bbox.max_x = std::max(bbox.max_x, vertex.x);
+	bbox.max_y = std::max(bbox.max_y, vertex.y);
+}
+
+// -----------------------------------------------------------------------------
+// Writes a Doom-format node to [data]
+// -----------------------------------------------------------------------------
+void writeNodeBase(vector<uint8_t>& data, const BSPBuilder::Node& node)
+{
+	// Scale the partition direction down if it doesn't fit in 16 bits
+	double dx    = node.dx;
+	double dy    = node.dy;
+	double scale = std::max(std::abs(dx), std::abs(dy)) / 32767.;
+	if (scale > 1.)
+	{
+		dx /= scale;
+		dy /= scale;
+	}
+
+	writeValue<int16_t>(data, toInt16(node.x));
+	writeValue<int16_t>(data, toInt16(node.y));
+	writeValue<int16_t>(data, toInt16(dx));
+	writeValue<int16_t>(data, toInt16(dy));
+	for (auto& bbox : node.bbox)
+	{
+		// Top, bottom, left, right
+		writeValue<int16_t>(data, toInt16(bbox.max_y));
+		writeValue<int16_t>(data, toInt16(bbox.min_y));
+		writeValue<int16_t>(data, toInt16(bbox.min_x));
+		writeValue<int16_t>(data, toInt16(bbox.max_x));
+	}
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// BSPBuilder Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// BSPBuilder class constructor
+// -----------------------------------------------------------------------------
+BSPBuilder::BSPBuilder(SLADEMap& map, const Options& options) : map_{ map }, options_{ options }
+{
+	if (options_.n_threads == 0)
+		options_.n_threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+// -----------------------------------------------------------------------------
+// BSPBuilder class destructor
+// -----------------------------------------------------------------------------
+BSPBuilder::~BSPBuilder()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	cv_work_.notify_all();
+
+	for (auto& thread : threads_)
+		thread.join();
+}
+
+// -----------------------------------------------------------------------------
+// Builds BSP nodes for the map, returns false if the map has no lines to
+// build from
+// -----------------------------------------------------------------------------
+bool BSPBuilder::build()
+{
+	auto start_time = app::runTimer();
+
+	vertices_.clear();
+	split_vertices_.clear();
+	segs_.clear();
+	subsectors_.clear();
+	nodes_.clear();
+	node_path_.clear();
+	ssector_clips_.clear();
+	gl_vertices_.clear();
+	gl_vertex_grid_.clear();
+	gl_segs_.clear();
+	gl_subsectors_.clear();
+
+	// Add map vertices
+	n_map_vertices_ = map_.nVertices();
+	for (unsigned a = 0; a < n_map_vertices_; a++)
+		vertices_.push_back({ map_.vertex(a)->xPos(), map_.vertex(a)->yPos() });
+
+	// Create initial segs from line sides
+	vector<BuildSeg> segs;
+	for (unsigned a = 0; a < map_.nLines(); a++)
+	{
+		auto line = map_.line(a);
+		auto v1   = static_cast<unsigned>(line->v1Index());
+		auto v2   = static_cast<unsigned>(line->v2Index());
+
+		// Ignore zero-length lines
+		if (vertices_[v1].x == vertices_[v2].x && vertices_[v1].y == vertices_[v2].y)
+			continue;
+
+		if (line->s1() && line->s1()->sector())
+			segs.push_back({ v1, v2, a, 0, 0. });
+		if (line->s2() && line->s2()->sector())
+			segs.push_back({ v2, v1, a, 1, 0. });
+	}
+
+	if (segs.empty())
+		return false;
+
+	// Build the tree
+	Bounds bbox;
+	buildNode(segs, bbox);
+
+	// Build GL subsectors from the tree
+	if (options_.gl)
+		buildGLNodes();
+
+	log::info(
+		2,
+		"Built nodes: {} nodes, {} subsectors, {} segs ({} GL segs), {} new vertices in {}ms",
+		nodes_.size(),
+		subsectors_.size(),
+		segs_.size(),
+		gl_segs_.size(),
+		vertices_.size() - n_map_vertices_,
+		app::runTimer() - start_time);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the built nodes exceed the limits of the vanilla Doom node
+// format and need to be written as ZDoom extended nodes
+// -----------------------------------------------------------------------------
+bool BSPBuilder::needsExtendedNodes() const
+{
+	return options_.extended || vertices_.size() > 65535 || segs_.size() > 65535 || subsectors_.size() > 32767
+		   || nodes_.size() > 32767;
+}
+
+// -----------------------------------------------------------------------------
+// Creates and returns Doom-format VERTEXES, SEGS, SSECTORS and NODES entries
+// from the built nodes (VERTEXES includes any vertices created by splits)
+// -----------------------------------------------------------------------------
+vector<unique_ptr<ArchiveEntry>> BSPBuilder::writeDoomNodes() const
+{
+	vector<unique_ptr<ArchiveEntry>> entries;
+	vector<uint8_t>                  data;
+
+	// VERTEXES
+	for (unsigned a = 0; a < vertices_.size(); a++)
+	{
+		// Map vertices are written the same way as DoomMapFormat::writeVERTEXES
+		if (a < n_map_vertices_)
+		{
+			writeValue<int16_t>(data, toInt16(std::trunc(vertices_[a].x)));
+			writeValue<int16_t>(data, toInt16(std::trunc(vertices_[a].y)));
+		}
+		else
+		{
+			writeValue<int16_t>(data, toInt16(vertices_[a].x));
+			writeValue<int16_t>(data, toInt16(vertices_[a].y));
+		}
+	}
+	entries.push_back(std::make_unique<ArchiveEntry>("VERTEXES"));
+	entries.back()->importMem(data.data(), data.size());
+
+	// SEGS
+	data.clear();
+	for (auto& seg : segs_)
+	{
+		auto   line  = map_.line(seg.line);
+		double angle = std::atan2(line->y2() - line->y1(), line->x2() - line->x1());
+		if (seg.side == 1)
+			angle += math::PI;
+
+		writeValue<uint16_t>(data, seg.v1);
+		writeValue<uint16_t>(data, seg.v2);
+		writeValue<uint16_t>(data, static_cast<uint16_t>(std::lround(angle * 32768. / math::PI) & 0xFFFF));
+		writeValue<uint16_t>(data, seg.line);
+		writeValue<int16_t>(data, seg.side);
+		writeValue<int16_t>(data, toInt16(seg.offset));
+	}
+	entries.push_back(std::make_unique<ArchiveEntry>("SEGS"));
+	entries.back()->importMem(data.data(), data.size());
+
+	// SSECTORS
+	data.clear();
+	for (auto& ssector : subsectors_)
+	{
+		writeValue<uint16_t>(data, ssector.n_segs);
+		writeValue<uint16_t>(data, ssector.first_seg);
+	}
+	entries.push_back(std::make_unique<ArchiveEntry>("SSECTORS"));
+	entries.back()->importMem(data.data(), data.size());
+
+	// NODES
+	data.clear();
+	for (auto& node : nodes_)
+	{
+		writeNodeBase(data, node);
+		for (auto child : node.child)
+			writeValue<uint16_t>(data, child & SUBSECTOR_FLAG ? (child & ~SUBSECTOR_FLAG) | 0x8000 : child);
+	}
+	entries.push_back(std::make_unique<ArchiveEntry>("NODES"));
+	entries.back()->importMem(data.data(), data.size());
+
+	return entries;
+}
+
+// -----------------------------------------------------------------------------
+// Creates and returns an entry named [name] containing the built nodes in
+// ZDoom extended (XNOD) format
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveEntry> BSPBuilder::writeExtendedNodes(string_view name) const
+{
+	vector<uint8_t> data;
+	data.insert(data.end(), { 'X', 'N', 'O', 'D' });
+
+	// Vertices (only new vertices are written, as 16.16 fixed point)
+	writeValue<uint32_t>(data, n_map_vertices_);
+	writeValue<uint32_t>(data, vertices_.size() - n_map_vertices_);
+	for (unsigned a = n_map_vertices_; a < vertices_.size(); a++)
+	{
+		writeValue<int32_t>(data, std::lround(vertices_[a].x * 65536.));
+		writeValue<int32_t>(data, std::lround(vertices_[a].y * 65536.));
+	}
+
+	// Subsectors
+	writeValue<uint32_t>(data, subsectors_.size());
+	for (auto& ssector : subsectors_)
+		writeValue<uint32_t>(data, ssector.n_segs);
+
+	// Segs
+	writeValue<uint32_t>(data, segs_.size());
+	for (auto& seg : segs_)
+	{
+		writeValue<uint32_t>(data, seg.v1);
+		writeValue<uint32_t>(data, seg.v2);
+		writeValue<uint16_t>(data, seg.line);
+		writeValue<uint8_t>(data, seg.side);
+	}
+
+	// Nodes
+	writeValue<uint32_t>(data, nodes_.size());
+	for (auto& node : nodes_)
+	{
+		writeNodeBase(data, node);
+		for (auto child : node.child)
+			writeValue<uint32_t>(data, child);
+	}
+
+	auto entry = std::make_unique<ArchiveEntry>(name);
+	entry->importMem(data.data(), data.size());
+	return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Creates and returns an entry named [name] containing the built GL nodes in
+// ZDoom extended GL (XGL2) format. build() must have been called with the gl
+// option enabled
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveEntry> BSPBuilder::writeExtendedGLNodes(string_view name) const
+{
+	vector<uint8_t> data;
+	data.insert(data.end(), { 'X', 'G', 'L', '2' });
+
+	// Vertices (only new vertices are written, as 16.16 fixed point)
+	writeValue<uint32_t>(data, n_map_vertices_);
+	writeValue<uint32_t>(data, gl_vertices_.size() - n_map_vertices_);
+	for (unsigned a = n_map_vertices_; a < gl_vertices_.size(); a++)
+	{
+		writeValue<int32_t>(data, std::lround(gl_vertices_[a].x * 65536.));
+		writeValue<int32_t>(data, std::lround(gl_vertices_[a].y * 65536.));
+	}
+
+	// Subsectors
+	writeValue<uint32_t>(data, gl_subsectors_.size());
+	for (auto& ssector : gl_subsectors_)
+		writeValue<uint32_t>(data, ssector.n_segs);
+
+	// Segs (the end vertex is the start of the next seg in the subsector)
+	writeValue<uint32_t>(data, gl_segs_.size());
+	for (auto& seg : gl_segs_)
+	{
+		writeValue<uint32_t>(data, seg.v1);
+		writeValue<uint32_t>(data, seg.partner);
+		writeValue<uint32_t>(data, seg.line);
+		writeValue<uint8_t>(data, seg.side);
+	}
+
+	// Nodes
+	writeValue<uint32_t>(data, nodes_.size());
+	for (auto& node : nodes_)
+	{
+		writeNodeBase(data, node);
+		for (auto child : node.child)
+			writeValue<uint32_t>(data, child);
+	}
+
+	auto entry = std::make_unique<ArchiveEntry>(name);
+	entry->importMem(data.data(), data.size());
+	return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Creates and returns a BLOCKMAP entry for the map.
+// If the blockmap is too large for the format, an empty entry is returned
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveEntry> BSPBuilder::writeBlockmap() const
+{
+	auto entry = std::make_unique<ArchiveEntry>("BLOCKMAP");
+	if (n_map_vertices_ == 0)
+		return entry;
+
+	// Determine origin and size (using vertex positions as written)
+	int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+	int max_x = std::numeric_limits<int>::min(), max_y = std::numeric_limits<int>::min();
+	for (unsigned a = 0; a < n_map_vertices_; a++)
+	{
+		min_x = std::min<int>(min_x, static_cast<int16_t>(vertices_[a].x));
+		min_y = std::min<int>(min_y, static_cast<int16_t>(vertices_[a].y));
+		max_x = std::max<int>(max_x, static_cast<int16_t>(vertices_[a].x));
+		max_y = std::max<int>(max_y, static_cast<int16_t>(vertices_[a].y));
+	}
+	int  org_x   = min_x - 8;
+	int  org_y   = min_y - 8;
+	int  columns = ((max_x - org_x) >> 7) + 1;
+	int  rows    = ((max_y - org_y) >> 7) + 1;
+	auto n_cells = static_cast<unsigned>(columns * rows);
+
+	// Determine which lines pass through each block
+	vector<vector<uint16_t>> blocks(n_cells);
+	for (unsigned a = 0; a < map_.nLines(); a++)
+	{
+		auto   line = map_.line(a);
+		double x1   = static_cast<int16_t>(vertices_[line->v1Index()].x) - org_x;
+		double y1   = static_cast<int16_t>(vertices_[line->v1Index()].y) - org_y;
+		double x2   = static_cast<int16_t>(vertices_[line->v2Index()].x) - org_x;
+		double y2   = static_cast<int16_t>(vertices_[line->v2Index()].y) - org_y;
+
+		// Go through each column the line passes through
+		int col_start = static_cast<int>(std::min(x1, x2)) >> 7;
+		int col_end   = static_cast<int>(std::max(x1, x2)) >> 7;
+		for (int col = col_start; col <= col_end; col++)
+		{
+			// Get the y range of the line within the column
+			double ly1 = y1, ly2 = y2;
+			if (x1 != x2)
+			{
+				double cx1 = std::max(std::min(x1, x2), col * 128.);
+				double cx2 = std::min(std::max(x1, x2), col * 128. + 128.);
+				ly1        = y1 + (y2 - y1) * (cx1 - x1) / (x2 - x1);
+				ly2        = y1 + (y2 - y1) * (cx2 - x1) / (x2 - x1);
+			}
+
+			int row_start = static_cast<int>(std::min(ly1, ly2)) >> 7;
+			int row_end   = static_cast<int>(std::max(ly1, ly2)) >> 7;
+			for (int row = std::max(row_start, 0); row <= std::min(row_end, rows - 1); row++)
+				blocks[row * columns + col].push_back(a);
+		}
+	}
+
+	// Build block lists, sharing offsets between identical lists
+	vector<uint16_t>                     lists;
+	vector<unsigned>                     offsets(n_cells);
+	std::map<vector<uint16_t>, unsigned> list_offsets;
+	unsigned                             header_size = 4 + n_cells;
+	for (unsigned a = 0; a < n_cells; a++)
+	{
+		auto existing = list_offsets.find(blocks[a]);
+		if (existing != list_offsets.end())
+		{
+			offsets[a] = existing->second;
+			continue;
+		}
+
+		offsets[a]              = header_size + lists.size();
+		list_offsets[blocks[a]] = offsets[a];
+		lists.push_back(0);
+		lists.insert(lists.end(), blocks[a].begin(), blocks[a].end());
+		lists.push_back(0xFFFF);
+	}
+
+	// Check size
+	if (header_size + lists.size() > 65535)
+	{
+		log::warning("Blockmap is too large for the map format, an empty BLOCKMAP was written");
+		return entry;
+	}
+
+	// Write
+	vector<uint8_t> data;
+	writeValue<int16_t>(data, org_x);
+	writeValue<int16_t>(data, org_y);
+	writeValue<int16_t>(data, columns);
+	writeValue<int16_t>(data, rows);
+	for (auto offset : offsets)
+		writeValue<uint16_t>(data, offset);
+	for (auto value : lists)
+		writeValue<uint16_t>(data, value);
+	entry->importMem(data.data(), data.size());
+
+	return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Creates and returns a REJECT entry for the map.
+// This is conservative - only pairs of sectors that aren't connected by any
+// path of two-sided lines (so can never see each other) are rejected. No
+// line-of-sight checks are done, so nothing that could be visible is rejected
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveEntry> BSPBuilder::writeReject() const
+{
+	auto n_sectors = map_.nSectors();
+
+	// Group sectors connected by two-sided lines
+	vector<unsigned> group(n_sectors);
+	std::iota(group.begin(), group.end(), 0);
+	auto groupOf = [&](unsigned sector) {
+		while (group[sector] != sector)
+			sector = group[sector] = group[group[sector]];
+		return sector;
+	};
+	for (unsigned a = 0; a < map_.nLines(); a++)
+	{
+		auto s1 = map_.line(a)->frontSector();
+		auto s2 = map_.line(a)->backSector();
+		if (s1 && s2)
+			group[groupOf(s1->index())] = groupOf(s2->index());
+	}
+	for (unsigned a = 0; a < n_sectors; a++)
+		group[a] = groupOf(a);
+
+	// Reject all pairs of sectors in different groups
+	vector<uint8_t> data((n_sectors * n_sectors + 7) / 8, 0);
+	for (unsigned a = 0; a < n_sectors; a++)
+		for (unsigned b = 0; b < n_sectors; b++)
+			if (group[a] != group[b])
+			{
+				auto bit = a * n_sectors + b;
+				data[bit / 8] |= 1 << (bit % 8);
+			}
+
+	auto entry = std::make_unique<ArchiveEntry>("REJECT");
+	entry->importMem(data.data(), data.size());
+	return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Adds the built node entries to the map with header [head] in [archive],
+// which should already contain the rest of the map data in [format].
+// Returns false if the required map entries were not found
+// -----------------------------------------------------------------------------
+bool BSPBuilder::addToArchive(Archive& archive, ArchiveEntry* head, MapFormat format) const
+{
+	// Find map entries following the header
+	auto findEntry = [&](string_view name) -> int
+	{
+		for (auto a = archive.entryIndex(head) + 1; a < static_cast<int>(archive.numEntries()); a++)
+			if (archive.entryAt(a)->upperName() == name)
+				return a;
+
+		return -1;
+	};
+
+	// UDMF: ZNODES (which must be GL nodes) before ENDMAP
+	if (format == MapFormat::UDMF)
+	{
+		auto index = findEntry("ENDMAP");
+		if (index < 0 || gl_subsectors_.empty())
+			return false;
+
+		archive.addEntry(writeExtendedGLNodes("ZNODES"), index);
+		return true;
+	}
+
+	auto i_vertexes = findEntry("VERTEXES");
+	auto i_sectors  = findEntry("SECTORS");
+	if (i_vertexes < 0 || i_sectors < 0 || i_sectors < i_vertexes)
+		return false;
+
+	// REJECT and BLOCKMAP follow SECTORS
+	archive.addEntry(writeBlockmap(), i_sectors + 1);
+	archive.addEntry(writeReject(), i_sectors + 1);
+
+	// SEGS, SSECTORS and NODES follow VERTEXES
+	if (needsExtendedNodes())
+	{
+		archive.addEntry(writeExtendedNodes("NODES"), i_vertexes + 1);
+		archive.addEntry(std::make_unique<ArchiveEntry>("SSECTORS"), i_vertexes + 1);
+		archive.addEntry(std::make_unique<ArchiveEntry>("SEGS"), i_vertexes + 1);
+	}
+	else
+	{
+		auto entries = writeDoomNodes();
+		archive.entryAt(i_vertexes)->importMem(entries[0]->rawData(), entries[0]->size());
+		for (unsigned a = 3; a > 0; a--)
+			archive.addEntry(std::move(entries[a]), i_vertexes + 1);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the partition line for [seg] (the full line of its parent linedef,
+// in the direction of the seg)
+// -----------------------------------------------------------------------------
+BSPBuilder::Partition BSPBuilder::partition(const BuildSeg& seg) const
+{
+	auto line = map_.line(seg.line);
+	auto v1   = vertices_[line->v1Index()];
+	auto v2   = vertices_[line->v2Index()];
+	if (seg.side == 1)
+		std::swap(v1, v2);
+
+	Partition part{ v1.x, v1.y, v2.x - v1.x, v2.y - v1.y, 0. };
+	part.length = std::sqrt(part.dx * part.dx + part.dy * part.dy);
+	return part;
+}
+
+// -----------------------------------------------------------------------------
+// Determines which side of [part] [seg] is on. [d1] and [d2] are set to the
+// distances of the seg's vertices from the partition line (positive = front)
+// -----------------------------------------------------------------------------
+BSPBuilder::Side BSPBuilder::classify(const BuildSeg& seg, const Partition& part, double& d1, double& d2) const
+{
+	auto& v1 = vertices_[seg.v1];
+	auto& v2 = vertices_[seg.v2];
+	d1       = ((v1.x - part.x) * part.dy - (v1.y - part.y) * part.dx) / part.length;
+	d2       = ((v2.x - part.x) * part.dy - (v2.y - part.y) * part.dx) / part.length;
+
+	// Collinear, front if facing the same direction as the partition
+	if (std::abs(d1) <= DIST_EPSILON && std::abs(d2) <= DIST_EPSILON)
+		return ((v2.x - v1.x) * part.dx + (v2.y - v1.y) * part.dy) > 0 ? Side::Front : Side::Back;
+
+	if (d1 >= -DIST_EPSILON && d2 >= -DIST_EPSILON)
+		return Side::Front;
+	if (d1 <= DIST_EPSILON && d2 <= DIST_EPSILON)
+		return Side::Back;
+
+	return Side::Split;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cost of splitting [segs] with [part] (lower is better), or
+// INVALID_SCORE if [part] doesn't divide [segs] or can't beat [best]
+// -----------------------------------------------------------------------------
+double BSPBuilder::score(const vector<BuildSeg>& segs, const Partition& part, double best) const
+{
+	unsigned n_front = 0, n_back = 0, n_split = 0;
+	double   d1, d2;
+	for (auto& seg : segs)
+	{
+		switch (classify(seg, part, d1, d2))
+		{
+		case Side::Front: n_front++; break;
+		case Side::Back: n_back++; break;
+		default:
+			n_split++;
+			if (n_split * SPLIT_COST >= best)
+				return INVALID_SCORE;
+		}
+	}
+
+	// Must put segs on both sides
+	if (n_split == 0 && (n_front == 0 || n_back == 0))
+		return INVALID_SCORE;
+
+	return n_split * SPLIT_COST + std::abs(static_cast<double>(n_front) - static_cast<double>(n_back));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index of the best seg in [segs] to use as a partition, or -1 if
+// [segs] is convex. If [sample] is true, only a limited number of candidates
+// are considered
+// -----------------------------------------------------------------------------
+int BSPBuilder::choosePartition(const vector<BuildSeg>& segs, bool sample)
+{
+	// Get candidates (one per linedef side)
+	vector<unsigned>                       candidates;
+	std::set<std::pair<unsigned, uint8_t>> used;
+	for (unsigned a = 0; a < segs.size(); a++)
+		if (used.insert({ segs[a].line, segs[a].side }).second)
+			candidates.push_back(a);
+
+	// Sample evenly if needed
+	unsigned max_candidates = options_.fast ? FAST_CANDIDATES : MAX_CANDIDATES;
+	bool     sampled        = sample && candidates.size() > max_candidates;
+	if (sampled)
+	{
+		vector<unsigned> sample_candidates(max_candidates);
+		for (unsigned a = 0; a < max_candidates; a++)
+			sample_candidates[a] = candidates[static_cast<size_t>(a) * candidates.size() / max_candidates];
+		candidates.swap(sample_candidates);
+	}
+
+	// Scores candidates [start] to [end], returning the best
+	auto scoreRange = [&](unsigned start, unsigned end)
+	{
+		std::pair<double, int> best{ INVALID_SCORE, -1 };
+		for (unsigned a = start; a < end; a++)
+		{
+			auto cost = score(segs, partition(segs[candidates[a]]), best.first);
+			if (cost < best.first)
+				best = { cost, candidates[a] };
+		}
+		return best;
+	};
+
+	// Score candidates, across multiple threads if there are enough
+	std::pair<double, int> best{ INVALID_SCORE, -1 };
+	auto                   n_threads = std::min<unsigned>(options_.n_threads, candidates.size());
+	if (n_threads > 1 && segs.size() * candidates.size() >= PARALLEL_MIN)
+	{
+		vector<std::pair<double, int>> results(n_threads);
+		runParallel(
+			n_threads,
+			[&](unsigned t) {
+				results[t] = scoreRange(candidates.size() * t / n_threads, candidates.size() * (t + 1) / n_threads);
+			});
+
+		// Take the best (earliest on equal score, so results don't depend on thread count)
+		for (auto& result : results)
+			if (result.first < best.first)
+				best = result;
+	}
+	else
+		best = scoreRange(0, candidates.size());
+
+	// Try all candidates if none of the sampled ones were valid
+	if (best.second < 0 && sampled)
+		return choosePartition(segs, false);
+
+	return best.second;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a vertex at [x,y] created by splitting a seg (or reuses an existing one
+// at the same position) and returns its index
+// -----------------------------------------------------------------------------
+unsigned BSPBuilder::addSplitVertex(double x, double y)
+{
+	std::pair<int64_t, int64_t> key{ std::llround(x * 65536.), std::llround(y * 65536.) };
+	auto                        existing = split_vertices_.find(key);
+	if (existing != split_vertices_.end())
+		return existing->second;
+
+	vertices_.push_back({ x, y });
+	split_vertices_[key] = vertices_.size() - 1;
+	return vertices_.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Recursively builds a node (or subsector if convex) from [segs], and returns
+// its index (ORed with SUBSECTOR_FLAG for a subsector).
+// [bbox] is set to the bounding box of all segs in the node
+// -----------------------------------------------------------------------------
+unsigned BSPBuilder::buildNode(vector<BuildSeg>& segs, Bounds& bbox)
+{
+	// Choose partition, create subsector if convex
+	auto part_index = choosePartition(segs, true);
+	if (part_index < 0)
+		return buildSubSector(segs, bbox);
+
+	// Split segs
+	auto             part = partition(segs[part_index]);
+	vector<BuildSeg> front, back;
+	double           d1, d2;
+	for (auto& seg : segs)
+	{
+		switch (classify(seg, part, d1, d2))
+		{
+		case Side::Front: front.push_back(seg); break;
+		case Side::Back: back.push_back(seg); break;
+		default:
+		{
+			// Split at intersection with partition line
+			auto&    v1 = vertices_[seg.v1];
+			auto&    v2 = vertices_[seg.v2];
+			double   t  = d1 / (d1 - d2);
+			double   x  = v1.x + (v2.x - v1.x) * t;
+			double   y  = v1.y + (v2.y - v1.y) * t;
+			double   dx = x - v1.x;
+			double   dy = y - v1.y;
+			unsigned nv = addSplitVertex(x, y);
+
+			BuildSeg seg1 = seg;
+			BuildSeg seg2 = seg;
+			seg1.v2       = nv;
+			seg2.v1       = nv;
+			seg2.offset += std::sqrt(dx * dx + dy * dy);
+
+			(d1 > 0 ? front : back).push_back(seg1);
+			(d1 > 0 ? back : front).push_back(seg2);
+		}
+		}
+	}
+	segs.clear();
+	segs.shrink_to_fit();
+
+	// Build children (keeping track of the partitions bounding each, for GL
+	// subsectors)
+	Node node{ part.x, part.y, part.dx, part.dy, {}, { 0, 0 } };
+	node_path_.push_back(part);
+	node.child[0]     = buildNode(front, node.bbox[0]);
+	node_path_.back() = { part.x, part.y, -part.dx, -part.dy, part.length };
+	node.child[1]     = buildNode(back, node.bbox[1]);
+	node_path_.pop_back();
+
+	// Get node bbox
+	bbox       = node.bbox[0];
+	bbox.min_x = std::min(bbox.min_x, node.bbox[1].min_x);
+	bbox.min_y = std::min(bbox.min_y, node.bbox[1].min_y);
+	bbox.max_x = std::max(bbox.max_x, node.bbox[1].max_x);
+	bbox.max_y = std::max(bbox.max_y, node.bbox[1].max_y);
+
+	nodes_.push_back(node);
+	return nodes_.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Creates a subsector from [segs] and returns its index (ORed with
+// SUBSECTOR_FLAG). [bbox] is set to the bounding box of the segs
+// -----------------------------------------------------------------------------
+unsigned BSPBuilder::buildSubSector(const vector<BuildSeg>& segs, Bounds& bbox)
+{
+	subsectors_.push_back({ static_cast<unsigned>(segs_.size()), static_cast<unsigned>(segs.size()) });
+	if (options_.gl)
+		ssector_clips_.push_back(node_path_);
+
+	bool first = true;
+	for (auto& seg : segs)
+	{
+		segs_.push_back({ seg.v1, seg.v2, seg.line, seg.side, seg.offset });
+		extendBounds(bbox, vertices_[seg.v1], first);
+		extendBounds(bbox, vertices_[seg.v2], false);
+		first = false;
+	}
+
+	return (subsectors_.size() - 1) | SUBSECTOR_FLAG;
+}
+
+// -----------------------------------------------------------------------------
+// Builds GL subsectors (closed loops of segs, including minisegs along
+// partition lines) for all built subsectors, and links partner segs
+// -----------------------------------------------------------------------------
+void BSPBuilder::buildGLNodes()
+{
+	// GL vertices start as all the normal vertices
+	gl_vertices_ = vertices_;
+	gl_vertex_grid_.clear();
+	for (unsigned a = 0; a < gl_vertices_.size(); a++)
+		gl_vertex_grid_[gridKey(std::floor(gl_vertices_[a].x), std::floor(gl_vertices_[a].y))].push_back(a);
+
+	// Get map bounds (plus some space) to clip subsector areas from
+	Bounds bounds;
+	for (unsigned a = 0; a < n_map_vertices_; a++)
+		extendBounds(bounds, vertices_[a], a == 0);
+	bounds.min_x -= 64.;
+	bounds.min_y -= 64.;
+	bounds.max_x += 64.;
+	bounds.max_y += 64.;
+
+	// Build subsectors
+	for (unsigned a = 0; a < subsectors_.size(); a++)
+		buildGLSubSector(a, bounds);
+	ssector_clips_.clear();
+
+	// Link partner segs (going between the same vertices in the opposite
+	// direction)
+	std::unordered_map<uint64_t, unsigned> seg_map;
+	for (unsigned a = 0; a < gl_segs_.size(); a++)
+		seg_map[gridKey(gl_segs_[a].v1, gl_segs_[a].v2)] = a;
+	for (auto& seg : gl_segs_)
+	{
+		auto partner = seg_map.find(gridKey(seg.v2, seg.v1));
+		if (partner != seg_map.end())
+			seg.partner = partner->second;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Builds the GL subsector for subsector [index]. Its area is found by clipping
+// [bounds] to the front of each partition above it and each of its segs, then
+// minisegs are added along any edges of the area not covered by segs
+// -----------------------------------------------------------------------------
+void BSPBuilder::buildGLSubSector(unsigned index, const Bounds& bounds)
+{
+	auto& ssector  = subsectors_[index];
+	auto  seg_end  = ssector.first_seg + ssector.n_segs;
+	auto  first_gl = static_cast<unsigned>(gl_segs_.size());
+
+	// Clips [poly] to the front side of [part]
+	vector<Vertex> poly;
+	auto           clip = [&](const Partition& part) {
+		vector<Vertex> clipped;
+		for (unsigned a = 0; a < poly.size(); a++)
+		{
+			auto&  p1 = poly[a];
+			auto&  p2 = poly[(a + 1) % poly.size()];
+			double d1 = ((p1.x - part.x) * part.dy - (p1.y - part.y) * part.dx) / part.length;
+			double d2 = ((p2.x - part.x) * part.dy - (p2.y - part.y) * part.dx) / part.length;
+
+			if (d1 >= -DIST_EPSILON)
+				clipped.push_back(p1);
+			if ((d1 > DIST_EPSILON && d2 < -DIST_EPSILON) || (d1 < -DIST_EPSILON && d2 > DIST_EPSILON))
+			{
+				double t = d1 / (d1 - d2);
+				clipped.push_back({ p1.x + (p2.x - p1.x) * t, p1.y + (p2.y - p1.y) * t });
+			}
+		}
+		poly.swap(clipped);
+	};
+
+	// Get subsector area (clockwise like segs, so the inside is to the right
+	// of each edge)
+	poly = { { bounds.min_x, bounds.min_y },
+			 { bounds.min_x, bounds.max_y },
+			 { bounds.max_x, bounds.max_y },
+			 { bounds.max_x, bounds.min_y } };
+	for (auto& part : ssector_clips_[index])
+		clip(part);
+	for (auto a = ssector.first_seg; a < seg_end; a++)
+	{
+		auto& seg = segs_[a];
+		clip(partition({ seg.v1, seg.v2, seg.line, seg.side, seg.offset }));
+	}
+
+	// Remove (near) duplicate points
+	vector<Vertex> points;
+	for (auto& point : poly)
+		if (points.empty()
+			|| std::abs(point.x - points.back().x) > VERTEX_EPSILON
+			|| std::abs(point.y - points.back().y) > VERTEX_EPSILON)
+			points.push_back(point);
+	while (points.size() > 1 && std::abs(points[0].x - points.back().x) <= VERTEX_EPSILON
+		   && std::abs(points[0].y - points.back().y) <= VERTEX_EPSILON)
+		points.pop_back();
+
+	// Find the edge of the area each seg is along (and its position on it)
+	vector<vector<std::pair<double, unsigned>>> edge_segs(points.size());
+	bool                                        ok = points.size() >= 3;
+	for (auto a = ssector.first_seg; ok && a < seg_end; a++)
+	{
+		auto& v1 = vertices_[segs_[a].v1];
+		auto& v2 = vertices_[segs_[a].v2];
+
+		ok = false;
+		for (unsigned e = 0; e < points.size() && !ok; e++)
+		{
+			auto&  p1  = points[e];
+			auto&  p2  = points[(e + 1) % points.size()];
+			double ex  = p2.x - p1.x;
+			double ey  = p2.y - p1.y;
+			double len = std::sqrt(ex * ex + ey * ey);
+
+			// Both seg vertices must be on the edge, and facing the same way
+			if (std::abs((v1.x - p1.x) * ey - (v1.y - p1.y) * ex) / len > VERTEX_EPSILON
+				|| std::abs((v2.x - p1.x) * ey - (v2.y - p1.y) * ex) / len > VERTEX_EPSILON
+				|| (v2.x - v1.x) * ex + (v2.y - v1.y) * ey <= 0)
+				continue;
+
+			edge_segs[e].emplace_back(((v1.x - p1.x) * ex + (v1.y - p1.y) * ey) / (len * len), a);
+			ok = true;
+		}
+	}
+
+	if (ok)
+	{
+		// Go around the area edges, adding segs along each edge in order
+		// and minisegs to fill any gaps
+		vector<unsigned> corners;
+		for (auto& point : points)
+			corners.push_back(glVertex(point.x, point.y));
+
+		for (unsigned e = 0; e < points.size(); e++)
+		{
+			std::sort(edge_segs[e].begin(), edge_segs[e].end());
+
+			auto current = corners[e];
+			for (auto& edge_seg : edge_segs[e])
+			{
+				auto& seg = segs_[edge_seg.second];
+				if (current != seg.v1)
+					gl_segs_.push_back({ current, seg.v1, NONE, 0 });
+				gl_segs_.push_back({ seg.v1, seg.v2, seg.line, seg.side });
+				current = seg.v2;
+			}
+
+			auto end = corners[(e + 1) % points.size()];
+			if (current != end)
+				gl_segs_.push_back({ current, end, NONE, 0 });
+		}
+	}
+	else
+	{
+		// Unable to get a valid area for the subsector (shouldn't happen
+		// unless it's degenerate), so just join the segs up in clockwise order
+		// around their centre
+		double cx = 0.;
+		double cy = 0.;
+		for (auto a = ssector.first_seg; a < seg_end; a++)
+		{
+			cx += (vertices_[segs_[a].v1].x + vertices_[segs_[a].v2].x) / (2. * ssector.n_segs);
+			cy += (vertices_[segs_[a].v1].y + vertices_[segs_[a].v2].y) / (2. * ssector.n_segs);
+		}
+
+		vector<std::pair<double, unsigned>> order;
+		for (auto a = ssector.first_seg; a < seg_end; a++)
+		{
+			double mx = (vertices_[segs_[a].v1].x + vertices_[segs_[a].v2].x) * 0.5;
+			double my = (vertices_[segs_[a].v1].y + vertices_[segs_[a].v2].y) * 0.5;
+			order.emplace_back(-std::atan2(my - cy, mx - cx), a);
+		}
+		std::sort(order.begin(), order.end());
+
+		for (unsigned a = 0; a < order.size(); a++)
+		{
+			auto& seg  = segs_[order[a].second];
+			auto& next = segs_[order[(a + 1) % order.size()].second];
+			gl_segs_.push_back({ seg.v1, seg.v2, seg.line, seg.side });
+			if (seg.v2 != next.v1)
+				gl_segs_.push_back({ seg.v2, next.v1, NONE, 0 });
+		}
+	}
+
+	gl_subsectors_.push_back({ first_gl, static_cast<unsigned>(gl_segs_.size()) - first_gl });
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index of the GL vertex at [x,y], adding a new one if there isn't
+// one there already (within VERTEX_EPSILON)
+// -----------------------------------------------------------------------------
+unsigned BSPBuilder::glVertex(double x, double y)
+{
+	auto cx = static_cast<int64_t>(std::floor(x));
+	auto cy = static_cast<int64_t>(std::floor(y));
+	for (auto gx = cx - 1; gx <= cx + 1; gx++)
+		for (auto gy = cy - 1; gy <= cy + 1; gy++)
+		{
+			auto cell = gl_vertex_grid_.find(gridKey(gx, gy));
+			if (cell == gl_vertex_grid_.end())
+				continue;
+
+			for (auto vertex : cell->second)
+				if (std::abs(gl_vertices_[vertex].x - x) <= VERTEX_EPSILON
+					&& std::abs(gl_vertices_[vertex].y - y) <= VERTEX_EPSILON)
+					return vertex;
+		}
+
+	gl_vertices_.push_back({ x, y });
+	gl_vertex_grid_[gridKey(cx, cy)].push_back(gl_vertices_.size() - 1);
+	return gl_vertices_.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Runs [job] for each part from 0 to [n_parts], spread across the worker
+// threads (and the calling thread), and returns once all parts are done.
+// The worker threads are started the first time this is called, and kept
+// until the builder is destroyed
+// -----------------------------------------------------------------------------
+void BSPBuilder::runParallel(unsigned n_parts, const std::function<void(unsigned)>& job)
+{
+	while (threads_.size() + 1 < options_.n_threads)
+		threads_.emplace_back(&BSPBuilder::workerThread, this);
+
+	{
+		std::lock_guard lock(mutex_);
+		job_        = job;
+		job_parts_  = n_parts;
+		next_part_  = 0;
+		parts_done_ = 0;
+	}
+	cv_work_.notify_all();
+
+	// Run parts on this thread too
+	std::unique_lock lock(mutex_);
+	while (next_part_ < job_parts_)
+	{
+		auto part = next_part_++;
+		lock.unlock();
+		job(part);
+		lock.lock();
+		parts_done_++;
+	}
+
+	// Wait for the workers to finish
+	cv_done_.wait(lock, [&]() { return parts_done_ == job_parts_; });
+	job_       = nullptr;
+	job_parts_ = 0;
+	next_part_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread function, runs parts of the current job until the builder is
+// destroyed
+// -----------------------------------------------------------------------------
+void BSPBuilder::workerThread()
+{
+	std::unique_lock lock(mutex_);
+	while (true)
+	{
+		cv_work_.wait(lock, [&]() { return stop_ || next_part_ < job_parts_; });
+		if (stop_)
+			return;
+
+		auto part = next_part_++;
+		lock.unlock();
+		job_(part);
+		lock.lock();
+
+		if (++parts_done_ == job_parts_)
+			cv_done_.notify_all();
+	}
+}
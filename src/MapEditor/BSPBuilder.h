@@ -0,0 +1,171 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace slade
+{
+class Archive;
+class ArchiveEntry;
+class SLADEMap;
+enum class MapFormat;
+
+class BSPBuilder
+{
+public:
+	static constexpr unsigned SUBSECTOR_FLAG = 0x80000000;
+	static constexpr unsigned NONE           = 0xFFFFFFFF;
+
+	struct Options
+	{
+		bool     fast      = false; // Only consider a small sample of partition candidates
+		bool     extended  = false; // Always write ZDoom extended nodes
+		bool     gl        = false; // Also build GL nodes (required for UDMF)
+		unsigned n_threads = 0;     // 0 = number of cores
+	};
+
+	struct Vertex
+	{
+		double x;
+		double y;
+	};
+
+	struct Seg
+	{
+		unsigned v1;
+		unsigned v2;
+		unsigned line;
+		uint8_t  side;
+		double   offset;
+	};
+
+	// A GL seg, either part of a line or a 'miniseg' along a partition line
+	// (line is NONE). The segs of a GL subsector form a closed loop
+	struct GLSeg
+	{
+		unsigned v1;
+		unsigned v2;
+		unsigned line;
+		uint8_t  side;
+		unsigned partner = NONE; // Seg on the other side of this one (if any)
+	};
+
+	struct SubSector
+	{
+		unsigned first_seg;
+		unsigned n_segs;
+	};
+
+	struct Bounds
+	{
+		double min_x = 0.;
+		double min_y = 0.;
+		double max_x = 0.;
+		double max_y = 0.;
+	};
+
+	struct Node
+	{
+		double   x;
+		double   y;
+		double   dx;
+		double   dy;
+		Bounds   bbox[2];  // Front, back
+		unsigned child[2]; // Front, back (ORed with SUBSECTOR_FLAG if a subsector)
+	};
+
+	BSPBuilder(SLADEMap& map, const Options& options);
+	~BSPBuilder();
+
+	const vector<Vertex>&    vertices() const { return vertices_; }
+	unsigned                 nMapVertices() const { return n_map_vertices_; }
+	const vector<Seg>&       segs() const { return segs_; }
+	const vector<SubSector>& subSectors() const { return subsectors_; }
+	const vector<Node>&      nodes() const { return nodes_; }
+	const vector<Vertex>&    glVertices() const { return gl_vertices_; }
+	const vector<GLSeg>&     glSegs() const { return gl_segs_; }
+	const vector<SubSector>& glSubSectors() const { return gl_subsectors_; }
+
+	bool build();
+	bool needsExtendedNodes() const;
+
+	vector<unique_ptr<ArchiveEntry>> writeDoomNodes() const;
+	unique_ptr<ArchiveEntry>         writeExtendedNodes(string_view name) const;
+	unique_ptr<ArchiveEntry>         writeExtendedGLNodes(string_view name) const;
+	unique_ptr<ArchiveEntry>         writeBlockmap() const;
+	unique_ptr<ArchiveEntry>         writeReject() const;
+	bool                             addToArchive(Archive& archive, ArchiveEntry* head, MapFormat format) const;
+
+private:
+	struct BuildSeg
+	{
+		unsigned v1;
+		unsigned v2;
+		unsigned line;
+		uint8_t  side;
+		double   offset;
+	};
+
+	struct Partition
+	{
+		double x;
+		double y;
+		double dx;
+		double dy;
+		double length;
+	};
+
+	enum class Side
+	{
+		Front,
+		Back,
+		Split
+	};
+
+	SLADEMap&                                  map_;
+	Options                                    options_;
+	vector<Vertex>                             vertices_;
+	unsigned                                   n_map_vertices_ = 0;
+	std::map<std::pair<int64_t, int64_t>, int> split_vertices_;
+	vector<Seg>                                segs_;
+	vector<SubSector>                          subsectors_;
+	vector<Node>                               nodes_;
+
+	// GL nodes
+	vector<Partition>                              node_path_;      // Partitions bounding the current node
+	vector<vector<Partition>>                      ssector_clips_;  // Partitions bounding each subsector
+	vector<Vertex>                                 gl_vertices_;
+	std::unordered_map<uint64_t, vector<unsigned>> gl_vertex_grid_; // GL vertices by 1x1 grid cell
+	vector<GLSeg>                                  gl_segs_;
+	vector<SubSector>                              gl_subsectors_;
+
+	// Worker threads for scoring partition candidates
+	vector<std::thread>           threads_;
+	std::mutex                    mutex_;
+	std::condition_variable       cv_work_;
+	std::condition_variable       cv_done_;
+	std::function<void(unsigned)> job_;
+	unsigned                      job_parts_  = 0;
+	unsigned                      next_part_  = 0;
+	unsigned                      parts_done_ = 0;
+	bool                          stop_       = false;
+
+	Partition partition(const BuildSeg& seg) const;
+	Side      classify(const BuildSeg& seg, const Partition& part, double& d1, double& d2) const;
+	double    score(const vector<BuildSeg>& segs, const Partition& part, double best) const;
+	int       choosePartition(const vector<BuildSeg>& segs, bool sample);
+	unsigned  addSplitVertex(double x, double y);
+	unsigned  buildNode(vector<BuildSeg>& segs, Bounds& bbox);
+	unsigned  buildSubSector(const vector<BuildSeg>& segs, Bounds& bbox);
+
+	void     buildGLNodes();
+	void     buildGLSubSector(unsigned index, const Bounds& map_bounds);
+	unsigned glVertex(double x, double y);
+
+	void runParallel(unsigned n_parts, const std::function<void(unsigned)>& job);
+	void workerThread();
+};
+} // namespace slade
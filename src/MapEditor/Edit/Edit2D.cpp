@@ -407,13 +407,13 @@ void Edit2D::changeSectorTexture() const
 	auto   mode = context_.sectorEditMode();
 	if (mode == SectorMode::Floor)
 	{
-		texture       = selection[0]->floor().texture;
+		texture       = selection[0]->floor().texture.str();
 		browser_title = "Browse Floor Texture";
 		undo_name     = "Change Floor Texture";
 	}
 	else if (mode == SectorMode::Ceiling)
 	{
-		texture       = selection[0]->ceiling().texture;
+		texture       = selection[0]->ceiling().texture.str();
 		browser_title = "Browse Ceiling Texture";
 		undo_name     = "Change Ceiling Texture";
 	}
@@ -1125,14 +1125,14 @@ void Edit2D::deleteSector() const
 		else
 			continue;
 
-		if (side->texMiddle() != "-")
+		if (side->texMiddleName() != MapSide::TEX_NONE_NAME)
 			continue;
 
 		// Inherit textures from upper or lower
-		if (side->texUpper() != "-")
-			side->setTexMiddle(side->texUpper());
-		else if (side->texLower() != "-")
-			side->setTexMiddle(side->texLower());
+		if (side->texUpperName() != MapSide::TEX_NONE_NAME)
+			side->setTexMiddle(side->texUpperName());
+		else if (side->texLowerName() != MapSide::TEX_NONE_NAME)
+			side->setTexMiddle(side->texLowerName());
 
 		// Clear any existing textures, which are no longer visible
 		side->setTexUpper(MapSide::TEX_NONE);
@@ -758,7 +758,7 @@ void Edit3D::copy(CopyType type)
 	{
 		// Texture
 		if (type == CopyType::TexType)
-			copy_texture_ = sector->floor().texture;
+			copy_texture_ = sector->floor().texture.str();
 	}
 
 	// Ceiling
@@ -766,7 +766,7 @@ void Edit3D::copy(CopyType type)
 	{
 		// Texture
 		if (type == CopyType::TexType)
-			copy_texture_ = sector->ceiling().texture;
+			copy_texture_ = sector->ceiling().texture.str();
 	}
 
 	// Thing
@@ -1228,9 +1228,9 @@ void Edit3D::changeTexture() const
 		type = mapeditor::TextureType::Flat;
 
 		if (first.type == ItemType::Floor)
-			tex = sector->floor().texture;
+			tex = sector->floor().texture.str();
 		else if (first.type == ItemType::Ceiling)
-			tex = sector->ceiling().texture;
+			tex = sector->ceiling().texture.str();
 	}
 	else if (auto side = first.asSide(map))
 	{
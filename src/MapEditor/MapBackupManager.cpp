@@ -6,7 +6,11 @@
 // Email:       sirjuddington@gmail.com
 // Web:         http://slade.mancubus.net
 // Filename:    MapBackupManager.cpp
-// Description: MapBackupManager class - creates/manages map backups
+// Description: MapBackupManager class - creates/manages map backups.
+//              Backups are kept in a content-addressed store per archive:
+//              each distinct lump is stored (compressed) once, named by a
+//              hash of its content, and each backup is a small manifest
+//              listing the lumps it contains
 //
 // This program is free software; you can redistribute it and/or modify it
 // under the terms of the GNU General Public License as published by the Free
@@ -32,15 +36,22 @@
 #include "Main.h"
 #include "MapBackupManager.h"
 #include "App.h"
+#include "Archive/Formats/WadArchive.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Misc.h"
 #include "MapEditor.h"
 #include "UI/MapBackupPanel.h"
 #include "UI/SDialog.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
+#include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
+#include <filesystem>
+#include <map>
+#include <set>
 
 using namespace slade;
+namespace fs = std::filesystem;
 
 
 // -----------------------------------------------------------------------------
@@ -54,112 +65,517 @@ namespace
 // List of entry names to be ignored for backups
 string mb_ignore_entries[] = { "NODES",    "SSECTORS", "ZNODES",  "SEGS",     "REJECT",
 							   "BLOCKMAP", "GL_VERT",  "GL_SEGS", "GL_SSECT", "GL_NODES" };
+
+const string MANIFEST_EXT = ".manifest";
+const string REFS_FILE    = "objects.refs";
 } // namespace
 
 
 // -----------------------------------------------------------------------------
 //
-// MapBackupManager Class Functions
+// Backup Store Functions
 //
 // -----------------------------------------------------------------------------
+namespace
+{
+// Layout of the backup store for an archive:
+// <store>/objects/<xx>/<hash>             - zlib-compressed lump data
+// <store>/maps/<map>/<timestamp>.manifest - one '<hash> <size> <name>' line per
+//                                           lump in the backup, in order
+// <store>/objects.refs                    - one '<hash> <count>' line per
+//                                           object, the number of manifests
+//                                           referencing it
+// Objects are only ever added or removed, never rewritten, so writing a backup
+// only costs the lumps that changed since any previous backup. The reference
+// counts mean pruning old backups only needs to read the manifests removed
 
+// A single lump in a backup manifest
+struct ManifestItem
+{
+	string   hash;
+	unsigned size = 0;
+	string   name;
+
+	bool operator==(const ManifestItem& rhs) const { return hash == rhs.hash && name == rhs.name; }
+};
 
 // -----------------------------------------------------------------------------
-// Writes a backup for [map_name] in [archive_name], with the map data entries
-// in [map_data]
+// Returns true if [entry_name] is a map entry that shouldn't be backed up
 // -----------------------------------------------------------------------------
-bool MapBackupManager::writeBackup(
-	vector<unique_ptr<ArchiveEntry>>& map_data,
-	std::string_view                  archive_name,
-	std::string_view                  map_name) const
+bool isIgnored(string_view entry_name)
+{
+	for (auto& ignore_entry : mb_ignore_entries)
+		if (strutil::equalCI(ignore_entry, entry_name))
+			return true;
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the content hash of [data] as a hex string (64-bit FNV-1a hash and
+// CRC-32, followed by the data size)
+// -----------------------------------------------------------------------------
+string contentHash(const uint8_t* data, unsigned size)
 {
-	// Create backup directory if needed
-	auto backup_dir = app::path("backups", app::Dir::User);
-	if (!wxDirExists(backup_dir))
-		wxMkdir(backup_dir);
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned a = 0; a < size; ++a)
+	{
+		hash ^= data[a];
+		hash *= 1099511628211ull;
+	}
+
+	return fmt::format("{:016x}{:08x}{:08x}", hash, size > 0 ? misc::crc(data, size) : 0, size);
+}
 
-	// Open or create backup zip
-	shared_ptr<Archive> backup = std::make_shared<ZipArchive>();
-	string              fname{ archive_name };
+// -----------------------------------------------------------------------------
+// Returns manifest items (content hashes etc.) for [entries]
+// -----------------------------------------------------------------------------
+vector<ManifestItem> manifestItems(const vector<ArchiveEntry*>& entries)
+{
+	vector<ManifestItem> items;
+	items.reserve(entries.size());
+	for (auto entry : entries)
+		items.push_back({ contentHash(entry->rawData(), entry->size()), entry->size(), entry->name() });
+
+	return items;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the backup store directory for [archive_name]
+// -----------------------------------------------------------------------------
+string storeDir(string_view archive_name)
+{
+	string fname{ archive_name };
 	std::replace(fname.begin(), fname.end(), '.', '_');
-	auto backup_file = fmt::format("{}/{}_backup.zip", backup_dir, fname);
-	if (!backup->open(backup_file))
-		backup->setFilename(backup_file);
+	return fmt::format("{}/{}", app::path("backups", app::Dir::User), fname);
+}
 
-	// Filter ignored entries
-	vector<ArchiveEntry*> backup_entries;
-	for (auto& entry : map_data)
+// -----------------------------------------------------------------------------
+// Returns the path to the object file for [hash] in [store_dir]
+// -----------------------------------------------------------------------------
+string objectPath(const string& store_dir, const string& hash)
+{
+	return fmt::format("{}/objects/{}/{}", store_dir, hash.substr(0, 2), hash);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the directory containing backup manifests for [map_name]
+// -----------------------------------------------------------------------------
+string mapDir(const string& store_dir, string_view map_name)
+{
+	return fmt::format("{}/maps/{}", store_dir, map_name);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the names of all backups in [map_dir], oldest first
+// -----------------------------------------------------------------------------
+vector<string> backupNames(const string& map_dir)
+{
+	vector<string>  names;
+	std::error_code ec;
+	for (const auto& item : fs::directory_iterator{ map_dir, ec })
+		if (item.is_regular_file() && item.path().extension() == MANIFEST_EXT)
+			names.push_back(item.path().stem().string());
+
+	// Names are timestamps so sort chronologically
+	std::sort(names.begin(), names.end());
+
+	return names;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the backup manifest at [path]
+// -----------------------------------------------------------------------------
+vector<ManifestItem> readManifest(const string& path)
+{
+	vector<ManifestItem> items;
+	string               content;
+	if (!fileutil::readFileToString(path, content))
+		return items;
+
+	for (auto line : strutil::splitV(content, '\n'))
 	{
-		// Check for ignored entry
-		bool ignored = false;
-		for (auto& ignore_entry : mb_ignore_entries)
+		auto space1 = line.find(' ');
+		auto space2 = space1 == string_view::npos ? space1 : line.find(' ', space1 + 1);
+		if (space2 == string_view::npos)
+			continue;
+
+		ManifestItem item;
+		item.hash = line.substr(0, space1);
+		item.size = strutil::asInt(line.substr(space1 + 1, space2 - space1 - 1));
+		item.name = line.substr(space2 + 1);
+		items.push_back(item);
+	}
+
+	return items;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [items] to the backup manifest at [path]. The manifest is written to a
+// temporary file first so an interrupted write can't leave a partial backup
+// -----------------------------------------------------------------------------
+bool writeManifest(const string& path, const vector<ManifestItem>& items)
+{
+	string content;
+	for (const auto& item : items)
+		content += fmt::format("{} {} {}\n", item.hash, item.size, item.name);
+
+	auto temp = path + ".tmp";
+	if (!fileutil::writeStringToFile(content, temp))
+		return false;
+
+	std::error_code ec;
+	fs::rename(temp, path, ec);
+	return !ec;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [data] to [store_dir] as the object for [item], if it isn't already
+// there
+// -----------------------------------------------------------------------------
+bool writeObject(const string& store_dir, const ManifestItem& item, MemChunk& data)
+{
+	// Empty lumps don't need an object
+	if (item.size == 0)
+		return true;
+
+	auto path = objectPath(store_dir, item.hash);
+	if (fileutil::fileExists(path))
+		return true;
+
+	std::error_code ec;
+	fs::create_directories(fs::path{ path }.parent_path(), ec);
+
+	MemChunk compressed;
+	if (!compression::zlibDeflate(data, compressed))
+		return false;
+
+	auto temp = path + ".tmp";
+	if (!compressed.exportFile(temp))
+		return false;
+
+	fs::rename(temp, path, ec);
+	return !ec;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data for [item] from [store_dir] into [data]. Returns false if the
+// object can't be read or its data doesn't match the size and hash in [item]
+// -----------------------------------------------------------------------------
+bool readObject(const string& store_dir, const ManifestItem& item, MemChunk& data)
+{
+	if (item.size == 0)
+		return data.clear();
+
+	MemChunk compressed;
+	if (!compressed.importFile(objectPath(store_dir, item.hash)))
+		return false;
+
+	if (!compression::zlibInflate(compressed, data, item.size))
+		return false;
+
+	// Verify data
+	if (data.size() != item.size || contentHash(data.data(), data.size()) != item.hash)
+	{
+		log::error("Backup data for {} ({}) is corrupt", item.name, item.hash);
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Object reference counts (hash -> number of manifests referencing it)
+// -----------------------------------------------------------------------------
+using RefCounts = std::map<string, unsigned>;
+
+// -----------------------------------------------------------------------------
+// Adds (or removes if [add] is false) a reference to each object in
+// [manifest] to [refs]. Objects no longer referenced are removed from [refs]
+// and added to [unreferenced]
+// -----------------------------------------------------------------------------
+void updateRefCounts(
+	RefCounts&                  refs,
+	const vector<ManifestItem>& manifest,
+	bool                        add,
+	vector<string>*             unreferenced = nullptr)
+{
+	// Only count each object once per manifest (empty lumps have no object)
+	std::set<string> hashes;
+	for (const auto& item : manifest)
+		if (item.size > 0)
+			hashes.insert(item.hash);
+
+	for (const auto& hash : hashes)
+	{
+		if (add)
 		{
-			if (strutil::equalCI(ignore_entry, entry->name()))
-			{
-				ignored = true;
-				break;
-			}
+			refs[hash]++;
+			continue;
 		}
 
-		if (!ignored)
-			backup_entries.push_back(entry.get());
+		auto ref = refs.find(hash);
+		if (ref == refs.end())
+			continue;
+
+		if (--ref->second == 0)
+		{
+			refs.erase(ref);
+			if (unreferenced)
+				unreferenced->push_back(hash);
+		}
 	}
+}
 
-	// Compare with last backup (if any)
-	auto map_dir = backup->dirAtPath(map_name);
-	if (map_dir && map_dir->numSubdirs() > 0)
+// -----------------------------------------------------------------------------
+// Reads the object reference counts for [store_dir]. If the store has no
+// reference counts file yet, they are counted from all manifests in the store
+// -----------------------------------------------------------------------------
+RefCounts readRefCounts(const string& store_dir)
+{
+	RefCounts refs;
+
+	auto   path = fmt::format("{}/{}", store_dir, REFS_FILE);
+	string content;
+	if (fileutil::fileExists(path) && fileutil::readFileToString(path, content))
 	{
-		auto last_backup = map_dir->subdirAt(map_dir->numSubdirs() - 1);
-		bool same        = true;
-		if (last_backup->numEntries() != backup_entries.size())
-			same = false;
-		else
+		for (auto line : strutil::splitV(content, '\n'))
 		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
-			{
-				auto e1 = backup_entries[a];
-				auto e2 = last_backup->entryAt(a);
-				if (e1->size() != e2->size())
-				{
-					same = false;
-					break;
-				}
-
-				uint32_t crc1 = misc::crc(e1->rawData(), e1->size());
-				uint32_t crc2 = misc::crc(e2->rawData(), e2->size());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
-			}
+			auto space = line.find(' ');
+			if (space != string_view::npos)
+				refs[string{ line.substr(0, space) }] = strutil::asInt(line.substr(space + 1));
 		}
 
-		if (same)
+		return refs;
+	}
+
+	std::error_code ec;
+	for (const auto& item : fs::recursive_directory_iterator{ store_dir + "/maps", ec })
+		if (item.is_regular_file() && item.path().extension() == MANIFEST_EXT)
+			updateRefCounts(refs, readManifest(item.path().string()), true);
+
+	return refs;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the object reference counts [refs] for [store_dir]
+// -----------------------------------------------------------------------------
+bool writeRefCounts(const string& store_dir, const RefCounts& refs)
+{
+	string content;
+	for (const auto& ref : refs)
+		content += fmt::format("{} {}\n", ref.first, ref.second);
+
+	auto path = fmt::format("{}/{}", store_dir, REFS_FILE);
+	auto temp = path + ".tmp";
+	if (!fileutil::writeStringToFile(content, temp))
+		return false;
+
+	std::error_code ec;
+	fs::rename(temp, path, ec);
+	return !ec;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a backup [name] for [map_name] to [store_dir], with lump data from
+// [entries] as described by [manifest]
+// -----------------------------------------------------------------------------
+bool addBackup(
+	const string&                store_dir,
+	string_view                  map_name,
+	const string&                name,
+	const vector<ArchiveEntry*>& entries,
+	const vector<ManifestItem>&  manifest)
+{
+	for (unsigned a = 0; a < entries.size(); ++a)
+	{
+		if (!writeObject(store_dir, manifest[a], entries[a]->data()))
 		{
-			log::info(2, "Same data as previous backup - ignoring");
-			return true;
+			log::warning("Unable to write backup data for {} ({})", manifest[a].name, manifest[a].hash);
+			return false;
 		}
 	}
 
-	// Add map data to backup
+	// Update object reference counts before writing the manifest, so an
+	// interrupted write can only leave objects referenced for too long (rather
+	// than removed while still in use)
+	auto refs = readRefCounts(store_dir);
+	updateRefCounts(refs, manifest, true);
+	if (!writeRefCounts(store_dir, refs))
+		return false;
+
+	auto map_dir = mapDir(store_dir, map_name);
+
+	std::error_code ec;
+	fs::create_directories(map_dir, ec);
+
+	return writeManifest(fmt::format("{}/{}{}", map_dir, name, MANIFEST_EXT), manifest);
+}
+
+// -----------------------------------------------------------------------------
+// Removes backups in [map_dir] (oldest first) until there are no more than
+// max_map_backups, then removes any objects in [store_dir] that were only
+// referenced by the removed backups
+// -----------------------------------------------------------------------------
+void pruneBackups(const string& store_dir, const string& map_dir)
+{
+	auto names = backupNames(map_dir);
+	auto max   = std::max<int>(max_map_backups, 1);
+	if ((int)names.size() <= max)
+		return;
+
+	// Remove old manifests, dropping their object references
+	auto            refs = readRefCounts(store_dir);
+	vector<string>  unreferenced;
+	std::error_code ec;
+	for (unsigned a = 0; a < names.size() - max; ++a)
+	{
+		auto path = fmt::format("{}/{}{}", map_dir, names[a], MANIFEST_EXT);
+		updateRefCounts(refs, readManifest(path), false, &unreferenced);
+		fs::remove(path, ec);
+	}
+
+	if (!writeRefCounts(store_dir, refs))
+		return;
+
+	// Remove objects that are no longer referenced
+	for (const auto& hash : unreferenced)
+		fs::remove(objectPath(store_dir, hash), ec);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the backup store directory for [archive_name], creating it if needed.
+// Backups from an old-style backup zip for the archive are moved into the store
+// -----------------------------------------------------------------------------
+string openStore(string_view archive_name)
+{
+	auto store_dir = storeDir(archive_name);
+	auto zip_path  = store_dir + "_backup.zip";
+
+	std::error_code ec;
+	fs::create_directories(store_dir, ec);
+
+	if (!fileutil::fileExists(zip_path))
+		return store_dir;
+
+	ZipArchive zip;
+	if (!zip.open(zip_path))
+		return store_dir;
+
+	log::info("Moving map backups from {} to {}", zip_path, store_dir);
+
+	bool ok = true;
+	for (const auto& map_dir : zip.rootDir()->subdirs())
+	{
+		for (const auto& backup_dir : map_dir->subdirs())
+		{
+			vector<ArchiveEntry*> entries;
+			for (const auto& entry : backup_dir->entries())
+				entries.push_back(entry.get());
+
+			ok &= addBackup(store_dir, map_dir->name(), backup_dir->name(), entries, manifestItems(entries));
+		}
+	}
+
+	// Keep the old zip around (renamed) in case anything couldn't be moved
+	zip.close();
+	if (ok)
+		fs::rename(zip_path, zip_path + ".old", ec);
+
+	return store_dir;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapBackupManager Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Writes a backup for [map_name] in [archive_name], with the map data entries
+// in [map_data]
+// -----------------------------------------------------------------------------
+bool MapBackupManager::writeBackup(
+	vector<unique_ptr<ArchiveEntry>>& map_data,
+	std::string_view                  archive_name,
+	std::string_view                  map_name) const
+{
+	auto store_dir = openStore(archive_name);
+	auto map_dir   = mapDir(store_dir, map_name);
+
+	// Filter ignored entries
+	vector<ArchiveEntry*> backup_entries;
+	for (auto& entry : map_data)
+		if (!isIgnored(entry->name()))
+			backup_entries.push_back(entry.get());
+
+	// Compare with last backup (if any)
+	auto manifest = manifestItems(backup_entries);
+	auto names    = backupNames(map_dir);
+	if (!names.empty() && readManifest(fmt::format("{}/{}{}", map_dir, names.back(), MANIFEST_EXT)) == manifest)
+	{
+		log::info(2, "Same data as previous backup - ignoring");
+		return true;
+	}
+
+	// Get a unique name for the backup (timestamps only have 1 second
+	// resolution, so add a counter if there's already a backup with the name)
 	auto timestamp = wxDateTime::Now().FormatISOCombined('_').ToStdString();
 	strutil::replaceIP(timestamp, ":", "");
-	auto dir = fmt::format("{}/{}", map_name, timestamp);
-	for (auto& entry : backup_entries)
-		backup->addEntry(std::make_shared<ArchiveEntry>(*entry), dir);
+	auto name = timestamp;
+	for (unsigned n = 1; fileutil::fileExists(fmt::format("{}/{}{}", map_dir, name, MANIFEST_EXT)); ++n)
+		name = fmt::format("{}_{:02}", timestamp, n);
+
+	// Add map data to backup
+	if (!addBackup(store_dir, map_name, name, backup_entries, manifest))
+		return false;
 
 	// Check for max backups & remove old ones if over
-	map_dir = backup->dirAtPath(map_name);
-	while ((int)map_dir->numSubdirs() > max_map_backups)
-		backup->removeDir(map_dir->subdirAt(0)->name(), map_dir);
+	pruneBackups(store_dir, map_dir);
+
+	return true;
+}
 
-	// Save backup file
-	Archive::save_backup = false;
-	bool ok              = backup->save();
-	Archive::save_backup = true;
+// -----------------------------------------------------------------------------
+// Returns the names (timestamps) of all backups for [map_name] in
+// [archive_name], oldest first
+// -----------------------------------------------------------------------------
+vector<string> MapBackupManager::backups(string_view archive_name, string_view map_name) const
+{
+	// Old-style backups are only moved to the store when a backup is written
+	return backupNames(mapDir(storeDir(archive_name), map_name));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the map data from backup [name] of [map_name] in [archive_name], in a
+// WadArchive. Returns nullptr if the backup couldn't be read
+// -----------------------------------------------------------------------------
+unique_ptr<Archive> MapBackupManager::loadBackup(string_view archive_name, string_view map_name, string_view name) const
+{
+	auto store_dir = storeDir(archive_name);
+	auto manifest  = readManifest(fmt::format("{}/{}{}", mapDir(store_dir, map_name), name, MANIFEST_EXT));
+	if (manifest.empty())
+		return nullptr;
+
+	auto archive = std::make_unique<WadArchive>();
+	for (const auto& item : manifest)
+	{
+		MemChunk data;
+		if (!readObject(store_dir, item, data))
+		{
+			log::error("Unable to read backup data for {} ({})", item.name, item.hash);
+			return nullptr;
+		}
+
+		auto entry = std::make_shared<ArchiveEntry>(item.name);
+		entry->importMemChunk(data);
+		archive->addEntry(entry, "");
+	}
 
-	return ok;
+	return archive;
 }
 
 // -----------------------------------------------------------------------------
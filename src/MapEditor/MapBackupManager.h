@@ -12,5 +12,8 @@ public:
 
 	bool writeBackup(vector<unique_ptr<ArchiveEntry>>& map_data, string_view archive_name, string_view map_name) const;
 	Archive* openBackup(string_view archive_name, string_view map_name) const;
+
+	vector<string>      backups(string_view archive_name, string_view map_name) const;
+	unique_ptr<Archive> loadBackup(string_view archive_name, string_view map_name, string_view name) const;
 };
 } // namespace slade
@@ -0,0 +1,283 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapCheckRunner.cpp
+// Description: MapCheckRunner class - runs a set of map checks (for one or
+//              more maps) in parallel on a pool of worker threads, with
+//              per-check progress and cancellation. Checks that can only run
+//              on the main thread are run via update()/wait() on the calling
+//              thread
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapCheckRunner.h"
+#include "MapChecks.h"
+#include "SLADEMap/SLADEMap.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, map_check_threads, 0, CVar::Flag::Save) // 0 = number of cores
+
+
+// -----------------------------------------------------------------------------
+//
+// MapCheckRunner Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapCheckRunner class constructor
+// -----------------------------------------------------------------------------
+MapCheckRunner::MapCheckRunner(const vector<MapCheck*>& checks) :
+	checks_{ checks },
+	states_(checks.size())
+{
+	for (unsigned a = 0; a < checks_.size(); a++)
+	{
+		states_[a] = State::Waiting;
+
+		if (checks_[a]->mainThreadOnly())
+			main_queue_.push_back(a);
+		else
+			worker_queue_.push_back(a);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// MapCheckRunner class destructor
+// -----------------------------------------------------------------------------
+MapCheckRunner::~MapCheckRunner()
+{
+	cancel();
+	joinThreads();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the current state of the check at [index]
+// -----------------------------------------------------------------------------
+MapCheckRunner::State MapCheckRunner::state(unsigned index) const
+{
+	return index < states_.size() ? states_[index].load() : State::Cancelled;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the progress (0.0 - 1.0) of the check at [index]
+// -----------------------------------------------------------------------------
+float MapCheckRunner::progress(unsigned index) const
+{
+	switch (state(index))
+	{
+	case State::Waiting: return 0.f;
+	case State::Running: return checks_[index]->progress();
+	default: return 1.f;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the overall progress (0.0 - 1.0) of all checks
+// -----------------------------------------------------------------------------
+float MapCheckRunner::totalProgress() const
+{
+	if (checks_.empty())
+		return 1.f;
+
+	float total = 0.f;
+	for (unsigned a = 0; a < checks_.size(); a++)
+		total += progress(a);
+
+	return total / checks_.size();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a description of the checks currently running
+// -----------------------------------------------------------------------------
+string MapCheckRunner::progressText() const
+{
+	unsigned n_done = 0;
+	string   running;
+	for (unsigned a = 0; a < checks_.size(); a++)
+	{
+		auto check_state = state(a);
+		if (check_state == State::Done || check_state == State::Cancelled)
+			n_done++;
+		else if (check_state == State::Running && running.empty())
+			running = checks_[a]->progressText();
+	}
+
+	if (running.empty())
+		running = "Checking...";
+
+	return fmt::format("{} ({}/{} checks complete)", running, n_done, checks_.size());
+}
+
+// -----------------------------------------------------------------------------
+// Begins running the checks on [n_threads] worker threads (or the
+// map_check_threads cvar/number of cores if 0).
+// update() or wait() must then be called from the main thread to run any
+// main thread-only checks and finish up
+// -----------------------------------------------------------------------------
+void MapCheckRunner::start(unsigned n_threads)
+{
+	if (started_)
+		return;
+	started_ = true;
+
+	// Update any lazily-calculated geometry up-front, since maps are shared
+	// read-only between threads while checks are running
+	vector<SLADEMap*> maps;
+	for (auto check : checks_)
+		if (std::find(maps.begin(), maps.end(), check->map()) == maps.end())
+			maps.push_back(check->map());
+	for (auto map : maps)
+		prepareMap(map);
+
+	// Determine number of threads
+	if (n_threads == 0)
+		n_threads = map_check_threads > 0 ? map_check_threads : std::thread::hardware_concurrency();
+	n_threads = std::max<unsigned>(1, std::min<unsigned>(n_threads, worker_queue_.size()));
+
+	// Start worker threads
+	if (!worker_queue_.empty())
+		for (unsigned a = 0; a < n_threads; a++)
+			threads_.emplace_back(&MapCheckRunner::workerThread, this);
+}
+
+// -----------------------------------------------------------------------------
+// Runs the next waiting main thread-only check (if any), must be called from
+// the main thread.
+// Returns true if all checks have finished
+// -----------------------------------------------------------------------------
+bool MapCheckRunner::update()
+{
+	if (!started_)
+		start();
+
+	// Run next main thread check
+	if (next_main_check_ < main_queue_.size())
+	{
+		runCheck(main_queue_[next_main_check_++]);
+		return false;
+	}
+
+	// Check if all checks are finished
+	for (auto& check_state : states_)
+		if (check_state == State::Waiting || check_state == State::Running)
+			return false;
+
+	joinThreads();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Runs all checks, returning when they have all finished (or been cancelled).
+// Must be called from the main thread
+// -----------------------------------------------------------------------------
+void MapCheckRunner::wait()
+{
+	while (!update())
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+// -----------------------------------------------------------------------------
+// Cancels all running checks. Any checks that haven't started yet will not be
+// run
+// -----------------------------------------------------------------------------
+void MapCheckRunner::cancel()
+{
+	cancelled_ = true;
+	for (auto check : checks_)
+		check->cancel();
+}
+
+// -----------------------------------------------------------------------------
+// Calculates any lazily-cached geometry of objects in [map] that checks may
+// use (see MapCheckRunner.h), so that it can be read from worker threads
+// -----------------------------------------------------------------------------
+void MapCheckRunner::prepareMap(SLADEMap* map)
+{
+	for (unsigned a = 0; a < map->nLines(); a++)
+	{
+		auto line = map->line(a);
+		line->length();
+		line->frontVector();
+	}
+
+	for (unsigned a = 0; a < map->nSectors(); a++)
+		map->sector(a)->boundingBox();
+}
+
+// -----------------------------------------------------------------------------
+// Runs the check at [index]
+// -----------------------------------------------------------------------------
+void MapCheckRunner::runCheck(unsigned index)
+{
+	if (cancelled_)
+	{
+		states_[index] = State::Cancelled;
+		return;
+	}
+
+	states_[index] = State::Running;
+	checks_[index]->doCheck();
+	states_[index] = checks_[index]->isCancelled() ? State::Cancelled : State::Done;
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread function, runs checks from the worker queue until there are
+// none left
+// -----------------------------------------------------------------------------
+void MapCheckRunner::workerThread()
+{
+	while (true)
+	{
+		auto next = next_worker_check_++;
+		if (next >= worker_queue_.size())
+			return;
+
+		runCheck(worker_queue_[next]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Waits for all worker threads to finish
+// -----------------------------------------------------------------------------
+void MapCheckRunner::joinThreads()
+{
+	for (auto& thread : threads_)
+		if (thread.joinable())
+			thread.join();
+
+	threads_.clear();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace slade
+{
+class SLADEMap;
+class MapCheck;
+
+// Runs a set of map checks (which can be for different maps) in parallel.
+//
+// While checks are running, their maps must not be modified, and checks run on
+// worker threads may only read from them. The following are safe to use from
+// a worker:
+// - Object lists, counts and lookups (eg. SLADEMap::line, LineList::firstWithId)
+// - Object properties (MapObject::intProperty etc., including UDMF defaults
+//   from the game configuration)
+// - MapLine length/frontVector/dirTabPoint and MapSector::boundingBox, which
+//   are cached up-front by prepareMap before the workers start
+// - SLADEMap::lineSideSector
+// - Game configuration lookups (thing types, specials, features)
+//
+// Anything that lazily updates or modifies shared state is NOT safe, and
+// checks using it must be mainThreadOnly. This includes MapSector::polygon,
+// MapSector::containsPoint and SectorList::atPos (which sync the map
+// topology), the map texture manager and all check fixes
+class MapCheckRunner
+{
+public:
+	enum class State
+	{
+		Waiting,
+		Running,
+		Done,
+		Cancelled
+	};
+
+	MapCheckRunner(const vector<MapCheck*>& checks);
+	~MapCheckRunner();
+
+	unsigned nChecks() const { return checks_.size(); }
+	State    state(unsigned index) const;
+	float    progress(unsigned index) const;
+	float    totalProgress() const;
+	string   progressText() const;
+	bool     isCancelled() const { return cancelled_; }
+
+	void start(unsigned n_threads = 0);
+	bool update();
+	void wait();
+	void cancel();
+
+	static void prepareMap(SLADEMap* map);
+
+private:
+	vector<MapCheck*>          checks_;
+	vector<std::atomic<State>> states_;
+	vector<unsigned>           worker_queue_;
+	vector<unsigned>           main_queue_;
+	std::atomic<unsigned>      next_worker_check_{ 0 };
+	unsigned                   next_main_check_ = 0;
+	vector<std::thread>        threads_;
+	std::atomic<bool>          cancelled_{ false };
+	bool                       started_ = false;
+
+	void runCheck(unsigned index);
+	void workerThread();
+	void joinThreads();
+};
+} // namespace slade
@@ -78,6 +78,58 @@ std::map<MapCheck::StandardCheck, StandardCheckInfo> std_checks = {
 } // namespace
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Calls [func] with the indices (a < b) of each pair of [boxes] whose extents
+// overlap (inclusive of edges). Uses a sweep along the x axis so that only
+// boxes with overlapping x ranges are compared, rather than every pair.
+// Pairs are passed to [func] in ascending order (by a, then b)
+// -----------------------------------------------------------------------------
+template<typename F> void forEachOverlappingPair(const vector<BBox>& boxes, F func)
+{
+	// Sort box indices by left edge
+	vector<unsigned> order(boxes.size());
+	for (unsigned a = 0; a < order.size(); a++)
+		order[a] = a;
+	std::sort(
+		order.begin(), order.end(), [&boxes](unsigned a, unsigned b) { return boxes[a].min.x < boxes[b].min.x; });
+
+	// Sweep
+	vector<std::pair<unsigned, unsigned>> pairs;
+	for (unsigned a = 0; a < order.size(); a++)
+	{
+		auto& box1 = boxes[order[a]];
+
+		for (unsigned b = a + 1; b < order.size(); b++)
+		{
+			auto& box2 = boxes[order[b]];
+
+			// No further boxes can overlap on x
+			if (box2.min.x > box1.max.x)
+				break;
+
+			// Check y overlap
+			if (box2.max.y < box1.min.y || box2.min.y > box1.max.y)
+				continue;
+
+			pairs.emplace_back(std::min(order[a], order[b]), std::max(order[a], order[b]));
+		}
+	}
+
+	// Report in index order
+	std::sort(pairs.begin(), pairs.end());
+	for (auto& pair : pairs)
+		func(pair.first, pair.second);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 // MissingTextureCheck Class
 //
@@ -90,9 +142,12 @@ public:
 
 	void doCheck() override
 	{
-		string sky_flat = game::configuration().skyFlat();
+		auto sky_key = TextureName::keyOf(game::configuration().skyFlat());
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
+			if (!updateProgress(a, map_->nLines()))
+				return;
+
 			// Check what textures the line needs
 			auto line  = map_->line(a);
 			auto side1 = line->s1();
@@ -101,29 +156,30 @@ public:
 
 			// Detect if sky hack might apply
 			bool sky_hack = false;
-			if (side1 && strutil::equalCI(sky_flat, side1->sector()->ceiling().texture) && side2
-				&& strutil::equalCI(sky_flat, side2->sector()->ceiling().texture))
+			if (side1 && side1->sector()->ceiling().texture.key() == sky_key && side2
+				&& side2->sector()->ceiling().texture.key() == sky_key)
 				sky_hack = true;
 
 			// Check for missing textures (front side)
 			if (side1)
 			{
 				// Upper
-				if ((needs & MapLine::Part::FrontUpper) > 0 && side1->texUpper() == MapSide::TEX_NONE && !sky_hack)
+				if ((needs & MapLine::Part::FrontUpper) > 0 && side1->texUpperName() == MapSide::TEX_NONE_NAME
+					&& !sky_hack)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontUpper);
 				}
 
 				// Middle
-				if ((needs & MapLine::Part::FrontMiddle) > 0 && side1->texMiddle() == MapSide::TEX_NONE)
+				if ((needs & MapLine::Part::FrontMiddle) > 0 && side1->texMiddleName() == MapSide::TEX_NONE_NAME)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontMiddle);
 				}
 
 				// Lower
-				if ((needs & MapLine::Part::FrontLower) > 0 && side1->texLower() == MapSide::TEX_NONE)
+				if ((needs & MapLine::Part::FrontLower) > 0 && side1->texLowerName() == MapSide::TEX_NONE_NAME)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontLower);
@@ -134,21 +190,22 @@ public:
 			if (side2)
 			{
 				// Upper
-				if ((needs & MapLine::Part::BackUpper) > 0 && side2->texUpper() == MapSide::TEX_NONE && !sky_hack)
+				if ((needs & MapLine::Part::BackUpper) > 0 && side2->texUpperName() == MapSide::TEX_NONE_NAME
+					&& !sky_hack)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackUpper);
 				}
 
 				// Middle
-				if ((needs & MapLine::Part::BackMiddle) > 0 && side2->texMiddle() == MapSide::TEX_NONE)
+				if ((needs & MapLine::Part::BackMiddle) > 0 && side2->texMiddleName() == MapSide::TEX_NONE_NAME)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackMiddle);
 				}
 
 				// Lower
-				if ((needs & MapLine::Part::BackLower) > 0 && side2->texLower() == MapSide::TEX_NONE)
+				if ((needs & MapLine::Part::BackLower) > 0 && side2->texLowerName() == MapSide::TEX_NONE_NAME)
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackLower);
@@ -374,6 +431,9 @@ public:
 			nthings = map_->nThings();
 		for (unsigned a = 0; a < (nlines + nthings); a++)
 		{
+			if (!updateProgress(a, nlines + nthings))
+				return;
+
 			MapObject* mo        = nullptr;
 			bool       thingmode = false;
 			if (a >= nlines)
@@ -493,30 +553,30 @@ class LinesIntersectCheck : public MapCheck
 public:
 	LinesIntersectCheck(SLADEMap* map) : MapCheck(map) {}
 
-	void checkIntersections(vector<MapLine*> lines)
+	void checkIntersections(const vector<MapLine*>& lines)
 	{
-		Vec2d    pos;
-		MapLine* line1;
-		MapLine* line2;
+		Vec2d pos;
 
 		// Clear existing intersections
 		intersections_.clear();
 
-		// Go through lines
+		// Get line bounding boxes
+		vector<BBox> bboxes(lines.size());
 		for (unsigned a = 0; a < lines.size(); a++)
 		{
-			line1 = lines[a];
+			auto seg      = lines[a]->seg();
+			bboxes[a].min = { std::min(seg.x1(), seg.x2()), std::min(seg.y1(), seg.y2()) };
+			bboxes[a].max = { std::max(seg.x1(), seg.x2()), std::max(seg.y1(), seg.y2()) };
+		}
 
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < lines.size(); b++)
+		// Check intersection of lines with overlapping bounding boxes
+		forEachOverlappingPair(
+			bboxes,
+			[&](unsigned a, unsigned b)
 			{
-				line2 = lines[b];
-
-				// Check intersection
-				if (line1->intersects(line2, pos))
-					intersections_.emplace_back(line1, line2, pos.x, pos.y);
-			}
-		}
+				if (lines[a]->intersects(lines[b], pos))
+					intersections_.emplace_back(lines[a], lines[b], pos.x, pos.y);
+			});
 	}
 
 	void doCheck() override
@@ -642,22 +702,47 @@ public:
 
 	void doCheck() override
 	{
-		// Go through lines
+		// Sort lines by their (unordered) vertex pair, so that lines sharing
+		// both vertices end up next to each other
+		struct LineVerts
+		{
+			unsigned v_min;
+			unsigned v_max;
+			unsigned line;
+
+			bool operator<(const LineVerts& rhs) const
+			{
+				return std::tie(v_min, v_max, line) < std::tie(rhs.v_min, rhs.v_max, rhs.line);
+			}
+		};
+		vector<LineVerts> sorted;
+		sorted.reserve(map_->nLines());
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
-			auto line1 = map_->line(a);
+			auto line = map_->line(a);
+			auto v1   = line->v1()->index();
+			auto v2   = line->v2()->index();
+			sorted.push_back({ std::min(v1, v2), std::max(v1, v2), a });
+		}
+		std::sort(sorted.begin(), sorted.end());
 
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < map_->nLines(); b++)
+		// Go through runs of lines with the same vertices
+		vector<std::pair<unsigned, unsigned>> pairs;
+		for (unsigned a = 0; a < sorted.size(); a++)
+		{
+			for (unsigned b = a + 1; b < sorted.size(); b++)
 			{
-				auto line2 = map_->line(b);
+				if (sorted[b].v_min != sorted[a].v_min || sorted[b].v_max != sorted[a].v_max)
+					break;
 
-				// Check for overlap (both vertices shared)
-				if ((line1->v1() == line2->v1() && line1->v2() == line2->v2())
-					|| (line1->v2() == line2->v1() && line1->v1() == line2->v2()))
-					overlaps_.emplace_back(line1, line2);
+				pairs.emplace_back(sorted[a].line, sorted[b].line);
 			}
 		}
+
+		// Add overlaps in line index order
+		std::sort(pairs.begin(), pairs.end());
+		for (auto& pair : pairs)
+			overlaps_.emplace_back(map_->line(pair.first), map_->line(pair.second));
 	}
 
 	unsigned nProblems() override { return overlaps_.size(); }
@@ -747,152 +832,107 @@ public:
 
 	void doCheck() override
 	{
-		double r1, r2;
-
-		// Go through things
+		auto& config     = game::configuration();
+		auto  map_format = map_->currentFormat();
+		bool  udmf_zdoom = (map_format == MapFormat::UDMF && strutil::equalCI(config.udmfNamespace(), "zdoom"));
+		bool  udmf_eternity =
+			(map_format == MapFormat::UDMF && strutil::equalCI(config.udmfNamespace(), "eternity"));
+		int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
+		int max_skill = udmf_zdoom ? 17 : 5;
+		int max_class = udmf_zdoom ? 17 : 4;
+
+		// Get skill/class flag names
+		vector<string> skill_flags, class_flags;
+		for (int s = min_skill; s < max_skill; ++s)
+			skill_flags.push_back(fmt::format("skill{}", s));
+		for (int c = 1; c < max_class; ++c)
+			class_flags.push_back(fmt::format("class{}", c));
+
+		// Gather info for all solid things with a radius
+		vector<ThingInfo> things;
+		vector<BBox>      bboxes;
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
-			auto  thing1 = map_->thing(a);
-			auto& tt1    = game::configuration().thingType(thing1->type());
-			r1           = tt1.radius() - 1;
+			if (!updateProgress(a, map_->nThings()))
+				return;
+
+			auto   thing  = map_->thing(a);
+			auto&  tt     = config.thingType(thing->type());
+			double radius = tt.radius() - 1;
 
 			// Ignore if no radius
-			if (r1 < 0 || !tt1.solid())
+			if (radius < 0 || !tt.solid())
 				continue;
 
-			// Go through uncompared things
-			auto map_format = map_->currentFormat();
-			bool udmf_zdoom =
-				(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "zdoom"));
-			bool udmf_eternity =
-				(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "eternity"));
-			int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
-			int max_skill = udmf_zdoom ? 17 : 5;
-			int max_class = udmf_zdoom ? 17 : 4;
-
-			for (unsigned b = a + 1; b < map_->nThings(); b++)
+			ThingInfo info;
+			info.thing      = thing;
+			info.coop_start = tt.flags() & game::ThingType::Flags::CoOpStart;
+
+			// Skill and class flags (as bitmasks)
+			for (unsigned f = 0; f < skill_flags.size(); f++)
+				if (config.thingBasicFlagSet(skill_flags[f], thing, map_format))
+					info.skills |= 1 << f;
+			for (unsigned f = 0; f < class_flags.size(); f++)
+				if (config.thingBasicFlagSet(class_flags[f], thing, map_format))
+					info.classes |= 1 << f;
+
+			// Game modes
+			// Player starts
+			// P1 are automatically S and C; P2+ are automatically C;
+			// Deathmatch starts are automatically D, and team start are T.
+			if (info.coop_start)
+			{
+				info.single = thing->type() == 1;
+				info.coop   = true;
+			}
+			else if (tt.flags() & game::ThingType::Flags::DMStart)
+				info.dm = true;
+			else if (tt.flags() & game::ThingType::Flags::TeamStart)
+				info.team = true;
+			else
 			{
-				auto  thing2 = map_->thing(b);
-				auto& tt2    = game::configuration().thingType(thing2->type());
-				r2           = tt2.radius() - 1;
+				info.single = config.thingBasicFlagSet("single", thing, map_format);
+				info.coop   = config.thingBasicFlagSet("coop", thing, map_format);
+				info.dm     = config.thingBasicFlagSet("dm", thing, map_format);
+			}
 
-				// Ignore if no radius
-				if (r2 < 0 || !tt2.solid())
-					continue;
+			things.push_back(info);
 
-				// Check flags
-				// Case #1: different skill levels
-				bool shareflag = false;
-				for (int s = min_skill; s < max_skill; ++s)
-				{
-					auto skill = fmt::format("skill{}", s);
-					if (game::configuration().thingBasicFlagSet(skill, thing1, map_format)
-						&& game::configuration().thingBasicFlagSet(skill, thing2, map_format))
-					{
-						shareflag = true;
-						s         = max_skill;
-					}
-				}
-				if (!shareflag)
-					continue;
+			BBox bbox;
+			bbox.min = { thing->xPos() - radius, thing->yPos() - radius };
+			bbox.max = { thing->xPos() + radius, thing->yPos() + radius };
+			bboxes.push_back(bbox);
+		}
 
-				// Booleans for single, coop, deathmatch, and teamgame status for each thing
-				bool s1, s2, c1, c2, d1, d2, t1, t2;
-				s1 = game::configuration().thingBasicFlagSet("single", thing1, map_format);
-				s2 = game::configuration().thingBasicFlagSet("single", thing2, map_format);
-				c1 = game::configuration().thingBasicFlagSet("coop", thing1, map_format);
-				c2 = game::configuration().thingBasicFlagSet("coop", thing2, map_format);
-				d1 = game::configuration().thingBasicFlagSet("dm", thing1, map_format);
-				d2 = game::configuration().thingBasicFlagSet("dm", thing2, map_format);
-				t1 = t2 = false;
-
-				// Player starts
-				// P1 are automatically S and C; P2+ are automatically C;
-				// Deathmatch starts are automatically D, and team start are T.
-				if (tt1.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					c1 = true;
-					d1 = t1 = false;
-					if (thing1->type() == 1)
-						s1 = true;
-					else
-						s1 = false;
-				}
-				else if (tt1.flags() & game::ThingType::Flags::DMStart)
-				{
-					s1 = c1 = t1 = false;
-					d1           = true;
-				}
-				else if (tt1.flags() & game::ThingType::Flags::TeamStart)
-				{
-					s1 = c1 = d1 = false;
-					t1           = true;
-				}
-				if (tt2.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					c2 = true;
-					d2 = t2 = false;
-					if (thing2->type() == 1)
-						s2 = true;
-					else
-						s2 = false;
-				}
-				else if (tt2.flags() & game::ThingType::Flags::DMStart)
-				{
-					s2 = c2 = t2 = false;
-					d2           = true;
-				}
-				else if (tt2.flags() & game::ThingType::Flags::TeamStart)
-				{
-					s2 = c2 = d2 = false;
-					t2           = true;
-				}
+		// Check things with overlapping bounding boxes
+		forEachOverlappingPair(
+			bboxes,
+			[&](unsigned a, unsigned b)
+			{
+				auto& info1 = things[a];
+				auto& info2 = things[b];
+
+				// Case #1: different skill levels
+				if (!(info1.skills & info2.skills))
+					return;
 
 				// Case #2: different game modes (single, coop, dm)
-				shareflag = false;
-				if ((c1 && c2) || (d1 && d2) || (t1 && t2))
-				{
-					shareflag = true;
-				}
-				if (!shareflag && s1 && s2)
-				{
-					// Case #3: things flagged for single player with different class filters
-					for (int c = 1; c < max_class; ++c)
-					{
-						auto pclass = fmt::format("class{}", c);
-						if (game::configuration().thingBasicFlagSet(pclass, thing1, map_format)
-							&& game::configuration().thingBasicFlagSet(pclass, thing2, map_format))
-						{
-							shareflag = true;
-							c         = max_class;
-						}
-					}
-				}
-				if (!shareflag)
-					continue;
+				bool shareflag = (info1.coop && info2.coop) || (info1.dm && info2.dm) || (info1.team && info2.team);
 
-				// Also check player start spots in Hexen-style hubs
-				shareflag = false;
-				if (tt1.flags() & game::ThingType::Flags::CoOpStart && tt2.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					if (thing1->arg(0) == thing2->arg(0))
-						shareflag = true;
-				}
-				if (!shareflag)
-					continue;
+				// Case #3: things flagged for single player with different class filters
+				if (!shareflag && info1.single && info2.single)
+					shareflag = info1.classes & info2.classes;
 
-				// Check x non-overlap
-				if (thing2->xPos() + r2 < thing1->xPos() - r1 || thing2->xPos() - r2 > thing1->xPos() + r1)
-					continue;
+				if (!shareflag)
+					return;
 
-				// Check y non-overlap
-				if (thing2->yPos() + r2 < thing1->yPos() - r1 || thing2->yPos() - r2 > thing1->yPos() + r1)
-					continue;
+				// Also check player start spots in Hexen-style hubs
+				if (!(info1.coop_start && info2.coop_start && info1.thing->arg(0) == info2.thing->arg(0)))
+					return;
 
 				// Overlap detected
-				overlaps_.emplace_back(thing1, thing2);
-			}
-		}
+				overlaps_.emplace_back(info1.thing, info2.thing);
+			});
 	}
 
 	unsigned nProblems() override { return overlaps_.size(); }
@@ -965,6 +1005,18 @@ public:
 	}
 
 private:
+	struct ThingInfo
+	{
+		MapThing* thing      = nullptr;
+		unsigned  skills     = 0;
+		unsigned  classes    = 0;
+		bool      single     = false;
+		bool      coop       = false;
+		bool      dm         = false;
+		bool      team       = false;
+		bool      coop_start = false;
+	};
+
 	struct Overlap
 	{
 		MapThing* thing1;
@@ -985,6 +1037,10 @@ class UnknownTexturesCheck : public MapCheck
 public:
 	UnknownTexturesCheck(SLADEMap* map, MapTextureManager* texman) : MapCheck(map), texman_{ texman } {}
 
+	// Textures are looked up via the texture manager and resources, which
+	// can't be used outside the main thread
+	bool mainThreadOnly() const override { return true; }
+
 	void doCheck() override
 	{
 		bool mixed = game::configuration().featureSupported(game::Feature::MixTexFlats);
@@ -992,32 +1048,35 @@ public:
 		// Go through lines
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
+			if (!updateProgress(a, map_->nLines()))
+				return;
+
 			auto line = map_->line(a);
 
 			// Check front side textures
 			if (line->s1())
 			{
 				// Get textures
-				auto upper  = line->s1()->texUpper();
-				auto middle = line->s1()->texMiddle();
-				auto lower  = line->s1()->texLower();
+				auto& upper  = line->s1()->texUpperName();
+				auto& middle = line->s1()->texMiddleName();
+				auto& lower  = line->s1()->texLowerName();
 
 				// Upper
-				if (upper != "-" && texman_->texture(upper, mixed).gl_id == gl::Texture::missingTexture())
+				if (upper != MapSide::TEX_NONE_NAME && !texman_->textureExists(upper, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontUpper);
 				}
 
 				// Middle
-				if (middle != "-" && texman_->texture(middle, mixed).gl_id == gl::Texture::missingTexture())
+				if (middle != MapSide::TEX_NONE_NAME && !texman_->textureExists(middle, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontMiddle);
 				}
 
 				// Lower
-				if (lower != "-" && texman_->texture(lower, mixed).gl_id == gl::Texture::missingTexture())
+				if (lower != MapSide::TEX_NONE_NAME && !texman_->textureExists(lower, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::FrontLower);
@@ -1028,26 +1087,26 @@ public:
 			if (line->s2())
 			{
 				// Get textures
-				auto upper  = line->s2()->texUpper();
-				auto middle = line->s2()->texMiddle();
-				auto lower  = line->s2()->texLower();
+				auto& upper  = line->s2()->texUpperName();
+				auto& middle = line->s2()->texMiddleName();
+				auto& lower  = line->s2()->texLowerName();
 
 				// Upper
-				if (upper != "-" && texman_->texture(upper, mixed).gl_id == gl::Texture::missingTexture())
+				if (upper != MapSide::TEX_NONE_NAME && !texman_->textureExists(upper, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackUpper);
 				}
 
 				// Middle
-				if (middle != "-" && texman_->texture(middle, mixed).gl_id == gl::Texture::missingTexture())
+				if (middle != MapSide::TEX_NONE_NAME && !texman_->textureExists(middle, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackMiddle);
 				}
 
 				// Lower
-				if (lower != "-" && texman_->texture(lower, mixed).gl_id == gl::Texture::missingTexture())
+				if (lower != MapSide::TEX_NONE_NAME && !texman_->textureExists(lower, mixed))
 				{
 					lines_.push_back(line);
 					parts_.push_back(MapLine::Part::BackLower);
@@ -1166,6 +1225,10 @@ class UnknownFlatsCheck : public MapCheck
 public:
 	UnknownFlatsCheck(SLADEMap* map, MapTextureManager* texman) : MapCheck(map), texman_{ texman } {}
 
+	// Textures are looked up via the texture manager and resources, which
+	// can't be used outside the main thread
+	bool mainThreadOnly() const override { return true; }
+
 	void doCheck() override
 	{
 		bool mixed = game::configuration().featureSupported(game::Feature::MixTexFlats);
@@ -1173,15 +1236,18 @@ public:
 		// Go through sectors
 		for (unsigned a = 0; a < map_->nSectors(); a++)
 		{
+			if (!updateProgress(a, map_->nSectors()))
+				return;
+
 			// Check floor texture
-			if (texman_->flat(map_->sector(a)->floor().texture, mixed).gl_id == gl::Texture::missingTexture())
+			if (!texman_->flatExists(map_->sector(a)->floor().texture, mixed))
 			{
 				sectors_.push_back(map_->sector(a));
 				floor_.push_back(true);
 			}
 
 			// Check ceiling texture
-			if (texman_->flat(map_->sector(a)->ceiling().texture, mixed).gl_id == gl::Texture::missingTexture())
+			if (!texman_->flatExists(map_->sector(a)->ceiling().texture, mixed))
 			{
 				sectors_.push_back(map_->sector(a));
 				floor_.push_back(false);
@@ -1198,10 +1264,11 @@ public:
 
 		auto sector = sectors_[index];
 		if (floor_[index])
-			return fmt::format("Sector {} has unknown floor texture \"{}\"", sector->index(), sector->floor().texture);
+			return fmt::format(
+				"Sector {} has unknown floor texture \"{}\"", sector->index(), sector->floor().texture.str());
 		else
 			return fmt::format(
-				"Sector {} has unknown ceiling texture \"{}\"", sector->index(), sector->ceiling().texture);
+				"Sector {} has unknown ceiling texture \"{}\"", sector->index(), sector->ceiling().texture.str());
 	}
 
 	bool fixProblem(unsigned index, unsigned fix_type, MapEditContext* editor) override
@@ -1368,6 +1435,9 @@ public:
 		// Go through things
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
+			if (!updateProgress(a, map_->nThings()))
+				return;
+
 			auto  thing = map_->thing(a);
 			auto& tt    = game::configuration().thingType(thing->type());
 
@@ -1487,7 +1557,12 @@ public:
 	{
 		// Go through map lines
 		for (unsigned a = 0; a < map_->nLines(); a++)
+		{
+			if (!updateProgress(a, map_->nLines()))
+				return;
+
 			checkLine(map_->line(a));
+		}
 	}
 
 	unsigned nProblems() override { return invalid_refs_.size(); }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 namespace slade
 {
 class SLADEMap;
@@ -42,12 +44,32 @@ public:
 	virtual string     progressText() { return "Checking..."; }
 	virtual string     fixText(unsigned fix_type, unsigned index) { return ""; }
 
+	// Returns true if the check must be run on the main thread (eg. if it needs
+	// to load textures), rather than in parallel with other checks
+	virtual bool mainThreadOnly() const { return false; }
+
+	SLADEMap* map() const { return map_; }
+	float     progress() const { return progress_; }
+	bool      isCancelled() const { return cancelled_; }
+	void      cancel() { cancelled_ = true; }
+
 	static unique_ptr<MapCheck> standardCheck(StandardCheck type, SLADEMap* map, MapTextureManager* texman = nullptr);
 	static unique_ptr<MapCheck> standardCheck(string_view type_id, SLADEMap* map, MapTextureManager* texman = nullptr);
 	static string               standardCheckDesc(StandardCheck type);
 	static string               standardCheckId(StandardCheck type);
 
 protected:
-	SLADEMap* map_;
+	SLADEMap*          map_;
+	std::atomic<float> progress_{ 0.f };
+	std::atomic<bool>  cancelled_{ false };
+
+	// Sets the check progress to [current] of [total] items, returns false if
+	// the check has been cancelled
+	bool updateProgress(unsigned current, unsigned total)
+	{
+		if (total > 0)
+			progress_ = static_cast<float>(current) / total;
+		return !cancelled_;
+	}
 };
 } // namespace slade
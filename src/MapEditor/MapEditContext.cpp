@@ -34,10 +34,13 @@
 #include "Main.h"
 #include "MapEditContext.h"
 #include "App.h"
+#include "Archive/ArchiveManager.h"
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/Console.h"
 #include "General/UndoRedo.h"
+#include "MainEditor/MainEditor.h"
+#include "MapCheckRunner.h"
 #include "MapChecks.h"
 #include "MapEditor/Renderer/Overlays/InfoOverlay3d.h"
 #include "MapEditor/Renderer/Overlays/LineTextureOverlay.h"
@@ -295,8 +298,8 @@ void MapEditContext::lockMouse(bool lock)
 // -----------------------------------------------------------------------------
 bool MapEditContext::update(long frametime)
 {
-	// Force an update if animations are active
-	if (renderer_.animationsActive() || selection_.hasHilight())
+	// Force an update if animations are active or textures are loading
+	if (renderer_.animationsActive() || selection_.hasHilight() || mapeditor::textureManager().nLoading() > 0)
 		next_frame_length_ = 2;
 
 	// Ignore if we aren't ready to update
@@ -1347,7 +1350,10 @@ void MapEditContext::beginUndoRecord(string_view name, bool mod, bool create, bo
 
 	// Init map/objects for recording
 	if (undo_modified_)
+	{
 		MapObject::beginPropBackup(app::runTimer());
+		undo_gen_ = map_.mapData().generation();
+	}
 	if (undo_deleted_ || undo_created_)
 		us_create_delete_ = std::make_unique<mapeditor::MapObjectCreateDeleteUS>();
 
@@ -1386,7 +1392,7 @@ void MapEditContext::endUndoRecord(bool success)
 		bool modified        = false;
 		bool created_deleted = false;
 		if (undo_modified_)
-			modified = manager->recordUndoStep(std::make_unique<mapeditor::MultiMapObjectPropertyChangeUS>());
+			modified = manager->recordUndoStep(std::make_unique<mapeditor::MultiMapObjectPropertyChangeUS>(undo_gen_));
 		if (undo_created_ || undo_deleted_)
 		{
 			auto ustep = dynamic_cast<mapeditor::MapObjectCreateDeleteUS*>(us_create_delete_.get());
@@ -2398,11 +2404,19 @@ CONSOLE_COMMAND(m_show_item, 1, true)
 	mapeditor::editContext().showItem(index);
 }
 
-CONSOLE_COMMAND(m_check, 0, true)
+namespace
 {
+// -----------------------------------------------------------------------------
+// Returns the ids of the map checks given in console command [args] ('all' for
+// all standard checks). Prints usage and returns nothing if [args] is empty
+// -----------------------------------------------------------------------------
+vector<string> consoleCheckIds(const vector<string>& args, string_view command)
+{
+	vector<string> ids;
+
 	if (args.empty())
 	{
-		log::console("Usage: m_check <check1> <check2> ...");
+		log::console(fmt::format("Usage: {} <check1> <check2> ...", command));
 
 		log::console("Available map checks:");
 		for (auto a = 0; a < MapCheck::NumStandardChecks; ++a)
@@ -2413,47 +2427,58 @@ CONSOLE_COMMAND(m_check, 0, true)
 
 		log::console("all: Run all checks");
 
-		return;
+		return ids;
 	}
 
-	auto map    = &(mapeditor::editContext().map());
-	auto texman = &(mapeditor::textureManager());
-
-	// Get checks to run
-	vector<unique_ptr<MapCheck>> checks;
-
 	// Check for 'all'
-	bool all = false;
 	for (auto& arg : args)
 		if (strutil::equalCI(arg, "all"))
 		{
-			all = true;
-			break;
+			for (auto a = 0; a < MapCheck::NumStandardChecks; ++a)
+				ids.push_back(MapCheck::standardCheckId(static_cast<MapCheck::StandardCheck>(a)));
+			return ids;
 		}
 
-	if (all)
+	for (auto& arg : args)
 	{
+		auto id    = strutil::lower(arg);
+		bool found = false;
 		for (auto a = 0; a < MapCheck::NumStandardChecks; ++a)
-			checks.push_back(MapCheck::standardCheck(static_cast<MapCheck::StandardCheck>(a), map, texman));
-	}
-	else
-	{
-		for (auto& arg : args)
-		{
-			auto check = MapCheck::standardCheck(strutil::lower(arg), map, texman);
-			if (check)
-				checks.push_back(std::move(check));
-			else
-				log::console(fmt::format("Unknown check \"{}\"", arg));
-		}
+			if (MapCheck::standardCheckId(static_cast<MapCheck::StandardCheck>(a)) == id)
+				found = true;
+
+		if (found)
+			ids.push_back(id);
+		else
+			log::console(fmt::format("Unknown check \"{}\"", arg));
 	}
 
-	// Run checks
+	return ids;
+}
+
+// -----------------------------------------------------------------------------
+// Runs [checks] in parallel, returning when they have all finished
+// -----------------------------------------------------------------------------
+void runChecks(const vector<unique_ptr<MapCheck>>& checks)
+{
+	vector<MapCheck*> run_checks;
+	for (auto& check : checks)
+		run_checks.push_back(check.get());
+
+	auto           start_time = app::runTimer();
+	MapCheckRunner runner(run_checks);
+	runner.wait();
+	log::info(2, "Map checks took {}ms", app::runTimer() - start_time);
+}
+
+// -----------------------------------------------------------------------------
+// Lists the problems found by [checks] in the console
+// -----------------------------------------------------------------------------
+void logCheckResults(const vector<unique_ptr<MapCheck>>& checks)
+{
 	for (auto& check : checks)
 	{
-		// Run
 		log::console(check->progressText());
-		check->doCheck();
 
 		// Check if no problems found
 		if (check->nProblems() == 0)
@@ -2464,6 +2489,93 @@ CONSOLE_COMMAND(m_check, 0, true)
 			log::console(check->problemDesc(b));
 	}
 }
+} // namespace
+
+CONSOLE_COMMAND(m_check, 0, true)
+{
+	auto ids = consoleCheckIds(args, "m_check");
+	if (ids.empty())
+		return;
+
+	auto map    = &(mapeditor::editContext().map());
+	auto texman = &(mapeditor::textureManager());
+
+	// Get checks to run
+	vector<unique_ptr<MapCheck>> checks;
+	for (auto& id : ids)
+		checks.push_back(MapCheck::standardCheck(id, map, texman));
+
+	// Run checks (in parallel) and list results (in the order checks were
+	// given)
+	runChecks(checks);
+	logCheckResults(checks);
+}
+
+// -----------------------------------------------------------------------------
+// Runs map checks on every map in the current archive (using the current game
+// configuration). All maps are loaded first so that the checks for all of them
+// can be run in parallel
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(m_check_archive, 0, true)
+{
+	auto ids = consoleCheckIds(args, "m_check_archive");
+	if (ids.empty())
+		return;
+
+	auto archive = app::archiveManager().shareArchive(maineditor::currentArchive());
+	if (!archive)
+	{
+		log::console("No archive is currently open");
+		return;
+	}
+
+	// Load maps
+	MapTextureManager            texman(archive);
+	vector<unique_ptr<SLADEMap>> maps;
+	vector<string>               map_names;
+	vector<unique_ptr<MapCheck>> checks;
+	for (auto& desc : archive->detectMaps())
+	{
+		auto map = std::make_unique<SLADEMap>();
+		if (!map->readMap(desc))
+		{
+			log::console(fmt::format("Unable to open map {}: {}", desc.name, global::error));
+			continue;
+		}
+
+		for (auto& id : ids)
+			checks.push_back(MapCheck::standardCheck(id, map.get(), &texman));
+		maps.push_back(std::move(map));
+		map_names.push_back(desc.name);
+	}
+
+	if (maps.empty())
+	{
+		log::console("No maps found in the current archive");
+		return;
+	}
+
+	// Run checks for all maps (in parallel)
+	runChecks(checks);
+
+	// List results by map
+	unsigned n_problems = 0;
+	for (unsigned a = 0; a < maps.size(); a++)
+	{
+		log::console(fmt::format("Map {}:", map_names[a]));
+
+		vector<unique_ptr<MapCheck>> map_checks;
+		for (unsigned c = 0; c < ids.size(); c++)
+		{
+			auto& check = checks[a * ids.size() + c];
+			n_problems += check->nProblems();
+			map_checks.push_back(std::move(check));
+		}
+		logCheckResults(map_checks);
+	}
+
+	log::console(fmt::format("{} problem(s) found in {} map(s)", n_problems, maps.size()));
+}
 
 
 
@@ -2535,9 +2647,23 @@ CONSOLE_COMMAND(m_n_polys, 0, false)
 	SLADEMap& map   = mapeditor::editContext().map();
 	int       npoly = 0;
 	for (unsigned a = 0; a < map.nSectors(); a++)
-		npoly += map.sector(a)->polygon()->nSubPolys();
+		npoly += map.sector(a)->polygon()->nTriangles();
+
+	log::console(fmt::format("{} triangles total", npoly));
+}
+
+CONSOLE_COMMAND(m_open_timings, 0, false)
+{
+	double total = 0.;
+	for (auto& stage : mapeditor::editContext().map().openStages())
+	{
+		log::console(fmt::format(
+			"{}{}: {:1.2f}ms", stage.concurrent ? "  (concurrent) " : "", stage.name, stage.duration_ms));
+		if (!stage.concurrent)
+			total += stage.duration_ms;
+	}
 
-	log::console(fmt::format("{} polygons total", npoly));
+	log::console(fmt::format("Total: {:1.2f}ms", total));
 }
 
 CONSOLE_COMMAND(mobj_info, 1, false)
@@ -171,10 +171,11 @@ private:
 	bool                  mouse_locked_   = false;
 
 	// Undo/Redo
-	bool   undo_modified_ = false;
-	bool   undo_created_  = false;
-	bool   undo_deleted_  = false;
-	string last_undo_level_;
+	bool          undo_modified_ = false;
+	bool          undo_created_  = false;
+	bool          undo_deleted_  = false;
+	unsigned long undo_gen_      = 0;
+	string        last_undo_level_;
 
 	// Tagged items
 	vector<MapSector*> tagged_sectors_;
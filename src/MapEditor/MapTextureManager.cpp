@@ -34,6 +34,7 @@
 #include "MapTextureManager.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/EntryType/EntryType.h"
 #include "Game/Configuration.h"
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
@@ -58,8 +59,75 @@ using namespace slade;
 namespace
 {
 MapTextureManager::Texture tex_invalid;
-}
+gl::TextureAtlas::Region   region_invalid;
+} // namespace
 CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
+CVAR(Bool, map_tex_atlas, true, CVar::Flag::Save)
+CVAR(Bool, map_tex_async, true, CVar::Flag::Save)
+CVAR(Int, map_tex_upload_budget, 4, CVar::Flag::Save) // Max ms per frame to spend uploading loaded textures
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if [entry] is an image that can be decoded from its data alone
+// via the SIFormat system (fonts, raw and jaguar images need access to the
+// entry and its archive)
+// -----------------------------------------------------------------------------
+bool isPlainImage(ArchiveEntry* entry)
+{
+	// Detect entry type if it isn't already
+	if (entry->type() == EntryType::unknownType())
+		EntryType::detectEntryType(*entry);
+
+	auto type = entry->type();
+	if (!type->extraProps().contains("image"))
+		return false;
+	auto format = type->formatId();
+	return !strutil::startsWith(format, "font_") && !strutil::startsWith(format, "img_jaguar") && format != "img_raw";
+}
+
+// -----------------------------------------------------------------------------
+// Applies the scale and world panning properties of composite texture [ctex]
+// to [mtex]
+// -----------------------------------------------------------------------------
+void applyCompositeScale(MapTextureManager::Texture& mtex, const CTexture& ctex)
+{
+	double sx = ctex.scaleX();
+	if (sx == 0)
+		sx = 1.0;
+	double sy = ctex.scaleY();
+	if (sy == 0)
+		sy = 1.0;
+
+	mtex.world_panning = ctex.worldPanning();
+	mtex.scale         = { 1.0 / sx, 1.0 / sy };
+}
+
+// -----------------------------------------------------------------------------
+// Adds a copy of the image data in [entry] to [request], to be drawn at
+// [offset] if it's a composite. Returns false if the entry isn't an image or
+// needs special handling that can only be done on the main thread
+// -----------------------------------------------------------------------------
+bool addRequestImage(TextureLoader::Request& request, ArchiveEntry* entry, Vec2i offset = {})
+{
+	if (!isPlainImage(entry))
+		return false;
+
+	request.images.emplace_back();
+	auto& image       = request.images.back();
+	image.format_hint = entry->type()->extraProps().getOr<string>("image_format", {});
+	image.offset      = offset;
+	image.data.assign(entry->rawData(), entry->rawData() + entry->size());
+
+	return true;
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -111,12 +179,21 @@ Palette* MapTextureManager::resourcePalette() const
 
 // -----------------------------------------------------------------------------
 // Returns the texture matching [name], loading it from resources if necessary.
-// If [mixed] is true, flats are also searched if no matching texture is found
+// See texture(const TextureName&, bool) below
 // -----------------------------------------------------------------------------
 const MapTextureManager::Texture& MapTextureManager::texture(string_view name, bool mixed)
+{
+	return texture(TextureName{ name }, mixed);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the texture matching [name], loading it from resources if necessary.
+// If [mixed] is true, flats are also searched if no matching texture is found
+// -----------------------------------------------------------------------------
+const MapTextureManager::Texture& MapTextureManager::texture(const TextureName& name, bool mixed)
 {
 	// Get texture matching name
-	auto& mtex = textures_[strutil::upper(name)];
+	auto& mtex = textures_[name.key()];
 
 	// Get desired filter type
 	auto filter = gl::TexFilter::Linear;
@@ -144,17 +221,37 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		}
 	}
 
+	// If the texture is being loaded in the background, use the placeholder
+	// until it's ready
+	else if (mtex.loading)
+		return loadingTexture();
+
 	// Texture not found or unloaded, look for it
 
 	// Look for stand-alone textures first
 	auto archive      = archive_.lock().get();
-	auto etex         = app::resources().getTextureEntry(name, "hires", archive);
+	auto etex         = app::resources().getTextureEntry(name.str(), "hires", archive);
 	auto textypefound = CTexture::Type::HiRes;
 	if (etex == nullptr)
 	{
-		etex         = app::resources().getTextureEntry(name, "textures", archive);
+		etex         = app::resources().getTextureEntry(name.str(), "textures", archive);
 		textypefound = CTexture::Type::Texture;
 	}
+	auto ctex = app::resources().getTexture(name.str(), archive);
+
+	// Load in the background if possible (hires textures that need scaling
+	// to a reference texture are loaded here)
+	bool hires_ref = false;
+	if (!ctex && etex && textypefound == CTexture::Type::HiRes)
+		hires_ref = app::resources().getTextureEntry(name.str(), "textures", archive) != nullptr;
+	if (!hires_ref && queueLoad(mtex, name.key(), false, etex, ctex, filter))
+	{
+		if (ctex)
+			applyCompositeScale(mtex, *ctex);
+
+		return loadingTexture();
+	}
+
 	if (etex)
 	{
 		SImage image;
@@ -166,7 +263,7 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 			// Handle hires texture scale
 			if (textypefound == CTexture::Type::HiRes)
 			{
-				auto ref = app::resources().getTextureEntry(name, "textures", archive);
+				auto ref = app::resources().getTextureEntry(name.str(), "textures", archive);
 				if (ref)
 				{
 					SImage imgref;
@@ -186,7 +283,6 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 	}
 
 	// Try composite textures then
-	auto ctex = app::resources().getTexture(name, archive);
 	if (ctex) // Composite textures take precedence over the textures directory
 	{
 		textypefound = CTexture::Type::WallTexture;
@@ -194,16 +290,7 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		if (ctex->toImage(image, archive, palette_.get(), true))
 		{
 			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-			double sx = ctex->scaleX();
-			if (sx == 0)
-				sx = 1.0;
-			double sy = ctex->scaleY();
-			if (sy == 0)
-				sy = 1.0;
-
-			mtex.world_panning = ctex->worldPanning();
-			mtex.scale         = { 1.0 / sx, 1.0 / sy };
+			applyCompositeScale(mtex, *ctex);
 		}
 	}
 
@@ -223,12 +310,21 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 
 // -----------------------------------------------------------------------------
 // Returns the flat matching [name], loading it from resources if necessary.
-// If [mixed] is true, textures are also searched if no matching flat is found
+// See flat(const TextureName&, bool) below
 // -----------------------------------------------------------------------------
 const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool mixed)
+{
+	return flat(TextureName{ name }, mixed);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the flat matching [name], loading it from resources if necessary.
+// If [mixed] is true, textures are also searched if no matching flat is found
+// -----------------------------------------------------------------------------
+const MapTextureManager::Texture& MapTextureManager::flat(const TextureName& name, bool mixed)
 {
 	// Get flat matching name
-	auto& mtex = flats_[strutil::upper(name)];
+	auto& mtex = flats_[name.key()];
 
 	// Get desired filter type
 	auto filter = gl::TexFilter::Linear;
@@ -256,26 +352,22 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 		}
 	}
 
+	// If the flat is being loaded in the background, use the placeholder
+	// until it's ready
+	else if (mtex.loading)
+		return loadingTexture();
+
 	auto archive = archive_.lock().get();
 	if (mixed)
 	{
-		auto ctex = app::resources().getTexture(name, archive);
+		auto ctex = app::resources().getTexture(name.str(), archive);
 		if (ctex && ctex->isExtended() && ctex->type() != "WallTexture")
 		{
 			SImage image;
 			if (ctex->toImage(image, archive, palette_.get(), true))
 			{
 				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-				double sx = ctex->scaleX();
-				if (sx == 0)
-					sx = 1.0;
-				double sy = ctex->scaleY();
-				if (sy == 0)
-					sy = 1.0;
-
-				mtex.scale         = { 1.0 / sx, 1.0 / sy };
-				mtex.world_panning = ctex->worldPanning();
+				applyCompositeScale(mtex, *ctex);
 
 				return mtex;
 			}
@@ -286,11 +378,16 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 	// Palette8bit* pal = getResourcePalette();
 	if (!mtex.gl_id)
 	{
-		auto entry = app::resources().getTextureEntry(name, "hires", archive);
+		auto entry = app::resources().getTextureEntry(name.str(), "hires", archive);
 		if (entry == nullptr)
-			entry = app::resources().getTextureEntry(name, "flats", archive);
+			entry = app::resources().getTextureEntry(name.str(), "flats", archive);
 		if (entry == nullptr)
-			entry = app::resources().getFlatEntry(name, archive);
+			entry = app::resources().getFlatEntry(name.str(), archive);
+
+		// Load in the background if possible
+		if (queueLoad(mtex, name.key(), true, entry, nullptr, filter))
+			return loadingTexture();
+
 		if (entry)
 		{
 			SImage image;
@@ -314,6 +411,45 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 	return mtex;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if a texture matching [name] exists in the resources, without
+// loading it. If [mixed] is true, flats are also searched
+// -----------------------------------------------------------------------------
+bool MapTextureManager::textureExists(const TextureName& name, bool mixed) const
+{
+	auto archive = archive_.lock().get();
+	if (app::resources().getTextureEntry(name.str(), "hires", archive)
+		|| app::resources().getTextureEntry(name.str(), "textures", archive)
+		|| app::resources().getTexture(name.str(), archive))
+		return true;
+
+	return mixed && flatExists(name, false);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if a flat matching [name] exists in the resources, without
+// loading it. If [mixed] is true, textures are also searched
+// -----------------------------------------------------------------------------
+bool MapTextureManager::flatExists(const TextureName& name, bool mixed) const
+{
+	auto archive = archive_.lock().get();
+	if (app::resources().getTextureEntry(name.str(), "hires", archive)
+		|| app::resources().getTextureEntry(name.str(), "flats", archive)
+		|| app::resources().getFlatEntry(name.str(), archive))
+		return true;
+
+	if (mixed)
+	{
+		auto ctex = app::resources().getTexture(name.str(), archive);
+		if (ctex && ctex->isExtended() && ctex->type() != "WallTexture")
+			return true;
+
+		return textureExists(name, false);
+	}
+
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sprite matching [name], loading it from resources if necessary.
 // Sprite name also supports wildcards (?)
@@ -358,6 +494,7 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		else
 		{
 			// Otherwise, reload the texture
+			removeFromAtlas(mtex);
 			gl::Texture::clear(mtex.gl_id);
 			mtex.gl_id = 0;
 		}
@@ -385,7 +522,18 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 	if (entry)
 	{
 		found = true;
-		misc::loadImageFromEntry(&image, entry);
+
+		// Use the cached decoded image if possible
+		TextureCache::Key key;
+		bool              cacheable = isPlainImage(entry);
+		if (cacheable)
+			key.add("sprite").add(entry->type()->id()).add(entry->rawData(), entry->size());
+		if (!cacheable || !cache_.read(key, image))
+		{
+			misc::loadImageFromEntry(&image, entry);
+			if (cacheable)
+				cache_.write(key, image);
+		}
 	}
 	else // Try composite textures then
 	{
@@ -420,6 +568,7 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 
 		// Turn into GL texture
 		mtex.gl_id = gl::Texture::createFromImage(image, pal, filter, false);
+		addToAtlas(mtex, image, pal, filter);
 		return mtex;
 	}
 	else if (name.back() == '?')
@@ -481,7 +630,7 @@ int MapTextureManager::verticalOffset(string_view name) const
 // -----------------------------------------------------------------------------
 // Loads all editor images (thing icons, etc) from the program resource archive
 // -----------------------------------------------------------------------------
-void MapTextureManager::importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path) const
+void MapTextureManager::importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path)
 {
 	SImage image;
 
@@ -498,6 +647,7 @@ void MapTextureManager::importEditorImages(MapTexHashMap& map, ArchiveDir* dir,
 			log::info(4, "Loading editor texture {}", name);
 			auto& mtex = map[name];
 			mtex.gl_id = gl::Texture::createFromImage(image, nullptr, gl::TexFilter::Mipmap);
+			addToAtlas(mtex, image, nullptr, gl::TexFilter::Mipmap);
 		}
 	}
 
@@ -531,13 +681,170 @@ const MapTextureManager::Texture& MapTextureManager::editorImage(string_view nam
 	return editor_images_[strutil::toString(name)];
 }
 
+// -----------------------------------------------------------------------------
+// Uploads textures that have finished loading in the background, until the
+// map_tex_upload_budget time (ms) has been used. Any left over are uploaded on
+// the next call. Should be called once per frame (with the map editor's GL
+// context active). Returns true if any textures were uploaded
+// -----------------------------------------------------------------------------
+bool MapTextureManager::update()
+{
+	// Get finished requests
+	for (auto& request : loader_.takeFinished())
+		uploads_.push_back(std::move(request));
+	if (uploads_.empty())
+		return false;
+
+	// Upload
+	auto     start      = app::runTimer();
+	unsigned n_uploaded = 0;
+	unsigned index      = 0;
+	while (index < uploads_.size())
+	{
+		auto& request = *uploads_[index++];
+
+		// Ignore if resources were refreshed since it was queued
+		if (request.generation != load_generation_)
+			continue;
+
+		// Ignore if the texture was unloaded
+		auto& textures = request.flat ? flats_ : textures_;
+		auto  mtex     = textures.find(request.key);
+		if (mtex == textures.end() || !mtex->second.loading)
+			continue;
+
+		mtex->second.loading = false;
+		if (request.ok)
+			mtex->second.gl_id = gl::Texture::createFromImage(request.image, &request.palette, request.filter);
+		if (!mtex->second.gl_id)
+			mtex->second.gl_id = gl::Texture::missingTexture();
+		n_uploaded++;
+
+		if (app::runTimer() - start >= map_tex_upload_budget)
+			break;
+	}
+	uploads_.erase(uploads_.begin(), uploads_.begin() + index);
+
+	if (n_uploaded == 0)
+		return false;
+
+	signals_.textures_loaded();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the placeholder texture used for textures that are being loaded in
+// the background
+// -----------------------------------------------------------------------------
+const MapTextureManager::Texture& MapTextureManager::loadingTexture()
+{
+	tex_loading_.gl_id = gl::Texture::loadingTexture();
+	return tex_loading_;
+}
+
+// -----------------------------------------------------------------------------
+// Queues [mtex] (with [key]) to be loaded in the background from composite
+// texture [ctex] if given, otherwise from [entry]. Returns false if it can't
+// be loaded in the background, in which case it should be loaded immediately.
+// Only non-extended (TEXTUREx) composite textures can be built in the
+// background, since extended ones can reference other textures and need
+// resources to be accessed while they are built
+// -----------------------------------------------------------------------------
+bool MapTextureManager::queueLoad(
+	Texture&      mtex,
+	unsigned      key,
+	bool          flat,
+	ArchiveEntry* entry,
+	CTexture*     ctex,
+	gl::TexFilter filter)
+{
+	if (!map_tex_async || !gl::isInitialised())
+		return false;
+
+	auto request = std::make_unique<TextureLoader::Request>();
+	if (ctex)
+	{
+		if (ctex->isExtended())
+			return false;
+
+		auto archive = archive_.lock().get();
+		for (unsigned a = 0; a < ctex->nPatches(); a++)
+		{
+			auto patch       = ctex->patch(a);
+			auto patch_entry = patch->patchEntry(archive);
+			if (patch_entry && !addRequestImage(*request, patch_entry, { patch->xOffset(), patch->yOffset() }))
+				return false;
+		}
+
+		request->size = { ctex->width(), ctex->height() };
+		if (request->size.x == 0 || request->size.y == 0)
+			return false;
+	}
+	else if (!entry || !addRequestImage(*request, entry))
+		return false;
+
+	request->key        = key;
+	request->flat       = flat;
+	request->filter     = filter;
+	request->generation = load_generation_;
+	request->palette.copyPalette(palette_.get());
+	loader_.queue(std::move(request));
+
+	mtex.loading = true;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the region in the texture atlas for the texture with [gl_id], which
+// will be invalid if the texture isn't in the atlas.
+// Only sprites and editor images are added to the atlas, since textures and
+// flats need to be tiled
+// -----------------------------------------------------------------------------
+const gl::TextureAtlas::Region& MapTextureManager::atlasRegion(unsigned gl_id) const
+{
+	auto i = atlas_regions_.find(gl_id);
+	return i != atlas_regions_.end() ? i->second : region_invalid;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [image] for [mtex] to the texture atlas, if it's small enough and
+// atlasing is enabled
+// -----------------------------------------------------------------------------
+void MapTextureManager::addToAtlas(Texture& mtex, const SImage& image, Palette* pal, gl::TexFilter filter)
+{
+	if (!map_tex_atlas || !mtex.gl_id)
+		return;
+
+	mtex.atlas = atlas_.add(image, pal, filter);
+	if (mtex.atlas.valid())
+		atlas_regions_[mtex.gl_id] = mtex.atlas;
+}
+
+// -----------------------------------------------------------------------------
+// Removes [mtex] from the texture atlas
+// -----------------------------------------------------------------------------
+void MapTextureManager::removeFromAtlas(Texture& mtex)
+{
+	if (!mtex.atlas.valid())
+		return;
+
+	atlas_.remove(mtex.atlas);
+	atlas_regions_.erase(mtex.gl_id);
+	mtex.atlas = {};
+}
+
 // -----------------------------------------------------------------------------
 // Unloads all cached textures, flats and sprites
 // -----------------------------------------------------------------------------
 void MapTextureManager::refreshResources()
 {
 	// Just clear all cached textures
+	for (auto& sprite : sprites_)
+		removeFromAtlas(sprite.second);
 	textures_.clear();
+	load_generation_++;
+	loader_.clear();
+	uploads_.clear();
 	flats_.clear();
 	sprites_.clear();
 	theMainWindow->paletteChooser()->setGlobalFromArchive(archive_.lock().get());
@@ -1,12 +1,20 @@
 #pragma once
 
 #include "OpenGL/GLTexture.h"
+#include "OpenGL/TextureAtlas.h"
+#include "SLADEMap/TextureName.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include <unordered_map>
 
 namespace slade
 {
 class ArchiveDir;
 class Archive;
+class ArchiveEntry;
+class CTexture;
 class Palette;
+class SImage;
 
 class MapTextureManager
 {
@@ -23,12 +31,15 @@ public:
 
 	struct Texture
 	{
-		unsigned gl_id         = 0;
-		bool     world_panning = false;
-		Vec2d    scale         = { 1., 1. };
+		unsigned                 gl_id         = 0;
+		bool                     world_panning = false;
+		Vec2d                    scale         = { 1., 1. };
+		gl::TextureAtlas::Region atlas;           // Where the texture is in the atlas (if it was packed)
+		bool                     loading = false; // Being loaded in the background
 		~Texture() { gl::Texture::clear(gl_id); }
 	};
-	typedef std::map<string, Texture> MapTexHashMap;
+	typedef std::map<string, Texture>             MapTexHashMap;
+	typedef std::unordered_map<unsigned, Texture> MapTexIdMap; // Keyed by TextureName key
 
 	struct TexInfo
 	{
@@ -56,28 +67,44 @@ public:
 		}
 	};
 
+	struct Signals
+	{
+		sigslot::signal<> textures_loaded;
+	};
+
 	MapTextureManager(shared_ptr<Archive> archive = nullptr);
 	~MapTextureManager() = default;
 
+	Signals& signals() { return signals_; }
+	unsigned nLoading() const { return loader_.nQueued() + uploads_.size(); }
+
 	void init();
+	bool update();
 	void setArchive(shared_ptr<Archive> archive);
 	void refreshResources();
 	void buildTexInfoList();
 
 	Palette*       resourcePalette() const;
 	const Texture& texture(string_view name, bool mixed);
+	const Texture& texture(const TextureName& name, bool mixed);
 	const Texture& flat(string_view name, bool mixed);
+	const Texture& flat(const TextureName& name, bool mixed);
 	const Texture& sprite(string_view name, string_view translation = "", string_view palette = "");
 	const Texture& editorImage(string_view name);
 	int            verticalOffset(string_view name) const;
 
+	bool textureExists(const TextureName& name, bool mixed) const;
+	bool flatExists(const TextureName& name, bool mixed) const;
+
+	const gl::TextureAtlas::Region& atlasRegion(unsigned gl_id) const;
+
 	vector<TexInfo>& allTexturesInfo() { return tex_info_; }
 	vector<TexInfo>& allFlatsInfo() { return flat_info_; }
 
 private:
 	weak_ptr<Archive>   archive_;
-	MapTexHashMap       textures_;
-	MapTexHashMap       flats_;
+	MapTexIdMap         textures_;
+	MapTexIdMap         flats_;
 	MapTexHashMap       sprites_;
 	MapTexHashMap       editor_images_;
 	bool                editor_images_loaded_ = false;
@@ -85,10 +112,35 @@ private:
 	vector<TexInfo>     tex_info_;
 	vector<TexInfo>     flat_info_;
 
+	// Texture atlas (sprites and editor images), and atlas regions by texture id
+	gl::TextureAtlas                                       atlas_;
+	std::unordered_map<unsigned, gl::TextureAtlas::Region> atlas_regions_;
+
+	// Background loading, and on-disk cache of decoded images
+	TextureCache                               cache_{ "texture_cache" };
+	TextureLoader                              loader_{ &cache_ };
+	vector<unique_ptr<TextureLoader::Request>> uploads_;
+	unsigned                                   load_generation_ = 0;
+	Texture                                    tex_loading_;
+
+	Signals signals_;
+
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
 
-	void importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path) const;
+	void importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path);
+	void addToAtlas(Texture& mtex, const SImage& image, Palette* pal, gl::TexFilter filter);
+	void removeFromAtlas(Texture& mtex);
+
+	const Texture& loadingTexture();
+
+	bool queueLoad(
+		Texture&      mtex,
+		unsigned      key,
+		bool          flat,
+		ArchiveEntry* entry,
+		CTexture*     ctex,
+		gl::TexFilter filter);
 };
 } // namespace slade
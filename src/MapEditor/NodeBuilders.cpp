@@ -73,6 +73,16 @@ void nodebuilders::init()
 	none.name  = "Don't Build Nodes";
 	builders.push_back(none);
 
+	// Built-in node builder
+	Builder builtin;
+	builtin.id   = "builtin";
+	builtin.name = "SLADE (Built-in)";
+	builtin.options.emplace_back("fast");
+	builtin.option_desc.emplace_back("Fast mode (quicker, but less optimal nodes)");
+	builtin.options.emplace_back("extended");
+	builtin.option_desc.emplace_back("Always build ZDoom extended nodes");
+	builders.push_back(builtin);
+
 	// Get nodebuilders configuration from slade.pk3
 	auto archive = app::archiveManager().programResourceArchive();
 	auto config  = archive->entryAtPath("config/nodebuilders.cfg");
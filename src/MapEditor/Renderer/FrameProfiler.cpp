@@ -0,0 +1,526 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    FrameProfiler.cpp
+// Description: FrameProfiler class - records CPU/GPU timings of sections of
+//              map editor frames, for the on-canvas profiler graph and Chrome
+//              trace export
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "FrameProfiler.h"
+#include "App.h"
+#include "General/Console.h"
+#include "OpenGL/Drawing.h"
+#include "OpenGL/OpenGL.h"
+#include "Utility/FileUtils.h"
+
+using namespace slade;
+using namespace mapeditor;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace slade::mapeditor
+{
+FrameProfiler frame_profiler;
+} // namespace slade::mapeditor
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr int    GRAPH_WIDTH  = 240;
+constexpr int    GRAPH_HEIGHT = 64;
+constexpr double GRAPH_MS     = 40.; // Frame time at the top of the graph
+
+// -----------------------------------------------------------------------------
+// Returns the graph colour for sections named [name]
+// -----------------------------------------------------------------------------
+ColRGBA sectionColour(const char* name)
+{
+	static const ColRGBA colours[] = {
+		{ 80, 160, 255 }, { 255, 160, 60 }, { 110, 220, 110 }, { 230, 90, 90 },
+		{ 200, 120, 240 }, { 240, 220, 80 }, { 80, 220, 220 }, { 240, 130, 190 },
+	};
+
+	return colours[std::hash<string_view>{}(name) % 8];
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// FrameProfiler::Scope Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// FrameProfiler::Scope class constructor
+// -----------------------------------------------------------------------------
+FrameProfiler::Scope::Scope(const char* name, bool gpu)
+{
+	if (frame_profiler.enabled())
+		section_ = frame_profiler.beginSection(name, gpu);
+}
+
+// -----------------------------------------------------------------------------
+// FrameProfiler::Scope class destructor
+// -----------------------------------------------------------------------------
+FrameProfiler::Scope::~Scope()
+{
+	if (section_ >= 0)
+		frame_profiler.endSection(section_);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// FrameProfiler Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Begins profiling a new frame
+// -----------------------------------------------------------------------------
+void FrameProfiler::beginFrame()
+{
+	if (in_frame_)
+		return;
+
+	// Check for any GPU timings from previous frames
+	readGPUTimings();
+
+	// Reuse the oldest frame
+	if (frames_.empty())
+		frames_.resize(HISTORY);
+	current_    = n_frames_ % HISTORY;
+	auto& frame = frames_[current_];
+	releaseQueries(frame);
+	frame.sections.clear();
+	frame.number   = n_frames_++;
+	frame.start_us = clock_.getElapsedTime().asMicroseconds();
+	frame.cpu_ms   = 0.;
+	frame.complete = false;
+
+	in_frame_ = true;
+	depth_    = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Ends profiling the current frame
+// -----------------------------------------------------------------------------
+void FrameProfiler::endFrame()
+{
+	if (!in_frame_)
+		return;
+
+	auto& frame = frames_[current_];
+	frame.cpu_ms = (clock_.getElapsedTime().asMicroseconds() - frame.start_us) / 1000.;
+	in_frame_    = false;
+
+	// The frame is finished if there are no GPU timings to wait for
+	bool gpu = false;
+	for (const auto& section : frame.sections)
+		if (section.queries[0] > 0)
+			gpu = true;
+	if (!gpu)
+		finishFrame(frame);
+	else
+		readGPUTimings();
+}
+
+// -----------------------------------------------------------------------------
+// Begins timing a section of the current frame called [name], including GPU
+// time if [gpu] is true and timer queries are supported. Returns the index of
+// the section, to be passed to endSection
+// -----------------------------------------------------------------------------
+int FrameProfiler::beginSection(const char* name, bool gpu)
+{
+	auto& frame = frames_[current_];
+
+	Section section;
+	section.name  = name;
+	section.depth = depth_++;
+	section.start = (clock_.getElapsedTime().asMicroseconds() - frame.start_us) / 1000.;
+
+	// Start GPU timer
+	if (gpu && gl::timerQuerySupport())
+	{
+		for (auto& query : section.queries)
+		{
+			if (free_queries_.empty())
+				glGenQueries(1, &query);
+			else
+			{
+				query = free_queries_.back();
+				free_queries_.pop_back();
+			}
+		}
+		glQueryCounter(section.queries[0], GL_TIMESTAMP);
+	}
+
+	frame.sections.push_back(section);
+	return frame.sections.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Ends timing section [index] of the current frame
+// -----------------------------------------------------------------------------
+void FrameProfiler::endSection(int index)
+{
+	auto& frame = frames_[current_];
+	if (index >= static_cast<int>(frame.sections.size()))
+		return;
+
+	auto& section  = frame.sections[index];
+	auto  end      = (clock_.getElapsedTime().asMicroseconds() - frame.start_us) / 1000.;
+	section.cpu_ms = end - section.start;
+	depth_--;
+
+	// End GPU timer
+	if (section.queries[1] > 0)
+		glQueryCounter(section.queries[1], GL_TIMESTAMP);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the most recent frame with all timings available, or nullptr if
+// there isn't one
+// -----------------------------------------------------------------------------
+const FrameProfiler::Frame* FrameProfiler::lastCompleteFrame() const
+{
+	for (unsigned a = 0; a < frames_.size(); a++)
+	{
+		auto& frame = frames_[(current_ + HISTORY - a) % HISTORY];
+		if (frame.complete)
+			return &frame;
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Starts recording frames (for export via stopRecording)
+// -----------------------------------------------------------------------------
+void FrameProfiler::startRecording()
+{
+	recorded_.clear();
+	recording_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Stops recording frames and writes all frames recorded to [path] as a Chrome
+// trace (JSON). CPU timings are on one thread and GPU timings on another, with
+// each frame's GPU timings starting from the start of the frame.
+// Returns false if the file couldn't be written
+// -----------------------------------------------------------------------------
+bool FrameProfiler::stopRecording(string_view path)
+{
+	recording_ = false;
+
+	// GPU timings can finish out of order
+	std::sort(
+		recorded_.begin(),
+		recorded_.end(),
+		[&](const Frame& left, const Frame& right) { return left.number < right.number; });
+
+	// Thread names
+	string json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+	json += R"({"name":"thread_name","ph":"M","pid":1,"tid":1,"args":{"name":"CPU"}},)";
+	json += R"({"name":"thread_name","ph":"M","pid":1,"tid":2,"args":{"name":"GPU"}})";
+
+	// Frames
+	auto event = [&](const char* name, const char* cat, int tid, double ts, double dur) {
+		json += fmt::format(
+			R"(,{{"name":"{}","cat":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+			name,
+			cat,
+			tid,
+			ts,
+			dur);
+	};
+	for (const auto& frame : recorded_)
+	{
+		event("Frame", "frame", 1, frame.start_us, frame.cpu_ms * 1000.);
+		for (const auto& section : frame.sections)
+		{
+			event(section.name, "cpu", 1, frame.start_us + section.start * 1000., section.cpu_ms * 1000.);
+			if (section.gpu_ms >= 0)
+				event(section.name, "gpu", 2, frame.start_us + section.gpu_start * 1000., section.gpu_ms * 1000.);
+		}
+	}
+	json += "]}";
+
+	auto n_frames = recorded_.size();
+	recorded_.clear();
+	if (!fileutil::writeStringToFile(json, string{ path }))
+		return false;
+
+	log::info("Wrote {} profiled frames to {}", n_frames, path);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Draws a graph of the most recent frame times at [x,y] (in screen space),
+// with a breakdown of the last complete frame next to it
+// -----------------------------------------------------------------------------
+void FrameProfiler::drawGraph(int x, int y) const
+{
+	if (frames_.empty())
+		return;
+
+	// Get average FPS and frame times from the last 30 frames
+	int    n_avg  = 0;
+	double cpu_ms = 0.;
+	double gpu_ms = 0.;
+	auto   newest = frames_[current_].start_us;
+	auto   oldest = newest;
+	for (unsigned a = 0; a < 30 && a < n_frames_ && a < HISTORY; a++)
+	{
+		auto& frame = frames_[(current_ + HISTORY - a) % HISTORY];
+		oldest      = frame.start_us;
+		if (!frame.complete)
+			continue;
+
+		cpu_ms += frame.cpu_ms;
+		for (const auto& section : frame.sections)
+			if (section.depth == 0 && section.gpu_ms > 0)
+				gpu_ms += section.gpu_ms;
+		n_avg++;
+	}
+	double fps = newest > oldest ? (std::min<unsigned long>(n_frames_, 30) - 1) * 1000000. / (newest - oldest) : 0.;
+	if (n_avg > 0)
+	{
+		cpu_ms /= n_avg;
+		gpu_ms /= n_avg;
+	}
+
+	drawing::setTextState(true);
+	drawing::enableTextStateReset(false);
+	drawing::setTextOutline(1.0f, ColRGBA::BLACK);
+	drawing::drawText(
+		fmt::format("FPS: {:.0f}  CPU: {:.2f}ms  GPU: {:.2f}ms", fps, cpu_ms, gpu_ms),
+		x,
+		y,
+		ColRGBA::WHITE,
+		drawing::Font::Bold);
+	drawing::setTextOutline(0);
+	drawing::setTextState(false);
+	drawing::enableTextStateReset(true);
+	y += 18;
+
+	// Background
+	glDisable(GL_TEXTURE_2D);
+	glLineWidth(1.0f);
+	gl::setColour(0, 0, 0, 160, gl::Blend::Normal);
+	drawing::drawFilledRect(x, y, x + GRAPH_WIDTH, y + GRAPH_HEIGHT);
+
+	// Frame time bars (stacked top-level sections, oldest on the left)
+	double scale = GRAPH_HEIGHT / GRAPH_MS;
+	glBegin(GL_LINES);
+	for (unsigned a = 0; a < HISTORY; a++)
+	{
+		auto& frame = frames_[(current_ + 1 + a) % HISTORY];
+		if (!frame.complete)
+			continue;
+
+		double bx     = x + a * GRAPH_WIDTH / HISTORY + 0.5;
+		double bottom = y + GRAPH_HEIGHT;
+		for (const auto& section : frame.sections)
+		{
+			if (section.depth > 0)
+				continue;
+
+			double top = std::max<double>(bottom - section.cpu_ms * scale, y);
+			gl::setColour(sectionColour(section.name));
+			glVertex2d(bx, bottom);
+			glVertex2d(bx, top);
+			bottom = top;
+		}
+
+		// Time not in any section
+		gl::setColour(128, 128, 128, 255);
+		glVertex2d(bx, bottom);
+		glVertex2d(bx, std::max<double>(y + GRAPH_HEIGHT - frame.cpu_ms * scale, y));
+	}
+
+	// 60fps and 30fps lines
+	gl::setColour(255, 255, 255, 100);
+	for (auto ms : { 1000. / 60., 1000. / 30. })
+	{
+		glVertex2d(x, y + GRAPH_HEIGHT - ms * scale);
+		glVertex2d(x + GRAPH_WIDTH, y + GRAPH_HEIGHT - ms * scale);
+	}
+	glEnd();
+
+	// Breakdown of the last complete frame
+	auto frame = lastCompleteFrame();
+	if (!frame)
+		return;
+	int ty = y;
+	drawing::setTextState(true);
+	drawing::enableTextStateReset(false);
+	drawing::setTextOutline(1.0f, ColRGBA::BLACK);
+	for (const auto& section : frame->sections)
+	{
+		auto text = fmt::format("{}{}: {:.2f}ms", string(section.depth * 2, ' '), section.name, section.cpu_ms);
+		if (section.gpu_ms >= 0)
+			text += fmt::format(" (GPU {:.2f}ms)", section.gpu_ms);
+
+		auto colour = section.depth == 0 ? sectionColour(section.name) : ColRGBA{ 200, 200, 200 };
+		drawing::drawText(text, x + GRAPH_WIDTH + 8, ty, colour, drawing::Font::Small);
+		ty += 12;
+	}
+	drawing::setTextOutline(0);
+	drawing::setTextState(false);
+	drawing::enableTextStateReset(true);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the GPU timings of any previous frames that have their timer query
+// results available
+// -----------------------------------------------------------------------------
+void FrameProfiler::readGPUTimings()
+{
+	for (auto& frame : frames_)
+	{
+		if (frame.complete || frame.sections.empty() || (in_frame_ && &frame == &frames_[current_]))
+			continue;
+
+		// Check if the frame's last query result is available (queries
+		// finish in order, so the rest will be too)
+		GLuint last = 0;
+		for (const auto& section : frame.sections)
+			if (section.queries[1] > 0)
+				last = section.queries[1];
+		if (last == 0)
+			continue;
+		GLint available = 0;
+		glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		// Read timings (relative to the first GPU section in the frame)
+		GLuint64 base = 0;
+		for (auto& section : frame.sections)
+		{
+			if (section.queries[0] == 0)
+				continue;
+
+			GLuint64 start = 0;
+			GLuint64 end   = 0;
+			glGetQueryObjectui64v(section.queries[0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(section.queries[1], GL_QUERY_RESULT, &end);
+			if (base == 0)
+				base = start;
+			section.gpu_start = (start - base) / 1000000.;
+			section.gpu_ms    = end > start ? (end - start) / 1000000. : 0.;
+		}
+
+		releaseQueries(frame);
+		finishFrame(frame);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Marks [frame] as complete, and adds it to the recording if recording
+// -----------------------------------------------------------------------------
+void FrameProfiler::finishFrame(Frame& frame)
+{
+	frame.complete = true;
+	if (recording_)
+		recorded_.push_back(frame);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the timer queries used by [frame] to the free list
+// -----------------------------------------------------------------------------
+void FrameProfiler::releaseQueries(Frame& frame)
+{
+	for (auto& section : frame.sections)
+	{
+		for (auto& query : section.queries)
+		{
+			if (query > 0)
+				free_queries_.push_back(query);
+			query = 0;
+		}
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MapEditor Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the map editor frame profiler
+// -----------------------------------------------------------------------------
+FrameProfiler& mapeditor::profiler()
+{
+	return frame_profiler;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+CONSOLE_COMMAND(m_profile_start, 0, true)
+{
+	profiler().startRecording();
+	log::console("Recording map editor frame timings, use m_profile_stop [file] to stop and export them");
+}
+
+CONSOLE_COMMAND(m_profile_stop, 0, true)
+{
+	if (!profiler().recording())
+	{
+		log::console("Not recording, use m_profile_start to start");
+		return;
+	}
+
+	auto path = args.empty() ? app::path("map_profile.json", app::Dir::User) : args[0];
+	if (profiler().stopRecording(path))
+		log::console(fmt::format("Exported frame timings as a Chrome trace to {}", path));
+	else
+		log::console(fmt::format("Unable to write {}", path));
+}
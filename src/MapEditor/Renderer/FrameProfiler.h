@@ -0,0 +1,86 @@
+#pragma once
+
+namespace slade::mapeditor
+{
+// Records CPU timings (and GPU timings, where timer queries are supported) of
+// named sections of each map editor frame. The most recent frames can be
+// shown as a graph on the map canvas (map_showfps), and a recorded session
+// can be exported as a Chrome trace (for chrome://tracing or Perfetto) to
+// compare render performance between maps or versions.
+//
+// Sections are timed with a Scope and can be nested. GPU timings use
+// timestamp queries which are only read once the results are available (a
+// frame or two later), so the CPU never has to wait for the GPU
+class FrameProfiler
+{
+public:
+	// Times a section of the current frame, from construction to destruction.
+	// [name] must be a string literal (or otherwise outlive the profiler)
+	class Scope
+	{
+	public:
+		Scope(const char* name, bool gpu = false);
+		~Scope();
+
+	private:
+		int section_ = -1;
+	};
+
+	struct Section
+	{
+		const char* name;
+		int         depth;
+		double      start;          // Start time (ms, relative to the frame start)
+		double      cpu_ms    = 0.; // CPU time taken
+		double      gpu_start = 0.; // GPU start time (ms, relative to the first GPU section in the frame)
+		double      gpu_ms    = -1; // GPU time taken (< 0 if not measured)
+		unsigned    queries[2]{};   // GPU timestamp queries (start, end)
+	};
+
+	struct Frame
+	{
+		unsigned long   number   = 0;
+		int64_t         start_us = 0; // Start time (microseconds since the profiler was created)
+		double          cpu_ms   = 0.;
+		bool            complete = false; // True once all GPU timings have been read
+		vector<Section> sections;
+	};
+
+	FrameProfiler()  = default;
+	~FrameProfiler() = default;
+
+	bool enabled() const { return in_frame_; }
+	bool recording() const { return recording_; }
+
+	void         beginFrame();
+	void         endFrame();
+	int          beginSection(const char* name, bool gpu);
+	void         endSection(int index);
+	const Frame* lastCompleteFrame() const;
+
+	void startRecording();
+	bool stopRecording(string_view path);
+
+	void drawGraph(int x, int y) const;
+
+private:
+	static constexpr unsigned HISTORY = 240;
+
+	sf::Clock        clock_;
+	vector<Frame>    frames_; // Most recent frames (ring buffer of HISTORY)
+	unsigned         current_  = 0;
+	unsigned long    n_frames_ = 0;
+	bool             in_frame_ = false;
+	int              depth_    = 0;
+	vector<unsigned> free_queries_;
+
+	bool          recording_ = false;
+	vector<Frame> recorded_;
+
+	void readGPUTimings();
+	void finishFrame(Frame& frame);
+	void releaseQueries(Frame& frame);
+};
+
+FrameProfiler& profiler();
+} // namespace slade::mapeditor
@@ -0,0 +1,243 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapObjectVBO.cpp
+// Description: MapObjectVBO class - a VBO with a block of vertex data per map
+//              object, allowing changed objects to be updated individually
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapObjectVBO.h"
+#include "OpenGL/OpenGL.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// MapObjectVBO Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapObjectVBO class destructor
+// -----------------------------------------------------------------------------
+MapObjectVBO::~MapObjectVBO()
+{
+	if (vbo_ > 0)
+		glDeleteBuffers(1, &vbo_);
+}
+
+// -----------------------------------------------------------------------------
+// Removes all object blocks. The VBO itself is kept (and reused) but will be
+// fully re-uploaded next time
+// -----------------------------------------------------------------------------
+void MapObjectVBO::clear()
+{
+	data_.clear();
+	blocks_.clear();
+	free_.clear();
+	dirty_.clear();
+	free_size_   = 0;
+	full_upload_ = true;
+	layout_++;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the objects in the buffer to [ids]. Blocks of any objects not in [ids]
+// are freed, and the ids of any objects that don't have a block yet are added
+// to [added] (these need to be written)
+// -----------------------------------------------------------------------------
+void MapObjectVBO::setObjects(const vector<unsigned>& ids, vector<unsigned>& added)
+{
+	// Find new objects
+	vector<bool> present(blocks_.size());
+	for (auto id : ids)
+	{
+		if (has(id))
+			present[id] = true;
+		else
+			added.push_back(id);
+	}
+
+	// Free removed objects
+	for (unsigned id = 0; id < blocks_.size(); id++)
+		if (!present[id] && has(id))
+			remove(id);
+}
+
+// -----------------------------------------------------------------------------
+// Returns a pointer to [size] bytes of data to write to for object [id].
+// The object's existing block is reused if it is the same size, otherwise a
+// new one is allocated. The block is uploaded on the next call to upload()
+// -----------------------------------------------------------------------------
+uint8_t* MapObjectVBO::write(unsigned id, unsigned size)
+{
+	if (id >= blocks_.size())
+		blocks_.resize(id + 1);
+
+	// Allocate a new block if needed
+	auto& block = blocks_[id];
+	if (block.offset == NO_OFFSET || block.size != size)
+	{
+		remove(id);
+		block.offset = allocate(size);
+		block.size   = size;
+	}
+
+	dirty_.emplace_back(block.offset, block.offset + size);
+
+	return data_.data() + block.offset;
+}
+
+// -----------------------------------------------------------------------------
+// Frees the block for object [id]
+// -----------------------------------------------------------------------------
+void MapObjectVBO::remove(unsigned id)
+{
+	if (!has(id))
+		return;
+
+	auto& block = blocks_[id];
+	if (block.size > 0)
+	{
+		free_.push_back(block);
+		free_size_ += block.size;
+	}
+
+	block = {};
+}
+
+// -----------------------------------------------------------------------------
+// Packs all blocks together if more than a quarter of the buffer is unused.
+// Returns true if the buffer was compacted (in which case block offsets have
+// changed)
+// -----------------------------------------------------------------------------
+bool MapObjectVBO::compact()
+{
+	if (free_size_ == 0 || free_size_ <= data_.size() / 4)
+		return false;
+
+	// Copy all blocks into new data (in object id order)
+	vector<uint8_t> data;
+	data.reserve(data_.size() - free_size_);
+	for (auto& block : blocks_)
+	{
+		if (block.offset == NO_OFFSET)
+			continue;
+
+		auto offset = data.size();
+		data.insert(data.end(), data_.begin() + block.offset, data_.begin() + block.offset + block.size);
+		block.offset = offset;
+	}
+
+	data_.swap(data);
+	free_.clear();
+	dirty_.clear();
+	free_size_   = 0;
+	full_upload_ = true;
+	layout_++;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Uploads any written data to the VBO, creating or growing it if needed.
+// The VBO is left bound to GL_ARRAY_BUFFER afterwards
+// -----------------------------------------------------------------------------
+void MapObjectVBO::upload()
+{
+	if (vbo_ == 0)
+		glGenBuffers(1, &vbo_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+	// Grow if needed (with some extra space so it isn't re-allocated every
+	// time something is added)
+	if (data_.size() > capacity_)
+	{
+		capacity_ = std::max<unsigned>(data_.size() + data_.size() / 2, 4096);
+		glBufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_DYNAMIC_DRAW);
+		full_upload_ = true;
+	}
+
+	// Upload everything
+	if (full_upload_)
+	{
+		if (!data_.empty())
+			glBufferSubData(GL_ARRAY_BUFFER, 0, data_.size(), data_.data());
+
+		dirty_.clear();
+		full_upload_ = false;
+		return;
+	}
+
+	// Upload changed ranges, merging any that overlap or are adjacent
+	std::sort(dirty_.begin(), dirty_.end());
+	for (unsigned a = 0; a < dirty_.size();)
+	{
+		auto start = dirty_[a].first;
+		auto end   = dirty_[a].second;
+		for (a++; a < dirty_.size() && dirty_[a].first <= end; a++)
+			end = std::max(end, dirty_[a].second);
+
+		glBufferSubData(GL_ARRAY_BUFFER, start, end - start, data_.data() + start);
+	}
+
+	dirty_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the offset of a new block of [size] bytes, reusing the first large
+// enough free block if possible, otherwise adding it to the end of the buffer
+// -----------------------------------------------------------------------------
+unsigned MapObjectVBO::allocate(unsigned size)
+{
+	for (unsigned a = 0; a < free_.size(); a++)
+	{
+		auto& block = free_[a];
+		if (block.size < size)
+			continue;
+
+		// Use the start of the free block
+		auto offset = block.offset;
+		block.offset += size;
+		block.size -= size;
+		free_size_ -= size;
+		if (block.size == 0)
+		{
+			free_[a] = free_.back();
+			free_.pop_back();
+		}
+
+		return offset;
+	}
+
+	auto offset = data_.size();
+	data_.resize(data_.size() + size);
+	return offset;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace slade
+{
+// A VBO holding a block of vertex data for each of a set of map objects, so
+// that when objects change only their own blocks need to be re-uploaded
+// rather than the whole buffer.
+//
+// Blocks are looked up by object id rather than index, so they don't move when
+// other objects are removed from the map. Blocks of removed objects (or ones
+// that have outgrown their space) go on a free list to be reused, and once too
+// much of the buffer is unused compact() packs all blocks together again,
+// which changes their offsets (see layout()).
+//
+// A copy of the buffer data is kept in memory, so written data only needs to
+// be uploaded once per frame via upload(), and the buffer can be grown or
+// compacted without rebuilding the data
+class MapObjectVBO
+{
+public:
+	static constexpr unsigned NO_OFFSET = 0xFFFFFFFF;
+
+	MapObjectVBO() = default;
+	~MapObjectVBO();
+
+	unsigned      vbo() const { return vbo_; }
+	unsigned      size() const { return data_.size(); }
+	bool          empty() const { return data_.empty(); }
+	unsigned long layout() const { return layout_; }
+	bool          has(unsigned id) const { return id < blocks_.size() && blocks_[id].offset != NO_OFFSET; }
+	unsigned      offset(unsigned id) const { return id < blocks_.size() ? blocks_[id].offset : NO_OFFSET; }
+
+	void     clear();
+	void     setObjects(const vector<unsigned>& ids, vector<unsigned>& added);
+	uint8_t* write(unsigned id, unsigned size);
+	void     remove(unsigned id);
+	bool     compact();
+	void     upload();
+
+private:
+	struct Block
+	{
+		unsigned offset = NO_OFFSET;
+		unsigned size   = 0;
+	};
+
+	unsigned        vbo_         = 0;
+	unsigned        capacity_    = 0; // Allocated size of the VBO (bytes)
+	vector<uint8_t> data_;            // Copy of the VBO data
+	vector<Block>   blocks_;          // Block for each object, by object id
+	vector<Block>   free_;            // Unused blocks
+	unsigned        free_size_   = 0;
+	unsigned long   layout_      = 0;
+	bool            full_upload_ = true;
+
+	vector<std::pair<unsigned, unsigned>> dirty_; // Ranges (start, end) needing upload
+
+	unsigned allocate(unsigned size);
+};
+} // namespace slade
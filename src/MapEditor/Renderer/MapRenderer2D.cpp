@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "MapRenderer2D.h"
 #include "App.h"
+#include "FrameProfiler.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/ObjectEdit.h"
@@ -43,6 +44,7 @@
 #include "OpenGL/GLTexture.h"
 #include "OpenGL/OpenGL.h"
 #include "SLADEMap/SLADEMap.h"
+#include "Utility/MathStuff.h"
 #include "Utility/Polygon2D.h"
 
 using namespace slade;
@@ -80,10 +82,17 @@ CVAR(Bool, action_lines, true, CVar::Flag::Save)
 CVAR(String, arrow_pathed_color, "#22FFFF", CVar::Flag::Save)
 CVAR(String, arrow_dragon_color, "#FF2222", CVar::Flag::Save)
 CVAR(Bool, test_ssplit, false, CVar::Flag::Save)
+CVAR(Bool, map_2d_lod, true, CVar::Flag::Save)
 namespace
 {
 // Texture coordinates for rendering square things (since we can't just rotate these)
 float sq_thing_tc[] = { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f };
+
+// Size of the grid cells line ends are snapped to at each line LOD level
+unsigned lodCellSize(unsigned level)
+{
+	return 1u << (level * 2);
+}
 } // namespace
 
 
@@ -107,16 +116,12 @@ EXTERN_CVAR(Bool, use_zeth_icons)
 // -----------------------------------------------------------------------------
 MapRenderer2D::~MapRenderer2D()
 {
-	if (vbo_vertices_ > 0)
-		glDeleteBuffers(1, &vbo_vertices_);
-	if (vbo_lines_ > 0)
-		glDeleteBuffers(1, &vbo_lines_);
-	if (vbo_flats_ > 0)
-		glDeleteBuffers(1, &vbo_flats_);
 	if (list_vertices_ > 0)
 		glDeleteLists(list_vertices_, 1);
 	if (list_lines_ > 0)
 		glDeleteLists(list_lines_, 1);
+
+	clearLineTiles();
 }
 
 // -----------------------------------------------------------------------------
@@ -190,6 +195,8 @@ void MapRenderer2D::renderVertices(float alpha)
 	if (alpha <= 0.01f)
 		return;
 
+	mapeditor::FrameProfiler::Scope scope("Vertices", true);
+
 	// Setup rendering properties
 	bool point = setupVertexRendering(1.0f);
 
@@ -250,8 +257,7 @@ void MapRenderer2D::renderVerticesVBO()
 		return;
 
 	// Update vertices VBO if required
-	if (vbo_vertices_ == 0 || map_->nVertices() != n_vertices_ || map_->geometryUpdated() > vertices_updated_)
-		updateVerticesVBO();
+	updateVerticesVBO();
 
 	// Set VBO arrays to use
 	glEnableClientState(GL_VERTEX_ARRAY);
@@ -259,11 +265,11 @@ void MapRenderer2D::renderVerticesVBO()
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	// Setup VBO pointers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_.vbo());
 	glVertexPointer(2, GL_FLOAT, 0, nullptr);
 
 	// Render the VBO
-	glDrawArrays(GL_POINTS, 0, map_->nVertices());
+	glDrawElements(GL_POINTS, vertex_indices_.size(), GL_UNSIGNED_INT, vertex_indices_.data());
 
 	// Cleanup state
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -379,6 +385,8 @@ void MapRenderer2D::renderLines(bool show_direction, float alpha)
 	if (alpha <= 0.01f)
 		return;
 
+	mapeditor::FrameProfiler::Scope scope("Lines", true);
+
 	// Setup rendering properties
 	glLineWidth(line_width);
 	if (line_smooth)
@@ -457,7 +465,9 @@ void MapRenderer2D::renderLinesImmediate(bool show_direction, float alpha)
 }
 
 // -----------------------------------------------------------------------------
-// Renders map lines using an OpenGL Vertex Buffer Object
+// Renders map lines using OpenGL Vertex Buffer Objects. Only lines in tiles
+// within the view are drawn, and when zoomed out far enough merged lines from
+// a lower level of detail are drawn instead
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 {
@@ -465,10 +475,12 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 	if (map_->nLines() == 0)
 		return;
 
-	// Update lines VBO if required
-	if (vbo_lines_ == 0 || show_direction != lines_dirs_ || map_->nLines() != n_lines_
-		|| map_->geometryUpdated() > lines_updated_
-		|| map_->mapData().modifiedSince(lines_updated_, MapObject::Type::Line))
+	// Update tiles and get level of detail to draw
+	updateTiles();
+	auto level = lineLodLevel();
+
+	// Update lines VBO if required (only needed at full detail)
+	if (level == 0)
 		updateLinesVBO(show_direction, alpha);
 
 	// Disable any blending
@@ -479,24 +491,54 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 	glEnableClientState(GL_COLOR_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
-	// Setup VBO pointers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines_);
-	glVertexPointer(2, GL_FLOAT, 24, nullptr);
+	if (level == 0)
+	{
+		// Full detail, draw the lines in each visible tile from the lines VBO
+		glBindBuffer(GL_ARRAY_BUFFER, vbo_lines_.vbo());
+		glVertexPointer(2, GL_FLOAT, 24, nullptr);
+		glColorPointer(4, GL_FLOAT, 24, ((char*)nullptr + 8));
 
-	glColorPointer(4, GL_FLOAT, 24, ((char*)nullptr + 8));
+		line_tiles_[0].forEachTile(view_tl_, view_br_, [&](uint64_t key, const MapTileGrid::Tile& tile) {
+			auto& data = line_tile_data_[0][key];
+			if (data.version != tile.version || data.layout != vbo_lines_.layout() || data.indices.empty())
+			{
+				// Rebuild tile line vertex indices
+				unsigned vpl = lines_dirs_ ? 4 : 2;
+				data.indices.clear();
+				for (auto index : tile.items)
+				{
+					auto first = vbo_lines_.offset(map_->line(index)->objId()) / sizeof(GLVert);
+					for (unsigned v = 0; v < vpl; v++)
+						data.indices.push_back(first + v);
+				}
+				data.version = tile.version;
+				data.layout  = vbo_lines_.layout();
+			}
 
-	// Render the VBO
-	if (show_direction)
-		glDrawArrays(GL_LINES, 0, map_->nLines() * 4);
+			glDrawElements(GL_LINES, data.indices.size(), GL_UNSIGNED_INT, data.indices.data());
+		});
+	}
 	else
-		glDrawArrays(GL_LINES, 0, map_->nLines() * 2);
+	{
+		// Zoomed out, draw merged lines for each visible tile
+		line_tiles_[level].forEachTile(view_tl_, view_br_, [&](uint64_t key, const MapTileGrid::Tile& tile) {
+			auto& data = line_tile_data_[level][key];
+			if (data.vbo == 0 || data.version != tile.version)
+				updateLineTile(data, tile, level, alpha);
+			if (data.n_vertices == 0)
+				return;
+
+			glBindBuffer(GL_ARRAY_BUFFER, data.vbo);
+			glVertexPointer(2, GL_FLOAT, 24, nullptr);
+			glColorPointer(4, GL_FLOAT, 24, ((char*)nullptr + 8));
+			glDrawArrays(GL_LINES, 0, data.n_vertices);
+		});
+	}
 
 	// Clean state
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_COLOR_ARRAY);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	lines_dirs_ = show_direction;
 }
 
 // -----------------------------------------------------------------------------
@@ -781,39 +823,129 @@ void MapRenderer2D::renderThingOverlay(double x, double y, double radius, bool p
 }
 
 // -----------------------------------------------------------------------------
-// Renders a round thing icon at [x,y]
+// Returns the icon colour for a thing of [type] with [args]. Point lights use
+// the colour of the light
+// -----------------------------------------------------------------------------
+ColRGBA MapRenderer2D::thingColour(const game::ThingType& type, const MapObject::ArgSet& args) const
+{
+	auto arg = [&](int index) { return static_cast<uint8_t>(math::clamp(args[index], 0, 255)); };
+
+	if (type.pointLight().empty())
+		return type.colour();
+	else if (type.pointLight() == "zdoom")
+		return { arg(0), arg(1), arg(2) };
+	else if (type.pointLight() == "vavoom")
+		return { arg(1), arg(2), arg(3) };
+	else
+		return ColRGBA::WHITE;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a quad using [texture] to the thing batches, centered at [x,y] with
+// half-size [hw,hh], rotated by [angle] degrees. [tc_start] is the
+// (rotated) starting texture coordinate for square things.
+// If [texture] is in the texture atlas, the quad is added to the batch for its
+// atlas page instead
+// -----------------------------------------------------------------------------
+void MapRenderer2D::addThingQuad(
+	unsigned       texture,
+	double         x,
+	double         y,
+	double         hw,
+	double         hh,
+	double         angle,
+	const ColRGBA& colour,
+	int            tc_start)
+{
+	// Use atlas page if the texture was packed into the atlas
+	auto& region = mapeditor::textureManager().atlasRegion(texture);
+	if (region.valid())
+		texture = region.page;
+
+	// Get batch for texture
+	auto i = thing_batch_index_.find(texture);
+	if (i == thing_batch_index_.end())
+	{
+		i = thing_batch_index_.emplace(texture, thing_batches_.size()).first;
+		thing_batches_.emplace_back();
+		thing_batches_.back().texture = texture;
+	}
+	auto& vertices = thing_batches_[i->second].vertices;
+
+	// Add corners
+	double c = 1., s = 0.;
+	if (angle != 0)
+	{
+		c = cos(math::degToRad(angle));
+		s = sin(math::degToRad(angle));
+	}
+	static const double corners[] = { -1., -1., -1., 1., 1., 1., 1., -1. };
+	int                 tc        = tc_start;
+	for (int a = 0; a < 8; a += 2)
+	{
+		double cx = corners[a] * hw;
+		double cy = corners[a + 1] * hh;
+		Vec2f  uv{ sq_thing_tc[tc], sq_thing_tc[tc + 1] };
+		if (region.valid())
+			uv = region.coord(uv.x, uv.y);
+		vertices.push_back(
+			{ static_cast<float>(x + cx * c - cy * s),
+			  static_cast<float>(y + cx * s + cy * c),
+			  uv.x,
+			  uv.y,
+			  colour.r,
+			  colour.g,
+			  colour.b,
+			  colour.a });
+		tc = (tc + 2) % 8;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Draws and clears all batched thing quads
+// -----------------------------------------------------------------------------
+void MapRenderer2D::renderThingBatches()
+{
+	glEnable(GL_TEXTURE_2D);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	for (auto& batch : thing_batches_)
+	{
+		if (batch.vertices.empty())
+			continue;
+
+		gl::Texture::bind(batch.texture, false);
+		glVertexPointer(2, GL_FLOAT, sizeof(ThingVertex), &batch.vertices[0].x);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(ThingVertex), &batch.vertices[0].tx);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ThingVertex), &batch.vertices[0].r);
+		glDrawArrays(GL_QUADS, 0, batch.vertices.size());
+
+		batch.vertices.clear();
+	}
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+// -----------------------------------------------------------------------------
+// Adds a round thing icon at [x,y] to the thing batches
 // -----------------------------------------------------------------------------
-void MapRenderer2D::renderRoundThing(
+void MapRenderer2D::batchRoundThing(
 	double                   x,
 	double                   y,
 	double                   angle,
 	const game::ThingType&   type,
 	const MapObject::ArgSet& args,
 	float                    alpha,
-	double                   radius_mult) const
+	double                   radius_mult)
 {
 	// --- Determine texture to use ---
 	unsigned tex    = 0;
 	bool     rotate = false;
 
-	// Set colour
-	if (type.pointLight().empty())
-		glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
-	else if (type.pointLight() == "zdoom")
-		glColor4f(
-			static_cast<float>(args[0]) / 255.f,
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			alpha);
-	else if (type.pointLight() == "vavoom")
-		glColor4f(
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			static_cast<float>(args[3]) / 255.f,
-			alpha);
-	else
-		glColor4f(1.f, 1.f, 1.f, alpha);
-
 	// Check for custom thing icon
 	if (!type.icon().empty() && !thing_force_dir && !things_angles_)
 	{
@@ -845,43 +977,21 @@ void MapRenderer2D::renderRoundThing(
 		return;
 	}
 
-	// Bind texture
-	gl::Texture::bind(tex, false);
-
-	// Rotate if needed
-	if (rotate)
-	{
-		glPushMatrix();
-		glTranslated(x, y, 0);
-		glRotated(angle, 0, 0, 1);
-		x = y = 0;
-	}
-
-	// Draw thing
+	// Add thing
 	double radius = type.radius() * radius_mult;
 	if (type.shrinkOnZoom())
 		radius = scaledRadius(radius);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 1.0f);
-	glVertex2d(x - radius, y - radius);
-	glTexCoord2f(0.0f, 0.0f);
-	glVertex2d(x - radius, y + radius);
-	glTexCoord2f(1.0f, 0.0f);
-	glVertex2d(x + radius, y + radius);
-	glTexCoord2f(1.0f, 1.0f);
-	glVertex2d(x + radius, y - radius);
-	glEnd();
-
-	// Restore previous matrix if rotated
-	if (rotate)
-		glPopMatrix();
+	auto colour = thingColour(type, args);
+	colour.a    = alpha * 255;
+	addThingQuad(tex, x, y, radius, radius, rotate ? angle : 0, colour);
 }
 
 // -----------------------------------------------------------------------------
-// Renders a sprite thing icon at [x,y].
-// If [fitradius] is true, the sprite is drawn to fit within the thing's radius
+// Adds a sprite thing icon at [x,y] to the thing batches.
+// If [fitradius] is true, the sprite is drawn to fit within the thing's radius.
+// Returns true if the thing needs a direction arrow
 // -----------------------------------------------------------------------------
-bool MapRenderer2D::renderSpriteThing(
+bool MapRenderer2D::batchSpriteThing(
 	double                   x,
 	double                   y,
 	double                   angle,
@@ -893,15 +1003,10 @@ bool MapRenderer2D::renderSpriteThing(
 {
 	// Refresh sprites list if needed
 	if (thing_sprites_.size() != map_->nThings())
-	{
-		thing_sprites_.clear();
-		for (unsigned a = 0; a < map_->nThings(); a++)
-			thing_sprites_.push_back(0);
-	}
+		thing_sprites_.assign(map_->nThings(), 0);
 
 	// --- Determine texture to use ---
-	bool show_angle = false;
-	auto tex        = index < thing_sprites_.size() ? thing_sprites_[index] : 0;
+	auto tex = index < thing_sprites_.size() ? thing_sprites_[index] : 0;
 
 	// Attempt to get sprite texture
 	if (!tex)
@@ -919,20 +1024,13 @@ bool MapRenderer2D::renderSpriteThing(
 	if (!tex)
 	{
 		if (thing_drawtype == ThingDrawType::FramedSprite)
-			renderRoundThing(x, y, angle, type, args, alpha, 0.7);
+			batchRoundThing(x, y, angle, type, args, alpha, 0.7);
 		else
-			renderRoundThing(x, y, angle, type, args, alpha);
+			batchRoundThing(x, y, angle, type, args, alpha);
 		return false;
 	}
 
-	// Check if we have to draw the angle arrow later
-	if (type.angled() || thing_force_dir || things_angles_)
-		show_angle = true;
-
-	// Bind texture
-	gl::Texture::bind(tex, false);
-
-	// Draw thing
+	// Get sprite size
 	auto&  tex_info = gl::Texture::info(tex);
 	double hw       = tex_info.size.x * 0.5;
 	double hh       = tex_info.size.y * 0.5;
@@ -945,55 +1043,30 @@ bool MapRenderer2D::renderSpriteThing(
 		hh *= scale;
 	}
 
-	// Shadow if needed
+	// Shadow if needed (added before the sprite in the same batch, so it's
+	// drawn underneath)
 	if (thing_shadow > 0.01f && alpha >= 0.9 && !fitradius)
 	{
 		double sz = (min(hw, hh)) * 0.1;
 		if (sz < 1)
 			sz = 1;
-		glColor4f(0.0f, 0.0f, 0.0f, alpha * (thing_shadow * 0.7));
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);
-		glVertex2d(x - hw - sz, y - hh - sz);
-		glTexCoord2f(0.0f, 0.0f);
-		glVertex2d(x - hw - sz, y + hh + sz);
-		glTexCoord2f(1.0f, 0.0f);
-		glVertex2d(x + hw + sz, y + hh + sz);
-		glTexCoord2f(1.0f, 1.0f);
-		glVertex2d(x + hw + sz, y - hh - sz);
-		glEnd();
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);
-		glVertex2d(x - hw - sz, y - hh - sz - sz);
-		glTexCoord2f(0.0f, 0.0f);
-		glVertex2d(x - hw - sz, y + hh + sz);
-		glTexCoord2f(1.0f, 0.0f);
-		glVertex2d(x + hw + sz + sz, y + hh + sz);
-		glTexCoord2f(1.0f, 1.0f);
-		glVertex2d(x + hw + sz + sz, y - hh - sz - sz);
-		glEnd();
+		ColRGBA shadow(0, 0, 0, alpha * (thing_shadow * 0.7) * 255);
+		addThingQuad(tex, x, y, hw + sz, hh + sz, 0, shadow);
+		addThingQuad(tex, x + sz * 0.5, y - sz * 0.5, hw + sz * 1.5, hh + sz * 1.5, 0, shadow);
 	}
-	// Draw thing
-	glColor4f(1.0f, 1.0f, 1.0f, alpha);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 1.0f);
-	glVertex2d(x - hw, y - hh);
-	glTexCoord2f(0.0f, 0.0f);
-	glVertex2d(x - hw, y + hh);
-	glTexCoord2f(1.0f, 0.0f);
-	glVertex2d(x + hw, y + hh);
-	glTexCoord2f(1.0f, 1.0f);
-	glVertex2d(x + hw, y - hh);
-	glEnd();
 
+	// Add thing
+	addThingQuad(tex, x, y, hw, hh, 0, ColRGBA(255, 255, 255, alpha * 255));
 
-	return show_angle;
+	// Check if we have to draw the angle arrow later
+	return type.angled() || thing_force_dir || things_angles_;
 }
 
 // -----------------------------------------------------------------------------
-// Renders a square thing icon at [x,y]
+// Adds a square thing icon at [x,y] to the thing batches.
+// Returns true if the thing needs a direction arrow
 // -----------------------------------------------------------------------------
-bool MapRenderer2D::renderSquareThing(
+bool MapRenderer2D::batchSquareThing(
 	double                   x,
 	double                   y,
 	double                   angle,
@@ -1001,29 +1074,11 @@ bool MapRenderer2D::renderSquareThing(
 	const MapObject::ArgSet& args,
 	float                    alpha,
 	bool                     showicon,
-	bool                     framed) const
+	bool                     framed)
 {
 	// --- Determine texture to use ---
 	unsigned tex = 0;
 
-	// Set colour
-	if (type.pointLight().empty())
-		glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
-	else if (type.pointLight() == "zdoom")
-		glColor4f(
-			static_cast<float>(args[0]) / 255.f,
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			alpha);
-	else if (type.pointLight() == "vavoom")
-		glColor4f(
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			static_cast<float>(args[3]) / 255.f,
-			alpha);
-	else
-		glColor4f(1.f, 1.f, 1.f, alpha);
-
 	// Show icon anyway if no sprite set
 	if (type.sprite().empty())
 		showicon = true;
@@ -1092,33 +1147,13 @@ bool MapRenderer2D::renderSquareThing(
 		return false;
 	}
 
-	// Bind texture
-	gl::Texture::bind(tex, false);
-
-	// Draw thing
+	// Add thing
 	double radius = type.radius();
 	if (type.shrinkOnZoom())
 		radius = scaledRadius(radius);
-	glBegin(GL_QUADS);
-	int tc = tc_start;
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc + 1]);
-	tc += 2;
-	if (tc == 8)
-		tc = 0;
-	glVertex2d(x - radius, y - radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc + 1]);
-	tc += 2;
-	if (tc == 8)
-		tc = 0;
-	glVertex2d(x - radius, y + radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc + 1]);
-	tc += 2;
-	if (tc == 8)
-		tc = 0;
-	glVertex2d(x + radius, y + radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc + 1]);
-	glVertex2d(x + radius, y - radius);
-	glEnd();
+	auto colour = thingColour(type, args);
+	colour.a    = alpha * 255;
+	addThingQuad(tex, x, y, radius, radius, 0, colour, tc_start);
 
 	return ((type.angled() || thing_force_dir || things_angles_) && !showicon);
 }
@@ -1141,6 +1176,7 @@ void MapRenderer2D::renderSimpleSquareThing(
 	double radius2 = radius * 0.1;
 
 	// Move to thing position
+	glDisable(GL_TEXTURE_2D);
 	glPushMatrix();
 	glTranslated(x, y, 0);
 
@@ -1154,22 +1190,8 @@ void MapRenderer2D::renderSimpleSquareThing(
 	glEnd();
 
 	// Set colour
-	if (type.pointLight().empty())
-		glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
-	else if (type.pointLight() == "zdoom")
-		glColor4f(
-			static_cast<float>(args[0]) / 255.f,
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			alpha);
-	else if (type.pointLight() == "vavoom")
-		glColor4f(
-			static_cast<float>(args[1]) / 255.f,
-			static_cast<float>(args[2]) / 255.f,
-			static_cast<float>(args[3]) / 255.f,
-			alpha);
-	else
-		glColor4f(1.f, 1.f, 1.f, alpha);
+	auto colour = thingColour(type, args);
+	glColor4f(colour.fr(), colour.fg(), colour.fb(), alpha);
 
 	// Draw base
 	glBegin(GL_QUADS);
@@ -1192,6 +1214,7 @@ void MapRenderer2D::renderSimpleSquareThing(
 
 	// Restore previous matrix
 	glPopMatrix();
+	glEnable(GL_TEXTURE_2D);
 }
 
 // -----------------------------------------------------------------------------
@@ -1203,51 +1226,37 @@ void MapRenderer2D::renderThings(float alpha, bool force_dir)
 	if (alpha <= 0.01f)
 		return;
 
+	mapeditor::FrameProfiler::Scope scope("Things", true);
+
 	things_angles_ = force_dir;
-	renderThingsImmediate(alpha);
+	renderThingsBatched(alpha);
 }
 
 // -----------------------------------------------------------------------------
-// Renders map things in immediate mode
+// Renders map things in batches. Each layer (shadows, things, sprites within
+// squares and direction arrows) is built as quads grouped by texture, and
+// each group is drawn in one call
 // -----------------------------------------------------------------------------
-void MapRenderer2D::renderThingsImmediate(float alpha)
+void MapRenderer2D::renderThingsBatched(float alpha)
 {
-	// Display lists aren't really good for this, better to check for
-	// visibility and just render things in immediate mode
-
-	// Enable textures
-	glEnable(GL_TEXTURE_2D);
-	glColor4f(1.0f, 1.0f, 1.0f, alpha);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Go through things
-	MapThing*   thing;
-	double      x, y, angle;
-	vector<int> things_arrows;
-	long        last_update = thing_sprites_updated_;
+	MapThing*        thing;
+	double           x, y, angle;
+	vector<unsigned> things_arrows;
+	long             last_update = thing_sprites_updated_;
 
 	// Draw thing shadows if needed
 	if (thing_shadow > 0.01f && thing_drawtype != ThingDrawType::Sprite)
 	{
-		glEnable(GL_TEXTURE_2D);
 		auto tex_shadow = mapeditor::textureManager().editorImage("thing/shadow").gl_id;
 		if (thing_drawtype == ThingDrawType::Square || thing_drawtype == ThingDrawType::SquareSprite
 			|| thing_drawtype == ThingDrawType::FramedSprite)
 			tex_shadow = mapeditor::textureManager().editorImage("thing/square/shadow").gl_id;
 		if (tex_shadow)
 		{
-			gl::Texture::bind(tex_shadow);
-			glColor4f(0.0f, 0.0f, 0.0f, alpha * thing_shadow);
-
-			// Setup point sprites if supported
-			bool point = false;
-			if (gl::pointSpriteSupport())
-			{
-				glEnable(GL_POINT_SPRITE);
-				glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
-				point = true;
-			}
-
+			ColRGBA shadow(0, 0, 0, alpha * thing_shadow * 255);
 			for (unsigned a = 0; a < map_->nThings(); a++)
 			{
 				if (vis_t_[a] > 0)
@@ -1264,44 +1273,16 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 				if (tt.shrinkOnZoom())
 					radius = scaledRadius(radius);
 				radius *= 1.3;
-				x = thing->xPos();
-				y = thing->yPos();
 
-				// Draw shadow
-				if (point && radius * 2 * view_scale_ <= gl::maxPointSize())
-				{
-					// Point sprite
-					glPointSize(radius * 2 * view_scale_);
-					glBegin(GL_POINTS);
-					glVertex2d(x, y);
-					glEnd();
-				}
-				else
-				{
-					// Textured quad
-					if (point)
-						glDisable(GL_POINT_SPRITE);
-					glBegin(GL_QUADS);
-					glTexCoord2f(0.0f, 1.0f);
-					glVertex2d(x - radius, y - radius);
-					glTexCoord2f(0.0f, 0.0f);
-					glVertex2d(x - radius, y + radius);
-					glTexCoord2f(1.0f, 0.0f);
-					glVertex2d(x + radius, y + radius);
-					glTexCoord2f(1.0f, 1.0f);
-					glVertex2d(x + radius, y - radius);
-					glEnd();
-					if (point)
-						glEnable(GL_POINT_SPRITE);
-				}
+				addThingQuad(tex_shadow, thing->xPos(), thing->yPos(), radius, radius, 0, shadow);
 			}
 
-			if (point)
-				glDisable(GL_POINT_SPRITE);
+			renderThingBatches();
 		}
 	}
 
 	// Draw things
+	glEnable(GL_TEXTURE_2D);
 	double talpha;
 	for (unsigned a = 0; a < map_->nThings(); a++)
 	{
@@ -1327,18 +1308,18 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 		if (thing->modifiedTime() > last_update && thing_sprites_.size() > a)
 			thing_sprites_[a] = 0;
 
-		// Draw thing depending on 'things_drawtype' cvar
+		// Add thing depending on 'things_drawtype' cvar
 		if (thing_drawtype == ThingDrawType::Sprite) // Drawtype 2: Sprites
 		{
 			// Check if we need to draw the direction arrow for this thing
-			if (renderSpriteThing(x, y, angle, tt, thing->args(), a, talpha))
+			if (batchSpriteThing(x, y, angle, tt, thing->args(), a, talpha))
 				things_arrows.push_back(a);
 		}
 		else if (thing_drawtype == ThingDrawType::Round) // Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, thing->args(), talpha);
+			batchRoundThing(x, y, angle, tt, thing->args(), talpha);
 		else // Drawtype 0 (or other): Square
 		{
-			if (renderSquareThing(
+			if (batchSquareThing(
 					x,
 					y,
 					angle,
@@ -1350,12 +1331,11 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 				things_arrows.push_back(a);
 		}
 	}
+	renderThingBatches();
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > ThingDrawType::Sprite)
 	{
-		glEnable(GL_TEXTURE_2D);
-
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
 			if (vis_t_[a] > 0)
@@ -1364,8 +1344,6 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 			// Get thing info
 			thing    = map_->thing(a);
 			auto& tt = game::configuration().thingType(thing->type());
-			x        = thing->xPos();
-			y        = thing->yPos();
 
 			if (thing_drawtype == ThingDrawType::SquareSprite && tt.sprite().empty())
 				continue;
@@ -1376,56 +1354,39 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 			else
 				talpha = alpha;
 
-			renderSpriteThing(x, y, thing->angle(), tt, thing->args(), a, talpha, true);
+			batchSpriteThing(thing->xPos(), thing->yPos(), thing->angle(), tt, thing->args(), a, talpha, true);
 		}
+
+		renderThingBatches();
 	}
 
 	// Draw any thing direction arrows needed
 	if (!things_arrows.empty())
 	{
-		auto acol = ColRGBA::WHITE;
-		acol.a    = 255 * alpha * arrow_alpha;
-		gl::setColour(acol);
-		// glColor4f(1.0f, 1.0f, 1.0f, alpha * arrow_alpha);
 		auto tex_arrow = mapeditor::textureManager().editorImage("arrow").gl_id;
 		if (tex_arrow)
 		{
-			glEnable(GL_TEXTURE_2D);
-			gl::Texture::bind(tex_arrow);
-
-			for (int things_arrow : things_arrows)
+			auto acol = ColRGBA::WHITE;
+			acol.a    = 255 * alpha * arrow_alpha;
+			for (auto index : things_arrows)
 			{
-				thing = map_->thing(things_arrow);
+				thing = map_->thing(index);
+
+				auto col = acol;
 				if (arrow_colour)
 				{
 					auto& tt = game::configuration().thingType(thing->type());
 					if (tt.defined())
 					{
-						acol.set(tt.colour());
-						acol.a = 255 * alpha * arrow_alpha;
-						gl::setColour(acol);
+						col.set(tt.colour());
+						col.a = acol.a;
 					}
 				}
-				x = thing->xPos();
-				y = thing->yPos();
-
-				glPushMatrix();
-				glTranslated(x, y, 0);
-				glRotated(thing->angle(), 0, 0, 1);
-
-				glBegin(GL_QUADS);
-				glTexCoord2f(0.0f, 1.0f);
-				glVertex2d(-32, -32);
-				glTexCoord2f(0.0f, 0.0f);
-				glVertex2d(-32, 32);
-				glTexCoord2f(1.0f, 0.0f);
-				glVertex2d(32, 32);
-				glTexCoord2f(1.0f, 1.0f);
-				glVertex2d(32, -32);
-				glEnd();
 
-				glPopMatrix();
+				addThingQuad(tex_arrow, thing->xPos(), thing->yPos(), 32, 32, thing->angle(), col);
 			}
+
+			renderThingBatches();
 		}
 	}
 
@@ -1947,6 +1908,8 @@ void MapRenderer2D::renderFlats(int type, bool texture, float alpha)
 	if (alpha <= 0.01f)
 		return;
 
+	mapeditor::FrameProfiler::Scope scope("Flats", true);
+
 	if (gl::vboSupport() && flats_use_vbo)
 		renderFlatsVBO(type, texture, alpha);
 	else
@@ -1993,8 +1956,9 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 	}
 
 	// Go through sectors
-	unsigned tex_last = 0;
-	unsigned tex      = 0;
+	unsigned tex_last    = 0;
+	unsigned tex         = 0;
+	unsigned tex_loading = gl::Texture::loadingTexture(); // Re-check flats still loading in the background
 	for (unsigned a = 0; a < map_->nSectors(); a++)
 	{
 		auto sector = map_->sector(a);
@@ -2006,7 +1970,7 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 		const MapTextureManager::Texture* map_tex_props = nullptr;
 		if (texture)
 		{
-			if (!tex_flats_[a] || sector->modifiedTime() > flats_updated_ - 100)
+			if (!tex_flats_[a] || tex_flats_[a] == tex_loading || sector->modifiedTime() > flats_updated_ - 100)
 			{
 				// Get the sector texture
 				bool mix_tex_flats = game::configuration().featureSupported(Feature::MixTexFlats);
@@ -2109,8 +2073,6 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 	using game::Feature;
 	using game::UDMFFeature;
 
-	bool vbo_updated = false;
-
 	if (flat_ignore_light)
 		glColor4f(flat_brightness, flat_brightness, flat_brightness, alpha);
 
@@ -2131,37 +2093,23 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		last_flat_type_ = type;
 	}
 
-	// First, check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
-	for (unsigned a = 0; a < map_->nSectors(); a++)
-	{
-		auto poly = map_->sector(a)->polygon();
-		if (poly && poly->vboUpdate() > 1)
-		{
-			updateFlatsVBO();
-			vbo_updated = true;
-		}
-	}
-
-	// Create VBO if necessary
-	if (!vbo_updated && vbo_flats_ == 0)
-	{
-		updateFlatsVBO();
-		vbo_updated = true;
-	}
+	// Update the VBO with any new or changed polygons
+	updateFlatsVBO();
 
 	// Setup opengl state
 	if (texture)
 		glEnable(GL_TEXTURE_2D);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats_.vbo());
 
 	// Setup VBO pointers
 	Polygon2D::setupVBOPointers();
 
 	// Go through sectors
-	unsigned tex_last = 0;
-	unsigned tex      = 0;
-	bool     first    = true;
-	unsigned update   = 0;
+	unsigned tex_last    = 0;
+	unsigned tex         = 0;
+	unsigned tex_loading = gl::Texture::loadingTexture(); // Re-check flats still loading in the background
+	bool     first       = true;
+	unsigned update      = 0;
 	for (unsigned a = 0; a < map_->nSectors(); a++)
 	{
 		auto sector = map_->sector(a);
@@ -2174,7 +2122,7 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		const MapTextureManager::Texture* map_tex_props = nullptr;
 		if (texture)
 		{
-			if (!tex_flats_[a] || sector->modifiedTime() > flats_updated_ - 100)
+			if (!tex_flats_[a] || tex_flats_[a] == tex_loading || sector->modifiedTime() > flats_updated_ - 100)
 			{
 				// Get the sector texture
 				bool mix_tex_flats = game::configuration().featureSupported(Feature::MixTexFlats);
@@ -2246,15 +2194,27 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 			poly->updateTextureCoords(sx, sy, ox, oy, rot);
 		}
 
-		// Update polygon VBO data if needed
-		if (poly->vboUpdate() > 0)
+		// Update polygon VBO data if the texture coordinates changed
+		auto& vbo_data = flat_vbo_data_[sector->objId()];
+		if (vbo_data.texture != poly->texture())
 		{
-			poly->updateVBOData();
+			writeFlatVBO(sector);
+			vbo_flats_.upload();
 			update++;
 			if (update > 200)
 				break;
 		}
 
+		// Offset triangles to the polygon's location in the VBO if needed
+		unsigned base = vbo_flats_.offset(sector->objId()) / sizeof(Polygon2D::Vertex);
+		if (vbo_data.indices.size() != poly->indices().size() || vbo_data.base != base)
+		{
+			vbo_data.indices = poly->indices();
+			for (auto& index : vbo_data.indices)
+				index += base;
+			vbo_data.base = base;
+		}
+
 		// Bind the texture if needed
 		if (tex)
 		{
@@ -2274,7 +2234,8 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 			col.ampf(flat_brightness, flat_brightness, flat_brightness, 1.0f);
 			glColor4f(col.fr(), col.fg(), col.fb(), alpha);
 		}
-		poly->renderVBO(false);
+		if (!vbo_data.indices.empty())
+			glDrawElements(GL_TRIANGLES, vbo_data.indices.size(), GL_UNSIGNED_INT, vbo_data.indices.data());
 	}
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -2707,11 +2668,11 @@ void MapRenderer2D::renderMovingThings(const vector<mapeditor::Item>& things, Ve
 
 		// Draw thing depending on 'things_drawtype' cvar
 		if (thing_drawtype == ThingDrawType::Sprite) // Drawtype 2: Sprites
-			renderSpriteThing(x, y, angle, tt, thing->args(), a, 1.0f);
+			batchSpriteThing(x, y, angle, tt, thing->args(), a, 1.0f);
 		else if (thing_drawtype == ThingDrawType::Round) // Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, thing->args(), 1.0f);
+			batchRoundThing(x, y, angle, tt, thing->args(), 1.0f);
 		else // Drawtype 0 (or other): Square
-			renderSquareThing(
+			batchSquareThing(
 				x,
 				y,
 				angle,
@@ -2721,6 +2682,7 @@ void MapRenderer2D::renderMovingThings(const vector<mapeditor::Item>& things, Ve
 				thing_drawtype < ThingDrawType::SquareSprite,
 				thing_drawtype == ThingDrawType::FramedSprite);
 	}
+	renderThingBatches();
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > ThingDrawType::Sprite)
@@ -2737,9 +2699,10 @@ void MapRenderer2D::renderMovingThings(const vector<mapeditor::Item>& things, Ve
 				y        = thing->yPos() + move_vec.y;
 				angle    = thing->angle();
 
-				renderSpriteThing(x, y, angle, tt, thing->args(), item.index, 1.0f, true);
+				batchSpriteThing(x, y, angle, tt, thing->args(), item.index, 1.0f, true);
 			}
 		}
+		renderThingBatches();
 	}
 
 	// Set 'moving' colour
@@ -2797,11 +2760,11 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, Vec2d pos)
 
 		// Draw thing depending on 'things_drawtype' cvar
 		if (thing_drawtype == ThingDrawType::Sprite) // Drawtype 2: Sprites
-			renderSpriteThing(x, y, angle, tt, thing->args(), wxUINT32_MAX, 1.0f);
+			batchSpriteThing(x, y, angle, tt, thing->args(), wxUINT32_MAX, 1.0f);
 		else if (thing_drawtype == ThingDrawType::Round) // Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, thing->args(), 1.0f);
+			batchRoundThing(x, y, angle, tt, thing->args(), 1.0f);
 		else // Drawtype 0 (or other): Square
-			renderSquareThing(
+			batchSquareThing(
 				x,
 				y,
 				angle,
@@ -2811,6 +2774,7 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, Vec2d pos)
 				thing_drawtype < ThingDrawType::SquareSprite,
 				thing_drawtype == ThingDrawType::FramedSprite);
 	}
+	renderThingBatches();
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > ThingDrawType::Sprite)
@@ -2825,8 +2789,9 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, Vec2d pos)
 			y        = thing->yPos() + pos.y;
 			angle    = thing->angle();
 
-			renderSpriteThing(x, y, angle, tt, thing->args(), wxUINT32_MAX, 1.0f, true);
+			batchSpriteThing(x, y, angle, tt, thing->args(), wxUINT32_MAX, 1.0f, true);
 		}
+		renderThingBatches();
 	}
 
 	// Set 'drawing' colour
@@ -2945,11 +2910,11 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 
 			// Draw thing depending on 'things_drawtype' cvar
 			if (thing_drawtype == ThingDrawType::Sprite) // Drawtype 2: Sprites
-				renderSpriteThing(x, y, angle, tt, thing->args(), thing->index(), 1.0f);
+				batchSpriteThing(x, y, angle, tt, thing->args(), thing->index(), 1.0f);
 			else if (thing_drawtype == ThingDrawType::Round) // Drawtype 1: Round
-				renderRoundThing(x, y, angle, tt, thing->args(), 1.0f);
+				batchRoundThing(x, y, angle, tt, thing->args(), 1.0f);
 			else // Drawtype 0 (or other): Square
-				renderSquareThing(
+				batchSquareThing(
 					x,
 					y,
 					angle,
@@ -2959,6 +2924,7 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 					thing_drawtype < ThingDrawType::SquareSprite,
 					thing_drawtype == ThingDrawType::FramedSprite);
 		}
+		renderThingBatches();
 
 		// Draw thing sprites within squares if that drawtype is set
 		if (thing_drawtype > ThingDrawType::Sprite)
@@ -2974,8 +2940,9 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 				y        = item.position.y;
 				angle    = thing->angle();
 
-				renderSpriteThing(x, y, angle, tt, thing->args(), thing->index(), 1.0f, true);
+				batchSpriteThing(x, y, angle, tt, thing->args(), thing->index(), 1.0f, true);
 			}
+			renderThingBatches();
 		}
 
 		// Set 'object edit' colour
@@ -3008,205 +2975,276 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the map vertices VBO
+// Updates the map vertices VBO with any vertices added, removed or modified
+// since the last update
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateVerticesVBO()
 {
-	// Create VBO if needed
-	if (vbo_vertices_ == 0)
-		glGenBuffers(1, &vbo_vertices_);
+	auto& data = map_->mapData();
+	if (!vbo_vertices_.empty() && data.generation() == vertices_gen_)
+		return;
+
+	mapeditor::FrameProfiler::Scope scope("Vertices VBO update");
+
+	// Update the vertices in the VBO if any were added or removed
+	bool list_changed = vbo_vertices_.empty() || data.listGeneration(MapObject::Type::Vertex) != vertices_list_gen_;
 
-	// Fill vertices VBO
-	int             nfloats = map_->nVertices() * 2;
-	vector<GLfloat> verts(nfloats);
-	unsigned        i = 0;
-	for (unsigned a = 0; a < map_->nVertices(); a++)
+	vector<unsigned> dirty;
+	if (list_changed)
 	{
-		verts[i++] = map_->vertex(a)->xPos();
-		verts[i++] = map_->vertex(a)->yPos();
+		vector<unsigned> ids;
+		data.putObjectIdList(MapObject::Type::Vertex, ids);
+		vbo_vertices_.setObjects(ids, dirty);
+		vbo_vertices_.compact();
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * nfloats, verts.data(), GL_STATIC_DRAW);
 
-	// Clean up
+	// Write new and modified vertices
+	for (auto object : data.modifiedObjectsSinceGen(vertices_gen_, MapObject::Type::Vertex))
+		dirty.push_back(object->objId());
+	std::sort(dirty.begin(), dirty.end());
+	dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+	for (auto id : dirty)
+	{
+		auto vertex = dynamic_cast<MapVertex*>(data.getObjectById(id));
+		auto pos    = reinterpret_cast<GLfloat*>(vbo_vertices_.write(id, sizeof(GLfloat) * 2));
+		pos[0]      = vertex->xPos();
+		pos[1]      = vertex->yPos();
+	}
+
+	// Upload
+	vbo_vertices_.upload();
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	n_vertices_       = map_->nVertices();
-	vertices_updated_ = app::runTimer();
+	// Update vertex indices if the vertex list changed
+	if (list_changed)
+	{
+		vertex_indices_.clear();
+		for (auto vertex : map_->vertices())
+			vertex_indices_.push_back(vbo_vertices_.offset(vertex->objId()) / (sizeof(GLfloat) * 2));
+	}
+
+	n_vertices_        = map_->nVertices();
+	vertices_gen_      = data.generation();
+	vertices_list_gen_ = data.listGeneration(MapObject::Type::Vertex);
+	vertices_updated_  = app::runTimer();
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the map lines VBO
+// Updates the map lines VBO with any lines added, removed or modified since
+// the last update (including lines attached to modified vertices or sides).
+// All lines are rewritten if [show_direction] has changed
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 {
-	log::info(3, "Updating lines VBO");
-
-	// Create VBO if needed
-	if (vbo_lines_ == 0)
-		glGenBuffers(1, &vbo_lines_);
-
-	// Determine the number of vertices per line
-	int vpl = 2;
-	if (show_direction)
-		vpl = 4;
-
-	// Fill lines VBO
-	int            nverts = map_->nLines() * vpl;
-	vector<GLVert> lines(nverts);
-	unsigned       v = 0;
-	ColRGBA        col;
-	float          alpha;
-	for (unsigned a = 0; a < map_->nLines(); a++)
-	{
-		auto line = map_->line(a);
+	auto& data = map_->mapData();
+	if (!vbo_lines_.empty() && show_direction == lines_dirs_ && data.generation() == lines_gen_)
+		return;
 
-		// Get line colour
-		col   = lineColour(line);
-		alpha = base_alpha * col.fa();
-
-		// Set line vertices
-		lines[v].x     = line->v1()->xPos();
-		lines[v].y     = line->v1()->yPos();
-		lines[v + 1].x = line->v2()->xPos();
-		lines[v + 1].y = line->v2()->yPos();
-
-		// Set line colour(s)
-		lines[v].r = lines[v + 1].r = col.fr();
-		lines[v].g = lines[v + 1].g = col.fg();
-		lines[v].b = lines[v + 1].b = col.fb();
-		lines[v].a = lines[v + 1].a = alpha;
-
-		// Direction tab if needed
-		if (show_direction)
-		{
-			auto mid       = line->getPoint(MapObject::Point::Mid);
-			auto tab       = line->dirTabPoint();
-			lines[v + 2].x = mid.x;
-			lines[v + 2].y = mid.y;
-			lines[v + 3].x = tab.x;
-			lines[v + 3].y = tab.y;
-
-			// Colours
-			lines[v + 2].r = lines[v + 3].r = col.fr();
-			lines[v + 2].g = lines[v + 3].g = col.fg();
-			lines[v + 2].b = lines[v + 3].b = col.fb();
-			lines[v + 2].a = lines[v + 3].a = alpha * 0.6f;
-		}
+	mapeditor::FrameProfiler::Scope scope("Lines VBO update");
+
+	// Rewrite everything if the direction tabs were toggled (changes the
+	// size of each line's data)
+	if (vbo_lines_.empty() || show_direction != lines_dirs_)
+	{
+		log::info(3, "Updating lines VBO");
+		vbo_lines_.clear();
+		lines_dirs_  = show_direction;
+		lines_alpha_ = base_alpha;
+	}
+
+	// Update the lines in the VBO if any were added or removed. If any
+	// vertices were added or removed just rewrite all lines, since merging
+	// vertices can change the vertices of lines without modifying them
+	bool vertices_changed = data.listGeneration(MapObject::Type::Vertex) != lines_list_gen_[0];
+	bool lines_changed    = data.listGeneration(MapObject::Type::Line) != lines_list_gen_[1];
+
+	vector<unsigned> dirty;
+	if (vbo_lines_.empty() || vertices_changed || lines_changed)
+	{
+		vector<unsigned> ids;
+		data.putObjectIdList(MapObject::Type::Line, ids);
+		vbo_lines_.setObjects(ids, dirty);
+		vbo_lines_.compact();
+		if (vertices_changed)
+			dirty = ids;
+	}
+
+	// Write new and modified lines
+	for (auto object : data.modifiedObjectsSinceGen(lines_gen_, MapObject::Type::Vertex))
+		for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+			dirty.push_back(line->objId());
+	for (auto object : data.modifiedObjectsSinceGen(lines_gen_, MapObject::Type::Line))
+		dirty.push_back(object->objId());
+	for (auto object : data.modifiedObjectsSinceGen(lines_gen_, MapObject::Type::Side))
+		if (auto line = dynamic_cast<MapSide*>(object)->parentLine())
+			dirty.push_back(line->objId());
+	std::sort(dirty.begin(), dirty.end());
+	dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+	for (auto id : dirty)
+		writeLineVBO(dynamic_cast<MapLine*>(data.getObjectById(id)));
+
+	// Upload
+	vbo_lines_.upload();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		// Next line
-		v += vpl;
-	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines_);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLVert) * nverts, lines.data(), GL_STATIC_DRAW);
+	n_lines_           = map_->nLines();
+	lines_gen_         = data.generation();
+	lines_list_gen_[0] = data.listGeneration(MapObject::Type::Vertex);
+	lines_list_gen_[1] = data.listGeneration(MapObject::Type::Line);
+	lines_updated_     = app::runTimer();
+}
 
-	// Clean up
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+// -----------------------------------------------------------------------------
+// Writes the vertices of [line] (and its direction tab if shown) to the lines
+// VBO
+// -----------------------------------------------------------------------------
+void MapRenderer2D::writeLineVBO(MapLine* line)
+{
+	// Get line colour
+	auto  col   = lineColour(line);
+	float alpha = lines_alpha_ * col.fa();
 
-	n_lines_       = map_->nLines();
-	lines_updated_ = app::runTimer();
+	// Set line vertices
+	unsigned vpl   = lines_dirs_ ? 4 : 2;
+	auto     verts = reinterpret_cast<GLVert*>(vbo_lines_.write(line->objId(), sizeof(GLVert) * vpl));
+	verts[0]       = { (float)line->x1(), (float)line->y1(), col.fr(), col.fg(), col.fb(), alpha };
+	verts[1]       = { (float)line->x2(), (float)line->y2(), col.fr(), col.fg(), col.fb(), alpha };
+
+	// Direction tab if needed
+	if (lines_dirs_)
+	{
+		auto mid = line->getPoint(MapObject::Point::Mid);
+		auto tab = line->dirTabPoint();
+		verts[2] = { (float)mid.x, (float)mid.y, col.fr(), col.fg(), col.fb(), alpha * 0.6f };
+		verts[3] = { (float)tab.x, (float)tab.y, col.fr(), col.fg(), col.fb(), alpha * 0.6f };
+	}
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the map flats VBO
+// Updates the map flats VBO with the polygons of any sectors that have been
+// added or have had their polygon geometry change since the last update, and
+// frees the polygons of removed sectors
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateFlatsVBO()
 {
 	if (!flats_use_vbo)
 		return;
 
-	// Create VBO if needed
-	if (vbo_flats_ == 0)
-		glGenBuffers(1, &vbo_flats_);
+	mapeditor::FrameProfiler::Scope scope("Flats VBO update");
 
-	// Get total size needed
-	unsigned totalsize = 0;
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	// Free removed sectors if the sector list changed
+	if (vbo_flats_.empty() || map_->mapData().listGeneration(MapObject::Type::Sector) != flats_list_gen_)
 	{
-		auto poly = map_->sector(a)->polygon();
-		totalsize += poly->vboDataSize();
+		vector<unsigned> ids, added;
+		map_->mapData().putObjectIdList(MapObject::Type::Sector, ids);
+		vbo_flats_.setObjects(ids, added);
+		flats_list_gen_ = map_->mapData().listGeneration(MapObject::Type::Sector);
 	}
 
-	// Allocate buffer data
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats_);
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	// Pack polygons together if too much of the VBO is unused
+	vbo_flats_.compact();
 
-	// Write polygon data to VBO
-	unsigned offset = 0;
-	unsigned index  = 0;
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	// Write new and changed polygons
+	bool written = false;
+	for (auto sector : map_->sectors())
 	{
-		auto poly = map_->sector(a)->polygon();
-		offset    = poly->writeToVBO(offset, index);
-		index += poly->totalVertices();
+		auto id = sector->objId();
+		if (id >= flat_vbo_data_.size())
+			flat_vbo_data_.resize(id + 1);
+
+		if (!vbo_flats_.has(id) || flat_vbo_data_[id].geometry != sector->polygon()->geometryVersion())
+		{
+			writeFlatVBO(sector);
+			written = true;
+		}
 	}
 
-	// Clean up
+	// Upload
+	vbo_flats_.upload();
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	flats_updated_ = app::runTimer();
+	if (written)
+		flats_updated_ = app::runTimer();
+}
+
+// -----------------------------------------------------------------------------
+// Writes the polygon vertices of [sector] to the flats VBO
+// -----------------------------------------------------------------------------
+void MapRenderer2D::writeFlatVBO(MapSector* sector)
+{
+	auto  poly = sector->polygon();
+	auto& data = flat_vbo_data_[sector->objId()];
+	auto  size = poly->vboDataSize();
+
+	memcpy(vbo_flats_.write(sector->objId(), size), poly->vertices().data(), size);
+	data.geometry = poly->geometryVersion();
+	data.texture  = poly->texture();
+	data.indices.clear();
 }
 
 // -----------------------------------------------------------------------------
-// Updates map object visibility info depending on the current view
+// Updates map object visibility info depending on the current view.
+// Only objects in tiles within the view are checked individually
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateVisibility(Vec2d view_tl, Vec2d view_br)
 {
+	view_tl_ = view_tl;
+	view_br_ = view_br;
+	updateTiles();
+
 	// Sector visibility
-	if (map_->nSectors() != vis_s_.size())
-	{
-		// Number of sectors changed, reset array
-		vis_s_.clear();
-		for (unsigned a = 0; a < map_->nSectors(); a++)
-			vis_s_.push_back(0);
-	}
-	for (unsigned a = 0; a < map_->nSectors(); a++)
-	{
-		// Check against sector bounding box
-		auto bbox = map_->sector(a)->boundingBox();
-		vis_s_[a] = 0;
-		if (bbox.max.x < view_tl.x)
-			vis_s_[a] = VIS_LEFT;
-		if (bbox.max.y < view_tl.y)
-			vis_s_[a] = VIS_ABOVE;
-		if (bbox.min.x > view_br.x)
-			vis_s_[a] = VIS_RIGHT;
-		if (bbox.min.y > view_br.y)
-			vis_s_[a] = VIS_BELOW;
+	auto& bboxes = map_->geometry().sectorBBox();
+	vis_s_.assign(map_->nSectors(), VIS_TILE);
+	sector_tiles_.forEachTile(view_tl, view_br, [&](uint64_t, const MapTileGrid::Tile& tile) {
+		// Check if any sectors in the tile are worth drawing
+		if (tile.max_size * view_scale_ < 4)
+		{
+			for (auto index : tile.items)
+				vis_s_[index] = VIS_SMALL;
+			return;
+		}
 
-		// Check if the sector is worth drawing
-		if ((bbox.max.x - bbox.min.x) * view_scale_ < 4 || (bbox.max.y - bbox.min.y) * view_scale_ < 4)
-			vis_s_[a] = VIS_SMALL;
-	}
+		for (auto index : tile.items)
+		{
+			// Check against sector bounding box
+			auto& bbox    = bboxes[index];
+			vis_s_[index] = 0;
+			if (bbox.max.x < view_tl.x)
+				vis_s_[index] = VIS_LEFT;
+			if (bbox.max.y < view_tl.y)
+				vis_s_[index] = VIS_ABOVE;
+			if (bbox.min.x > view_br.x)
+				vis_s_[index] = VIS_RIGHT;
+			if (bbox.min.y > view_br.y)
+				vis_s_[index] = VIS_BELOW;
+
+			// Check if the sector is worth drawing
+			if (sector_tiles_.itemSize(index) * view_scale_ < 4)
+				vis_s_[index] = VIS_SMALL;
+		}
+	});
 
 	// Thing visibility
-	if (map_->nThings() != vis_t_.size())
-	{
-		// Number of things changed, reset array
-		vis_t_.clear();
-		for (unsigned a = 0; a < map_->nThings(); a++)
-			vis_t_.push_back(0);
-	}
-	double x, y;
-	double radius;
-	for (unsigned a = 0; a < vis_t_.size(); a++)
-	{
-		vis_t_[a] = 0;
-		x         = map_->thing(a)->xPos();
-		y         = map_->thing(a)->yPos();
+	vis_t_.assign(map_->nThings(), VIS_TILE);
+	thing_tiles_.forEachTile(view_tl, view_br, [&](uint64_t, const MapTileGrid::Tile& tile) {
+		// Skip the tile if all things in it are too small to be worth drawing
+		if (tile.max_size * view_scale_ < 2)
+			return;
 
-		// Get thing type properties from game configuration
-		auto& tt = game::configuration().thingType(map_->thing(a)->type());
-		radius   = tt.radius() * 1.3;
+		for (auto index : tile.items)
+		{
+			// Ignore if outside of screen
+			if (!thing_tiles_.itemBox(index).intersects(view_tl, view_br))
+				vis_t_[index] = 1;
 
-		// Ignore if outside of screen
-		if (x + radius < view_tl.x || x - radius > view_br.x || y + radius < view_tl.y || y - radius > view_br.y)
-			vis_t_[a] = 1;
+			// Check if the thing is worth drawing
+			else if (thing_tiles_.itemSize(index) * view_scale_ < 2)
+				vis_t_[index] = VIS_SMALL;
 
-		// Check if the thing is worth drawing
-		else if (radius * view_scale_ < 2)
-			vis_t_[a] = VIS_SMALL;
-	}
+			else
+				vis_t_[index] = 0;
+		}
+	});
 }
 
 // -----------------------------------------------------------------------------
@@ -3219,9 +3257,13 @@ void MapRenderer2D::forceUpdate(float line_alpha)
 	tex_flats_.clear();
 	thing_sprites_.clear();
 	thing_paths_.clear();
+	tiles_valid_ = false;
 
 	if (gl::vboSupport())
 	{
+		vbo_vertices_.clear();
+		vbo_lines_.clear();
+		vbo_flats_.clear();
 		updateVerticesVBO();
 		updateLinesVBO(lines_dirs_, line_alpha);
 	}
@@ -3264,3 +3306,268 @@ bool MapRenderer2D::visOK() const
 {
 	return !(map_->nSectors() != vis_s_.size() || map_->nThings() != vis_t_.size());
 }
+
+// -----------------------------------------------------------------------------
+// Brings the line, sector and thing tiles up to date with the map. Object
+// lists that have had objects added or removed are re-tiled in full, otherwise
+// only objects affected by modifications since the last update are
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateTiles()
+{
+	mapeditor::FrameProfiler::Scope scope("Tiles update");
+
+	auto& data        = map_->mapData();
+	auto  listChanged = [&](MapObject::Type type) {
+		return data.listGeneration(type) != tiles_list_gen_[static_cast<int>(type)];
+	};
+
+	// Check which object lists have changed
+	bool lines_changed   = !tiles_valid_ || listChanged(MapObject::Type::Vertex) || listChanged(MapObject::Type::Line);
+	bool sectors_changed = lines_changed || listChanged(MapObject::Type::Side) || listChanged(MapObject::Type::Sector);
+	bool things_changed  = !tiles_valid_ || listChanged(MapObject::Type::Thing);
+	if (!sectors_changed && !things_changed && data.generation() == tiles_gen_)
+		return;
+
+	// Make sure the geometry snapshot is up to date
+	auto& geometry = map_->geometry();
+
+	// Lines
+	vector<unsigned> dirty_lines;
+	if (lines_changed)
+	{
+		clearLineTiles();
+		for (auto& grid : line_tiles_)
+			grid.clear(geometry.nLines());
+		for (unsigned a = 0; a < geometry.nLines(); a++)
+			setLineTile(a);
+	}
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(tiles_gen_, MapObject::Type::Vertex))
+			for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+				dirty_lines.push_back(line->index());
+		for (auto object : data.modifiedObjectsSinceGen(tiles_gen_, MapObject::Type::Line))
+			dirty_lines.push_back(object->index());
+		for (auto object : data.modifiedObjectsSinceGen(tiles_gen_, MapObject::Type::Side))
+			if (auto line = dynamic_cast<MapSide*>(object)->parentLine())
+				dirty_lines.push_back(line->index());
+
+		std::sort(dirty_lines.begin(), dirty_lines.end());
+		dirty_lines.erase(std::unique(dirty_lines.begin(), dirty_lines.end()), dirty_lines.end());
+		for (auto index : dirty_lines)
+			setLineTile(index);
+	}
+
+	// Sectors (changing a side's sector can change the size of sectors other
+	// than the modified ones, so just re-tile them all)
+	if (sectors_changed || data.modifiedSinceGen(tiles_gen_, MapObject::Type::Side))
+	{
+		sector_tiles_.clear(geometry.nSectors());
+		for (unsigned a = 0; a < geometry.nSectors(); a++)
+			setSectorTile(a);
+	}
+	else
+	{
+		// Sectors either side of modified lines may have changed size
+		vector<unsigned> dirty_sectors;
+		for (auto index : dirty_lines)
+		{
+			auto line = map_->line(index);
+			if (line->frontSector())
+				dirty_sectors.push_back(line->frontSector()->index());
+			if (line->backSector())
+				dirty_sectors.push_back(line->backSector()->index());
+		}
+		for (auto object : data.modifiedObjectsSinceGen(tiles_gen_, MapObject::Type::Sector))
+			dirty_sectors.push_back(object->index());
+
+		std::sort(dirty_sectors.begin(), dirty_sectors.end());
+		dirty_sectors.erase(std::unique(dirty_sectors.begin(), dirty_sectors.end()), dirty_sectors.end());
+		for (auto index : dirty_sectors)
+			setSectorTile(index);
+	}
+
+	// Things
+	if (things_changed)
+	{
+		thing_tiles_.clear(geometry.nThings());
+		for (unsigned a = 0; a < geometry.nThings(); a++)
+			setThingTile(a);
+	}
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(tiles_gen_, MapObject::Type::Thing))
+			setThingTile(object->index());
+	}
+
+	// Update tile bounds
+	for (auto& grid : line_tiles_)
+		grid.updateBounds();
+	sector_tiles_.updateBounds();
+	thing_tiles_.updateBounds();
+
+	for (int a = 0; a < 6; a++)
+		tiles_list_gen_[a] = data.listGeneration(static_cast<MapObject::Type>(a));
+	tiles_gen_   = data.generation();
+	tiles_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the tiles for line [index] at all levels of detail
+// -----------------------------------------------------------------------------
+void MapRenderer2D::setLineTile(unsigned index)
+{
+	auto& geometry = map_->geometry();
+	auto  v1       = geometry.lineV1()[index];
+	auto  v2       = geometry.lineV2()[index];
+
+	MapTileGrid::Box box;
+	if (v1 != MapGeometrySnapshot::NO_INDEX && v2 != MapGeometrySnapshot::NO_INDEX)
+	{
+		box.extend(geometry.vertexX()[v1], geometry.vertexY()[v1]);
+		box.extend(geometry.vertexX()[v2], geometry.vertexY()[v2]);
+	}
+
+	for (auto& grid : line_tiles_)
+		grid.setItem(index, box);
+}
+
+// -----------------------------------------------------------------------------
+// Updates the tile for sector [index]. The sector's size in the tile is its
+// smallest dimension, since sectors smaller than a few pixels in either
+// dimension aren't drawn
+// -----------------------------------------------------------------------------
+void MapRenderer2D::setSectorTile(unsigned index)
+{
+	auto& bbox = map_->geometry().sectorBBox()[index];
+
+	MapTileGrid::Box box;
+	box.extend(bbox.min.x, bbox.min.y);
+	box.extend(bbox.max.x, bbox.max.y);
+
+	sector_tiles_.setItem(index, box, std::min(bbox.width(), bbox.height()));
+}
+
+// -----------------------------------------------------------------------------
+// Updates the tile for thing [index]. The thing's size in the tile is its
+// radius (plus some extra for the shadow, etc.)
+// -----------------------------------------------------------------------------
+void MapRenderer2D::setThingTile(unsigned index)
+{
+	auto&  geometry = map_->geometry();
+	double x        = geometry.thingX()[index];
+	double y        = geometry.thingY()[index];
+	double radius   = game::configuration().thingType(geometry.thingType()[index]).radius() * 1.3;
+
+	MapTileGrid::Box box;
+	box.extend(x - radius, y - radius);
+	box.extend(x + radius, y + radius);
+
+	thing_tiles_.setItem(index, box, radius);
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached line tile data
+// -----------------------------------------------------------------------------
+void MapRenderer2D::clearLineTiles()
+{
+	for (auto& level : line_tile_data_)
+	{
+		for (auto& tile : level)
+			if (tile.second.vbo > 0)
+				glDeleteBuffers(1, &tile.second.vbo);
+
+		level.clear();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the line level of detail to draw at the current view scale - the
+// lowest detail level with merged lines no more than a pixel apart
+// -----------------------------------------------------------------------------
+unsigned MapRenderer2D::lineLodLevel() const
+{
+	if (!map_2d_lod)
+		return 0;
+
+	for (unsigned level = N_LINE_LOD - 1; level > 0; level--)
+		if (lodCellSize(level) <= view_scale_inv_)
+			return level;
+
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the merged lines VBO for [tile] at LOD [level].
+// Line ends are snapped to a grid of the level's cell size, then lines that
+// end up zero length are dropped and lines that end up the same are merged
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateLineTile(LineTile& data, const MapTileGrid::Tile& tile, unsigned level, float base_alpha)
+{
+	struct LodLine
+	{
+		int64_t  x1, y1, x2, y2;
+		unsigned index;
+
+		bool operator<(const LodLine& rhs) const
+		{
+			return std::tie(x1, y1, x2, y2, index) < std::tie(rhs.x1, rhs.y1, rhs.x2, rhs.y2, rhs.index);
+		}
+		bool sameAs(const LodLine& rhs) const { return x1 == rhs.x1 && y1 == rhs.y1 && x2 == rhs.x2 && y2 == rhs.y2; }
+	};
+
+	// Snap lines to the grid
+	auto&           geometry = map_->geometry();
+	auto&           vx       = geometry.vertexX();
+	auto&           vy       = geometry.vertexY();
+	double          cell     = lodCellSize(level);
+	vector<LodLine> lod_lines;
+	for (auto index : tile.items)
+	{
+		auto    v1 = geometry.lineV1()[index];
+		auto    v2 = geometry.lineV2()[index];
+		LodLine line{ std::llround(vx[v1] / cell),
+					  std::llround(vy[v1] / cell),
+					  std::llround(vx[v2] / cell),
+					  std::llround(vy[v2] / cell),
+					  index };
+
+		// Drop if less than a cell long
+		if (line.x1 == line.x2 && line.y1 == line.y2)
+			continue;
+
+		// Always start from the 'lowest' end so the same lines in opposite
+		// directions are merged
+		if (std::tie(line.x2, line.y2) < std::tie(line.x1, line.y1))
+		{
+			std::swap(line.x1, line.x2);
+			std::swap(line.y1, line.y2);
+		}
+
+		lod_lines.push_back(line);
+	}
+	std::sort(lod_lines.begin(), lod_lines.end());
+
+	// Build vertices, merging identical lines (the first line's colour is used)
+	vector<GLVert> vertices;
+	for (unsigned a = 0; a < lod_lines.size(); a++)
+	{
+		auto& line = lod_lines[a];
+		if (a > 0 && line.sameAs(lod_lines[a - 1]))
+			continue;
+
+		auto  col   = lineColour(map_->line(line.index));
+		float alpha = base_alpha * col.fa();
+		vertices.push_back({ (float)(line.x1 * cell), (float)(line.y1 * cell), col.fr(), col.fg(), col.fb(), alpha });
+		vertices.push_back({ (float)(line.x2 * cell), (float)(line.y2 * cell), col.fr(), col.fg(), col.fb(), alpha });
+	}
+
+	// Upload to VBO
+	if (data.vbo == 0)
+		glGenBuffers(1, &data.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, data.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLVert) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+	data.n_vertices = vertices.size();
+	data.version    = tile.version;
+}
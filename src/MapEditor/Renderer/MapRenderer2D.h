@@ -1,8 +1,11 @@
 #pragma once
 
 #include "MapEditor/MapEditor.h"
+#include "MapObjectVBO.h"
+#include "MapTileGrid.h"
 #include "SLADEMap/MapObject/MapObject.h"
 #include "Utility/Colour.h"
+#include <unordered_map>
 
 namespace slade
 {
@@ -55,15 +58,15 @@ public:
 	};
 	bool setupThingOverlay() const;
 	void renderThingOverlay(double x, double y, double radius, bool point) const;
-	void renderRoundThing(
+	void batchRoundThing(
 		double                   x,
 		double                   y,
 		double                   angle,
 		const game::ThingType&   type,
 		const MapObject::ArgSet& args,
 		float                    alpha       = 1.0f,
-		double                   radius_mult = 1.0) const;
-	bool renderSpriteThing(
+		double                   radius_mult = 1.0);
+	bool batchSpriteThing(
 		double                   x,
 		double                   y,
 		double                   angle,
@@ -79,7 +82,7 @@ public:
 		const game::ThingType&   type,
 		const MapObject::ArgSet& args,
 		float                    alpha = 1.0f) const;
-	bool renderSquareThing(
+	bool batchSquareThing(
 		double                   x,
 		double                   y,
 		double                   angle,
@@ -87,9 +90,9 @@ public:
 		const MapObject::ArgSet& args,
 		float                    alpha    = 1.0f,
 		bool                     showicon = true,
-		bool                     framed   = false) const;
+		bool                     framed   = false);
 	void renderThings(float alpha = 1.0f, bool force_dir = false);
-	void renderThingsImmediate(float alpha);
+	void renderThingsBatched(float alpha);
 	void renderThingHilight(int index, float fade) const;
 	void renderThingSelection(const ItemSelection& selection, float fade = 1.0f) const;
 	void renderTaggedThings(vector<MapThing*>& things, float fade) const;
@@ -121,6 +124,8 @@ public:
 	void updateVerticesVBO();
 	void updateLinesVBO(bool show_direction, float base_alpha);
 	void updateFlatsVBO();
+	void writeLineVBO(MapLine* line);
+	void writeFlatVBO(MapSector* sector);
 
 	// Misc
 	void setScale(double scale)
@@ -141,10 +146,17 @@ private:
 	long lines_updated_    = 0;
 	long flats_updated_    = 0;
 
-	// VBOs etc
-	unsigned vbo_vertices_ = 0;
-	unsigned vbo_lines_    = 0;
-	unsigned vbo_flats_    = 0;
+	// VBOs etc (see MapObjectVBO)
+	MapObjectVBO vbo_vertices_;
+	MapObjectVBO vbo_lines_;
+	MapObjectVBO vbo_flats_;
+
+	// Map generations (see MapObjectCollection) the VBOs were last updated at
+	unsigned long vertices_gen_      = 0;
+	unsigned long vertices_list_gen_ = 0;
+	unsigned long lines_gen_         = 0;
+	unsigned long lines_list_gen_[2]{}; // Vertex, Line
+	unsigned long flats_list_gen_ = 0;
 
 	// Display lists
 	unsigned list_vertices_ = 0;
@@ -158,6 +170,7 @@ private:
 		VIS_ABOVE = 4,
 		VIS_BELOW = 8,
 		VIS_SMALL = 16,
+		VIS_TILE  = 32, // Not in any tile within the view
 	};
 	vector<uint8_t> vis_v_;
 	vector<uint8_t> vis_l_;
@@ -178,6 +191,7 @@ private:
 
 	// Other
 	bool     lines_dirs_     = false;
+	float    lines_alpha_    = 1.f;
 	unsigned n_vertices_     = 0;
 	unsigned n_lines_        = 0;
 	unsigned n_things_       = 0;
@@ -187,9 +201,38 @@ private:
 
 	vector<unsigned> tex_flats_;
 	int              last_flat_type_ = -1;
+	vector<unsigned> vertex_indices_; // Index of each map vertex in the vertices VBO
 	vector<unsigned> thing_sprites_;
 	long             thing_sprites_updated_ = 0;
 
+	// Thing batches (quads grouped by texture, rebuilt each frame)
+	struct ThingVertex
+	{
+		float   x, y;
+		float   tx, ty;
+		uint8_t r, g, b, a;
+	};
+	struct ThingBatch
+	{
+		unsigned            texture = 0;
+		vector<ThingVertex> vertices;
+	};
+	vector<ThingBatch>                     thing_batches_;
+	std::unordered_map<unsigned, unsigned> thing_batch_index_;
+
+	void addThingQuad(
+		unsigned       texture,
+		double         x,
+		double         y,
+		double         hw,
+		double         hh,
+		double         angle,
+		const ColRGBA& colour,
+		int            tc_start = 0);
+	void renderThingBatches();
+
+	ColRGBA thingColour(const game::ThingType& type, const MapObject::ArgSet& args) const;
+
 	// Thing paths
 	enum class PathType
 	{
@@ -206,5 +249,48 @@ private:
 	};
 	vector<ThingPath> thing_paths_;
 	long              thing_paths_updated_ = 0;
+
+	// Flat polygon triangles in the flats VBO, by sector object id
+	struct FlatVBOData
+	{
+		unsigned         geometry = 0; // Polygon geometry version when written
+		unsigned         texture  = 0; // Polygon texture when written
+		unsigned         base     = 0; // Index of the polygon's first vertex in the VBO
+		vector<unsigned> indices;
+	};
+	vector<FlatVBOData> flat_vbo_data_;
+
+	// World-space tiles, for culling and level of detail. Lines are tiled at
+	// several levels of detail, level 0 is full detail (drawn from the lines
+	// VBO), higher levels have larger tiles of merged lines for zoomed out views
+	static constexpr unsigned N_LINE_LOD = 4;
+	struct LineTile
+	{
+		unsigned long    version = 0;
+		unsigned long    layout  = 0; // Lines VBO layout the indices are for
+		vector<unsigned> indices;     // Line vertex indices in the lines VBO (level 0)
+
+		// Merged line vertices (other levels)
+		unsigned vbo        = 0;
+		unsigned n_vertices = 0;
+	};
+	MapTileGrid line_tiles_[N_LINE_LOD]{ 2048., 8192., 32768., 131072. };
+	MapTileGrid thing_tiles_{ 1024. };
+	MapTileGrid sector_tiles_{ 2048. };
+	bool        tiles_valid_ = false;
+	Vec2d       view_tl_;
+	Vec2d       view_br_;
+
+	std::unordered_map<uint64_t, LineTile> line_tile_data_[N_LINE_LOD];
+	unsigned long                          tiles_gen_ = 0;
+	unsigned long                          tiles_list_gen_[6]{};
+
+	void     updateTiles();
+	void     setLineTile(unsigned index);
+	void     setSectorTile(unsigned index);
+	void     setThingTile(unsigned index);
+	void     clearLineTiles();
+	unsigned lineLodLevel() const;
+	void     updateLineTile(LineTile& data, const MapTileGrid::Tile& tile, unsigned level, float base_alpha);
 };
 } // namespace slade
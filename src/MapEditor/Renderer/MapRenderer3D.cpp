@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "MapRenderer3D.h"
 #include "App.h"
+#include "FrameProfiler.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
 #include "General/ResourceManager.h"
@@ -44,7 +45,6 @@
 #include "SLADEMap/SLADEMap.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "Utility/MathStuff.h"
-#include "Utility/StringUtils.h"
 
 using namespace slade;
 
@@ -105,6 +105,10 @@ MapRenderer3D::MapRenderer3D(SLADEMap* map) : map_{ map }
 	sc_resources_updated_ = app::resources().signals().resources_updated.connect([this]() { refreshTextures(); });
 	sc_palette_changed_   = theMainWindow->paletteChooser()->signals().palette_changed.connect(
         [this]() { refreshTextures(); });
+
+	// Update anything using the loading placeholder when background textures finish loading
+	sc_textures_loaded_ = mapeditor::textureManager().signals().textures_loaded.connect(
+		[this]() { refreshLoadingTextures(); });
 }
 
 // -----------------------------------------------------------------------------
@@ -147,6 +151,8 @@ void MapRenderer3D::refresh()
 {
 	// Clear any existing map data
 	dist_sectors_.clear();
+	vis_sectors_.clear();
+	vis_lines_.clear();
 	if (quads_)
 	{
 		delete quads_;
@@ -210,6 +216,36 @@ void MapRenderer3D::refreshTextures()
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Forces an update of any lines or flats currently using the 'loading'
+// placeholder texture, so they pick up textures that have finished loading
+// -----------------------------------------------------------------------------
+void MapRenderer3D::refreshLoadingTextures()
+{
+	auto tex_loading = gl::Texture::loadingTexture();
+
+	// Lines
+	for (auto& line : lines_)
+	{
+		for (auto& quad : line.quads)
+		{
+			if (quad.texture == tex_loading)
+			{
+				line.updated_time = 0;
+				break;
+			}
+		}
+	}
+
+	// Flats
+	for (auto& floor : floors_)
+		if (floor.texture == tex_loading)
+			floor.updated_time = 0;
+	for (auto& ceiling : ceilings_)
+		if (ceiling.texture == tex_loading)
+			ceiling.updated_time = 0;
+}
+
 // -----------------------------------------------------------------------------
 // Clears all cached rendering data
 // -----------------------------------------------------------------------------
@@ -217,9 +253,17 @@ void MapRenderer3D::clearData()
 {
 	// Clear map structures
 	lines_.clear();
+	vis_lines_.clear();
 	things_.clear();
 	floors_.clear();
 	ceilings_.clear();
+	wall_vertices_.clear();
+	walls_dirty_.clear();
+	pick_bvh_.clear();
+	pick_dirty_.clear();
+	walls_unused_ = 0;
+	wall_batches_.clear();
+	wall_batch_index_.clear();
 
 	// Clear everything else
 	refresh();
@@ -474,6 +518,7 @@ void MapRenderer3D::setupView(int width, int height)
 	// Calculate aspect ratio
 	float aspect = (1.6f / 1.333333f) * ((float)width / (float)height);
 	float fovy   = 2 * math::radToDeg(atan(tan(math::degToRad(render_fov) / 2) / aspect));
+	view_aspect_ = aspect;
 
 	// Setup projection
 	glMatrixMode(GL_PROJECTION);
@@ -508,6 +553,16 @@ void MapRenderer3D::setupView(int width, int height)
 // level
 // -----------------------------------------------------------------------------
 void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
+{
+	float mult = lightMultiplier(light);
+	glColor4f(colour.fr() * mult, colour.fg() * mult, colour.fb() * mult, colour.fa() * alpha);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the colour multiplier for [light] level, taking fullbright mode and
+// the brightness setting into account
+// -----------------------------------------------------------------------------
+float MapRenderer3D::lightMultiplier(uint8_t light) const
 {
 	// Force 255 light in fullbright mode
 	if (fullbright_)
@@ -520,8 +575,7 @@ void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
 	// If we have a non-coloured light, darken it a bit to
 	// closer resemble the software renderer light level
 	float mult = (float)light / 255.0f;
-	mult *= (mult * 1.3f);
-	glColor4f(colour.fr() * mult, colour.fg() * mult, colour.fb() * mult, colour.fa() * alpha);
+	return mult * (mult * 1.3f);
 }
 
 // -----------------------------------------------------------------------------
@@ -576,6 +630,8 @@ void MapRenderer3D::renderMap()
 	// Init VBO stuff
 	if (gl::vboSupport())
 	{
+		mapeditor::FrameProfiler::Scope scope("Flats VBO update");
+
 		// Check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
 		bool vbo_updated = false;
 		for (unsigned a = 0; a < map_->nSectors(); a++)
@@ -604,9 +660,14 @@ void MapRenderer3D::renderMap()
 		ceilings_.resize(map_->nSectors());
 	}
 
-	// Create lines array if empty
+	// Create lines array if empty (walls VBO slots of any lines dropped are no
+	// longer used)
 	if (lines_.size() != map_->nLines())
+	{
+		for (auto a = map_->nLines(); a < lines_.size(); a++)
+			walls_unused_ += lines_[a].vbo_slots;
 		lines_.resize(map_->nLines());
+	}
 
 	// Create things array if empty
 	if (things_.size() != map_->nThings())
@@ -614,15 +675,21 @@ void MapRenderer3D::renderMap()
 
 	// Quick distance vis check
 	sf::Clock clock;
-	quickVisDiscard();
+	{
+		mapeditor::FrameProfiler::Scope scope("Visibility");
+		quickVisDiscard();
 
-	// Build lists of quads and flats to render
-	checkVisibleFlats();
-	checkVisibleQuads();
+		// Build lists of quads and flats to render
+		checkVisibleFlats();
+		checkVisibleQuads();
+	}
 
 	// Render sky
 	if (render_3d_sky)
+	{
+		mapeditor::FrameProfiler::Scope scope("Sky", true);
 		renderSky();
+	}
 	gl::setColour(ColRGBA::WHITE);
 
 	if (fog_)
@@ -640,17 +707,29 @@ void MapRenderer3D::renderMap()
 	}
 
 	// Render walls
-	renderWalls();
+	{
+		mapeditor::FrameProfiler::Scope scope("Walls", true);
+		renderWalls();
+	}
 
 	// Render flats
-	renderFlats();
+	{
+		mapeditor::FrameProfiler::Scope scope("Flats", true);
+		renderFlats();
+	}
 
 	// Render things
 	if (render_3d_things > 0)
+	{
+		mapeditor::FrameProfiler::Scope scope("Things", true);
 		renderThings();
+	}
 
 	// Render transparent stuff
-	renderTransparentWalls();
+	{
+		mapeditor::FrameProfiler::Scope scope("Transparent walls", true);
+		renderTransparentWalls();
+	}
 
 	// Check elapsed time
 	if (render_max_dist_adaptive)
@@ -954,7 +1033,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	floors_[index].light     = sector->lightAt(1);
 	floors_[index].flags     = 0;
 	floors_[index].plane     = sector->floor().plane;
-	if (strutil::equalCI(sector->floor().texture, game::configuration().skyFlat()))
+	if (sector->floor().texture.key() == TextureName::keyOf(game::configuration().skyFlat()))
 		floors_[index].flags |= SKY;
 
 	// Update floor VBO
@@ -977,7 +1056,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	ceilings_[index].light     = sector->lightAt(2);
 	ceilings_[index].flags     = CEIL;
 	ceilings_[index].plane     = sector->ceiling().plane;
-	if (strutil::equalCI(sector->ceiling().texture, game::configuration().skyFlat()))
+	if (sector->ceiling().texture.key() == TextureName::keyOf(game::configuration().skyFlat()))
 		ceilings_[index].flags |= SKY;
 
 	// Update ceiling VBO
@@ -1307,6 +1386,7 @@ void MapRenderer3D::updateLine(unsigned index)
 
 	// Clear current line data
 	lines_[index].quads.clear();
+	walls_dirty_.push_back(index);
 
 	// Skip invalid line
 	auto line = map_->line(index);
@@ -1380,7 +1460,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = mapeditor::textureManager().texture(line->s1()->texMiddle(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s1()->texMiddleName(), mixed);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1428,8 +1508,8 @@ void MapRenderer3D::updateLine(unsigned index)
 	int    yoff2       = line->s2()->texOffsetY();
 	int    lowceil     = min(ceiling1, ceiling2);
 	int    highfloor   = max(floor1, floor2);
-	string sky_flat    = game::configuration().skyFlat();
-	string hidden_tex  = map_->currentFormat() == MapFormat::Doom64 ? "?" : "-";
+	auto   sky_key     = TextureName::keyOf(game::configuration().skyFlat());
+	auto   hidden_tex  = TextureName{ map_->currentFormat() == MapFormat::Doom64 ? "?" : "-" };
 	bool   show_midtex = (map_->currentFormat() != MapFormat::Doom64) || (line->flagSet(512));
 	// Heights at both endpoints, for both planes, on both sides
 	double f1h1 = fp1.heightAt(line->x1(), line->y1());
@@ -1483,7 +1563,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = mapeditor::textureManager().texture(line->s1()->texLower(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s1()->texLowerName(), mixed);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1525,13 +1605,13 @@ void MapRenderer3D::updateLine(unsigned index)
 	// Front middle
 	lsx          = 1;
 	lsy          = 1;
-	auto midtex1 = line->stringProperty("side1.texturemiddle");
+	auto midtex1 = line->s1()->texMiddleName();
 	if (!midtex1.empty() && midtex1 != hidden_tex && show_midtex)
 	{
 		Quad quad;
 
 		// Get texture
-		auto& tex    = mapeditor::textureManager().texture(line->s1()->texMiddle(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s1()->texMiddleName(), mixed);
 		quad.texture = tex.gl_id;
 
 		// Determine offsets
@@ -1639,7 +1719,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = mapeditor::textureManager().texture(line->s1()->texUpper(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s1()->texUpperName(), mixed);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1668,8 +1748,8 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.light     = light1;
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling1, ceiling2, !upeg, sx, sy);
 		// Sky hack only applies if both sectors have a sky ceiling
-		if (strutil::equalCI(sky_flat, line->frontSector()->ceiling().texture)
-			&& strutil::equalCI(sky_flat, line->backSector()->ceiling().texture))
+		if (line->frontSector()->ceiling().texture.key() == sky_key
+			&& line->backSector()->ceiling().texture.key() == sky_key)
 			quad.flags |= SKY;
 		quad.flags |= UPPER;
 
@@ -1698,7 +1778,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = mapeditor::textureManager().texture(line->s2()->texLower(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s2()->texLowerName(), mixed);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1729,7 +1809,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.fogcolour = fogcolour2;
 		quad.light     = light2;
 		setupQuadTexCoords(&quad, length, xoff, yoff, floor1, floor2, false, sx, sy);
-		if (strutil::equalCI(sky_flat, line->frontSector()->floor().texture))
+		if (line->frontSector()->floor().texture.key() == sky_key)
 			quad.flags |= SKY;
 		quad.flags |= BACK;
 		quad.flags |= LOWER;
@@ -1741,7 +1821,7 @@ void MapRenderer3D::updateLine(unsigned index)
 	// Back middle
 	lsx          = 1;
 	lsy          = 1;
-	auto midtex2 = line->stringProperty("side2.texturemiddle");
+	auto midtex2 = line->s2()->texMiddleName();
 	if (!midtex2.empty() && midtex2 != hidden_tex && show_midtex)
 	{
 		Quad quad;
@@ -1856,7 +1936,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = mapeditor::textureManager().texture(line->s2()->texUpper(), mixed);
+		auto& tex    = mapeditor::textureManager().texture(line->s2()->texUpperName(), mixed);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1884,7 +1964,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.fogcolour = fogcolour2;
 		quad.light     = light2;
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling2, ceiling1, !upeg, sx, sy);
-		if (strutil::equalCI(sky_flat, line->frontSector()->ceiling().texture))
+		if (line->frontSector()->ceiling().texture.key() == sky_key)
 			quad.flags |= SKY;
 		quad.flags |= BACK;
 		quad.flags |= UPPER;
@@ -1897,6 +1977,33 @@ void MapRenderer3D::updateLine(unsigned index)
 	lines_[index].updated_time = app::runTimer();
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if the cached rendering data for line [index] is out of date
+// -----------------------------------------------------------------------------
+bool MapRenderer3D::lineNeedsUpdate(unsigned index) const
+{
+	auto  line = map_->line(index);
+	auto& data = lines_[index];
+
+	// Check line modified
+	if (data.updated_time < line->modifiedTime() || data.line != line)
+		return true;
+
+	// Check front side/sector modified
+	if (line->s1()
+		&& (data.updated_time < line->s1()->modifiedTime() || data.updated_time < line->frontSector()->modifiedTime()
+			|| data.updated_time < line->frontSector()->geometryUpdatedTime()))
+		return true;
+
+	// Check back side/sector modified
+	if (line->s2()
+		&& (data.updated_time < line->s2()->modifiedTime() || data.updated_time < line->backSector()->modifiedTime()
+			|| data.updated_time < line->backSector()->geometryUpdatedTime()))
+		return true;
+
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 // Renders [quad]
 // -----------------------------------------------------------------------------
@@ -1958,7 +2065,11 @@ void MapRenderer3D::renderWalls()
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
 
-	// Render all visible quads, ordered by texture
+	// Render opaque quads from the walls VBO if possible
+	if (gl::vboSupport())
+		renderWallBatches();
+
+	// Render all remaining visible quads, ordered by texture
 	unsigned a        = 0;
 	unsigned tex_last = 0;
 	while (n_quads_ > 0)
@@ -1998,6 +2109,86 @@ void MapRenderer3D::renderWalls()
 	glDisable(GL_TEXTURE_2D);
 }
 
+// -----------------------------------------------------------------------------
+// Renders all currently visible opaque wall quads from the walls VBO, with one
+// draw call per texture (and fog setting). Quads that can't be drawn this way
+// (sky, transparent or faded out by distance) are left in the visible quads
+// list for renderWalls to draw individually
+// -----------------------------------------------------------------------------
+void MapRenderer3D::renderWallBatches()
+{
+	updateWallsVBO();
+
+	// Sort visible quads into batches
+	for (auto& batch : wall_batches_)
+		batch.indices.clear();
+	unsigned a = 0;
+	while (a < n_quads_)
+	{
+		auto quad = quads_[a];
+		if (quad->colour.a < 255 || quad->alpha < 1.0f || quad->flags & TRANSADD
+			|| (quad->flags & SKY && render_3d_sky))
+		{
+			a++;
+			continue;
+		}
+
+		// Get batch for the quad's texture and fog
+		uint64_t key = static_cast<uint64_t>(quad->texture << 1 | (quad->flags & MIDTEX ? 1 : 0)) << 32;
+		if (fog_)
+			key |= static_cast<uint32_t>(quad->fogcolour.r) << 24 | quad->fogcolour.g << 16 | quad->fogcolour.b << 8
+				   | quad->light;
+		auto index = wall_batch_index_.find(key);
+		if (index == wall_batch_index_.end())
+		{
+			index = wall_batch_index_.emplace(key, wall_batches_.size()).first;
+			wall_batches_.emplace_back();
+			wall_batches_.back().texture = quad->texture;
+		}
+
+		// Add quad to batch
+		auto& batch = wall_batches_[index->second];
+		if (batch.indices.empty())
+			batch.first = quad;
+		for (unsigned v = 0; v < 4; v++)
+			batch.indices.push_back(quad->vbo_vertex + v);
+
+		// Remove from visible quads list
+		quads_[a] = quads_[n_quads_ - 1];
+		n_quads_--;
+	}
+
+	// Setup VBO
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_walls_);
+	glVertexPointer(3, GL_FLOAT, sizeof(WallVertex), nullptr);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(WallVertex), ((char*)nullptr + 12));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(WallVertex), ((char*)nullptr + 20));
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Render batches
+	for (auto& batch : wall_batches_)
+	{
+		if (batch.indices.empty())
+			continue;
+
+		gl::Texture::bind(batch.texture);
+		setFog(batch.first->fogcolour, batch.first->light);
+
+		if (batch.first->flags & MIDTEX)
+			glAlphaFunc(GL_GREATER, 0.9f);
+		glDrawElements(GL_QUADS, batch.indices.size(), GL_UNSIGNED_INT, batch.indices.data());
+		if (batch.first->flags & MIDTEX)
+			glAlphaFunc(GL_GREATER, 0.0f);
+	}
+
+	// Clean up
+	glDisableClientState(GL_COLOR_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 // -----------------------------------------------------------------------------
 // Renders all currently visible transparent wall quads
 // -----------------------------------------------------------------------------
@@ -2009,6 +2200,18 @@ void MapRenderer3D::renderTransparentWalls()
 	glDisable(GL_ALPHA_TEST);
 	glCullFace(GL_BACK);
 
+	// Sort transparent quads back to front, so they blend correctly
+	auto cam      = cam_position_.get2d();
+	auto quadDist = [&](const Quad* quad) {
+		double x = (quad->points[0].x + quad->points[2].x) * 0.5 - cam.x;
+		double y = (quad->points[0].y + quad->points[2].y) * 0.5 - cam.y;
+		return x * x + y * y;
+	};
+	std::sort(
+		quads_transparent_.begin(),
+		quads_transparent_.end(),
+		[&](const Quad* left, const Quad* right) { return quadDist(left) > quadDist(right); });
+
 	// Render all transparent quads
 	for (auto& quad : quads_transparent_)
 	{
@@ -2196,6 +2399,35 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 	things_[index].z += mapeditor::textureManager().verticalOffset(things_[index].type->sprite());
 
 	things_[index].updated_time = app::runTimer();
+	pick_dirty_.push_back(pick_lines_ + pick_sectors_ + index);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the cached data for thing [index] is out of date
+// -----------------------------------------------------------------------------
+bool MapRenderer3D::thingNeedsUpdate(unsigned index) const
+{
+	auto& data = things_[index];
+	if (!data.type || data.updated_time < map_->thing(index)->modifiedTime())
+		return true;
+
+	// Check sector modified
+	return data.sector
+		   && (data.updated_time < data.sector->modifiedTime()
+			   || data.updated_time < data.sector->geometryUpdatedTime());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the half-width (x) and height (y) of the sprite for thing [index]
+// -----------------------------------------------------------------------------
+Vec2d MapRenderer3D::thingSpriteSize(unsigned index) const
+{
+	auto& data = things_[index];
+	if (data.flags & ICON)
+		return { render_thing_icon_size * 0.5, (double)render_thing_icon_size };
+
+	auto& tex_info = gl::Texture::info(data.sprite);
+	return { data.type->scaleX() * tex_info.size.x * 0.5, data.type->scaleY() * tex_info.size.y };
 }
 
 // -----------------------------------------------------------------------------
@@ -2236,10 +2468,7 @@ void MapRenderer3D::renderThings()
 			continue;
 
 		// Update thing if needed
-		if (things_[a].updated_time < thing->modifiedTime()
-			|| (things_[a].sector
-				&& (things_[a].updated_time < things_[a].sector->modifiedTime()
-					|| things_[a].updated_time < things_[a].sector->geometryUpdatedTime())))
+		if (thingNeedsUpdate(a))
 		{
 			updateThing(a, thing);
 			update++;
@@ -2258,14 +2487,9 @@ void MapRenderer3D::renderThings()
 		gl::Texture::bind(tex, false);
 
 		// Determine coordinates
-		auto& tex_info = gl::Texture::info(tex);
-		halfwidth      = things_[a].type->scaleX() * tex_info.size.x * 0.5;
-		theight        = things_[a].type->scaleY() * tex_info.size.y;
-		if (things_[a].flags & ICON)
-		{
-			halfwidth = render_thing_icon_size * 0.5;
-			theight   = render_thing_icon_size;
-		}
+		auto size         = thingSpriteSize(a);
+		halfwidth         = size.x;
+		theight           = size.y;
 		x1                = thing->xPos() - cam_strafe_.x * halfwidth;
 		y1                = thing->yPos() - cam_strafe_.y * halfwidth;
 		x2                = thing->xPos() + cam_strafe_.x * halfwidth;
@@ -2535,137 +2759,403 @@ void MapRenderer3D::updateFlatsVBO()
 		glGenBuffers(1, &vbo_ceilings_);
 	}
 
-	// Get total size needed
-	unsigned totalsize = 0;
+	// Gather floor and ceiling vertex data. Both buffers share the same layout,
+	// so the polygon VBO locations recorded for the floors apply to ceilings too
+	vector<Polygon2D::Vertex> floors;
+	vector<Polygon2D::Vertex> ceilings;
 	for (unsigned a = 0; a < map_->nSectors(); a++)
 	{
-		auto poly = map_->sector(a)->polygon();
-		totalsize += poly->vboDataSize();
-	}
+		auto sector = map_->sector(a);
+		auto poly   = sector->polygon();
 
-	// --- Floors ---
+		poly->setZ(sector->ceiling().height);
+		ceilings.insert(ceilings.end(), poly->vertices().begin(), poly->vertices().end());
 
-	// Allocate buffer data
+		poly->setZ(sector->floor().height);
+		poly->writeToBuffer(floors);
+
+		// Reset polygon z
+		poly->setZ(0.0f);
+	}
+
+	// Upload to VBOs
+	auto size = floors.size() * sizeof(Polygon2D::Vertex);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_floors_);
 	Polygon2D::setupVBOPointers();
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, size, floors.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_ceilings_);
+	Polygon2D::setupVBOPointers();
+	glBufferData(GL_ARRAY_BUFFER, size, ceilings.data(), GL_STATIC_DRAW);
 
-	// Write polygon data to VBO
-	unsigned offset = 0;
-	unsigned index  = 0;
-	for (unsigned a = 0; a < map_->nSectors(); a++)
-	{
-		// Set polygon z height
-		auto poly = map_->sector(a)->polygon();
-		poly->setZ(map_->sector(a)->floor().height);
+	// Clean up
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-		// Write to VBO
-		offset = poly->writeToVBO(offset, index);
-		index += poly->totalVertices();
+// -----------------------------------------------------------------------------
+// Updates the walls Vertex Buffer Object with the quads of any lines updated
+// since the last call. A line's quads are rewritten in place if they fit in
+// the slots reserved for the line, otherwise the line is given new slots at
+// the end of the buffer. Only the range of the buffer that changed is uploaded
+// -----------------------------------------------------------------------------
+void MapRenderer3D::updateWallsVBO()
+{
+	// Light levels are applied to the vertex colours, so all lines need
+	// updating if the lighting settings change
+	if (walls_fullbright_ != fullbright_ || walls_brightness_ != render_3d_brightness)
+	{
+		walls_fullbright_ = fullbright_;
+		walls_brightness_ = render_3d_brightness;
+		for (unsigned a = 0; a < lines_.size(); a++)
+			walls_dirty_.push_back(a);
 	}
 
-	// --- Ceilings ---
+	// Rebuild the whole buffer if too much of it is unused (more than 1/8 of
+	// the quad slots)
+	if (walls_unused_ > wall_vertices_.size() / 4 / 8)
+	{
+		wall_vertices_.clear();
+		walls_unused_ = 0;
+		walls_dirty_.clear();
+		for (unsigned a = 0; a < lines_.size(); a++)
+		{
+			lines_[a].vbo_slots = 0;
+			walls_dirty_.push_back(a);
+		}
+	}
 
-	// Allocate buffer data
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_ceilings_);
-	Polygon2D::setupVBOPointers();
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	if (walls_dirty_.empty() && vbo_walls_ != 0)
+		return;
 
-	// Write polygon data to VBO
-	offset = 0;
-	index  = 0;
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	// Write quads of updated lines
+	size_t dirty_start = wall_vertices_.size();
+	size_t dirty_end   = 0;
+	for (auto index : walls_dirty_)
 	{
-		// Set polygon z height
-		auto poly = map_->sector(a)->polygon();
-		poly->setZ(map_->sector(a)->ceiling().height);
+		if (index >= lines_.size())
+			continue;
+
+		auto& line = lines_[index];
+		if (line.quads.size() > line.vbo_slots)
+		{
+			walls_unused_ += line.vbo_slots;
+			line.vbo_first = wall_vertices_.size() / 4;
+			line.vbo_slots = line.quads.size();
+			wall_vertices_.resize(wall_vertices_.size() + line.vbo_slots * 4);
+		}
 
-		// Write to VBO
-		offset = poly->writeToVBO(offset, index);
-		index += poly->totalVertices();
+		for (unsigned q = 0; q < line.quads.size(); q++)
+		{
+			auto& quad      = line.quads[q];
+			quad.vbo_vertex = (line.vbo_first + q) * 4;
 
-		// Reset polygon z
-		poly->setZ(0.0f);
+			// Apply light the same way as setLight (each channel is clamped
+			// after multiplying)
+			float mult  = lightMultiplier(quad.light);
+			auto  light = [mult](uint8_t channel) {
+				return static_cast<uint8_t>(std::min(channel * mult / 255.f, 1.f) * 255.f);
+			};
+			for (unsigned p = 0; p < 4; p++)
+			{
+				auto& vertex = wall_vertices_[quad.vbo_vertex + p];
+				vertex.x     = quad.points[p].x;
+				vertex.y     = quad.points[p].y;
+				vertex.z     = quad.points[p].z;
+				vertex.tx    = quad.points[p].tx;
+				vertex.ty    = quad.points[p].ty;
+				vertex.r     = light(quad.colour.r);
+				vertex.g     = light(quad.colour.g);
+				vertex.b     = light(quad.colour.b);
+				vertex.a     = quad.colour.a;
+			}
+		}
+
+		dirty_start = std::min<size_t>(dirty_start, line.vbo_first * 4);
+		dirty_end   = std::max<size_t>(dirty_end, (line.vbo_first + line.vbo_slots) * 4);
 	}
+	walls_dirty_.clear();
+
+	// Create VBO if needed
+	if (vbo_walls_ == 0)
+		glGenBuffers(1, &vbo_walls_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_walls_);
+
+	// Upload, reallocating the VBO with room to grow if needed
+	if (wall_vertices_.size() > vbo_walls_size_ || vbo_walls_size_ == 0)
+	{
+		vbo_walls_size_ = std::max<size_t>(wall_vertices_.size() * 3 / 2, 1024);
+		glBufferData(GL_ARRAY_BUFFER, vbo_walls_size_ * sizeof(WallVertex), nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, wall_vertices_.size() * sizeof(WallVertex), wall_vertices_.data());
+	}
+	else if (dirty_start < dirty_end)
+		glBufferSubData(
+			GL_ARRAY_BUFFER,
+			dirty_start * sizeof(WallVertex),
+			(dirty_end - dirty_start) * sizeof(WallVertex),
+			wall_vertices_.data() + dirty_start);
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the walls Vertex Buffer Object
-// (or would, if it were used for wall rendering)
-// -----------------------------------------------------------------------------
-void MapRenderer3D::updateWallsVBO() const {}
-
-// -----------------------------------------------------------------------------
-// Runs a quick check of all sector bounding boxes against the current view to
-// hide any that are outside it
+// Determines which sectors and lines are potentially visible from the camera.
+// Uses portal traversal from the camera's sector if possible, otherwise runs a
+// quick check of all sector bounding boxes against the current view to hide
+// any that are outside it
 // -----------------------------------------------------------------------------
 void MapRenderer3D::quickVisDiscard()
 {
 	// Create sector distance array if needed
 	if (dist_sectors_.size() != map_->nSectors())
-		dist_sectors_.resize(map_->nSectors());
+	{
+		dist_sectors_.assign(map_->nSectors(), -1.0f);
+		vis_sectors_.clear();
+	}
 
-	// Go through all sectors
-	auto   cam = cam_position_.get2d();
-	double min_dist, dist;
-	Seg2d  strafe(cam, cam + cam_strafe_.get2d());
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	// Clear last frame's visible sectors and lines
+	for (auto index : vis_sectors_)
+		dist_sectors_[index] = -1.0f;
+	for (auto index : vis_lines_)
+		if (index < lines_.size())
+			lines_[index].visible = false;
+	vis_sectors_.clear();
+	vis_lines_.clear();
+
+	if (!portalVisCheck())
 	{
-		// Get sector bbox
-		auto bbox = map_->sector(a)->boundingBox();
+		// Go through all sectors
+		auto   cam = cam_position_.get2d();
+		double min_dist, dist;
+		Seg2d  strafe(cam, cam + cam_strafe_.get2d());
+		for (unsigned a = 0; a < map_->nSectors(); a++)
+		{
+			// Get sector bbox
+			auto bbox = map_->sector(a)->boundingBox();
+
+			// Init to visible
+			dist_sectors_[a] = 0.0f;
+			vis_sectors_.push_back(a);
 
-		// Init to visible
-		dist_sectors_[a] = 0.0f;
+			// Check if within bbox
+			if (bbox.contains(cam))
+				continue;
 
-		// Check if within bbox
-		if (bbox.contains(cam))
+			// Check side of camera
+			if (cam_pitch_ > -0.9 && cam_pitch_ < 0.9)
+			{
+				if (math::lineSide(bbox.min, strafe) > 0 && math::lineSide(Vec2d(bbox.max.x, bbox.min.y), strafe) > 0
+					&& math::lineSide(bbox.max, strafe) > 0
+					&& math::lineSide(Vec2d(bbox.min.x, bbox.max.y), strafe) > 0)
+				{
+					// Behind camera, invisible
+					dist_sectors_[a] = -1.0f;
+					vis_sectors_.pop_back();
+					continue;
+				}
+			}
+
+			// Check distance to bbox
+			if (render_max_dist > 0)
+			{
+				min_dist = 9999999;
+				dist     = math::distanceToLine(cam, bbox.leftSide());
+				if (dist < min_dist)
+					min_dist = dist;
+				dist = math::distanceToLine(cam, bbox.topSide());
+				if (dist < min_dist)
+					min_dist = dist;
+				dist = math::distanceToLine(cam, bbox.rightSide());
+				if (dist < min_dist)
+					min_dist = dist;
+				dist = math::distanceToLine(cam, bbox.bottomSide());
+				if (dist < min_dist)
+					min_dist = dist;
+
+				dist_sectors_[a] = dist;
+			}
+		}
+	}
+
+	// Set all lines that are part of visible sectors to visible
+	for (auto index : vis_sectors_)
+	{
+		auto dist = dist_sectors_[index];
+		if (dist < 0 || (render_max_dist > 0 && dist > render_max_dist))
 			continue;
 
-		// Check side of camera
-		if (cam_pitch_ > -0.9 && cam_pitch_ < 0.9)
+		for (auto side : map_->sector(index)->connectedSides())
 		{
-			if (math::lineSide(bbox.min, strafe) > 0 && math::lineSide(Vec2d(bbox.max.x, bbox.min.y), strafe) > 0
-				&& math::lineSide(bbox.max, strafe) > 0 && math::lineSide(Vec2d(bbox.min.x, bbox.max.y), strafe) > 0)
+			auto line = side->parentLine()->index();
+			if (line < lines_.size() && !lines_[line].visible)
 			{
-				// Behind camera, invisible
-				dist_sectors_[a] = -1.0f;
-				continue;
+				lines_[line].visible = true;
+				vis_lines_.push_back(line);
 			}
 		}
+	}
+}
 
-		// Check distance to bbox
-		if (render_max_dist > 0)
+// -----------------------------------------------------------------------------
+// Finds the sectors visible from the camera by traversing two-sided lines
+// (portals) outward from the sector the camera is in. Each portal narrows the
+// range of view angles the sector behind it can be seen through, and closed
+// portals (eg. doors) or portals outside the current range are not traversed,
+// so only sectors actually in view are visited.
+// Returns false if the camera isn't in a sector
+// -----------------------------------------------------------------------------
+bool MapRenderer3D::portalVisCheck()
+{
+	auto cam   = cam_position_.get2d();
+	auto start = map_->topology().sectorAt(cam);
+	if (!start)
+		return false;
+
+	// Init per-sector traversal info
+	if (sector_vis_frame_.size() != map_->nSectors())
+	{
+		sector_vis_frame_.assign(map_->nSectors(), 0);
+		sector_windows_.resize(map_->nSectors());
+	}
+	vis_frame_++;
+
+	// Returns the angle of [point] from the camera, relative to the view
+	// direction and in the range -PI to PI
+	double view_angle = std::atan2(cam_direction_.y, cam_direction_.x);
+	auto   angleTo    = [&](const Vec2d& point) {
+		double angle = std::atan2(point.y - cam.y, point.x - cam.x) - view_angle;
+		if (angle > math::PI)
+			angle -= math::PI * 2;
+		else if (angle < -math::PI)
+			angle += math::PI * 2;
+		return angle;
+	};
+
+	// Returns true if a flat plane
+	auto flat = [](const Plane& plane) { return plane.a == 0 && plane.b == 0; };
+
+	// Traverse portals breadth-first from the camera sector
+	auto half_angle = viewHalfAngle();
+	portal_queue_.clear();
+	portal_queue_.push_back({ start, -half_angle, half_angle });
+	for (unsigned q = 0; q < portal_queue_.size(); q++)
+	{
+		auto window = portal_queue_[q];
+		auto sector = window.sector;
+		auto index  = sector->index();
+
+		if (sector_vis_frame_[index] != vis_frame_)
+		{
+			// First time this sector has been reached, check distance
+			auto  bbox = sector->boundingBox();
+			float dist = 0.0f;
+			if (!bbox.contains(cam))
+			{
+				dist = std::min(math::distanceToLine(cam, bbox.leftSide()), math::distanceToLine(cam, bbox.topSide()));
+				dist = std::min<float>(dist, math::distanceToLine(cam, bbox.rightSide()));
+				dist = std::min<float>(dist, math::distanceToLine(cam, bbox.bottomSide()));
+			}
+
+			sector_vis_frame_[index] = vis_frame_;
+			sector_windows_[index]   = window;
+			if (render_max_dist > 0 && dist > render_max_dist)
+				continue;
+
+			dist_sectors_[index] = dist;
+			vis_sectors_.push_back(index);
+		}
+		else
 		{
-			min_dist = 9999999;
-			dist     = math::distanceToLine(cam, bbox.leftSide());
-			if (dist < min_dist)
-				min_dist = dist;
-			dist = math::distanceToLine(cam, bbox.topSide());
-			if (dist < min_dist)
-				min_dist = dist;
-			dist = math::distanceToLine(cam, bbox.rightSide());
-			if (dist < min_dist)
-				min_dist = dist;
-			dist = math::distanceToLine(cam, bbox.bottomSide());
-			if (dist < min_dist)
-				min_dist = dist;
+			// Already reached, only continue if this window is wider than
+			// before (the windows are merged, so this is conservative)
+			auto& prev = sector_windows_[index];
+			if (window.min >= prev.min && window.max <= prev.max)
+				continue;
+			if (dist_sectors_[index] < 0)
+				continue;
+
+			window.min = prev.min = std::min(window.min, prev.min);
+			window.max = prev.max = std::max(window.max, prev.max);
+		}
+
+		// Go through portals out of the sector
+		for (auto side : sector->connectedSides())
+		{
+			auto line  = side->parentLine();
+			auto other = side == line->s1() ? line->backSector() : line->frontSector();
+			if (!other || other == sector)
+				continue;
+
+			// Ignore if closed
+			if (flat(sector->floor().plane) && flat(sector->ceiling().plane) && flat(other->floor().plane)
+				&& flat(other->ceiling().plane))
+			{
+				if (other->ceiling().height <= other->floor().height
+					|| other->ceiling().height <= sector->floor().height
+					|| other->floor().height >= sector->ceiling().height)
+					continue;
+			}
+
+			// Ignore if the camera is behind the portal
+			double side_dist = math::distanceToLine(cam, line->seg());
+			bool   front     = math::lineSide(cam, line->seg()) >= 0;
+			if (side_dist > 1. && front != (side == line->s1()))
+				continue;
+
+			// Narrow the window to the portal (unless the camera is right on it)
+			auto next = window;
+			if (side_dist > 1.)
+			{
+				auto a1 = angleTo(line->start());
+				auto a2 = angleTo(line->end());
 
-			dist_sectors_[a] = dist;
+				// Portals spanning the area directly behind the camera can't
+				// narrow the window
+				if (std::fabs(a1 - a2) < math::PI)
+				{
+					next.min = std::max(window.min, std::min(a1, a2));
+					next.max = std::min(window.max, std::max(a1, a2));
+					if (next.min >= next.max)
+						continue;
+				}
+			}
+
+			next.sector = other;
+			portal_queue_.push_back(next);
 		}
 	}
 
-	// Set all lines that are part of invisible sectors to invisible
-	for (unsigned a = 0; a < map_->nSides(); a++)
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the largest horizontal angle (from the camera direction) visible in
+// the current view, or PI if the view can include anything around the camera
+// -----------------------------------------------------------------------------
+float MapRenderer3D::viewHalfAngle() const
+{
+	// Check the 2d direction of each corner of the view frustum
+	auto   up    = cam_strafe_.cross(cam_dir3d_).normalized();
+	double tan_x = tan(math::degToRad(render_fov) / 2);
+	double tan_y = tan_x / view_aspect_;
+	double max   = 0.;
+	for (int sx = -1; sx <= 1; sx += 2)
 	{
-		dist = dist_sectors_[map_->side(a)->sector()->index()];
-		if (dist < 0 || (render_max_dist > 0 && dist > render_max_dist))
-			lines_[map_->side(a)->parentLine()->index()].visible = false;
-		else
-			lines_[map_->side(a)->parentLine()->index()].visible = true;
+		for (int sy = -1; sy <= 1; sy += 2)
+		{
+			auto  corner = cam_dir3d_ + cam_strafe_ * (sx * tan_x) + up * (sy * tan_y);
+			Vec2d dir(corner.x, corner.y);
+
+			// Corner points behind (or straight up/down from) the camera
+			double forward = dir.dot(cam_direction_);
+			if (forward <= 0.)
+				return math::PI;
+
+			max = std::max(max, std::fabs(std::atan2(cam_direction_.cross(dir), forward)));
+		}
 	}
+
+	// Add a small margin for the near clip plane
+	return std::min(max + 0.05, math::PI);
 }
 
 // -----------------------------------------------------------------------------
@@ -2697,16 +3187,11 @@ void MapRenderer3D::checkVisibleQuads()
 	float    distfade;
 	n_quads_         = 0;
 	unsigned updates = 0;
-	bool     update  = false;
 	Seg2d    strafe(cam_position_.get2d(), (cam_position_ + cam_strafe_).get2d());
-	for (unsigned a = 0; a < lines_.size(); a++)
+	for (auto a : vis_lines_)
 	{
 		line = map_->line(a);
 
-		// Skip if not visible
-		if (!lines_[a].visible)
-			continue;
-
 		// Check side of camera
 		if (cam_pitch_ > -0.9 && cam_pitch_ < 0.9)
 		{
@@ -2721,34 +3206,8 @@ void MapRenderer3D::checkVisibleQuads()
 			distfade = 1.0f;
 
 		// Update line if needed
-		update = false;
-		if (lines_[a].updated_time < line->modifiedTime()) // Check line modified
-			update = true;
-		if (lines_[a].line != line)
-			update = true;
-		if (!update && line->s1())
-		{
-			// Check front side/sector modified
-			if (lines_[a].updated_time < line->s1()->modifiedTime()
-				|| lines_[a].updated_time < line->frontSector()->modifiedTime()
-				|| lines_[a].updated_time < line->frontSector()->geometryUpdatedTime())
-				update = true;
-		}
-		if (!update && line->s2())
-		{
-			// Check back side/sector modified
-			if (lines_[a].updated_time < line->s2()->modifiedTime()
-				|| lines_[a].updated_time < line->backSector()->modifiedTime()
-				|| lines_[a].updated_time < line->backSector()->geometryUpdatedTime())
-				update = true;
-		}
-		if (update)
-		{
+		if (lineNeedsUpdate(a))
 			updateLine(a);
-			// updates++;
-			// if (updates > 500)
-			//	break;
-		}
 
 		// Determine quads to be drawn
 		for (auto& quad : lines_[a].quads)
@@ -2781,7 +3240,7 @@ void MapRenderer3D::checkVisibleFlats()
 	n_flats_ = 0;
 	float alpha;
 	auto  cam = cam_position_.get2d();
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	for (auto a : vis_sectors_)
 	{
 		sector = map_->sector(a);
 
@@ -2818,7 +3277,7 @@ void MapRenderer3D::checkVisibleFlats()
 		// Add floor flat
 		flats_[n_flats_++] = &(floors_[a]);
 	}
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	for (auto a : vis_sectors_)
 	{
 		// Skip if invisible
 		if (dist_sectors_[a] < 0)
@@ -2830,183 +3289,392 @@ void MapRenderer3D::checkVisibleFlats()
 }
 
 // -----------------------------------------------------------------------------
-// Finds the closest wall/flat/thing to the camera along the view vector
+// Casts a ray from [origin] in [direction] and returns the closest wall, flat
+// or thing it hits, along with the distance to it. If [visible_only] is true,
+// only walls and flats in the current view are checked
 // -----------------------------------------------------------------------------
-mapeditor::Item MapRenderer3D::determineHilight()
+MapRenderer3D::RayHit MapRenderer3D::castRay(const Vec3d& origin, const Vec3d& direction, bool visible_only)
 {
-	// Init
-	double          min_dist = 9999999;
-	mapeditor::Item current;
-	Seg2d           strafe(cam_position_.get2d(), (cam_position_ + cam_strafe_).get2d());
+	RayHit hit;
 
-	// Check for required map structures
+	// Check for required map structures (and a valid direction)
 	if (!map_ || lines_.size() != map_->nLines() || floors_.size() != map_->nSectors()
-		|| things_.size() != map_->nThings())
-		return current;
+		|| things_.size() != map_->nThings() || direction.magnitude() == 0.)
+		return hit;
+
+	updatePickBVH();
+
+	// Test each object whose bounding box the ray passes through
+	auto dir     = direction.normalized();
+	hit.distance = pick_bvh_.castRay(
+		origin,
+		dir,
+		-1.,
+		[&](unsigned leaf, double max) {
+			// Line
+			if (leaf < pick_lines_)
+			{
+				if (visible_only && !lines_[leaf].visible)
+					return -1.;
+				return rayTestLine(leaf, origin, dir, max, hit.item);
+			}
 
-	// Check lines
-	double height, dist;
-	for (unsigned a = 0; a < map_->nLines(); a++)
-	{
-		// Ignore if not visible
-		if (!lines_[a].visible)
-			continue;
+			// Sector
+			leaf -= pick_lines_;
+			if (leaf < pick_sectors_)
+			{
+				if (visible_only && (leaf >= dist_sectors_.size() || dist_sectors_[leaf] < 0))
+					return -1.;
+				return rayTestSector(leaf, origin, dir, max, hit.item);
+			}
 
-		auto line = map_->line(a);
+			// Thing
+			return rayTestThing(leaf - pick_sectors_, origin, dir, max, hit.item);
+		});
 
-		// Find (2d) distance to line
-		dist = math::distanceRayLine(
-			cam_position_.get2d(), (cam_position_ + cam_dir3d_).get2d(), line->start(), line->end());
+	if (hit.distance < 0)
+		hit.item = {};
 
-		// Ignore if no intersection or something was closer
-		if (dist < 0 || dist >= min_dist)
-			continue;
+	return hit;
+}
 
-		// Find quad intersect if any
-		auto intersection = cam_position_ + cam_dir3d_ * dist;
-		for (auto& quad : lines_[a].quads)
-		{
-			// Check side of camera
-			if (math::lineSide(
-					cam_position_.get2d(),
-					Seg2d(quad.points[0].x, quad.points[0].y, quad.points[2].x, quad.points[2].y))
-				< 0)
-				continue;
+// -----------------------------------------------------------------------------
+// Finds the closest wall/flat/thing to the camera along the view vector
+// -----------------------------------------------------------------------------
+mapeditor::Item MapRenderer3D::determineHilight()
+{
+	auto hit = castRay(cam_position_, cam_dir3d_, true);
 
-			// Check intersection height
-			// Need to handle slopes by finding the floor and ceiling height of
-			// the quad at the intersection point
-			Vec2d  seg_left           = Vec2d(quad.points[1].x, quad.points[1].y);
-			Vec2d  seg_right          = Vec2d(quad.points[2].x, quad.points[2].y);
-			double dist_along_segment = (intersection.get2d() - seg_left).magnitude()
-										/ (seg_right - seg_left).magnitude();
-			double top    = quad.points[0].z + (quad.points[3].z - quad.points[0].z) * dist_along_segment;
-			double bottom = quad.points[1].z + (quad.points[2].z - quad.points[1].z) * dist_along_segment;
-			if (bottom <= intersection.z && intersection.z <= top)
-			{
-				// Determine selected item from quad flags
+	// Update item distance
+	if (hit.distance < 0)
+		item_dist_ = -1;
+	else
+		item_dist_ = math::round(hit.distance);
 
-				// Side index
-				if (quad.flags & BACK)
-					current.index = line->s2Index();
-				else
-					current.index = line->s1Index();
+	return hit.item;
+}
 
-				// Side part
-				if (quad.flags & UPPER)
-					current.type = mapeditor::ItemType::WallTop;
-				else if (quad.flags & LOWER)
-					current.type = mapeditor::ItemType::WallBottom;
-				else
-					current.type = mapeditor::ItemType::WallMiddle;
+// -----------------------------------------------------------------------------
+// Brings the ray picking BVH up to date with the map. Leaves for objects
+// modified since the last update are refitted, and the BVH is rebuilt if any
+// objects have been added or removed
+// -----------------------------------------------------------------------------
+void MapRenderer3D::updatePickBVH()
+{
+	auto& data = map_->mapData();
+
+	// Rebuild if any object lists have changed
+	bool rebuild = pick_bvh_.nLeaves() != map_->nLines() + map_->nSectors() + map_->nThings();
+	for (int a = 0; a < 6; a++)
+		if (pick_list_gen_[a] != data.listGeneration(static_cast<MapObject::Type>(a)))
+			rebuild = true;
+	if (rebuild)
+	{
+		rebuildPickBVH();
+		return;
+	}
 
-				min_dist = dist;
+	// Find leaves affected by objects modified since the last update
+	if (data.generation() != pick_gen_)
+	{
+		auto first_thing = pick_lines_ + pick_sectors_;
+		auto dirtyLine   = [&](MapLine* line) {
+			pick_dirty_.push_back(line->index());
+			if (line->frontSector())
+				pick_dirty_.push_back(pick_lines_ + line->frontSector()->index());
+			if (line->backSector())
+				pick_dirty_.push_back(pick_lines_ + line->backSector()->index());
+		};
+
+		// Vertices and lines
+		for (auto object : data.modifiedObjectsSinceGen(pick_gen_, MapObject::Type::Vertex))
+			for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+				dirtyLine(line);
+		for (auto object : data.modifiedObjectsSinceGen(pick_gen_, MapObject::Type::Line))
+			dirtyLine(dynamic_cast<MapLine*>(object));
+
+		// Sides (changing a side's sector can change the size of sectors other
+		// than its current one, so just refit all sectors)
+		auto sides = data.modifiedObjectsSinceGen(pick_gen_, MapObject::Type::Side);
+		for (auto object : sides)
+			if (auto line = dynamic_cast<MapSide*>(object)->parentLine())
+				pick_dirty_.push_back(line->index());
+		if (!sides.empty())
+			for (unsigned a = 0; a < pick_sectors_; a++)
+				pick_dirty_.push_back(pick_lines_ + a);
+
+		// Sectors (heights affect the lines around them and things within them)
+		auto sectors = data.modifiedObjectsSinceGen(pick_gen_, MapObject::Type::Sector);
+		if (!sectors.empty())
+		{
+			vector<bool> modified(pick_sectors_, false);
+			for (auto object : sectors)
+			{
+				auto sector               = dynamic_cast<MapSector*>(object);
+				modified[sector->index()] = true;
+				pick_dirty_.push_back(pick_lines_ + sector->index());
+				for (auto side : sector->connectedSides())
+					pick_dirty_.push_back(side->parentLine()->index());
 			}
+
+			for (unsigned a = 0; a < things_.size(); a++)
+				if (things_[a].sector && modified[things_[a].sector->index()])
+					pick_dirty_.push_back(first_thing + a);
 		}
+
+		// Things
+		for (auto object : data.modifiedObjectsSinceGen(pick_gen_, MapObject::Type::Thing))
+			pick_dirty_.push_back(first_thing + object->index());
+
+		pick_gen_ = data.generation();
 	}
 
-	// Check sectors
-	for (unsigned a = 0; a < map_->nSectors(); a++)
-	{
-		// Ignore if not visible
-		if (dist_sectors_[a] < 0)
-			continue;
+	// Update changed leaves (getting a thing's box can add to the list if the
+	// thing needs updating, so don't use an iterator here)
+	for (unsigned a = 0; a < pick_dirty_.size(); a++)
+		pick_bvh_.updateLeaf(pick_dirty_[a], pickBox(pick_dirty_[a]));
+	pick_dirty_.clear();
+
+	if (pick_bvh_.needsRebuild())
+		rebuildPickBVH();
+	else
+		pick_bvh_.refit();
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the ray picking BVH for the whole map
+// -----------------------------------------------------------------------------
+void MapRenderer3D::rebuildPickBVH()
+{
+	auto& data    = map_->mapData();
+	pick_lines_   = map_->nLines();
+	pick_sectors_ = map_->nSectors();
+
+	vector<PickBVH::Box> boxes(pick_lines_ + pick_sectors_ + map_->nThings());
+	for (unsigned a = 0; a < boxes.size(); a++)
+		boxes[a] = pickBox(a);
+	pick_bvh_.build(std::move(boxes));
+	pick_dirty_.clear();
+
+	for (int a = 0; a < 6; a++)
+		pick_list_gen_[a] = data.listGeneration(static_cast<MapObject::Type>(a));
+	pick_gen_ = data.generation();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the bounding box of the object for [leaf] in the ray picking BVH
+// -----------------------------------------------------------------------------
+PickBVH::Box MapRenderer3D::pickBox(unsigned leaf)
+{
+	PickBVH::Box box;
 
-		// Check distance to floor plane
-		dist = math::distanceRayPlane(cam_position_, cam_dir3d_, floors_[a].plane);
-		if (dist >= 0 && dist < min_dist)
+	// Line, from the floor and ceiling heights either side (all its quads are
+	// within these)
+	if (leaf < pick_lines_)
+	{
+		auto line = map_->line(leaf);
+		for (auto sector : { line->frontSector(), line->backSector() })
 		{
-			// Check if on the correct side of the plane
-			if (cam_position_.z > floors_[a].plane.heightAt(cam_position_.x, cam_position_.y))
+			if (!sector)
+				continue;
+
+			for (auto point : { line->start(), line->end() })
 			{
-				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
-				{
-					current.index = a;
-					current.type  = mapeditor::ItemType::Floor;
-					min_dist      = dist;
-				}
+				box.extend(Vec3f(point.x, point.y, sector->floor().plane.heightAt(point)));
+				box.extend(Vec3f(point.x, point.y, sector->ceiling().plane.heightAt(point)));
 			}
 		}
 
-		// Check distance to ceiling plane
-		dist = math::distanceRayPlane(cam_position_, cam_dir3d_, ceilings_[a].plane);
-		if (dist >= 0 && dist < min_dist)
+		return box;
+	}
+
+	// Sector, from its bounding box and floor and ceiling heights
+	leaf -= pick_lines_;
+	if (leaf < pick_sectors_)
+	{
+		auto sector = map_->sector(leaf);
+		auto bbox   = sector->boundingBox();
+		if (!bbox.isValid())
+			return box;
+
+		for (auto point : { bbox.min, bbox.max, Vec2d(bbox.min.x, bbox.max.y), Vec2d(bbox.max.x, bbox.min.y) })
 		{
-			// Check if on the correct side of the plane
-			if (cam_position_.z < ceilings_[a].plane.heightAt(cam_position_.x, cam_position_.y))
-			{
-				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
-				{
-					current.index = a;
-					current.type  = mapeditor::ItemType::Ceiling;
-					min_dist      = dist;
-				}
-			}
+			box.extend(Vec3f(point.x, point.y, sector->floor().plane.heightAt(point)));
+			box.extend(Vec3f(point.x, point.y, sector->ceiling().plane.heightAt(point)));
 		}
+
+		return box;
 	}
 
-	// Update item distance
-	if (min_dist >= 9999999 || min_dist < 0)
-		item_dist_ = -1;
-	else
-		item_dist_ = math::round(min_dist);
+	// Thing, from its sprite size (sprites always face the camera, so use the
+	// width in both directions)
+	leaf -= pick_sectors_;
+	if (leaf >= things_.size())
+		return box;
+	if (thingNeedsUpdate(leaf))
+		updateThing(leaf, map_->thing(leaf));
+	if (!things_[leaf].sprite)
+		return box;
 
-	// Check things (if visible)
-	if (render_3d_things == 0)
-		return current;
-	double halfwidth, theight;
-	for (unsigned a = 0; a < map_->nThings(); a++)
-	{
-		// Ignore if no sprite
-		if (!things_[a].sprite)
-			continue;
+	auto pos  = map_->thing(leaf)->position();
+	auto size = thingSpriteSize(leaf);
+	box.extend(Vec3f(pos.x - size.x, pos.y - size.x, things_[leaf].z));
+	box.extend(Vec3f(pos.x + size.x, pos.y + size.x, things_[leaf].z + size.y));
 
-		// Ignore if not visible
-		auto thing = map_->thing(a);
-		if (math::lineSide(thing->position(), strafe) > 0)
-			continue;
+	return box;
+}
 
-		// Ignore if not shown
-		if (!things_[a].type->decoration() && render_3d_things == 2)
-			continue;
+// -----------------------------------------------------------------------------
+// Checks if a ray from [origin] in [dir] hits any wall of line [index] closer
+// than [max]. If so, [hit] is set to the wall and the distance is returned,
+// otherwise returns -1
+// -----------------------------------------------------------------------------
+double MapRenderer3D::rayTestLine(
+	unsigned         index,
+	const Vec3d&     origin,
+	const Vec3d&     dir,
+	double           max,
+	mapeditor::Item& hit)
+{
+	auto line = map_->line(index);
 
-		// Find distance to thing sprite
-		auto& tex_info = gl::Texture::info(things_[a].sprite);
-		halfwidth      = tex_info.size.x * 0.5;
-		if (things_[a].flags & ICON)
-			halfwidth = render_thing_icon_size * 0.5;
-		dist = math::distanceRayLine(
-			cam_position_.get2d(),
-			(cam_position_ + cam_dir3d_).get2d(),
-			thing->position() - cam_strafe_.get2d() * halfwidth,
-			thing->position() + cam_strafe_.get2d() * halfwidth);
-
-		// Ignore if no intersection or something was closer
-		if (dist < 0 || dist >= min_dist)
+	// Find (2d) distance to line
+	auto dist = math::distanceRayLine(origin.get2d(), (origin + dir).get2d(), line->start(), line->end());
+	if (dist < 0 || dist >= max)
+		return -1.;
+
+	// Make sure the line's quads are up to date
+	if (lineNeedsUpdate(index))
+		updateLine(index);
+
+	// Find quad intersect if any
+	auto   intersection = origin + dir * dist;
+	double result       = -1.;
+	for (auto& quad : lines_[index].quads)
+	{
+		// Check side of origin
+		if (math::lineSide(
+				origin.get2d(), Seg2d(quad.points[0].x, quad.points[0].y, quad.points[2].x, quad.points[2].y))
+			< 0)
 			continue;
 
 		// Check intersection height
-		theight = tex_info.size.y;
-		height  = cam_position_.z + cam_dir3d_.z * dist;
-		if (things_[a].flags & ICON)
-			theight = render_thing_icon_size;
-		if (height >= things_[a].z && height <= things_[a].z + theight)
+		// Need to handle slopes by finding the floor and ceiling height of
+		// the quad at the intersection point
+		Vec2d  seg_left           = Vec2d(quad.points[1].x, quad.points[1].y);
+		Vec2d  seg_right          = Vec2d(quad.points[2].x, quad.points[2].y);
+		double dist_along_segment = (intersection.get2d() - seg_left).magnitude()
+									/ (seg_right - seg_left).magnitude();
+		double top    = quad.points[0].z + (quad.points[3].z - quad.points[0].z) * dist_along_segment;
+		double bottom = quad.points[1].z + (quad.points[2].z - quad.points[1].z) * dist_along_segment;
+		if (bottom <= intersection.z && intersection.z <= top)
+		{
+			// Determine selected item from quad flags
+
+			// Side index
+			if (quad.flags & BACK)
+				hit.index = line->s2Index();
+			else
+				hit.index = line->s1Index();
+
+			// Side part
+			if (quad.flags & UPPER)
+				hit.type = mapeditor::ItemType::WallTop;
+			else if (quad.flags & LOWER)
+				hit.type = mapeditor::ItemType::WallBottom;
+			else
+				hit.type = mapeditor::ItemType::WallMiddle;
+
+			result = dist;
+		}
+	}
+
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Checks if a ray from [origin] in [dir] hits the floor or ceiling of sector
+// [index] closer than [max]. If so, [hit] is set to the flat and the distance
+// is returned, otherwise returns -1
+// -----------------------------------------------------------------------------
+double MapRenderer3D::rayTestSector(
+	unsigned         index,
+	const Vec3d&     origin,
+	const Vec3d&     dir,
+	double           max,
+	mapeditor::Item& hit)
+{
+	auto   sector = map_->sector(index);
+	double result = -1.;
+
+	// Check distance to floor plane
+	auto& floor = sector->floor().plane;
+	auto  dist  = math::distanceRayPlane(origin, dir, floor);
+	if (dist >= 0 && dist < max)
+	{
+		// Check if on the correct side of the plane, and intersection is
+		// within sector
+		if (origin.z > floor.heightAt(origin.x, origin.y) && sector->containsPoint((origin + dir * dist).get2d()))
 		{
-			current.index = a;
-			current.type  = mapeditor::ItemType::Thing;
-			min_dist      = dist;
+			hit.index = index;
+			hit.type  = mapeditor::ItemType::Floor;
+			result    = dist;
+			max       = dist;
 		}
 	}
 
-	// Update item distance
-	if (min_dist >= 9999999 || min_dist < 0)
-		item_dist_ = -1;
-	else
-		item_dist_ = math::round(min_dist);
+	// Check distance to ceiling plane
+	auto& ceiling = sector->ceiling().plane;
+	dist          = math::distanceRayPlane(origin, dir, ceiling);
+	if (dist >= 0 && dist < max)
+	{
+		if (origin.z < ceiling.heightAt(origin.x, origin.y) && sector->containsPoint((origin + dir * dist).get2d()))
+		{
+			hit.index = index;
+			hit.type  = mapeditor::ItemType::Ceiling;
+			result    = dist;
+		}
+	}
 
-	return current;
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Checks if a ray from [origin] in [dir] hits the sprite of thing [index]
+// closer than [max]. If so, [hit] is set to the thing and the distance is
+// returned, otherwise returns -1
+// -----------------------------------------------------------------------------
+double MapRenderer3D::rayTestThing(
+	unsigned         index,
+	const Vec3d&     origin,
+	const Vec3d&     dir,
+	double           max,
+	mapeditor::Item& hit)
+{
+	// Ignore if not shown
+	auto& info = things_[index];
+	if (render_3d_things == 0 || !info.sprite || (!info.type->decoration() && render_3d_things == 2))
+		return -1.;
+
+	// Find distance to thing sprite (which faces the camera)
+	auto thing = map_->thing(index);
+	auto size  = thingSpriteSize(index);
+	auto dist  = math::distanceRayLine(
+		origin.get2d(),
+		(origin + dir).get2d(),
+		thing->position() - cam_strafe_.get2d() * size.x,
+		thing->position() + cam_strafe_.get2d() * size.x);
+	if (dist < 0 || dist >= max)
+		return -1.;
+
+	// Check intersection height
+	auto height = origin.z + dir.z * dist;
+	if (height < info.z || height > info.z + size.y)
+		return -1.;
+
+	hit.index = index;
+	hit.type  = mapeditor::ItemType::Thing;
+	return dist;
 }
 
 // -----------------------------------------------------------------------------
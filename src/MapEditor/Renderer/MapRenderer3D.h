@@ -1,7 +1,9 @@
 #pragma once
 
 #include "MapEditor/Edit/Edit3D.h"
+#include "PickBVH.h"
 #include "SLADEMap/SLADEMap.h"
+#include <unordered_map>
 
 namespace slade
 {
@@ -49,10 +51,11 @@ public:
 		GLVertex points[4] = { {}, {}, {}, {} };
 		ColRGBA  colour;
 		ColRGBA  fogcolour;
-		uint8_t  light   = 0;
-		unsigned texture = 0;
-		uint8_t  flags   = 0;
-		float    alpha   = 1.f;
+		uint8_t  light      = 0;
+		unsigned texture    = 0;
+		uint8_t  flags      = 0;
+		float    alpha      = 1.f;
+		unsigned vbo_vertex = 0; // First vertex of the quad in the walls VBO
 
 		Quad() : colour{ 255, 255, 255, 255, 0 } {}
 	};
@@ -60,8 +63,10 @@ public:
 	{
 		vector<Quad> quads;
 		long         updated_time = 0;
-		bool         visible      = true;
+		bool         visible      = false;
 		MapLine*     line         = nullptr;
+		unsigned     vbo_first    = 0; // First quad slot reserved for the line in the walls VBO
+		unsigned     vbo_slots    = 0; // Number of quad slots reserved for the line in the walls VBO
 	};
 	struct Thing
 	{
@@ -86,6 +91,11 @@ public:
 		MapSector* sector       = nullptr;
 		long       updated_time = 0;
 	};
+	struct RayHit
+	{
+		mapeditor::Item item;
+		double          distance = -1.;
+	};
 
 	MapRenderer3D(SLADEMap* map = nullptr);
 	~MapRenderer3D();
@@ -101,6 +111,7 @@ public:
 	bool init();
 	void refresh();
 	void refreshTextures();
+	void refreshLoadingTextures();
 	void clearData();
 	void buildSkyCircle();
 
@@ -161,6 +172,7 @@ public:
 	void updateLine(unsigned index);
 	void renderQuad(Quad* quad, float alpha = 1.0f);
 	void renderWalls();
+	void renderWallBatches();
 	void renderTransparentWalls();
 	void renderWallSelection(const ItemSelection& selection, float alpha = 1.0f);
 
@@ -171,15 +183,18 @@ public:
 
 	// VBO stuff
 	void updateFlatsVBO();
-	void updateWallsVBO() const;
+	void updateWallsVBO();
 
 	// Visibility checking
 	void  quickVisDiscard();
+	bool  portalVisCheck();
+	float viewHalfAngle() const;
 	float calcDistFade(double distance, double max = -1) const;
 	void  checkVisibleQuads();
 	void  checkVisibleFlats();
 
 	// Hilight
+	RayHit          castRay(const Vec3d& origin, const Vec3d& direction, bool visible_only = false);
 	mapeditor::Item determineHilight();
 	void            renderHilight(mapeditor::Item hilight, float alpha = 1.0f);
 
@@ -195,8 +210,28 @@ private:
 	ColRGBA   fog_colour_last_;
 	float     fog_depth_last_ = 0.f;
 
+	float lightMultiplier(uint8_t light) const;
+	bool  lineNeedsUpdate(unsigned index) const;
+	bool  thingNeedsUpdate(unsigned index) const;
+	Vec2d thingSpriteSize(unsigned index) const;
+
 	// Visibility
-	vector<float> dist_sectors_;
+	// A sector and the range of view angles (relative to the camera direction)
+	// it is seen through
+	struct PortalWindow
+	{
+		MapSector* sector;
+		double     min;
+		double     max;
+	};
+	vector<float>        dist_sectors_;
+	vector<unsigned>     vis_sectors_; // Sectors visible this frame
+	vector<unsigned>     vis_lines_;   // Lines visible this frame
+	vector<PortalWindow> portal_queue_;
+	vector<PortalWindow> sector_windows_; // Widest window each sector has been entered with this frame
+	vector<unsigned>     sector_vis_frame_;
+	unsigned             vis_frame_   = 0;
+	float                view_aspect_ = 1.f;
 
 	// Camera
 	Vec3d  cam_position_;
@@ -222,6 +257,46 @@ private:
 	unsigned vbo_ceilings_ = 0;
 	unsigned vbo_walls_    = 0;
 
+	// Walls VBO data. Each line has its own range of quad slots in the buffer,
+	// and visible opaque quads are drawn in batches of quads sharing the same
+	// texture and fog
+	struct WallVertex
+	{
+		float   x = 0.f, y = 0.f, z = 0.f;
+		float   tx = 0.f, ty = 0.f;
+		uint8_t r = 255, g = 255, b = 255, a = 255;
+	};
+	struct WallBatch
+	{
+		unsigned         texture = 0;
+		Quad*            first   = nullptr; // First quad added, for the fog and flags shared by the batch
+		vector<unsigned> indices;
+	};
+	vector<WallVertex>                     wall_vertices_;
+	vector<unsigned>                       walls_dirty_;          // Indices of lines to update in the VBO
+	unsigned                               walls_unused_     = 0; // Quad slots no longer reserved by any line
+	unsigned                               vbo_walls_size_   = 0; // Number of vertices allocated in the VBO
+	bool                                   walls_fullbright_ = false;
+	float                                  walls_brightness_ = 1.f;
+	vector<WallBatch>                      wall_batches_;
+	std::unordered_map<uint64_t, unsigned> wall_batch_index_;
+
+	// Ray picking. The BVH has a leaf for each line, then each sector
+	// (floor+ceiling), then each thing
+	PickBVH          pick_bvh_;
+	vector<unsigned> pick_dirty_; // Leaves to refit
+	unsigned long    pick_gen_ = 0;
+	unsigned long    pick_list_gen_[6]{};
+	unsigned         pick_lines_   = 0;
+	unsigned         pick_sectors_ = 0;
+
+	void         updatePickBVH();
+	void         rebuildPickBVH();
+	PickBVH::Box pickBox(unsigned leaf);
+	double       rayTestLine(unsigned index, const Vec3d& origin, const Vec3d& dir, double max, mapeditor::Item& hit);
+	double       rayTestSector(unsigned index, const Vec3d& origin, const Vec3d& dir, double max, mapeditor::Item& hit);
+	double       rayTestThing(unsigned index, const Vec3d& origin, const Vec3d& dir, double max, mapeditor::Item& hit);
+
 	// Sky
 	struct GLVertexEx
 	{
@@ -238,5 +313,6 @@ private:
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
+	sigslot::scoped_connection sc_textures_loaded_;
 };
 } // namespace slade
@@ -0,0 +1,183 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapTileGrid.cpp
+// Description: MapTileGrid class - a uniform grid of world-space tiles over
+//              2d boxes, used to cull and cache map geometry per tile in the
+//              2d map view
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapTileGrid.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTileGrid::Box Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Extends the box to include the point [x,y]
+// -----------------------------------------------------------------------------
+void MapTileGrid::Box::extend(double x, double y)
+{
+	min.x = std::min(min.x, x);
+	min.y = std::min(min.y, y);
+	max.x = std::max(max.x, x);
+	max.y = std::max(max.y, y);
+}
+
+// -----------------------------------------------------------------------------
+// Extends the box to include [box]
+// -----------------------------------------------------------------------------
+void MapTileGrid::Box::extend(const Box& box)
+{
+	if (box.empty())
+		return;
+
+	extend(box.min.x, box.min.y);
+	extend(box.max.x, box.max.y);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTileGrid Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Removes all items and tiles, and sets the number of items to [n_items]
+// (all initially empty and not in any tile)
+// -----------------------------------------------------------------------------
+void MapTileGrid::clear(unsigned n_items)
+{
+	tiles_.clear();
+	bounds_dirty_.clear();
+	item_tile_.assign(n_items, NO_TILE);
+	item_slot_.assign(n_items, 0);
+	item_box_.assign(n_items, {});
+	item_size_.assign(n_items, 0.f);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the bounding [box] and [size] of [item], moving it to a different tile
+// if needed. [size] can be anything that is useful to know the maximum of for
+// a tile (eg. radius), an empty [box] removes the item from the grid.
+// Tile bounds aren't updated until updateBounds is called
+// -----------------------------------------------------------------------------
+void MapTileGrid::setItem(unsigned item, const Box& box, float size)
+{
+	if (item >= item_box_.size())
+		return;
+
+	// Move to new tile if needed
+	auto key = box.empty() ? NO_TILE : tileKey(box);
+	if (key != item_tile_[item])
+	{
+		removeItem(item);
+
+		if (key != NO_TILE)
+		{
+			auto& tile       = tiles_[key];
+			item_tile_[item] = key;
+			item_slot_[item] = tile.items.size();
+			tile.items.push_back(item);
+		}
+	}
+
+	item_box_[item]  = box;
+	item_size_[item] = size;
+
+	if (key != NO_TILE)
+	{
+		tiles_[key].version++;
+		bounds_dirty_.push_back(key);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Recalculates the bounds (and max item size) of all tiles that have changed
+// since the last update
+// -----------------------------------------------------------------------------
+void MapTileGrid::updateBounds()
+{
+	std::sort(bounds_dirty_.begin(), bounds_dirty_.end());
+	bounds_dirty_.erase(std::unique(bounds_dirty_.begin(), bounds_dirty_.end()), bounds_dirty_.end());
+
+	for (auto key : bounds_dirty_)
+	{
+		auto& tile    = tiles_[key];
+		tile.bounds   = {};
+		tile.max_size = 0.f;
+		for (auto item : tile.items)
+		{
+			tile.bounds.extend(item_box_[item]);
+			tile.max_size = std::max(tile.max_size, item_size_[item]);
+		}
+	}
+
+	bounds_dirty_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the key of the tile containing the centre of [box]
+// -----------------------------------------------------------------------------
+uint64_t MapTileGrid::tileKey(const Box& box) const
+{
+	auto tx = static_cast<int32_t>(std::floor((box.min.x + box.max.x) * 0.5 / tile_size_));
+	auto ty = static_cast<int32_t>(std::floor((box.min.y + box.max.y) * 0.5 / tile_size_));
+
+	return (static_cast<uint64_t>(static_cast<uint32_t>(tx)) << 32) | static_cast<uint32_t>(ty);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [item] from the tile it is currently in (if any)
+// -----------------------------------------------------------------------------
+void MapTileGrid::removeItem(unsigned item)
+{
+	if (item_tile_[item] == NO_TILE)
+		return;
+
+	// Swap with the last item in the tile and remove
+	auto& tile  = tiles_[item_tile_[item]];
+	auto  slot  = item_slot_[item];
+	auto  moved = tile.items.back();
+
+	tile.items[slot]  = moved;
+	item_slot_[moved] = slot;
+	tile.items.pop_back();
+	tile.version++;
+	bounds_dirty_.push_back(item_tile_[item]);
+
+	item_tile_[item] = NO_TILE;
+}
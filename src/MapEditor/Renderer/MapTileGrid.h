@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cfloat>
+#include <unordered_map>
+
+namespace slade
+{
+// A uniform grid of square world-space tiles over a set of numbered 2d boxes
+// (items), for quickly finding everything within (or near) a view.
+//
+// Each item is placed in the tile containing the centre of its box, and each
+// tile keeps the bounds of all its items, so a tile only needs to be checked
+// against the view rather than each item. Items can be moved or changed
+// individually, which marks the tiles involved as changed (via their version)
+// so any data cached per tile can be rebuilt
+class MapTileGrid
+{
+public:
+	struct Box
+	{
+		Vec2d min{ DBL_MAX, DBL_MAX };
+		Vec2d max{ -DBL_MAX, -DBL_MAX };
+
+		bool empty() const { return min.x > max.x || min.y > max.y; }
+		void extend(double x, double y);
+		void extend(const Box& box);
+		bool intersects(const Vec2d& tl, const Vec2d& br) const
+		{
+			return !(max.x < tl.x || min.x > br.x || max.y < tl.y || min.y > br.y);
+		}
+	};
+
+	struct Tile
+	{
+		Box              bounds;       // Bounds of all items in the tile
+		float            max_size = 0; // Largest item size (see setItem)
+		vector<unsigned> items;
+		unsigned long    version = 0; // Incremented whenever the tile's items change
+	};
+
+	MapTileGrid(double tile_size) : tile_size_{ tile_size } {}
+	~MapTileGrid() = default;
+
+	double     tileSize() const { return tile_size_; }
+	unsigned   nItems() const { return item_box_.size(); }
+	const Box& itemBox(unsigned item) const { return item_box_[item]; }
+	float      itemSize(unsigned item) const { return item_size_[item]; }
+
+	void clear(unsigned n_items = 0);
+	void setItem(unsigned item, const Box& box, float size = 0.f);
+	void updateBounds();
+
+	// Calls [func] with the key and tile of each non-empty tile with bounds
+	// intersecting the area from [tl] to [br]
+	template<typename F> void forEachTile(const Vec2d& tl, const Vec2d& br, F&& func) const
+	{
+		for (const auto& tile : tiles_)
+			if (!tile.second.items.empty() && tile.second.bounds.intersects(tl, br))
+				func(tile.first, tile.second);
+	}
+
+private:
+	static constexpr uint64_t NO_TILE = 0xFFFFFFFFFFFFFFFF;
+
+	double                             tile_size_ = 1024.;
+	std::unordered_map<uint64_t, Tile> tiles_;
+	vector<uint64_t>                   item_tile_; // Key of the tile containing each item, or NO_TILE
+	vector<unsigned>                   item_slot_; // Index of each item within its tile's items
+	vector<Box>                        item_box_;
+	vector<float>                      item_size_;
+	vector<uint64_t>                   bounds_dirty_; // Tiles needing their bounds recalculated
+
+	uint64_t tileKey(const Box& box) const;
+	void     removeItem(unsigned item);
+};
+} // namespace slade
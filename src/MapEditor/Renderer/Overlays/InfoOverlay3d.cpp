@@ -407,9 +407,9 @@ void InfoOverlay3D::update(int item_index, mapeditor::ItemType item_type, SLADEM
 
 		// Texture
 		if (item_type == mapeditor::ItemType::Floor)
-			texname_ = sector->floor().texture;
+			texname_ = sector->floor().texture.str();
 		else
-			texname_ = sector->ceiling().texture;
+			texname_ = sector->ceiling().texture.str();
 		texture_ = mapeditor::textureManager()
 					   .flat(texname_, game::configuration().featureSupported(Feature::MixTexFlats))
 					   .gl_id;
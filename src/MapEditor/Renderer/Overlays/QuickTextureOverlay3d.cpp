@@ -89,9 +89,9 @@ QuickTextureOverlay3d::QuickTextureOverlay3d(MapEditContext* editor) : MCOverlay
 		// Get initial texture
 		string tex_init;
 		if (sel[initial].type == mapeditor::ItemType::Ceiling)
-			tex_init = editor->map().sector(sel[initial].index)->ceiling().texture;
+			tex_init = editor->map().sector(sel[initial].index)->ceiling().texture.str();
 		else if (sel[initial].type == mapeditor::ItemType::Floor)
-			tex_init = editor->map().sector(sel[initial].index)->floor().texture;
+			tex_init = editor->map().sector(sel[initial].index)->floor().texture.str();
 		else if (sel[initial].type == mapeditor::ItemType::WallTop)
 			tex_init = editor->map().side(sel[initial].index)->texUpper();
 		else if (sel[initial].type == mapeditor::ItemType::WallMiddle)
@@ -88,8 +88,8 @@ void SectorInfoOverlay::update(MapSector* sector)
 	info_text += fmt::format("Tag: {}", sector->tag());
 
 	// Textures
-	ftex_ = sector->floor().texture;
-	ctex_ = sector->ceiling().texture;
+	ftex_ = sector->floor().texture.str();
+	ctex_ = sector->ceiling().texture.str();
 
 	// Setup text box
 	text_box_->setText(info_text);
@@ -235,8 +235,8 @@ void SectorTextureOverlay::openSectors(vector<MapSector*>& list)
 		sectors_.push_back(sector);
 
 		// Get textures
-		auto ftex = sector->floor().texture;
-		auto ctex = sector->ceiling().texture;
+		auto ftex = sector->floor().texture.str();
+		auto ctex = sector->ceiling().texture.str();
 
 		// Add floor texture if different
 		bool exists = false;
@@ -349,7 +349,7 @@ void SectorTextureOverlay::browseFloorTexture()
 	// Get initial texture
 	string texture;
 	if (tex_floor_.empty())
-		texture = sectors_[0]->floor().texture;
+		texture = sectors_[0]->floor().texture.str();
 	else
 		texture = tex_floor_[0];
 
@@ -374,7 +374,7 @@ void SectorTextureOverlay::browseCeilingTexture()
 	// Get initial texture
 	string texture;
 	if (tex_ceil_.empty())
-		texture = sectors_[0]->ceiling().texture;
+		texture = sectors_[0]->ceiling().texture.str();
 	else
 		texture = tex_ceil_[0];
 
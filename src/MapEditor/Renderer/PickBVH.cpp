@@ -0,0 +1,303 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    PickBVH.cpp
+// Description: PickBVH class - a bounding volume hierarchy over 3d boxes,
+//              used to find the objects a ray hits in 3d mode without testing
+//              every object
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PickBVH.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// PickBVH::Box Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Extends the box to include [point]
+// -----------------------------------------------------------------------------
+void PickBVH::Box::extend(const Vec3f& point)
+{
+	min.x = std::min(min.x, point.x);
+	min.y = std::min(min.y, point.y);
+	min.z = std::min(min.z, point.z);
+	max.x = std::max(max.x, point.x);
+	max.y = std::max(max.y, point.y);
+	max.z = std::max(max.z, point.z);
+}
+
+// -----------------------------------------------------------------------------
+// Extends the box to include [box]
+// -----------------------------------------------------------------------------
+void PickBVH::Box::extend(const Box& box)
+{
+	if (box.empty())
+		return;
+
+	extend(box.min);
+	extend(box.max);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the box is the same as [rhs]
+// -----------------------------------------------------------------------------
+bool PickBVH::Box::operator==(const Box& rhs) const
+{
+	return min.x == rhs.min.x && min.y == rhs.min.y && min.z == rhs.min.z && max.x == rhs.max.x
+		   && max.y == rhs.max.y && max.z == rhs.max.z;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// PickBVH Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns true if the tree should be rebuilt, either because a leaf that
+// wasn't in the tree now has a box, or because enough leaves have moved since
+// it was built that the refitted tree is likely to be inefficient
+// -----------------------------------------------------------------------------
+bool PickBVH::needsRebuild() const
+{
+	return missing_ || n_refitted_ > std::max<unsigned>(64, leaf_boxes_.size() / 4);
+}
+
+// -----------------------------------------------------------------------------
+// Clears the tree
+// -----------------------------------------------------------------------------
+void PickBVH::clear()
+{
+	nodes_.clear();
+	leaf_boxes_.clear();
+	leaf_order_.clear();
+	leaf_node_.clear();
+	dirty_nodes_.clear();
+	node_dirty_.clear();
+	n_refitted_ = 0;
+	missing_    = false;
+}
+
+// -----------------------------------------------------------------------------
+// Builds the tree from [leaf_boxes]. Leaves are numbered by their index in
+// [leaf_boxes], and leaves with empty boxes are left out of the tree
+// -----------------------------------------------------------------------------
+void PickBVH::build(vector<Box> leaf_boxes)
+{
+	clear();
+	leaf_boxes_ = std::move(leaf_boxes);
+	leaf_node_.assign(leaf_boxes_.size(), NONE);
+
+	for (unsigned a = 0; a < leaf_boxes_.size(); a++)
+		if (!leaf_boxes_[a].empty())
+			leaf_order_.push_back(a);
+
+	if (leaf_order_.empty())
+		return;
+
+	nodes_.reserve(leaf_order_.size() * 2 / MAX_LEAVES_PER_NODE + 1);
+	nodes_.emplace_back();
+	buildNode(0, 0, leaf_order_.size(), 0);
+	node_dirty_.assign(nodes_.size(), false);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the box of [leaf] to [box]. The tree isn't updated until refit() is
+// called
+// -----------------------------------------------------------------------------
+void PickBVH::updateLeaf(unsigned leaf, const Box& box)
+{
+	if (leaf >= leaf_boxes_.size() || leaf_boxes_[leaf] == box)
+		return;
+
+	leaf_boxes_[leaf] = box;
+
+	// Can't be refitted if it isn't in the tree
+	auto node = leaf_node_[leaf];
+	if (node == NONE)
+	{
+		if (!box.empty())
+			missing_ = true;
+		return;
+	}
+
+	if (!node_dirty_[node])
+	{
+		node_dirty_[node] = true;
+		dirty_nodes_.push_back(node);
+	}
+	n_refitted_++;
+}
+
+// -----------------------------------------------------------------------------
+// Refits the tree around any leaf boxes changed since the last refit
+// -----------------------------------------------------------------------------
+void PickBVH::refit()
+{
+	if (dirty_nodes_.empty())
+		return;
+
+	// Mark all ancestors of changed nodes
+	for (unsigned a = 0; a < dirty_nodes_.size(); a++)
+	{
+		auto parent = nodes_[dirty_nodes_[a]].parent;
+		if (parent != NONE && !node_dirty_[parent])
+		{
+			node_dirty_[parent] = true;
+			dirty_nodes_.push_back(parent);
+		}
+	}
+
+	// Children always come after their parent, so refitting in reverse index
+	// order updates all children before their parents
+	std::sort(dirty_nodes_.begin(), dirty_nodes_.end(), std::greater<>());
+	for (auto index : dirty_nodes_)
+	{
+		fitNode(index);
+		node_dirty_[index] = false;
+	}
+	dirty_nodes_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Builds the node at [index] from [count] leaves starting at [first] in the
+// leaf order, splitting it into child nodes if needed
+// -----------------------------------------------------------------------------
+void PickBVH::buildNode(unsigned index, unsigned first, unsigned count, unsigned depth)
+{
+	// Get bounds of leaf boxes and their centres
+	Box bounds, centres;
+	for (unsigned a = first; a < first + count; a++)
+	{
+		auto& box = leaf_boxes_[leaf_order_[a]];
+		bounds.extend(box);
+		centres.extend(box.centre());
+	}
+	nodes_[index].box = bounds;
+
+	// Make a leaf node if there are few enough leaves (or the tree is too deep)
+	auto size = centres.empty() ? Vec3f{} : centres.max - centres.min;
+	if (count <= MAX_LEAVES_PER_NODE || depth >= MAX_DEPTH - 2 || (size.x <= 0 && size.y <= 0 && size.z <= 0))
+	{
+		nodes_[index].first = first;
+		nodes_[index].count = count;
+		for (unsigned a = first; a < first + count; a++)
+			leaf_node_[leaf_order_[a]] = index;
+		return;
+	}
+
+	// Split at the median along the longest axis
+	int axis = 0;
+	if (size.y > size.x && size.y >= size.z)
+		axis = 1;
+	else if (size.z > size.x && size.z > size.y)
+		axis = 2;
+	auto axisValue = [&](unsigned leaf) {
+		auto centre = leaf_boxes_[leaf].centre();
+		return axis == 0 ? centre.x : axis == 1 ? centre.y : centre.z;
+	};
+	auto half = count / 2;
+	std::nth_element(
+		leaf_order_.begin() + first,
+		leaf_order_.begin() + first + half,
+		leaf_order_.begin() + first + count,
+		[&](unsigned left, unsigned right) { return axisValue(left) < axisValue(right); });
+
+	// Add children
+	unsigned child      = nodes_.size();
+	nodes_[index].first = child;
+	nodes_[index].count = 0;
+	nodes_.resize(child + 2);
+	nodes_[child].parent     = index;
+	nodes_[child + 1].parent = index;
+	buildNode(child, first, half, depth + 1);
+	buildNode(child + 1, first + half, count - half, depth + 1);
+}
+
+// -----------------------------------------------------------------------------
+// Recalculates the box of the node at [index] from its leaves or children
+// -----------------------------------------------------------------------------
+void PickBVH::fitNode(unsigned index)
+{
+	auto& node = nodes_[index];
+	Box   box;
+	if (node.count > 0)
+	{
+		for (unsigned a = node.first; a < node.first + node.count; a++)
+			box.extend(leaf_boxes_[leaf_order_[a]]);
+	}
+	else
+	{
+		box.extend(nodes_[node.first].box);
+		box.extend(nodes_[node.first + 1].box);
+	}
+	node.box = box;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the distance along a ray from [origin] at which it enters [box], 0
+// if [origin] is within [box], or -1 if it doesn't hit [box] within
+// [max_dist]. [inv] is the reciprocal of the ray direction
+// -----------------------------------------------------------------------------
+double PickBVH::rayEntry(const Box& box, const Vec3d& origin, const Vec3d& inv, double max_dist)
+{
+	if (box.empty())
+		return -1.;
+
+	// Narrows the entry/exit distances to where the ray is between [min] and
+	// [max] on one axis, returns false if it never is
+	double t_min = 0.;
+	double t_max = max_dist;
+	auto   slab  = [&](double min, double max, double start, double inv_dir) {
+		// Ray is parallel to the slab (inv_dir is infinite), so it is either
+		// always or never within it. This has to be checked separately as
+		// 0 * inf (for a zero-thickness box) is NaN
+		if (std::isinf(inv_dir))
+			return start >= min && start <= max;
+
+		double t1 = (min - start) * inv_dir;
+		double t2 = (max - start) * inv_dir;
+		t_min     = std::max(t_min, std::min(t1, t2));
+		t_max     = std::min(t_max, std::max(t1, t2));
+		return t_min <= t_max;
+	};
+
+	if (!slab(box.min.x, box.max.x, origin.x, inv.x) || !slab(box.min.y, box.max.y, origin.y, inv.y)
+		|| !slab(box.min.z, box.max.z, origin.z, inv.z))
+		return -1.;
+
+	return t_min;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cfloat>
+
+namespace slade
+{
+// A bounding volume hierarchy over a set of numbered 3d boxes (leaves), for
+// quickly finding what a ray hits. Leaf boxes can be changed after the tree
+// is built, in which case the tree is refitted around them rather than
+// rebuilt, until it has degraded enough that needsRebuild() returns true.
+//
+// The tree only knows about boxes - castRay calls back with each leaf whose
+// box the ray passes through (nearest first, roughly) to test the actual
+// object(s) it contains
+class PickBVH
+{
+public:
+	struct Box
+	{
+		Vec3f min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vec3f max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		bool  empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+		Vec3f centre() const { return { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f }; }
+		void  extend(const Vec3f& point);
+		void  extend(const Box& box);
+		bool  operator==(const Box& rhs) const;
+	};
+
+	static constexpr unsigned NONE = 0xFFFFFFFF;
+
+	PickBVH()  = default;
+	~PickBVH() = default;
+
+	unsigned   nLeaves() const { return leaf_boxes_.size(); }
+	const Box& leafBox(unsigned leaf) const { return leaf_boxes_[leaf]; }
+	bool       needsRebuild() const;
+
+	void clear();
+	void build(vector<Box> leaf_boxes);
+	void updateLeaf(unsigned leaf, const Box& box);
+	void refit();
+
+	// Casts a ray from [origin] in [dir], calling [test] for each leaf whose
+	// box it passes through. [test] is given the leaf index and the closest
+	// hit distance so far, and returns the distance to its own hit (or a
+	// negative value if nothing in the leaf was hit). Leaves further away than
+	// the closest hit are skipped. Returns the closest hit distance, or -1
+	template<typename F> double castRay(const Vec3d& origin, const Vec3d& dir, double max_dist, F&& test) const
+	{
+		if (nodes_.empty())
+			return -1.;
+
+		Vec3d  inv(1. / dir.x, 1. / dir.y, 1. / dir.z);
+		double closest = max_dist > 0 ? max_dist : DBL_MAX;
+		double hit     = -1.;
+
+		// Traverse nearest child first, so later boxes can be skipped once
+		// something has been hit
+		unsigned stack[MAX_DEPTH];
+		unsigned n_stack = 0;
+		if (rayEntry(nodes_[0].box, origin, inv, closest) >= 0.)
+			stack[n_stack++] = 0;
+		while (n_stack > 0)
+		{
+			auto& node = nodes_[stack[--n_stack]];
+
+			if (node.count > 0)
+			{
+				// Leaf node, test each leaf
+				for (unsigned a = node.first; a < node.first + node.count; a++)
+				{
+					auto dist = test(leaf_order_[a], closest);
+					if (dist >= 0. && dist < closest)
+					{
+						closest = dist;
+						hit     = dist;
+					}
+				}
+				continue;
+			}
+
+			auto d1 = rayEntry(nodes_[node.first].box, origin, inv, closest);
+			auto d2 = rayEntry(nodes_[node.first + 1].box, origin, inv, closest);
+			if (d1 >= 0. && d2 >= 0.)
+			{
+				// Push the further child first so the nearer one is visited first
+				stack[n_stack++] = d1 < d2 ? node.first + 1 : node.first;
+				stack[n_stack++] = d1 < d2 ? node.first : node.first + 1;
+			}
+			else if (d1 >= 0.)
+				stack[n_stack++] = node.first;
+			else if (d2 >= 0.)
+				stack[n_stack++] = node.first + 1;
+		}
+
+		return hit;
+	}
+
+private:
+	// A tree node. Internal nodes have count 0 and their children at first
+	// and first + 1, leaf nodes have [count] leaves from leaf_order_[first]
+	struct Node
+	{
+		Box      box;
+		unsigned first  = 0;
+		unsigned count  = 0;
+		unsigned parent = NONE;
+	};
+
+	static constexpr unsigned MAX_LEAVES_PER_NODE = 4;
+	static constexpr unsigned MAX_DEPTH           = 64;
+
+	vector<Node>     nodes_;
+	vector<Box>      leaf_boxes_;
+	vector<unsigned> leaf_order_;
+	vector<unsigned> leaf_node_; // Node containing each leaf, or NONE if not in the tree (empty box)
+	vector<unsigned> dirty_nodes_;
+	vector<bool>     node_dirty_;
+	unsigned         n_refitted_ = 0;
+	bool             missing_    = false; // A leaf not in the tree has become non-empty
+
+	void buildNode(unsigned index, unsigned first, unsigned count, unsigned depth);
+	void fitNode(unsigned index);
+
+	static double rayEntry(const Box& box, const Vec3d& origin, const Vec3d& inv, double max_dist);
+};
+} // namespace slade
@@ -36,8 +36,10 @@
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/ColourConfiguration.h"
+#include "FrameProfiler.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/MapTextureManager.h"
 #include "OpenGL/Drawing.h"
 #include "OpenGL/OpenGL.h"
 #include "Overlays/MCOverlay.h"
@@ -529,7 +531,7 @@ void Renderer::drawEditorMessages() const
 {
 	int yoff = 0;
 	if (map_showfps)
-		yoff = 16;
+		yoff = 90; // Below the frame profiler graph
 	auto col_fg = colourconfig::colour("map_editor_message");
 	auto col_bg = colourconfig::colour("map_editor_message_outline");
 	drawing::setTextState(true);
@@ -975,7 +977,10 @@ void Renderer::drawMap2d()
 
 	// Update visibility info if needed
 	if (!renderer_2d_.visOK())
+	{
+		FrameProfiler::Scope scope("Visibility");
 		renderer_2d_.updateVisibility(view_.mapBounds().tl, view_.mapBounds().br);
+	}
 
 	// Draw flats if needed
 	gl::setColour(ColRGBA::WHITE, gl::Blend::Normal);
@@ -1234,11 +1239,22 @@ void Renderer::draw()
 	glDisableClientState(GL_COLOR_ARRAY);
 	glDisable(GL_TEXTURE_2D);
 
+	// Upload any textures that have finished loading in the background
+	{
+		FrameProfiler::Scope scope("Texture uploads");
+		mapeditor::textureManager().update();
+	}
+
 	// Draw 2d or 3d map depending on mode
-	if (context_.editMode() == Mode::Visual)
-		drawMap3d();
-	else
-		drawMap2d();
+	{
+		FrameProfiler::Scope scope("Map", true);
+		if (context_.editMode() == Mode::Visual)
+			drawMap3d();
+		else
+			drawMap2d();
+	}
+
+	FrameProfiler::Scope overlays_scope("Overlays", true);
 
 	// Draw info overlay
 	glDisable(GL_CULL_FACE);
@@ -1318,22 +1334,9 @@ void Renderer::draw()
 		}
 	}
 
-	// FPS counter
-	/*if (map_showfps)
-	{
-		glEnable(GL_TEXTURE_2D);
-		if (frametime_last > 0)
-		{
-			int fps = MathStuff::round(1.0 / (frametime_last / 1000.0));
-			fps_avg.push_back(fps);
-			if (fps_avg.size() > 20) fps_avg.erase(fps_avg.begin());
-		}
-		int afps = 0;
-		for (unsigned a = 0; a < fps_avg.size(); a++)
-			afps += fps_avg[a];
-		if (fps_avg.size() > 0) afps /= fps_avg.size();
-		Drawing::drawText(fmt::format("FPS: {}", afps));
-	}*/
+	// Frame profiler graph
+	if (map_showfps)
+		profiler().drawGraph(4, 4);
 
 	// test
 	// Drawing::drawText(fmt::format("Render distance: {:1.2f}", (double)render_max_dist), 0, 100);
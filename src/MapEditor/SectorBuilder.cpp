@@ -52,62 +52,37 @@ typedef std::map<MapLine*, int> MapLineSet;
 
 // -----------------------------------------------------------------------------
 // Finds the next adjacent edge to [edge], ie the adjacent edge that creates the
-// smallest angle
+// smallest angle. The outgoing edges of each vertex are kept sorted by angle in
+// the map topology, so this is the first edge anticlockwise from [edge]'s twin
+// that hasn't already been traversed
 // -----------------------------------------------------------------------------
-SectorBuilder::Edge nextEdge(SectorBuilder::Edge edge, MapLineSet& visited_lines)
+SectorBuilder::Edge nextEdge(MapTopology& topology, SectorBuilder::Edge edge, MapLineSet& visited_lines)
 {
-	// Get relevant vertices
-	auto vertex      = edge.line->v2(); // Vertex to be tested
-	auto vertex_prev = edge.line->v1(); // 'Previous' vertex
-	if (!edge.front)
-	{
-		vertex      = edge.line->v1();
-		vertex_prev = edge.line->v2();
-	}
+	MapTopology::HalfEdge twin{ edge.line, !edge.front };
+	auto&                 fan = topology.outgoing(twin.origin());
 
-	// Find next connected line with the lowest angle
-	double              min_angle = 2 * math::PI;
+	// Find the twin in the vertex's outgoing edges
+	unsigned start = 0;
+	while (start < fan.size() && fan[start] != twin)
+		start++;
+
+	// Find next edge anticlockwise from the twin
 	SectorBuilder::Edge next;
-	for (unsigned a = 0; a < vertex->nConnectedLines(); a++)
+	for (unsigned a = 1; a <= fan.size(); a++)
 	{
-		auto line = vertex->connectedLine(a);
+		auto& out = fan[(start + a) % fan.size()];
 
 		// Ignore original line
-		if (line == edge.line)
-			continue;
-
-		// Ignore if zero-length
-		if (line->v1() == line->v2())
+		if (out.line == edge.line)
 			continue;
 
-		// Get next vertex
-		MapVertex* vertex_next;
-		bool       front = true;
-		if (line->v1() == vertex)
-			vertex_next = line->v2();
-		else
-		{
-			vertex_next = line->v1();
-			front       = false;
-		}
-
 		// Ignore already-traversed lines
-		if (visited_lines[line] & (front ? 1 : 2))
+		if (visited_lines[out.line] & (out.front ? 1 : 2))
 			continue;
 
-		// Determine angle between lines
-		double angle = math::angle2DRad(
-			{ vertex_prev->xPos(), vertex_prev->yPos() },
-			{ vertex->xPos(), vertex->yPos() },
-			{ vertex_next->xPos(), vertex_next->yPos() });
-
-		// Check if minimum angle
-		if (angle < min_angle)
-		{
-			min_angle  = angle;
-			next.line  = line;
-			next.front = front;
-		}
+		next.line  = out.line;
+		next.front = out.front;
+		break;
 	}
 
 	// Return the next edge found
@@ -195,7 +170,7 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 			vertex_right_ = edge.line->v2();
 
 		// Get next edge
-		Edge edge_next = nextEdge(edge, visited_lines);
+		Edge edge_next = nextEdge(map_->topology(), edge, visited_lines);
 		log::info(
 			4,
 			"Got next edge line {}, {}",
@@ -211,8 +186,8 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 		}
 
 		// Discard edge vertices
-		vertex_valid_[edge_next.line->v1Index()] = false;
-		vertex_valid_[edge_next.line->v2Index()] = false;
+		vertex_discarded_.insert(edge_next.line->v1());
+		vertex_discarded_.insert(edge_next.line->v2());
 
 		// Check if we're back to the start
 		if (edge_next.line == o_edges_[0].line && edge_next.front == o_edges_[0].front)
@@ -310,20 +285,48 @@ bool SectorBuilder::pointWithinOutline(double x, double y)
 }
 
 // -----------------------------------------------------------------------------
-// Discards any vertices outside of the current outline
+// Discards any vertices outside of the current outline.
+// Until the outmost (clockwise) outline has been found, only vertices within
+// the bounding box of the current outline can be outside of it, so only those
+// are checked. Once it has been found, the vertices within it become the list
+// of candidates for finding inner edges
 // -----------------------------------------------------------------------------
 void SectorBuilder::discardOutsideVertices()
 {
-	// Go through valid vertices list
-	for (unsigned a = 0; a < vertex_valid_.size(); a++)
+	// Get candidate vertices within the outmost outline
+	if (!candidates_found_)
 	{
-		// Skip if already discarded
-		if (!vertex_valid_[a])
-			continue;
+		vector<MapVertex*> vertices;
+		map_->topology().putVerticesWithin(o_bbox_, vertices);
+
+		for (auto vertex : vertices)
+		{
+			if (vertex_discarded_.count(vertex) > 0)
+				continue;
+
+			if (!pointWithinOutline(vertex->xPos(), vertex->yPos()))
+				vertex_discarded_.insert(vertex);
+			else if (o_clockwise_)
+				vertex_candidates_.push_back(vertex);
+		}
 
-		// Discard if outside the current outline
-		if (!pointWithinOutline(map_->vertex(a)->xPos(), map_->vertex(a)->yPos()))
-			vertex_valid_[a] = false;
+		candidates_found_ = o_clockwise_;
+		return;
+	}
+
+	// Go through candidate vertices list
+	for (unsigned a = 0; a < vertex_candidates_.size(); a++)
+	{
+		auto vertex = vertex_candidates_[a];
+
+		// Discard if already discarded or outside the current outline
+		if (vertex_discarded_.count(vertex) > 0 || !pointWithinOutline(vertex->xPos(), vertex->yPos()))
+		{
+			vertex_discarded_.insert(vertex);
+			vertex_candidates_[a] = vertex_candidates_.back();
+			vertex_candidates_.pop_back();
+			a--;
+		}
 	}
 }
 
@@ -337,71 +340,9 @@ SectorBuilder::Edge SectorBuilder::findOuterEdge() const
 	if (!vertex_right_)
 		return { nullptr };
 
-	// Init
-	double   vr_x     = vertex_right_->xPos();
-	double   vr_y     = vertex_right_->yPos();
-	double   min_dist = 999999999;
-	MapLine* nearest  = nullptr;
-
-	// LOG_DEBUG("Finding outer edge from vertex", vertex_right, "at", vertex_right->point());
-
 	// Fire a ray east from the vertex and find the first line it crosses
-	MapLine* line = nullptr;
-	for (unsigned a = 0; a < map_->nLines(); a++)
-	{
-		line = map_->line(a);
-
-		// Ignore if the line is completely left of the vertex
-		if (line->x1() <= vr_x && line->x2() <= vr_x)
-			continue;
-
-		// Ignore horizontal lines
-		if (line->y1() == line->y2())
-			continue;
-
-		// Ignore if the line doesn't intersect the y value
-		if ((line->y1() < vr_y && line->y2() < vr_y) || (line->y1() > vr_y && line->y2() > vr_y))
-			continue;
-
-		// Get x intercept
-		double int_frac = (vr_y - line->y1()) / (line->y2() - line->y1());
-		double int_x    = line->x1() + ((line->x2() - line->x1()) * int_frac);
-		double dist     = fabs(int_x - vr_x);
-
-		// Check if closest
-		if (!nearest || dist < min_dist)
-		{
-			min_dist = dist;
-			nearest  = line;
-		}
-		else if (fabs(dist - min_dist) < 0.001)
-		{
-			// In the case of a tie, use the distance to each line as a
-			// tiebreaker -- this fixes cases where the ray hits a vertex
-			// shared by two lines.  Choosing the further line would mean
-			// choosing an inner edge, which is clearly wrong.
-			double line_dist    = math::distanceToLineFast(vertex_right_->position(), line->seg());
-			double nearest_dist = math::distanceToLineFast(vertex_right_->position(), nearest->seg());
-			if (line_dist < nearest_dist)
-			{
-				min_dist = dist;
-				nearest  = line;
-			}
-		}
-	}
-
-	// Check for valid line
-	if (!nearest)
-		return { nullptr };
-
-
-	// Determine the edge side
-	double side = math::lineSide(vertex_right_->position(), nearest->seg());
-	// LOG_DEBUG("Found next outer line", nearest, "on side", side);
-	if (side >= 0)
-		return Edge{ nearest, true };
-	else
-		return Edge{ nearest, false };
+	auto edge = map_->topology().edgeRightOf(vertex_right_->position());
+	return { edge.line, edge.front };
 }
 
 // -----------------------------------------------------------------------------
@@ -412,22 +353,15 @@ SectorBuilder::Edge SectorBuilder::findInnerEdge()
 {
 	// Find rightmost non-discarded vertex
 	vertex_right_ = nullptr;
-	for (unsigned a = 0; a < vertex_valid_.size(); a++)
+	for (auto vertex : vertex_candidates_)
 	{
 		// Ignore if discarded
-		if (!vertex_valid_[a])
-			continue;
-
-		// Set rightmost if no current rightmost vertex
-		if (!vertex_right_)
-		{
-			vertex_right_ = map_->vertex(a);
+		if (vertex_discarded_.count(vertex) > 0)
 			continue;
-		}
 
 		// Check if the vertex is rightmost
-		if (map_->vertex(a)->xPos() > vertex_right_->xPos())
-			vertex_right_ = map_->vertex(a);
+		if (!vertex_right_ || vertex->xPos() > vertex_right_->xPos())
+			vertex_right_ = vertex;
 	}
 
 	// If no vertex was found, we're done
@@ -473,7 +407,7 @@ SectorBuilder::Edge SectorBuilder::findInnerEdge()
 	if (!eline)
 	{
 		// Discard vertex and try again
-		vertex_valid_[vertex_right_->index()] = false;
+		vertex_discarded_.insert(vertex_right_);
 		return findInnerEdge();
 	}
 
@@ -607,10 +541,10 @@ bool SectorBuilder::traceSector(SLADEMap* map, MapLine* line, bool front)
 	sector_edges_.clear();
 	error_ = "Unknown error";
 
-	// Create valid vertices list
-	vertex_valid_.clear();
-	for (unsigned a = 0; a < map->nVertices(); a++)
-		vertex_valid_.push_back(true);
+	// Clear vertex lists
+	vertex_discarded_.clear();
+	vertex_candidates_.clear();
+	candidates_found_ = false;
 
 	// Find outmost outline
 	for (unsigned a = 0; a < 10000; a++)
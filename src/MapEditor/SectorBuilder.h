@@ -47,10 +47,12 @@ public:
 	void drawResult();
 
 private:
-	vector<bool> vertex_valid_;
-	SLADEMap*    map_ = nullptr;
-	vector<Edge> sector_edges_;
-	string       error_;
+	std::set<MapVertex*> vertex_discarded_;
+	vector<MapVertex*>   vertex_candidates_;
+	bool                 candidates_found_ = false;
+	SLADEMap*            map_              = nullptr;
+	vector<Edge>         sector_edges_;
+	string               error_;
 
 	// Current outline
 	vector<Edge> o_edges_;
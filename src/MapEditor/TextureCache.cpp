@@ -0,0 +1,390 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureCache.cpp
+// Description: TextureCache class - a persistent on-disk cache of decoded map
+//              editor texture images
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureCache.h"
+#include "App.h"
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/SImage/SImage.h"
+#include "Utility/FileUtils.h"
+#include "Utility/StringUtils.h"
+
+using namespace slade;
+namespace fs = std::filesystem;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, map_tex_cache, true, CVar::Flag::Save)
+CVAR(Int, map_tex_cache_size, 256, CVar::Flag::Save) // Maximum size in MB
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Increase if the cached image format (or how images are decoded) changes
+constexpr uint32_t CACHE_VERSION = 1;
+
+struct FileHeader
+{
+	char     magic[4] = { 'S', 'T', 'C', 'I' };
+	uint32_t version  = CACHE_VERSION;
+	uint64_t key      = 0;
+	int32_t  width    = 0;
+	int32_t  height   = 0;
+	int32_t  offset_x = 0;
+	int32_t  offset_y = 0;
+	uint16_t pal_size = 0; // Number of palette colours following the header
+	uint8_t  type     = 0;
+	uint8_t  has_mask = 0;
+};
+
+// -----------------------------------------------------------------------------
+// Returns the size of the image data following [header] in a cache file
+// -----------------------------------------------------------------------------
+unsigned dataSize(const FileHeader& header)
+{
+	unsigned n_pixels = header.width * header.height;
+	unsigned size     = header.pal_size * 4;
+	size += n_pixels * (header.type == static_cast<uint8_t>(SImage::Type::RGBA) ? 4 : 1);
+	if (header.has_mask)
+		size += n_pixels;
+
+	return size;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the maximum size of the cache in bytes
+// -----------------------------------------------------------------------------
+uint64_t cacheSizeLimit()
+{
+	return static_cast<uint64_t>(std::max(*map_tex_cache_size, 0)) * 1024 * 1024;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureCache::Key Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Adds [size] bytes of [data] to the key
+// -----------------------------------------------------------------------------
+TextureCache::Key& TextureCache::Key::add(const void* data, unsigned size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (unsigned a = 0; a < size; a++)
+	{
+		hash_ ^= bytes[a];
+		hash_ *= 1099511628211ull;
+	}
+
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+// Adds all colours in [palette] to the key
+// -----------------------------------------------------------------------------
+TextureCache::Key& TextureCache::Key::add(const Palette& palette)
+{
+	for (const auto& colour : palette.colours())
+	{
+		uint8_t rgba[] = { colour.r, colour.g, colour.b, colour.a };
+		add(rgba, 4);
+	}
+
+	return *this;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureCache Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Reads the image cached for [key] into [image].
+// Returns false if there is no (valid) cached image for [key]
+// -----------------------------------------------------------------------------
+bool TextureCache::read(const Key& key, SImage& image)
+{
+	if (!map_tex_cache)
+		return false;
+
+	string path;
+	{
+		std::lock_guard lock(mutex_);
+		if (!scanned_)
+			scan();
+
+		// Check the image is in the cache before trying to open anything
+		if (files_.find(key.hash()) == files_.end())
+			return false;
+
+		path = filePath(key.hash());
+	}
+
+	// Map the file and check its header
+	MappedFile file(path);
+	FileHeader header;
+	if (!file.isOpen() || file.size() < sizeof(FileHeader))
+		return false;
+	memcpy(&header, file.data(), sizeof(FileHeader));
+	if (memcmp(header.magic, FileHeader{}.magic, 4) != 0 || header.version != CACHE_VERSION
+		|| header.key != key.hash() || header.width <= 0 || header.height <= 0
+		|| header.type > static_cast<uint8_t>(SImage::Type::AlphaMap)
+		|| file.size() != sizeof(FileHeader) + dataSize(header))
+		return false;
+
+	// Palette
+	auto    data = file.data() + sizeof(FileHeader);
+	Palette palette(header.pal_size);
+	for (unsigned a = 0; a < header.pal_size; a++, data += 4)
+		palette.setColour(a, { data[0], data[1], data[2], data[3] });
+
+	// Image data
+	auto type   = static_cast<SImage::Type>(header.type);
+	auto pixels = data;
+	auto mask   = header.has_mask ? data + header.width * header.height : nullptr;
+	if (!image.setImageData(pixels, mask, header.width, header.height, type))
+		return false;
+	if (header.pal_size > 0)
+		image.setPalette(&palette);
+	image.setXOffset(header.offset_x);
+	image.setYOffset(header.offset_y);
+
+	// Mark as recently used
+	std::error_code ec;
+	auto            now = fs::file_time_type::clock::now();
+	fs::last_write_time(path, now, ec);
+	std::lock_guard lock(mutex_);
+	auto            cached = files_.find(key.hash());
+	if (cached != files_.end())
+		cached->second.last_used = now;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [image] to the cache for [key], replacing any existing cached image.
+// The least recently used images are removed afterwards if the cache is over
+// its size limit
+// -----------------------------------------------------------------------------
+void TextureCache::write(const Key& key, SImage& image)
+{
+	if (!map_tex_cache || !image.isValid() || image.type() == SImage::Type::Unknown)
+		return;
+
+	// Setup header
+	FileHeader header;
+	header.key      = key.hash();
+	header.width    = image.width();
+	header.height   = image.height();
+	header.offset_x = image.offset().x;
+	header.offset_y = image.offset().y;
+	header.pal_size = image.hasPalette() ? image.palette()->colours().size() : 0;
+	header.type     = static_cast<uint8_t>(image.type());
+	header.has_mask = image.type() == SImage::Type::PalMask
+					  && image.maskData().size() == static_cast<unsigned>(image.width() * image.height());
+
+	// Build file data
+	vector<uint8_t> data(sizeof(FileHeader));
+	memcpy(data.data(), &header, sizeof(FileHeader));
+	for (unsigned a = 0; a < header.pal_size; a++)
+	{
+		auto colour = image.palette()->colour(a);
+		data.insert(data.end(), { colour.r, colour.g, colour.b, colour.a });
+	}
+	data.insert(data.end(), image.pixelData().data(), image.pixelData().data() + image.pixelData().size());
+	if (header.has_mask)
+		data.insert(data.end(), image.maskData().data(), image.maskData().data() + image.maskData().size());
+	if (data.size() != sizeof(FileHeader) + dataSize(header))
+		return;
+
+	// Get paths
+	string path, temp_path;
+	{
+		std::lock_guard lock(mutex_);
+		if (!scanned_)
+			scan();
+
+		path      = filePath(key.hash());
+		temp_path = fmt::format("{}.{}.tmp", path, n_temp_++);
+	}
+
+	// Write to a temporary file first, then move it into place so that a
+	// partially written file is never read
+	{
+		SFile file(temp_path, SFile::Mode::Write);
+		if (!file.isOpen())
+			return;
+		if (!file.write(data.data(), data.size()))
+		{
+			file.close();
+			fileutil::removeFile(temp_path);
+			return;
+		}
+	}
+	std::error_code ec;
+	fs::rename(temp_path, path, ec);
+	if (ec)
+	{
+		fs::remove(temp_path, ec);
+		return;
+	}
+
+	// Add to cache
+	std::lock_guard lock(mutex_);
+	auto&           file = files_[key.hash()];
+	total_size_ -= file.size;
+	total_size_ += data.size();
+	file.size      = data.size();
+	file.last_used = fs::file_time_type::clock::now();
+
+	if (total_size_ > cacheSizeLimit())
+		evict();
+}
+
+// -----------------------------------------------------------------------------
+// Removes all cached images
+// -----------------------------------------------------------------------------
+void TextureCache::clear()
+{
+	std::lock_guard lock(mutex_);
+	if (!scanned_)
+		scan();
+
+	std::error_code ec;
+	for (const auto& file : files_)
+		fs::remove(filePath(file.first), ec);
+
+	files_.clear();
+	total_size_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the path to the cache file for [key]
+// -----------------------------------------------------------------------------
+string TextureCache::filePath(uint64_t key) const
+{
+	return fmt::format("{}/{:016x}.stc", dir_, key);
+}
+
+// -----------------------------------------------------------------------------
+// Creates the cache directory if needed and finds all currently cached images.
+// The mutex must be locked when this is called
+// -----------------------------------------------------------------------------
+void TextureCache::scan()
+{
+	scanned_ = true;
+	dir_     = app::path(dir_name_, app::Dir::User);
+
+	std::error_code ec;
+	fs::create_directories(dir_, ec);
+
+	for (const auto& item : fs::directory_iterator(dir_, ec))
+	{
+		if (!item.is_regular_file(ec))
+			continue;
+
+		// Remove any temporary files left over from an interrupted write
+		auto filename = item.path().filename().string();
+		if (strutil::endsWith(filename, ".tmp"))
+		{
+			fs::remove(item.path(), ec);
+			continue;
+		}
+
+		// Get key from filename
+		if (filename.size() != 20 || !strutil::endsWith(filename, ".stc"))
+			continue;
+		uint64_t key = 0;
+		try
+		{
+			key = std::stoull(filename.substr(0, 16), nullptr, 16);
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+
+		auto& file     = files_[key];
+		file.size      = item.file_size(ec);
+		file.last_used = item.last_write_time(ec);
+		total_size_ += file.size;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes the least recently used images until the cache is below 90% of its
+// size limit. The mutex must be locked when this is called
+// -----------------------------------------------------------------------------
+void TextureCache::evict()
+{
+	// Sort cached images by when they were last used (oldest first)
+	vector<std::pair<fs::file_time_type, uint64_t>> by_use;
+	by_use.reserve(files_.size());
+	for (const auto& file : files_)
+		by_use.emplace_back(file.second.last_used, file.first);
+	std::sort(by_use.begin(), by_use.end());
+
+	// Remove until under the limit
+	auto            limit = cacheSizeLimit() / 10 * 9;
+	std::error_code ec;
+	for (const auto& item : by_use)
+	{
+		if (total_size_ <= limit)
+			break;
+
+		// Keep the image (and its size) if it couldn't be removed (a file
+		// that's already gone is fine)
+		fs::remove(filePath(item.second), ec);
+		if (ec)
+			continue;
+
+		auto file = files_.find(item.second);
+		total_size_ -= file->second.size;
+		files_.erase(file);
+	}
+}
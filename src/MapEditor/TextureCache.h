@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+namespace slade
+{
+class SImage;
+class Palette;
+
+// Persistent on-disk cache of decoded (and composited) map editor texture
+// images, so they don't need to be decoded again the next time they are
+// loaded. Images are stored in their native format (paletted + mask or RGBA),
+// one file per image, named by a hash of everything the image was built from.
+//
+// Cached files are memory-mapped when read, and the least recently used ones
+// are removed once the total size of the cache goes over the limit set by the
+// map_tex_cache_size cvar. All functions are thread-safe
+class TextureCache
+{
+public:
+	// Builds a key (64-bit FNV-1a hash) from the source data of an image
+	class Key
+	{
+	public:
+		Key& add(const void* data, unsigned size);
+		Key& add(string_view str) { return add(str.data(), str.size()); }
+		Key& add(int value) { return add(&value, sizeof(int)); }
+		Key& add(const Palette& palette);
+
+		uint64_t hash() const { return hash_; }
+
+	private:
+		uint64_t hash_ = 14695981039346656037ull;
+	};
+
+	TextureCache(string_view dir_name) : dir_name_{ dir_name } {}
+	~TextureCache() = default;
+
+	bool read(const Key& key, SImage& image);
+	void write(const Key& key, SImage& image);
+	void clear();
+
+private:
+	struct File
+	{
+		unsigned                        size = 0;
+		std::filesystem::file_time_type last_used;
+	};
+
+	string                             dir_name_;
+	string                             dir_;
+	std::mutex                         mutex_;
+	std::unordered_map<uint64_t, File> files_;
+	bool                               scanned_    = false;
+	uint64_t                           total_size_ = 0;
+	unsigned                           n_temp_     = 0;
+
+	string filePath(uint64_t key) const;
+	void   scan();
+	void   evict();
+};
+} // namespace slade
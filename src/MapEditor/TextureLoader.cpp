@@ -0,0 +1,239 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureLoader.cpp
+// Description: TextureLoader class - decodes and composites map editor
+//              texture images on a pool of worker threads, ready to be
+//              uploaded to OpenGL on the main thread
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureLoader.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "TextureCache.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, map_tex_load_threads, 0, CVar::Flag::Save) // 0 = automatic
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Decodes [image] data to [out]
+// -----------------------------------------------------------------------------
+bool decodeImage(const TextureLoader::Image& image, SImage& out)
+{
+	MemChunk mc(image.data.data(), image.data.size());
+
+	// Try SIFormat system first
+	if (out.open(mc, 0, image.format_hint))
+		return true;
+
+	// Then FreeImage
+	if (SIFormat::generalFormat()->isThisFormat(mc))
+		return SIFormat::generalFormat()->loadImage(out, mc);
+
+	return false;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureLoader Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// TextureLoader class destructor
+// -----------------------------------------------------------------------------
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+		queued_.clear();
+	}
+	cv_.notify_all();
+
+	for (auto& thread : threads_)
+		if (thread.joinable())
+			thread.join();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of requests that haven't been finished (or collected)
+// yet
+// -----------------------------------------------------------------------------
+unsigned TextureLoader::nQueued() const
+{
+	std::lock_guard lock(mutex_);
+	return queued_.size() + n_processing_ + finished_.size();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [request] to the queue, to be processed by the next free worker
+// -----------------------------------------------------------------------------
+void TextureLoader::queue(unique_ptr<Request> request)
+{
+	if (threads_.empty())
+		startThreads();
+
+	{
+		std::lock_guard lock(mutex_);
+		queued_.push_back(std::move(request));
+	}
+	cv_.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+// Returns all requests finished since the last call
+// -----------------------------------------------------------------------------
+vector<unique_ptr<TextureLoader::Request>> TextureLoader::takeFinished()
+{
+	std::lock_guard             lock(mutex_);
+	vector<unique_ptr<Request>> finished;
+	finished.swap(finished_);
+	return finished;
+}
+
+// -----------------------------------------------------------------------------
+// Discards all queued and finished requests. Requests currently being
+// processed will still be finished
+// -----------------------------------------------------------------------------
+void TextureLoader::clear()
+{
+	std::lock_guard lock(mutex_);
+	queued_.clear();
+	finished_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Starts the worker threads
+// -----------------------------------------------------------------------------
+void TextureLoader::startThreads()
+{
+	unsigned n_threads = map_tex_load_threads;
+	if (map_tex_load_threads <= 0)
+		n_threads = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, 4u);
+
+	for (unsigned a = 0; a < n_threads; a++)
+		threads_.emplace_back(&TextureLoader::workerThread, this);
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread function, processes queued requests until the loader is
+// destroyed
+// -----------------------------------------------------------------------------
+void TextureLoader::workerThread()
+{
+	while (true)
+	{
+		// Wait for the next request
+		unique_ptr<Request> request;
+		{
+			std::unique_lock lock(mutex_);
+			cv_.wait(lock, [&]() { return stop_ || !queued_.empty(); });
+			if (stop_)
+				return;
+
+			request = std::move(queued_.front());
+			queued_.pop_front();
+			n_processing_++;
+		}
+
+		process(*request);
+
+		std::lock_guard lock(mutex_);
+		finished_.push_back(std::move(request));
+		n_processing_--;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the image(s) in [request], compositing them if needed.
+// The result is read from the cache instead if it was cached previously
+// -----------------------------------------------------------------------------
+void TextureLoader::process(Request& request) const
+{
+	bool composite = request.size.x > 0 && request.size.y > 0;
+
+	// Build cache key from everything the image is built from
+	TextureCache::Key key;
+	key.add(composite ? "composite" : "image");
+	for (const auto& image : request.images)
+	{
+		key.add(image.format_hint).add(image.offset.x).add(image.offset.y);
+		key.add(image.data.data(), image.data.size());
+	}
+	if (composite)
+		key.add(request.size.x).add(request.size.y).add(request.palette);
+
+	// Check cache
+	if (cache_ && cache_->read(key, request.image))
+	{
+		request.ok = true;
+		return;
+	}
+
+	// Single image
+	if (!composite)
+	{
+		request.ok = !request.images.empty() && decodeImage(request.images[0], request.image);
+		if (request.ok && cache_)
+			cache_->write(key, request.image);
+		return;
+	}
+
+	// Composite (same as CTexture::toImage for non-extended textures)
+	request.image.resize(request.size.x, request.size.y);
+	SImage            p_img(SImage::Type::PalMask);
+	SImage::DrawProps dp;
+	dp.src_alpha = false;
+	for (auto& patch : request.images)
+	{
+		if (decodeImage(patch, p_img))
+			request.image.drawImage(p_img, patch.offset.x, patch.offset.y, dp, &request.palette, &request.palette);
+	}
+
+	request.ok = true;
+	if (cache_)
+		cache_->write(key, request.image);
+}
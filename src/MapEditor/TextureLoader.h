@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/SImage/SImage.h"
+#include "OpenGL/GLTexture.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace slade
+{
+class TextureCache;
+
+// Decodes (and composites) map editor texture images on worker threads.
+// Requests are built on the main thread with copies of all the data they
+// need, so the workers never touch archives or resources. Finished requests
+// are collected via takeFinished() and uploaded to OpenGL on the main thread.
+// If a TextureCache is given, decoded images are read from/written to it
+class TextureLoader
+{
+public:
+	struct Image
+	{
+		vector<uint8_t> data;
+		string          format_hint;
+		Vec2i           offset;
+	};
+
+	struct Request
+	{
+		unsigned      key        = 0; // TextureName key
+		bool          flat       = false;
+		gl::TexFilter filter     = gl::TexFilter::Nearest;
+		unsigned      generation = 0;
+		vector<Image> images; // A single image, or patches to composite
+		Vec2i         size;   // Size of the composite (if compositing patches)
+		Palette       palette;
+
+		// Result
+		SImage image;
+		bool   ok = false;
+	};
+
+	TextureLoader(TextureCache* cache = nullptr) : cache_{ cache } {}
+	~TextureLoader();
+
+	unsigned nQueued() const;
+
+	void                        queue(unique_ptr<Request> request);
+	vector<unique_ptr<Request>> takeFinished();
+	void                        clear();
+
+private:
+	TextureCache*                   cache_ = nullptr;
+	vector<std::thread>             threads_;
+	mutable std::mutex              mutex_;
+	std::condition_variable         cv_;
+	std::deque<unique_ptr<Request>> queued_;
+	vector<unique_ptr<Request>>     finished_;
+	unsigned                        n_processing_ = 0;
+	bool                            stop_         = false;
+
+	void startThreads();
+	void workerThread();
+	void process(Request& request) const;
+};
+} // namespace slade
@@ -37,6 +37,7 @@
 #include "MapEditor/MapEditor.h"
 #include "MapEditor/MapTextureManager.h"
 #include "SLADEMap/SLADEMap.h"
+#include "UI/Browser/BrowserCanvas.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -266,6 +267,11 @@ MapTextureBrowser::MapTextureBrowser(wxWindow* parent, TextureType type, const w
 
 	// Select initial texture (if any)
 	selectItem(texture);
+
+	// Textures for visible items are loaded in the background, check for any
+	// that have finished loading periodically
+	timer_load_.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { updateLoading(); });
+	timer_load_.Start(50);
 }
 
 // -----------------------------------------------------------------------------
@@ -358,3 +364,17 @@ void MapTextureBrowser::updateUsage() const
 			item->setUsage(map_->sectors().texUsageCount(item->name().ToStdString()));
 	}
 }
+
+// -----------------------------------------------------------------------------
+// Uploads any textures that have finished loading in the background and
+// refreshes the browser to show them
+// -----------------------------------------------------------------------------
+void MapTextureBrowser::updateLoading() const
+{
+	auto& tex_manager = mapeditor::textureManager();
+	if (tex_manager.nLoading() == 0 || !canvas_->setContext())
+		return;
+
+	if (tex_manager.update())
+		canvas_->Refresh();
+}
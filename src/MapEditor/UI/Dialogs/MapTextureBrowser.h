@@ -49,5 +49,8 @@ public:
 private:
 	mapeditor::TextureType type_ = mapeditor::TextureType::Texture;
 	SLADEMap*              map_  = nullptr;
+	wxTimer                timer_load_;
+
+	void updateLoading() const;
 };
 } // namespace slade
@@ -4,8 +4,6 @@ namespace slade
 {
 class MapPreviewCanvas;
 class Archive;
-class ZipArchive;
-class ArchiveDir;
 class ListView;
 
 class MapBackupPanel : public wxPanel
@@ -20,10 +18,11 @@ public:
 	void updateMapPreview();
 
 private:
-	MapPreviewCanvas*      canvas_map_   = nullptr;
-	ListView*              list_backups_ = nullptr;
-	unique_ptr<ZipArchive> archive_backups_;
-	unique_ptr<Archive>    archive_mapdata_;
-	ArchiveDir*            dir_current_ = nullptr;
+	MapPreviewCanvas*   canvas_map_   = nullptr;
+	ListView*           list_backups_ = nullptr;
+	unique_ptr<Archive> archive_mapdata_;
+	string              archive_name_;
+	string              map_name_;
+	vector<string>      backups_;
 };
 } // namespace slade
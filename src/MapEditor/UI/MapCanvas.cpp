@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "MapCanvas.h"
 #include "App.h"
+#include "MapEditor/Renderer/FrameProfiler.h"
 #include "MapEditor/Renderer/Overlays/MCOverlay.h"
 #include "MapEditor/SectorBuilder.h"
 #include "OpenGL/Drawing.h"
@@ -52,6 +53,14 @@ using mapeditor::Mode;
 CVAR(Int, map_bg_ms, 15, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// External Variables
+//
+// -----------------------------------------------------------------------------
+EXTERN_CVAR(Bool, map_showfps)
+
+
 // -----------------------------------------------------------------------------
 //
 // MapCanvas Class Functions
@@ -111,11 +120,22 @@ void MapCanvas::draw()
 	if (!IsEnabled())
 		return;
 
+	// Profile the frame if the profiler graph is shown or a trace is recording
+	auto& profiler = mapeditor::profiler();
+	if (map_showfps || profiler.recording())
+		profiler.beginFrame();
+
 	context_->renderer().draw();
 
-	SwapBuffers();
+	{
+		mapeditor::FrameProfiler::Scope scope("Present");
+
+		SwapBuffers();
+
+		glFinish();
+	}
 
-	glFinish();
+	profiler.endFrame();
 }
 
 // -----------------------------------------------------------------------------
@@ -323,11 +343,10 @@ void MapCanvas::onKeyDown(wxKeyEvent& e)
 		}
 		if (e.GetKeyCode() == WXK_F5 && context_->editMode() == Mode::Sectors)
 		{
-			PolygonSplitter splitter;
-			splitter.setVerbose(true);
-			splitter.openSector(context_->selection().hilightedSector());
-			Polygon2D temp;
-			splitter.doSplitting(&temp);
+			Triangulator triangulator;
+			triangulator.setVerbose(true);
+			triangulator.addSectorEdges(context_->selection().hilightedSector());
+			triangulator.triangulate();
 		}
 	}
 
@@ -33,12 +33,14 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapChecksPanel.h"
+#include "MapEditor/MapCheckRunner.h"
 #include "MapEditor/MapChecks.h"
 #include "MapEditor/MapEditContext.h"
 #include "MapEditor/MapEditor.h"
 #include "SLADEMap/SLADEMap.h"
 #include "UI/WxUtils.h"
 #include "Utility/SFileDialog.h"
+#include <wx/progdlg.h>
 
 using namespace slade;
 
@@ -332,18 +334,41 @@ void MapChecksPanel::onBtnCheck(wxCommandEvent& e)
 		}
 	}
 
-	// Run checks
+	// Run checks in parallel, with a modal progress dialog so the map can't
+	// be modified while checks are running
+	vector<MapCheck*> checks;
 	for (auto& check : active_checks_)
+		checks.push_back(check.get());
+	MapCheckRunner runner(checks);
 	{
-		// Check
-		updateStatusText(check->progressText());
-		check->doCheck();
+		wxProgressDialog progress(
+			"Map Checks",
+			"Checking...",
+			100,
+			wxGetTopLevelParent(this),
+			wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+
+		runner.start();
+		while (!runner.update())
+		{
+			if (!progress.Update(static_cast<int>(runner.totalProgress() * 99), runner.progressText()))
+				runner.cancel();
+
+			wxMilliSleep(10);
+		}
+	}
 
-		// Add results to list
+	// Add results to list (in check order)
+	for (unsigned a = 0; a < active_checks_.size(); a++)
+	{
+		if (runner.state(a) != MapCheckRunner::State::Done)
+			continue;
+
+		auto check = active_checks_[a].get();
 		for (unsigned b = 0; b < check->nProblems(); b++)
 		{
 			lb_errors_->Append(check->problemDesc(b));
-			check_items_.emplace_back(check.get(), b);
+			check_items_.emplace_back(check, b);
 		}
 	}
 
@@ -356,6 +381,9 @@ void MapChecksPanel::onBtnCheck(wxCommandEvent& e)
 	}
 	else
 		updateStatusText("No problems found");
+
+	if (runner.isCancelled())
+		updateStatusText(label_status_->GetLabel() + " (checks cancelled)");
 }
 
 // -----------------------------------------------------------------------------
@@ -38,6 +38,7 @@
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "MainEditor/MainEditor.h"
+#include "MapEditor/BSPBuilder.h"
 #include "MapEditor/MapBackupManager.h"
 #include "MapEditor/MapEditContext.h"
 #include "MapEditor/MapEditor.h"
@@ -78,6 +79,7 @@ bool nb_warned = false;
 CVAR(Bool, mew_maximized, true, CVar::Flag::Save);
 CVAR(String, nodebuilder_id, "zdbsp", CVar::Flag::Save);
 CVAR(String, nodebuilder_options, "", CVar::Flag::Save);
+CVAR(Bool, nodebuilder_builtin_test_run, false, CVar::Flag::Save);
 CVAR(Bool, save_archive_with_map, true, CVar::Flag::Save);
 
 
@@ -727,23 +729,47 @@ void MapEditorWindow::loadMapScripts(Archive::MapDesc map)
 }
 
 // -----------------------------------------------------------------------------
-// Builds nodes for the maps in [wad]
+// Builds nodes for the maps in [wad]. If [test_run] is true, the built-in node
+// builder will be used in fast mode (if enabled)
 // -----------------------------------------------------------------------------
-void MapEditorWindow::buildNodes(Archive* wad)
+void MapEditorWindow::buildNodes(Archive* wad, bool test_run)
 {
-	// Save wad to disk
-	auto filename = app::path("sladetemp.wad", app::Dir::Temp);
-	wad->save(filename);
-
 	// Get current nodebuilder
 	auto     builder = nodebuilders::builder(nodebuilder_id);
 	wxString command = builder.command;
 	wxString options = nodebuilder_options;
 
+	// Use built-in nodebuilder in fast mode for test runs if enabled
+	if (test_run && nodebuilder_builtin_test_run)
+	{
+		builder = nodebuilders::builder("builtin");
+		options = " fast ";
+	}
+
 	// Don't build if none selected
 	if (builder.id == "none")
 		return;
 
+	// Built-in nodebuilder, build directly from the map
+	if (builder.id == "builtin")
+	{
+		auto&               edit_context = mapeditor::editContext();
+		BSPBuilder::Options bsp_options;
+		bsp_options.fast     = options.Contains(" fast ");
+		bsp_options.extended = options.Contains(" extended ");
+		bsp_options.gl       = edit_context.mapDesc().format == MapFormat::UDMF; // UDMF requires GL nodes
+
+		BSPBuilder bsp(edit_context.map(), bsp_options);
+		if (!bsp.build() || !bsp.addToArchive(*wad, wad->entryAt(0), edit_context.mapDesc().format))
+			log::warning("Unable to build nodes for the map");
+
+		return;
+	}
+
+	// Save wad to disk
+	auto filename = app::path("sladetemp.wad", app::Dir::Temp);
+	wad->save(filename);
+
 	// Switch to ZDBSP if UDMF
 	if (mapeditor::editContext().mapDesc().format == MapFormat::UDMF && nodebuilder_id != "zdbsp")
 	{
@@ -801,7 +827,7 @@ void MapEditorWindow::buildNodes(Archive* wad)
 // -----------------------------------------------------------------------------
 // Writes the current map as [name] to a wad archive and returns it
 // -----------------------------------------------------------------------------
-bool MapEditorWindow::writeMap(WadArchive& wad, const wxString& name, bool nodes)
+bool MapEditorWindow::writeMap(WadArchive& wad, const wxString& name, bool nodes, bool test_run)
 {
 	auto& mdesc_current = mapeditor::editContext().mapDesc();
 	auto& map           = mapeditor::editContext().map();
@@ -847,7 +873,7 @@ bool MapEditorWindow::writeMap(WadArchive& wad, const wxString& name, bool nodes
 
 	// Build nodes
 	if (nodes)
-		buildNodes(&wad);
+		buildNodes(&wad, test_run);
 
 	// Clear current map data
 	map_data_.clear();
@@ -1333,7 +1359,7 @@ bool MapEditorWindow::handleAction(string_view id)
 
 			// Write temp wad
 			WadArchive wad;
-			if (writeMap(wad, mdesc_current.name))
+			if (writeMap(wad, mdesc_current.name, true, true))
 				wad.save(app::path("sladetemp_run.wad", app::Dir::Temp));
 
 			// Reset player 1 start if moved
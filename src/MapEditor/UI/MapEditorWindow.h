@@ -33,7 +33,7 @@ public:
 	bool chooseMap(Archive* archive = nullptr);
 	bool openMap(Archive::MapDesc map);
 	void loadMapScripts(Archive::MapDesc map);
-	bool writeMap(WadArchive& wad, const wxString& name = "MAP01", bool nodes = true);
+	bool writeMap(WadArchive& wad, const wxString& name = "MAP01", bool nodes = true, bool test_run = false);
 	bool saveMap();
 	bool saveMapAs();
 	void closeMap() const;
@@ -63,7 +63,7 @@ private:
 	UndoManagerHistoryPanel*         panel_undo_history_ = nullptr;
 	wxMenu*                          menu_scripts_       = nullptr;
 
-	void buildNodes(Archive* wad);
+	void buildNodes(Archive* wad, bool test_run = false);
 	void lockMapEntries(bool lock = true) const;
 
 	// Events
@@ -664,7 +664,7 @@ wxPanel* ThingPropsPanel::setupExtraFlagsTab()
 	for (const auto& a : udmf_flags_extra_)
 	{
 		auto prop = game::configuration().getUDMFProperty(a.ToStdString(), MapObject::Type::Thing);
-		flags.push_back(prop->name());
+		flags.push_back(prop ? prop->name() : a.ToStdString());
 	}
 
 	// Add flag checkboxes
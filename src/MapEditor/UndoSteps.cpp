@@ -6,22 +6,204 @@
 using namespace slade;
 using namespace mapeditor;
 
-PropertyChangeUS::PropertyChangeUS(MapObject* object) : backup_{ new MapObject::Backup() }
+
+// -----------------------------------------------------------------------------
+// Compact binary backups
+//
+// Object backups are stored as a list of property entries rather than full
+// MapObject::Backup structs. A 'delta' only contains the properties that
+// differ between two backups, so undo levels for eg. moved vertices only
+// store the changed coordinates
+// -----------------------------------------------------------------------------
+namespace
+{
+enum DeltaFlags : uint8_t
+{
+	Internal = 1, // Entry is in Backup::props_internal
+	Removed  = 2, // Entry is a property to remove
+};
+
+template<typename T> void writeValue(vector<uint8_t>& data, T value)
+{
+	auto pos = data.size();
+	data.resize(pos + sizeof(T));
+	memcpy(data.data() + pos, &value, sizeof(T));
+}
+
+template<typename T> T readValue(const vector<uint8_t>& data, unsigned& pos)
+{
+	T value{};
+	if (pos + sizeof(T) <= data.size())
+		memcpy(&value, data.data() + pos, sizeof(T));
+	pos += sizeof(T);
+	return value;
+}
+
+void writeString(vector<uint8_t>& data, string_view str)
+{
+	writeValue<uint32_t>(data, str.size());
+	data.insert(data.end(), str.begin(), str.end());
+}
+
+string readString(const vector<uint8_t>& data, unsigned& pos)
+{
+	auto len = readValue<uint32_t>(data, pos);
+	if (len > data.size() - std::min<size_t>(pos, data.size()))
+	{
+		pos = data.size();
+		return {};
+	}
+
+	string str{ reinterpret_cast<const char*>(data.data()) + pos, len };
+	pos += len;
+	return str;
+}
+
+void writeProperty(vector<uint8_t>& data, const Property& prop)
+{
+	writeValue<uint8_t>(data, prop.index());
+	switch (property::valueType(prop))
+	{
+	case property::ValueType::Bool: writeValue<uint8_t>(data, std::get<bool>(prop)); break;
+	case property::ValueType::Int: writeValue<int32_t>(data, std::get<int>(prop)); break;
+	case property::ValueType::UInt: writeValue<uint32_t>(data, std::get<unsigned>(prop)); break;
+	case property::ValueType::Float: writeValue<double>(data, std::get<double>(prop)); break;
+	case property::ValueType::String: writeString(data, std::get<string>(prop)); break;
+	}
+}
+
+Property readProperty(const vector<uint8_t>& data, unsigned& pos)
+{
+	switch (static_cast<property::ValueType>(readValue<uint8_t>(data, pos)))
+	{
+	case property::ValueType::Bool: return readValue<uint8_t>(data, pos) > 0;
+	case property::ValueType::Int: return readValue<int32_t>(data, pos);
+	case property::ValueType::UInt: return readValue<uint32_t>(data, pos);
+	case property::ValueType::Float: return readValue<double>(data, pos);
+	case property::ValueType::String: return readString(data, pos);
+	default: return {};
+	}
+}
+
+void writeListDelta(
+	vector<uint8_t>&    data,
+	const PropertyList& base,
+	const PropertyList& current,
+	uint8_t             flags,
+	uint16_t&           count)
+{
+	// Properties in [base] that are different or missing in [current]
+	for (const auto& prop : base.properties())
+	{
+		auto cur_val = current.getIf(prop.name);
+		if (cur_val && *cur_val == prop.value)
+			continue;
+
+		writeValue<uint8_t>(data, flags);
+		writeString(data, prop.name);
+		writeProperty(data, prop.value);
+		++count;
+	}
+
+	// Properties in [current] that aren't in [base]
+	for (const auto& prop : current.properties())
+	{
+		if (base.contains(prop.name))
+			continue;
+
+		writeValue<uint8_t>(data, flags | Removed);
+		writeString(data, prop.name);
+		++count;
+	}
+}
+
+// Appends a delta to [data] that will restore [current] to [base].
+// Returns false (and appends nothing) if there are no differences
+bool writeBackupDelta(vector<uint8_t>& data, const MapObject::Backup& base, const MapObject::Backup& current)
+{
+	auto start = data.size();
+	writeValue<uint32_t>(data, base.id);
+	writeValue<uint8_t>(data, static_cast<uint8_t>(base.type));
+	auto count_pos = data.size();
+	writeValue<uint16_t>(data, 0);
+
+	uint16_t count = 0;
+	writeListDelta(data, base.properties, current.properties, 0, count);
+	writeListDelta(data, base.props_internal, current.props_internal, Internal, count);
+
+	if (count == 0)
+	{
+		data.resize(start);
+		return false;
+	}
+
+	memcpy(data.data() + count_pos, &count, sizeof(uint16_t));
+	return true;
+}
+
+// Reads the delta in [data] at [pos] and applies it to [backup]
+void applyBackupDelta(const vector<uint8_t>& data, unsigned& pos, MapObject::Backup& backup)
+{
+	backup.id   = readValue<uint32_t>(data, pos);
+	backup.type = static_cast<MapObject::Type>(readValue<uint8_t>(data, pos));
+
+	auto count = readValue<uint16_t>(data, pos);
+	for (unsigned a = 0; a < count && pos < data.size(); a++)
+	{
+		auto  flags = readValue<uint8_t>(data, pos);
+		auto  key   = readString(data, pos);
+		auto& list  = (flags & Internal) ? backup.props_internal : backup.properties;
+
+		if (flags & Removed)
+			list.remove(key);
+		else
+			list[key] = readProperty(data, pos);
+	}
+}
+
+bool writeData(MemChunk& mc, const vector<uint8_t>& data)
+{
+	return data.empty() || mc.write(data.data(), data.size());
+}
+
+void readData(MemChunk& mc, vector<uint8_t>& data)
+{
+	data.assign(mc.data(), mc.data() + mc.size());
+}
+} // namespace
+
+
+PropertyChangeUS::PropertyChangeUS(MapObject* object) : obj_id_{ object->objId() }
 {
-	object->backupTo(backup_.get());
+	MapObject::Backup backup;
+	object->backupTo(&backup);
+	writeBackupDelta(data_, backup, MapObject::Backup{});
+	data_.shrink_to_fit();
 }
 
 void PropertyChangeUS::doSwap(MapObject* obj)
 {
-	auto temp = std::make_unique<MapObject::Backup>();
-	obj->backupTo(temp.get());
-	obj->loadFromBackup(backup_.get());
-	backup_.swap(temp);
+	if (data_.empty())
+		return;
+
+	// Read stored backup
+	MapObject::Backup restored;
+	unsigned          pos = 0;
+	applyBackupDelta(data_, pos, restored);
+
+	// Store current state for the next swap
+	MapObject::Backup current;
+	obj->backupTo(&current);
+	data_.clear();
+	writeBackupDelta(data_, current, MapObject::Backup{});
+	data_.shrink_to_fit();
+
+	obj->loadFromBackup(&restored);
 }
 
 bool PropertyChangeUS::doUndo()
 {
-	auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id);
+	auto obj = undoredo::currentMap()->mapData().getObjectById(obj_id_);
 	if (obj)
 		doSwap(obj);
 
@@ -30,13 +212,29 @@ bool PropertyChangeUS::doUndo()
 
 bool PropertyChangeUS::doRedo()
 {
-	auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id);
+	auto obj = undoredo::currentMap()->mapData().getObjectById(obj_id_);
 	if (obj)
 		doSwap(obj);
 
 	return true;
 }
 
+bool PropertyChangeUS::writeFile(MemChunk& mc)
+{
+	return writeData(mc, data_);
+}
+
+bool PropertyChangeUS::readFile(MemChunk& mc)
+{
+	readData(mc, data_);
+	return true;
+}
+
+void PropertyChangeUS::unload()
+{
+	vector<uint8_t>().swap(data_);
+}
+
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
@@ -218,60 +416,139 @@ bool MapObjectCreateDeleteUS::isOk()
 		&& sides_[0] == 0 && sectors_.size() == 1 && sectors_[0] == 0 && things_.size() == 1 && things_[0] == 0);
 }
 
+bool MapObjectCreateDeleteUS::writeFile(MemChunk& mc)
+{
+	for (auto* list : { &vertices_, &lines_, &sides_, &sectors_, &things_ })
+	{
+		uint32_t count = list->size();
+		if (!mc.write(&count, sizeof(uint32_t)))
+			return false;
+		if (count > 0 && !mc.write(list->data(), count * sizeof(unsigned)))
+			return false;
+	}
 
+	return true;
+}
 
-MultiMapObjectPropertyChangeUS::MultiMapObjectPropertyChangeUS()
+bool MapObjectCreateDeleteUS::readFile(MemChunk& mc)
 {
-	// Get backups of recently modified map objects
-	auto objects = undoredo::currentMap()->mapData().allModifiedObjects(MapObject::propBackupTime());
+	mc.seekFromStart(0);
+	for (auto* list : { &vertices_, &lines_, &sides_, &sectors_, &things_ })
+	{
+		uint32_t count = 0;
+		if (!mc.read(&count, sizeof(uint32_t)))
+			return false;
+
+		list->resize(count);
+		if (count > 0 && !mc.read(list->data(), count * sizeof(unsigned)))
+			return false;
+	}
+
+	return true;
+}
+
+size_t MapObjectCreateDeleteUS::memoryUsage() const
+{
+	return (vertices_.capacity() + lines_.capacity() + sides_.capacity() + sectors_.capacity() + things_.capacity())
+		   * sizeof(unsigned);
+}
+
+void MapObjectCreateDeleteUS::unload()
+{
+	for (auto* list : { &vertices_, &lines_, &sides_, &sectors_, &things_ })
+		vector<unsigned>().swap(*list);
+}
+
+
+
+MultiMapObjectPropertyChangeUS::MultiMapObjectPropertyChangeUS(unsigned long since_gen)
+{
+	// Get backups of map objects modified since recording began, and store the
+	// differences to their current state
+	auto   objects = undoredo::currentMap()->mapData().allModifiedObjectsSinceGen(since_gen);
+	string msg     = "Modified ids: ";
 	for (auto& object : objects)
 	{
-		auto bak = object->backup(true);
-		if (bak)
+		unique_ptr<MapObject::Backup> bak{ object->backup(true) };
+		if (!bak)
+			continue;
+
+		MapObject::Backup current;
+		object->backupTo(&current);
+		if (writeBackupDelta(data_, *bak, current))
 		{
-			backups_.emplace_back(bak);
-			// log::info(1, "%s #%d modified", objects[a]->getTypeName(), objects[a]->getIndex());
+			++n_objects_;
+			if (log::verbosity() >= 2)
+				msg += fmt::format("{}, ", bak->id);
 		}
 	}
+	data_.shrink_to_fit();
 
 	if (log::verbosity() >= 2)
-	{
-		string msg = "Modified ids: ";
-		for (auto& backup : backups_)
-			msg += fmt::format("{}, ", backup->id);
 		log::info(msg);
-	}
 }
 
-void MultiMapObjectPropertyChangeUS::doSwap(MapObject* obj, unsigned index)
+void MultiMapObjectPropertyChangeUS::doSwap()
 {
-	auto temp = std::make_unique<MapObject::Backup>();
-	obj->backupTo(temp.get());
-	obj->loadFromBackup(backups_[index].get());
-	backups_[index].swap(temp);
-}
+	auto&           map_data = undoredo::currentMap()->mapData();
+	vector<uint8_t> swapped;
+	swapped.reserve(data_.size());
 
-bool MultiMapObjectPropertyChangeUS::doUndo()
-{
-	for (unsigned a = 0; a < backups_.size(); a++)
+	unsigned pos = 0;
+	while (pos < data_.size())
 	{
-		auto obj = undoredo::currentMap()->mapData().getObjectById(backups_[a]->id);
+		// Get object
+		auto start = pos;
+		auto obj   = map_data.getObjectById(readValue<uint32_t>(data_, pos));
+		pos        = start;
+
+		// Apply delta to the object's current state
+		MapObject::Backup current;
 		if (obj)
-			doSwap(obj, a);
+			obj->backupTo(&current);
+		auto restored = current;
+		applyBackupDelta(data_, pos, restored);
+
+		// Keep the delta as-is if the object doesn't exist
+		if (!obj)
+		{
+			swapped.insert(swapped.end(), data_.begin() + start, data_.begin() + pos);
+			continue;
+		}
+
+		// Store delta back to the current state and restore
+		writeBackupDelta(swapped, current, restored);
+		obj->loadFromBackup(&restored);
 	}
 
+	data_.swap(swapped);
+	data_.shrink_to_fit();
+}
+
+bool MultiMapObjectPropertyChangeUS::doUndo()
+{
+	doSwap();
 	return true;
 }
 
 bool MultiMapObjectPropertyChangeUS::doRedo()
 {
-	// log::info(2, "Restore %lu objects", backups.size());
-	for (unsigned a = 0; a < backups_.size(); a++)
-	{
-		auto obj = undoredo::currentMap()->mapData().getObjectById(backups_[a]->id);
-		if (obj)
-			doSwap(obj, a);
-	}
+	doSwap();
+	return true;
+}
 
+bool MultiMapObjectPropertyChangeUS::writeFile(MemChunk& mc)
+{
+	return writeData(mc, data_);
+}
+
+bool MultiMapObjectPropertyChangeUS::readFile(MemChunk& mc)
+{
+	readData(mc, data_);
 	return true;
 }
+
+void MultiMapObjectPropertyChangeUS::unload()
+{
+	vector<uint8_t>().swap(data_);
+}
@@ -12,12 +12,17 @@ public:
 	PropertyChangeUS(MapObject* object);
 	~PropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj);
-	bool doUndo() override;
-	bool doRedo() override;
+	void   doSwap(MapObject* obj);
+	bool   doUndo() override;
+	bool   doRedo() override;
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t memoryUsage() const override { return data_.capacity(); }
+	void   unload() override;
 
 private:
-	unique_ptr<MapObject::Backup> backup_;
+	unsigned        obj_id_ = 0;
+	vector<uint8_t> data_; // Compact binary backup of the object
 };
 
 // UndoStep for when a MapObject is either created or deleted
@@ -27,12 +32,16 @@ public:
 	MapObjectCreateDeleteUS();
 	~MapObjectCreateDeleteUS() = default;
 
-	bool isValid(vector<unsigned>& list) const { return !(list.size() == 1 && list[0] == 0); }
-	void swapLists();
-	bool doUndo() override;
-	bool doRedo() override;
-	void checkChanges();
-	bool isOk() override;
+	bool   isValid(vector<unsigned>& list) const { return !(list.size() == 1 && list[0] == 0); }
+	void   swapLists();
+	bool   doUndo() override;
+	bool   doRedo() override;
+	void   checkChanges();
+	bool   isOk() override;
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t memoryUsage() const override;
+	void   unload() override;
 
 private:
 	vector<unsigned> vertices_;
@@ -46,15 +55,20 @@ private:
 class MultiMapObjectPropertyChangeUS : public UndoStep
 {
 public:
-	MultiMapObjectPropertyChangeUS();
+	MultiMapObjectPropertyChangeUS(unsigned long since_gen);
 	~MultiMapObjectPropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj, unsigned index);
-	bool doUndo() override;
-	bool doRedo() override;
-	bool isOk() override { return !backups_.empty(); }
+	void   doSwap();
+	bool   doUndo() override;
+	bool   doRedo() override;
+	bool   isOk() override { return n_objects_ > 0; }
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t memoryUsage() const override { return data_.capacity(); }
+	void   unload() override;
 
 private:
-	vector<unique_ptr<MapObject::Backup>> backups_;
+	unsigned        n_objects_ = 0;
+	vector<uint8_t> data_; // Compact binary deltas of modified object properties
 };
 } // namespace slade::mapeditor
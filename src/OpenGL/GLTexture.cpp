@@ -48,6 +48,7 @@ namespace
 {
 std::map<unsigned, gl::Texture> textures;
 gl::Texture                     tex_missing;
+gl::Texture                     tex_loading;
 gl::Texture                     tex_background;
 unsigned                        last_bound_tex = 0;
 } // namespace
@@ -108,6 +109,26 @@ unsigned gl::Texture::missingTexture()
 	return tex_missing.id;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the 'loading' texture id, used in place of textures that are still
+// being loaded
+// -----------------------------------------------------------------------------
+unsigned gl::Texture::loadingTexture()
+{
+	if (!gl::isInitialised())
+		return 0;
+
+	// Create the 'loading' texture if necessary
+	if (tex_loading.id == 0)
+	{
+		auto id = create();
+		genChequeredTexture(id, 8, ColRGBA(48, 48, 48), ColRGBA(64, 64, 64));
+		tex_loading = textures[id];
+	}
+
+	return tex_loading.id;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the 'background' texture id
 // -----------------------------------------------------------------------------
@@ -207,7 +228,7 @@ bool gl::Texture::loadData(unsigned id, const uint8_t* data, unsigned width, uns
 		return false;
 
 	// Check given id
-	if (id == 0 || id == tex_missing.id || id == tex_background.id)
+	if (id == 0 || id == tex_missing.id || id == tex_loading.id || id == tex_background.id)
 	{
 		log::warning("Unable to load OpenGL texture with id {} - invalid or built-in texture", id);
 		return false;
@@ -430,7 +451,7 @@ void gl::Texture::bind(unsigned id, bool force)
 // -----------------------------------------------------------------------------
 void gl::Texture::clear(unsigned id)
 {
-	if (id == 0 || id == tex_missing.id || id == tex_background.id || textures.empty())
+	if (id == 0 || id == tex_missing.id || id == tex_loading.id || id == tex_background.id || textures.empty())
 		return;
 
 	textures[id] = {};
@@ -447,5 +468,6 @@ void gl::Texture::clearAll()
 
 	textures.clear();
 	tex_missing    = {};
+	tex_loading    = {};
 	tex_background = {};
 }
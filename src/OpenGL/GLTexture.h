@@ -35,6 +35,7 @@ namespace gl
 		static void           bind(unsigned id, bool force = true);
 
 		static unsigned missingTexture();
+		static unsigned loadingTexture();
 		static unsigned backgroundTexture();
 		static void     resetBackgroundTexture();
 
@@ -139,6 +139,10 @@ bool gl::init()
 		log::info("Framebuffer Objects supported");
 	else
 		log::info("Framebuffer Objects not supported");
+	if (GLEW_ARB_timer_query)
+		log::info("Timer Queries supported");
+	else
+		log::info("Timer Queries not supported");
 
 	initialised = true;
 	return true;
@@ -171,6 +175,15 @@ bool gl::vboSupport()
 	return GLEW_ARB_vertex_buffer_object && gl_vbo;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if the installed OpenGL version supports timer (timestamp)
+// queries, false otherwise
+// -----------------------------------------------------------------------------
+bool gl::timerQuerySupport()
+{
+	return GLEW_ARB_timer_query;
+}
+
 // -----------------------------------------------------------------------------
 // Returns true if [dim] is a valid texture dimension on the system OpenGL
 // version
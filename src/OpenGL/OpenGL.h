@@ -51,6 +51,7 @@ namespace gl
 	bool     np2TexSupport();
 	bool     pointSpriteSupport();
 	bool     vboSupport();
+	bool     timerQuerySupport();
 	bool     validTexDimension(unsigned dim);
 	float    maxPointSize();
 	unsigned maxTextureSize();
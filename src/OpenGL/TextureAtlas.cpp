@@ -0,0 +1,223 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureAtlas.cpp
+// Description: TextureAtlas class - packs small images into large OpenGL
+//              textures so they can be drawn without rebinding textures
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureAtlas.h"
+#include "Graphics/SImage/SImage.h"
+#include "OpenGL.h"
+
+using namespace slade;
+using namespace gl;
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureAtlas Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// TextureAtlas class constructor
+// -----------------------------------------------------------------------------
+TextureAtlas::TextureAtlas(unsigned page_size, unsigned max_image_size) :
+	page_size_{ page_size },
+	max_image_size_{ std::min(max_image_size, page_size - 2) }
+{
+}
+
+// -----------------------------------------------------------------------------
+// TextureAtlas class destructor
+// -----------------------------------------------------------------------------
+TextureAtlas::~TextureAtlas()
+{
+	clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds RGBA [data] of [width]x[height] to the atlas, on a page using [filter].
+// Returns the region the image was packed into, which will be invalid if the
+// image couldn't be added (eg. it's too big)
+// -----------------------------------------------------------------------------
+TextureAtlas::Region TextureAtlas::add(const uint8_t* data, unsigned width, unsigned height, TexFilter filter)
+{
+	if (!gl::isInitialised() || width == 0 || height == 0 || width > max_image_size_ || height > max_image_size_)
+		return {};
+
+	// Pages aren't mipmapped - images from mipmapped pages would bleed into
+	// each other at lower mip levels, and every mip level would need to be
+	// regenerated each time an image is added
+	if (filter == TexFilter::Mipmap || filter == TexFilter::LinearMipmap)
+		filter = TexFilter::Linear;
+	else if (filter == TexFilter::NearestMipmap)
+		filter = TexFilter::NearestLinearMin;
+
+	// Find a page with space for the image (plus border)
+	unsigned x = 0, y = 0;
+	Page*    page = nullptr;
+	for (auto& p : pages_)
+	{
+		if (p.filter == filter && pack(p, width + 2, height + 2, x, y))
+		{
+			page = &p;
+			break;
+		}
+	}
+
+	// Add a new page if needed
+	if (!page)
+	{
+		vector<uint8_t> blank(page_size_ * page_size_ * 4, 0);
+		auto            texture = Texture::createFromData(blank.data(), page_size_, page_size_, filter, false);
+		if (!texture)
+			return {};
+
+		pages_.emplace_back();
+		page          = &pages_.back();
+		page->texture = texture;
+		page->filter  = filter;
+		if (!pack(*page, width + 2, height + 2, x, y))
+			return {};
+	}
+
+	// Build image data with a border of repeated edge pixels
+	unsigned        pw = width + 2;
+	unsigned        ph = height + 2;
+	vector<uint8_t> padded(pw * ph * 4);
+	for (unsigned py = 0; py < ph; py++)
+	{
+		unsigned sy = std::min(std::max(py, 1u) - 1, height - 1);
+		for (unsigned px = 0; px < pw; px++)
+		{
+			unsigned sx = std::min(std::max(px, 1u) - 1, width - 1);
+			memcpy(&padded[(py * pw + px) * 4], data + (sy * width + sx) * 4, 4);
+		}
+	}
+
+	// Upload to page
+	Texture::bind(page->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pw, ph, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+	page->n_regions++;
+
+	Region region;
+	region.page = page->texture;
+	region.uv.set(
+		Vec2f{ (float)(x + 1) / page_size_, (float)(y + 1) / page_size_ },
+		Vec2f{ (float)(x + 1 + width) / page_size_, (float)(y + 1 + height) / page_size_ });
+	return region;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [image] to the atlas, using [pal] if necessary. See add above
+// -----------------------------------------------------------------------------
+TextureAtlas::Region TextureAtlas::add(const SImage& image, Palette* pal, TexFilter filter)
+{
+	if (image.width() <= 0 || image.height() <= 0 || image.width() > (int)max_image_size_
+		|| image.height() > (int)max_image_size_)
+		return {};
+
+	MemChunk rgba;
+	image.putRGBAData(rgba, pal);
+	return add(rgba.data(), image.width(), image.height(), filter);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the image in [region] from the atlas. The space it used isn't
+// reused until all other images on its page are removed too
+// -----------------------------------------------------------------------------
+void TextureAtlas::remove(const Region& region)
+{
+	if (!region.valid())
+		return;
+
+	for (auto& page : pages_)
+	{
+		if (page.texture != region.page || page.n_regions == 0)
+			continue;
+
+		// Reset page if it's now empty
+		if (--page.n_regions == 0)
+			page.shelves.clear();
+
+		return;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes all images and deletes all pages from the atlas
+// -----------------------------------------------------------------------------
+void TextureAtlas::clear()
+{
+	for (auto& page : pages_)
+		Texture::clear(page.texture);
+
+	pages_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Finds space for a [width]x[height] image on [page], and writes its position
+// to [x] and [y]. Returns false if the page doesn't have enough space
+// -----------------------------------------------------------------------------
+bool TextureAtlas::pack(Page& page, unsigned width, unsigned height, unsigned& x, unsigned& y) const
+{
+	if (width > page_size_ || height > page_size_)
+		return false;
+
+	// Find the shortest existing shelf that fits, ignoring shelves that would
+	// waste too much space
+	Shelf* best = nullptr;
+	for (auto& shelf : page.shelves)
+	{
+		if (shelf.height < height || shelf.height > height + height / 2 + 2 || shelf.x + width > page_size_)
+			continue;
+
+		if (!best || shelf.height < best->height)
+			best = &shelf;
+	}
+
+	// Otherwise start a new shelf below the last one
+	if (!best)
+	{
+		unsigned top = page.shelves.empty() ? 0 : page.shelves.back().y + page.shelves.back().height;
+		if (top + height > page_size_)
+			return false;
+
+		page.shelves.push_back({ top, height, 0 });
+		best = &page.shelves.back();
+	}
+
+	x = best->x;
+	y = best->y;
+	best->x += width;
+
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GLTexture.h"
+
+namespace slade
+{
+class SImage;
+class Palette;
+
+namespace gl
+{
+	// Packs small images into a few large 'page' textures, so that many
+	// different images can be drawn from the same texture without rebinding.
+	//
+	// Images are packed into rows (shelves) on each page, with a 1 pixel
+	// border of repeated edge pixels to avoid bleeding when filtered. Space
+	// isn't reused as individual images are removed, but a page is reset once
+	// all images on it have been removed
+	class TextureAtlas
+	{
+	public:
+		struct Region
+		{
+			unsigned page = 0; // Page texture id, 0 if not packed
+			Rectf    uv;       // Texture coordinates of the image within the page
+
+			bool  valid() const { return page > 0; }
+			Vec2f coord(float u, float v) const
+			{
+				return { uv.tl.x + u * (uv.br.x - uv.tl.x), uv.tl.y + v * (uv.br.y - uv.tl.y) };
+			}
+		};
+
+		TextureAtlas(unsigned page_size = 1024, unsigned max_image_size = 256);
+		~TextureAtlas();
+
+		unsigned nPages() const { return pages_.size(); }
+		unsigned maxImageSize() const { return max_image_size_; }
+
+		Region add(const uint8_t* data, unsigned width, unsigned height, TexFilter filter = TexFilter::Nearest);
+		Region add(const SImage& image, Palette* pal = nullptr, TexFilter filter = TexFilter::Nearest);
+		void   remove(const Region& region);
+		void   clear();
+
+	private:
+		struct Shelf
+		{
+			unsigned y      = 0;
+			unsigned height = 0;
+			unsigned x      = 0; // Start of free space
+		};
+		struct Page
+		{
+			unsigned      texture = 0;
+			TexFilter     filter  = TexFilter::Nearest;
+			vector<Shelf> shelves;
+			unsigned      n_regions = 0;
+		};
+
+		unsigned     page_size_      = 1024;
+		unsigned     max_image_size_ = 256;
+		vector<Page> pages_;
+
+		bool pack(Page& page, unsigned width, unsigned height, unsigned& x, unsigned& y) const;
+	};
+} // namespace gl
+} // namespace slade
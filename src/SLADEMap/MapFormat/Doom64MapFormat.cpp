@@ -132,22 +132,10 @@ bool Doom64MapFormat::readVERTEXES(ArchiveEntry* entry, MapObjectCollection& map
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Vertex))
-	{
-		log::info(3, "Read 0 vertices");
-		return true;
-	}
-
-	auto     vert_data = (Vertex*)entry->rawData(true);
-	unsigned nv        = entry->size() / sizeof(Vertex);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nv; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nv) * 0.2f);
-		map_data.addVertex(
-			std::make_unique<MapVertex>(Vec2d{ (double)vert_data[a].x / 65536, (double)vert_data[a].y / 65536 }));
-	}
+	auto vertices = maplump::decode<Vertex>(entry);
+	map_data.reserve(MapObject::Type::Vertex, vertices.size());
+	for (const auto& data : vertices)
+		map_data.addVertex(std::make_unique<MapVertex>(Vec2d{ (double)data.x / 65536, (double)data.y / 65536 }));
 
 	log::info(3, "Read {} vertices", map_data.vertices().size());
 
@@ -166,27 +154,25 @@ bool Doom64MapFormat::readSIDEDEFS(ArchiveEntry* entry, MapObjectCollection& map
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(SideDef))
-	{
-		log::info(3, "Read 0 sides");
-		return true;
-	}
+	auto sides = maplump::decode<SideDef>(entry);
+	map_data.reserve(MapObject::Type::Side, sides.size());
 
-	auto     side_data = (SideDef*)entry->rawData(true);
-	unsigned ns        = entry->size() / sizeof(SideDef);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / ns) * 0.2f);
+	// Resolve sector references
+	auto&              sector_list = map_data.sectors();
+	vector<MapSector*> sectors(sides.size());
+	for (unsigned a = 0; a < sides.size(); ++a)
+		sectors[a] = sector_list.at(sides[a].sector);
 
-		// Add side
+	// Add sides
+	for (unsigned a = 0; a < sides.size(); ++a)
+	{
+		const auto& data = sides[a];
 		map_data.addSide(std::make_unique<MapSide>(
-			map_data.sectors().at(side_data[a].sector),
-			ResourceManager::doom64TextureName(side_data[a].tex_upper),
-			ResourceManager::doom64TextureName(side_data[a].tex_middle),
-			ResourceManager::doom64TextureName(side_data[a].tex_lower),
-			Vec2i{ side_data[a].x_offset, side_data[a].y_offset }));
+			sectors[a],
+			ResourceManager::doom64TextureName(data.tex_upper),
+			ResourceManager::doom64TextureName(data.tex_middle),
+			ResourceManager::doom64TextureName(data.tex_lower),
+			Vec2i{ data.x_offset, data.y_offset }));
 	}
 
 	log::info(3, "Read {} sides", map_data.sides().size());
@@ -206,45 +192,24 @@ bool Doom64MapFormat::readLINEDEFS(ArchiveEntry* entry, MapObjectCollection& map
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(LineDef))
-	{
-		log::info(3, "Read 0 lines");
-		return true;
-	}
+	auto lines = maplump::decode<LineDef>(entry);
+	map_data.reserve(MapObject::Type::Line, lines.size());
 
-	auto     line_data = (LineDef*)entry->rawData(true);
-	unsigned nl        = entry->size() / sizeof(LineDef);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nl; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nl) * 0.2f);
-		const auto& data = line_data[a];
+	// Resolve vertex and side references
+	auto refs = maplump::resolveLineRefs(lines, map_data);
 
-		// Check vertices exist
-		auto v1 = map_data.vertices().at(data.vertex1);
-		auto v2 = map_data.vertices().at(data.vertex2);
-		if (!v1 || !v2)
+	// Add lines
+	for (unsigned a = 0; a < lines.size(); ++a)
+	{
+		const auto& data = lines[a];
+		const auto& ref  = refs[a];
+		if (!ref.v1 || !ref.v2)
 		{
 			log::warning("Line {} invalid, not added", a);
 			continue;
 		}
 
-		// Get side indices
-		int s1_index = data.side1;
-		int s2_index = data.side2;
-		if (map_data.sides().size() > 32767)
-		{
-			// Support for > 32768 sides
-			if (data.side1 != 65535)
-				s1_index = static_cast<unsigned short>(data.side1);
-			if (data.side2 != 65535)
-				s2_index = static_cast<unsigned short>(data.side2);
-		}
-
-		// Create line
-		auto line = map_data.addLine(
-			std::make_unique<MapLine>(v1, v2, map_data.sides().at(s1_index), map_data.sides().at(s2_index)));
+		auto line = map_data.addLine(std::make_unique<MapLine>(ref.v1, ref.v2, ref.s1, ref.s2));
 
 		// Set properties
 		line->setArg(0, data.sector_tag);
@@ -273,22 +238,10 @@ bool Doom64MapFormat::readSECTORS(ArchiveEntry* entry, MapObjectCollection& map_
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Sector))
+	auto sectors = maplump::decode<Sector>(entry);
+	map_data.reserve(MapObject::Type::Sector, sectors.size());
+	for (const auto& data : sectors)
 	{
-		log::info(3, "Read 0 sectors");
-		return true;
-	}
-
-	auto     sect_data = (Sector*)entry->rawData(true);
-	unsigned ns        = entry->size() / sizeof(Sector);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		const auto& data = sect_data[a];
-
-		// Add sector
 		auto sector = map_data.addSector(std::make_unique<MapSector>(
 			data.f_height,
 			ResourceManager::doom64TextureName(data.f_tex),
@@ -324,24 +277,13 @@ bool Doom64MapFormat::readTHINGS(ArchiveEntry* entry, MapObjectCollection& map_d
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Thing))
-	{
-		log::info(3, "Read 0 things");
-		return true;
-	}
+	auto things = maplump::decode<Thing>(entry);
+	map_data.reserve(MapObject::Type::Thing, things.size());
 
-	auto              thng_data = (Thing*)entry->rawData(true);
-	unsigned          nt        = entry->size() / sizeof(Thing);
-	float             p         = ui::getSplashProgress();
 	MapObject::ArgSet args;
-	for (size_t a = 0; a < nt; a++)
+	for (const auto& data : things)
 	{
-		ui::setSplashProgress(p + ((float)a / nt) * 0.2f);
-		const auto& data = thng_data[a];
-
-		// Create thing
-		auto thing = map_data.addThing(std::make_unique<MapThing>(
+		map_data.addThing(std::make_unique<MapThing>(
 			Vec3d{ (double)data.x, (double)data.y, (double)data.z },
 			data.type,
 			data.angle,
@@ -418,9 +360,9 @@ bool SLADEMap::writeDoom64Sidedefs(ArchiveEntry* entry)
 			d64_side.sector = side->sector_->index();
 
 		// Textures
-		d64_side.tex_middle = App::resources().getTextureHash(side->tex_middle_);
-		d64_side.tex_upper  = App::resources().getTextureHash(side->tex_upper_);
-		d64_side.tex_lower  = App::resources().getTextureHash(side->tex_lower_);
+		d64_side.tex_middle = App::resources().getTextureHash(side->tex_middle_.str());
+		d64_side.tex_upper  = App::resources().getTextureHash(side->tex_upper_.str());
+		d64_side.tex_lower  = App::resources().getTextureHash(side->tex_lower_.str());
 
 		entry->write(&d64_side, sizeof(MapSide::Doom64Data));
 	}
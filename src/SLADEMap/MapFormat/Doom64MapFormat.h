@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapFormatHandler.h"
+#include "MapLump.h"
 
 namespace slade
 {
@@ -12,6 +13,8 @@ public:
 		// These are actually fixed_t
 		int32_t x;
 		int32_t y;
+
+		void convertByteOrder() { maplump::convertByteOrder(x, y); }
 	};
 
 	struct SideDef
@@ -22,6 +25,11 @@ public:
 		uint16_t tex_lower;
 		uint16_t tex_middle;
 		short    sector;
+
+		void convertByteOrder()
+		{
+			maplump::convertByteOrder(x_offset, y_offset, tex_upper, tex_lower, tex_middle, sector);
+		}
 	};
 
 	struct LineDef
@@ -33,6 +41,8 @@ public:
 		uint16_t sector_tag;
 		uint16_t side1;
 		uint16_t side2;
+
+		void convertByteOrder() { maplump::convertByteOrder(vertex1, vertex2, flags, type, sector_tag, side1, side2); }
 	};
 
 	struct Sector
@@ -45,6 +55,13 @@ public:
 		short    special;
 		short    tag;
 		uint16_t flags;
+
+		void convertByteOrder()
+		{
+			maplump::convertByteOrder(f_height, c_height, f_tex, c_tex, special, tag, flags);
+			for (auto& c : color)
+				maplump::convertByteOrder(c);
+		}
 	};
 
 	struct Thing
@@ -56,6 +73,8 @@ public:
 		short type;
 		short flags;
 		short tid;
+
+		void convertByteOrder() { maplump::convertByteOrder(x, y, z, angle, type, flags, tid); }
 	};
 
 	bool readMap(Archive::MapDesc map, MapObjectCollection& map_data, PropertyList& map_extra_props) override;
@@ -145,21 +145,10 @@ bool DoomMapFormat::readVERTEXES(ArchiveEntry* entry, MapObjectCollection& map_d
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Vertex))
-	{
-		log::info(3, "Read 0 vertices");
-		return true;
-	}
-
-	auto     vert_data = (Vertex*)entry->rawData(true);
-	unsigned nv        = entry->size() / sizeof(Vertex);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nv; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nv) * 0.2f);
-		map_data.addVertex(std::make_unique<MapVertex>(Vec2d{ (double)vert_data[a].x, (double)vert_data[a].y }));
-	}
+	auto vertices = maplump::decode<Vertex>(entry);
+	map_data.reserve(MapObject::Type::Vertex, vertices.size());
+	for (const auto& data : vertices)
+		map_data.addVertex(std::make_unique<MapVertex>(Vec2d{ (double)data.x, (double)data.y }));
 
 	log::info(3, "Read {} vertices", map_data.vertices().size());
 
@@ -178,27 +167,25 @@ bool DoomMapFormat::readSIDEDEFS(ArchiveEntry* entry, MapObjectCollection& map_d
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(SideDef))
-	{
-		log::info(3, "Read 0 sides");
-		return true;
-	}
+	auto sides = maplump::decode<SideDef>(entry);
+	map_data.reserve(MapObject::Type::Side, sides.size());
 
-	auto     side_data = (SideDef*)entry->rawData(true);
-	unsigned ns        = entry->size() / sizeof(SideDef);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / ns) * 0.2f);
+	// Resolve sector references
+	auto&              sector_list = map_data.sectors();
+	vector<MapSector*> sectors(sides.size());
+	for (unsigned a = 0; a < sides.size(); ++a)
+		sectors[a] = sector_list.at(sides[a].sector);
 
-		// Add side
+	// Add sides
+	for (unsigned a = 0; a < sides.size(); ++a)
+	{
+		const auto& data = sides[a];
 		map_data.addSide(std::make_unique<MapSide>(
-			map_data.sectors().at(side_data[a].sector),
-			strutil::viewFromChars(side_data[a].tex_upper, 8),
-			strutil::viewFromChars(side_data[a].tex_middle, 8),
-			strutil::viewFromChars(side_data[a].tex_lower, 8),
-			Vec2i{ side_data[a].x_offset, side_data[a].y_offset }));
+			sectors[a],
+			strutil::viewFromChars(data.tex_upper, 8),
+			strutil::viewFromChars(data.tex_middle, 8),
+			strutil::viewFromChars(data.tex_lower, 8),
+			Vec2i{ data.x_offset, data.y_offset }));
 	}
 
 	log::info(3, "Read {} sides", map_data.sides().size());
@@ -218,45 +205,24 @@ bool DoomMapFormat::readLINEDEFS(ArchiveEntry* entry, MapObjectCollection& map_d
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(LineDef))
-	{
-		log::info(3, "Read 0 lines");
-		return true;
-	}
+	auto lines = maplump::decode<LineDef>(entry);
+	map_data.reserve(MapObject::Type::Line, lines.size());
 
-	auto     line_data = (LineDef*)entry->rawData(true);
-	unsigned nl        = entry->size() / sizeof(LineDef);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nl; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nl) * 0.2f);
-		const auto& data = line_data[a];
+	// Resolve vertex and side references
+	auto refs = maplump::resolveLineRefs(lines, map_data);
 
-		// Check vertices exist
-		auto v1 = map_data.vertices().at(data.vertex1);
-		auto v2 = map_data.vertices().at(data.vertex2);
-		if (!v1 || !v2)
+	// Add lines
+	for (unsigned a = 0; a < lines.size(); ++a)
+	{
+		const auto& data = lines[a];
+		const auto& ref  = refs[a];
+		if (!ref.v1 || !ref.v2)
 		{
 			log::warning("Line {} invalid, not added", a);
 			continue;
 		}
 
-		// Get side indices
-		int s1_index = data.side1;
-		int s2_index = data.side2;
-		if (map_data.sides().size() > 32767)
-		{
-			// Support for > 32768 sides
-			if (data.side1 != 65535)
-				s1_index = static_cast<unsigned short>(data.side1);
-			if (data.side2 != 65535)
-				s2_index = static_cast<unsigned short>(data.side2);
-		}
-
-		// Create line
-		auto line = map_data.addLine(std::make_unique<MapLine>(
-			v1, v2, map_data.sides().at(s1_index), map_data.sides().at(s2_index), data.type, data.flags));
+		auto line = map_data.addLine(std::make_unique<MapLine>(ref.v1, ref.v2, ref.s1, ref.s2, data.type, data.flags));
 
 		// Set properties
 		line->setArg(0, data.sector_tag);
@@ -280,22 +246,10 @@ bool DoomMapFormat::readSECTORS(ArchiveEntry* entry, MapObjectCollection& map_da
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Sector))
+	auto sectors = maplump::decode<Sector>(entry);
+	map_data.reserve(MapObject::Type::Sector, sectors.size());
+	for (const auto& data : sectors)
 	{
-		log::info(3, "Read 0 sectors");
-		return true;
-	}
-
-	auto     sect_data = (Sector*)entry->rawData(true);
-	unsigned ns        = entry->size() / sizeof(Sector);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		const auto& data = sect_data[a];
-
-		// Add sector
 		map_data.addSector(std::make_unique<MapSector>(
 			data.f_height,
 			strutil::viewFromChars(data.f_tex, 8),
@@ -323,24 +277,12 @@ bool DoomMapFormat::readTHINGS(ArchiveEntry* entry, MapObjectCollection& map_dat
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Thing))
+	auto things = maplump::decode<Thing>(entry);
+	map_data.reserve(MapObject::Type::Thing, things.size());
+	for (const auto& data : things)
 	{
-		log::info(3, "Read 0 things");
-		return true;
-	}
-
-	auto     thng_data = (Thing*)entry->rawData(true);
-	unsigned nt        = entry->size() / sizeof(Thing);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nt; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nt) * 0.2f);
 		map_data.addThing(std::make_unique<MapThing>(
-			Vec3d{ (double)thng_data[a].x, (double)thng_data[a].y, 0. },
-			thng_data[a].type,
-			thng_data[a].angle,
-			thng_data[a].flags));
+			Vec3d{ (double)data.x, (double)data.y, 0. }, data.type, data.angle, data.flags));
 	}
 
 	log::info(3, "Read {} things", map_data.things().size());
@@ -353,24 +295,14 @@ bool DoomMapFormat::readTHINGS(ArchiveEntry* entry, MapObjectCollection& map_dat
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> DoomMapFormat::writeVERTEXES(const VertexList& vertices) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("VERTEXES");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(vertices.size() * 4, false);
-	entry->seek(0, 0);
-
-	// Write vertex data
-	short x, y;
-	for (auto& vertex : vertices)
+	vector<Vertex> data(vertices.size());
+	for (unsigned a = 0; a < vertices.size(); ++a)
 	{
-		x = vertex->xPos();
-		y = vertex->yPos();
-		entry->write(&x, 2);
-		entry->write(&y, 2);
+		data[a].x = vertices[a]->xPos();
+		data[a].y = vertices[a]->yPos();
 	}
 
-	return entry;
+	return maplump::encode("VERTEXES", data);
 }
 
 // -----------------------------------------------------------------------------
@@ -378,37 +310,26 @@ unique_ptr<ArchiveEntry> DoomMapFormat::writeVERTEXES(const VertexList& vertices
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> DoomMapFormat::writeSIDEDEFS(const SideList& sides) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("SIDEDEFS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sides.size() * 30, false);
-	entry->seek(0, 0);
-
-	// Write side data
-	SideDef data;
-	for (auto& side : sides)
+	vector<SideDef> data(sides.size());
+	for (unsigned a = 0; a < sides.size(); ++a)
 	{
-		memset(&data, 0, 30);
+		auto  side = sides[a];
+		auto& def  = data[a];
 
 		// Offsets
-		data.x_offset = side->texOffsetX();
-		data.y_offset = side->texOffsetY();
+		def.x_offset = side->texOffsetX();
+		def.y_offset = side->texOffsetY();
 
 		// Sector
-		data.sector = -1;
-		if (side->sector())
-			data.sector = side->sector()->index();
+		def.sector = side->sector() ? side->sector()->index() : -1;
 
 		// Textures
-		memcpy(data.tex_middle, side->texMiddle().data(), side->texMiddle().size());
-		memcpy(data.tex_upper, side->texUpper().data(), side->texUpper().size());
-		memcpy(data.tex_lower, side->texLower().data(), side->texLower().size());
-
-		entry->write(&data, 30);
+		maplump::writeName(def.tex_middle, side->texMiddle());
+		maplump::writeName(def.tex_upper, side->texUpper());
+		maplump::writeName(def.tex_lower, side->texLower());
 	}
 
-	return entry;
+	return maplump::encode("SIDEDEFS", data);
 }
 
 // -----------------------------------------------------------------------------
@@ -416,33 +337,26 @@ unique_ptr<ArchiveEntry> DoomMapFormat::writeSIDEDEFS(const SideList& sides) con
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> DoomMapFormat::writeLINEDEFS(const LineList& lines) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("LINEDEFS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(lines.size() * 14, false);
-	entry->seek(0, 0);
-
-	// Write line data
-	LineDef data;
-	for (auto& line : lines)
+	vector<LineDef> data(lines.size());
+	for (unsigned a = 0; a < lines.size(); ++a)
 	{
-		data.vertex1 = line->v1Index();
-		data.vertex2 = line->v2Index();
+		auto  line = lines[a];
+		auto& def  = data[a];
+
+		def.vertex1 = line->v1Index();
+		def.vertex2 = line->v2Index();
 
 		// Properties
-		data.flags      = line->flags();
-		data.type       = line->special();
-		data.sector_tag = line->arg(0);
+		def.flags      = line->flags();
+		def.type       = line->special();
+		def.sector_tag = line->arg(0);
 
 		// Sides
-		data.side1 = line->s1Index();
-		data.side2 = line->s2Index();
-
-		entry->write(&data, 14);
+		def.side1 = line->s1Index();
+		def.side2 = line->s2Index();
 	}
 
-	return entry;
+	return maplump::encode("LINEDEFS", data);
 }
 
 // -----------------------------------------------------------------------------
@@ -450,36 +364,27 @@ unique_ptr<ArchiveEntry> DoomMapFormat::writeLINEDEFS(const LineList& lines) con
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> DoomMapFormat::writeSECTORS(const SectorList& sectors) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("SECTORS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sectors.size() * 26, false);
-	entry->seek(0, 0);
-
-	// Write sector data
-	Sector data;
-	for (auto& sector : sectors)
+	vector<Sector> data(sectors.size());
+	for (unsigned a = 0; a < sectors.size(); ++a)
 	{
-		memset(&data, 0, 26);
+		auto  sector = sectors[a];
+		auto& def    = data[a];
 
 		// Height
-		data.f_height = sector->floor().height;
-		data.c_height = sector->ceiling().height;
+		def.f_height = sector->floor().height;
+		def.c_height = sector->ceiling().height;
 
 		// Textures
-		memcpy(data.f_tex, sector->floor().texture.data(), sector->floor().texture.size());
-		memcpy(data.c_tex, sector->ceiling().texture.data(), sector->ceiling().texture.size());
+		maplump::writeName(def.f_tex, sector->floor().texture.str());
+		maplump::writeName(def.c_tex, sector->ceiling().texture.str());
 
 		// Properties
-		data.light   = sector->lightLevel();
-		data.special = sector->special();
-		data.tag     = sector->tag();
-
-		entry->write(&data, 26);
+		def.light   = sector->lightLevel();
+		def.special = sector->special();
+		def.tag     = sector->tag();
 	}
 
-	return entry;
+	return maplump::encode("SECTORS", data);
 }
 
 // -----------------------------------------------------------------------------
@@ -487,28 +392,21 @@ unique_ptr<ArchiveEntry> DoomMapFormat::writeSECTORS(const SectorList& sectors)
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> DoomMapFormat::writeTHINGS(const ThingList& things) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("THINGS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(things.size() * 10, false);
-	entry->seek(0, 0);
-
-	// Write thing data
-	Thing data;
-	for (auto& thing : things)
+	vector<Thing> data(things.size());
+	for (unsigned a = 0; a < things.size(); ++a)
 	{
+		auto  thing = things[a];
+		auto& def   = data[a];
+
 		// Position
-		data.x = thing->xPos();
-		data.y = thing->yPos();
+		def.x = thing->xPos();
+		def.y = thing->yPos();
 
 		// Properties
-		data.angle = thing->angle();
-		data.type  = thing->type();
-		data.flags = thing->flags();
-
-		entry->write(&data, 10);
+		def.angle = thing->angle();
+		def.type  = thing->type();
+		def.flags = thing->flags();
 	}
 
-	return entry;
+	return maplump::encode("THINGS", data);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapFormatHandler.h"
+#include "MapLump.h"
 
 namespace slade
 {
@@ -17,6 +18,8 @@ public:
 	{
 		short x;
 		short y;
+
+		void convertByteOrder() { maplump::convertByteOrder(x, y); }
 	};
 
 	struct SideDef
@@ -27,6 +30,8 @@ public:
 		char  tex_lower[8];
 		char  tex_middle[8];
 		short sector;
+
+		void convertByteOrder() { maplump::convertByteOrder(x_offset, y_offset, sector); }
 	};
 
 	struct LineDef
@@ -38,6 +43,8 @@ public:
 		uint16_t sector_tag;
 		uint16_t side1;
 		uint16_t side2;
+
+		void convertByteOrder() { maplump::convertByteOrder(vertex1, vertex2, flags, type, sector_tag, side1, side2); }
 	};
 
 	struct Sector
@@ -49,6 +56,8 @@ public:
 		short light;
 		short special;
 		short tag;
+
+		void convertByteOrder() { maplump::convertByteOrder(f_height, c_height, light, special, tag); }
 	};
 
 	struct Thing
@@ -58,6 +67,8 @@ public:
 		short angle;
 		short type;
 		short flags;
+
+		void convertByteOrder() { maplump::convertByteOrder(x, y, angle, type, flags); }
 	};
 
 	bool readMap(Archive::MapDesc map, MapObjectCollection& map_data, PropertyList& map_extra_props) override;
@@ -34,7 +34,6 @@
 #include "Main.h"
 #include "HexenMapFormat.h"
 #include "Game/Configuration.h"
-#include "General/UI.h"
 #include "SLADEMap/MapObject/MapLine.h"
 #include "SLADEMap/MapObjectCollection.h"
 
@@ -60,52 +59,33 @@ bool HexenMapFormat::readLINEDEFS(ArchiveEntry* entry, MapObjectCollection& map_
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(LineDef))
-	{
-		log::info(3, "Read 0 lines");
-		return true;
-	}
+	auto lines = maplump::decode<LineDef>(entry);
+	map_data.reserve(MapObject::Type::Line, lines.size());
 
-	auto     line_data = (LineDef*)entry->rawData(true);
-	unsigned nl        = entry->size() / sizeof(LineDef);
-	float    p         = ui::getSplashProgress();
-	for (size_t a = 0; a < nl; a++)
-	{
-		ui::setSplashProgress(p + ((float)a / nl) * 0.2f);
-		const auto& data = line_data[a];
+	// Resolve vertex and side references
+	auto refs = maplump::resolveLineRefs(lines, map_data);
 
-		// Check vertices exist
-		auto v1 = map_data.vertices().at(data.vertex1);
-		auto v2 = map_data.vertices().at(data.vertex2);
-		if (!v1 || !v2)
+	// Add lines
+	for (unsigned a = 0; a < lines.size(); ++a)
+	{
+		const auto& data = lines[a];
+		const auto& ref  = refs[a];
+		if (!ref.v1 || !ref.v2)
 		{
 			log::warning("Line {} invalid, not added", a);
 			continue;
 		}
 
-		// Get side indices
-		int s1_index = data.side1;
-		int s2_index = data.side2;
-		if (map_data.sides().size() > 32767)
-		{
-			// Support for > 32768 sides
-			if (data.side1 != 65535)
-				s1_index = static_cast<unsigned short>(data.side1);
-			if (data.side2 != 65535)
-				s2_index = static_cast<unsigned short>(data.side2);
-		}
-
 		// Get sides and duplicate if necessary
-		auto s1 = map_data.sides().at(s1_index);
+		auto s1 = ref.s1;
 		if (s1 && s1->parentLine())
 			s1 = map_data.duplicateSide(s1);
-		auto s2 = map_data.sides().at(s2_index);
+		auto s2 = ref.s2;
 		if (s2 && s2->parentLine())
 			s2 = map_data.duplicateSide(s2);
 
 		// Create line
-		auto line = map_data.addLine(std::make_unique<MapLine>(v1, v2, s1, s2, data.type, data.flags));
+		auto line = map_data.addLine(std::make_unique<MapLine>(ref.v1, ref.v2, s1, s2, data.type, data.flags));
 
 		// Set properties
 		for (unsigned i = 0; i < 5; ++i)
@@ -141,22 +121,12 @@ bool HexenMapFormat::readTHINGS(ArchiveEntry* entry, MapObjectCollection& map_da
 		return false;
 	}
 
-	// Check for empty entry
-	if (entry->size() < sizeof(Thing))
-	{
-		log::info(3, "Read 0 things");
-		return true;
-	}
+	auto things = maplump::decode<Thing>(entry);
+	map_data.reserve(MapObject::Type::Thing, things.size());
 
-	auto              thng_data = (Thing*)entry->rawData(true);
-	unsigned          nt        = entry->size() / sizeof(Thing);
-	float             p         = ui::getSplashProgress();
 	MapObject::ArgSet args;
-	for (size_t a = 0; a < nt; a++)
+	for (const auto& data : things)
 	{
-		ui::setSplashProgress(p + ((float)a / nt) * 0.2f);
-		const auto& data = thng_data[a];
-
 		// Set args
 		for (unsigned i = 0; i < 5; ++i)
 			args[i] = data.args[i];
@@ -182,34 +152,27 @@ bool HexenMapFormat::readTHINGS(ArchiveEntry* entry, MapObjectCollection& map_da
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> HexenMapFormat::writeLINEDEFS(const LineList& lines) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("LINEDEFS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(lines.size() * sizeof(LineDef), false);
-	entry->seek(0, 0);
-
-	// Write line data
-	LineDef data;
-	for (auto& line : lines)
+	vector<LineDef> data(lines.size());
+	for (unsigned a = 0; a < lines.size(); ++a)
 	{
-		data.vertex1 = line->v1Index();
-		data.vertex2 = line->v2Index();
+		auto  line = lines[a];
+		auto& def  = data[a];
+
+		def.vertex1 = line->v1Index();
+		def.vertex2 = line->v2Index();
 
 		// Properties
-		data.flags = line->flags();
-		data.type  = line->special();
+		def.flags = line->flags();
+		def.type  = line->special();
 		for (unsigned i = 0; i < 5; ++i)
-			data.args[i] = line->arg(i);
+			def.args[i] = line->arg(i);
 
 		// Sides
-		data.side1 = line->s1Index();
-		data.side2 = line->s2Index();
-
-		entry->write(&data, sizeof(LineDef));
+		def.side1 = line->s1Index();
+		def.side2 = line->s2Index();
 	}
 
-	return entry;
+	return maplump::encode("LINEDEFS", data);
 }
 
 // -----------------------------------------------------------------------------
@@ -217,36 +180,29 @@ unique_ptr<ArchiveEntry> HexenMapFormat::writeLINEDEFS(const LineList& lines) co
 // -----------------------------------------------------------------------------
 unique_ptr<ArchiveEntry> HexenMapFormat::writeTHINGS(const ThingList& things) const
 {
-	auto entry = std::make_unique<ArchiveEntry>("THINGS");
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(things.size() * sizeof(Thing), false);
-	entry->seek(0, 0);
-
-	// Write thing data
-	Thing data;
-	for (auto& thing : things)
+	vector<Thing> data(things.size());
+	for (unsigned a = 0; a < things.size(); ++a)
 	{
+		auto  thing = things[a];
+		auto& def   = data[a];
+
 		// Position
-		data.x = thing->xPos();
-		data.y = thing->yPos();
-		data.z = thing->zPos();
+		def.x = thing->xPos();
+		def.y = thing->yPos();
+		def.z = thing->zPos();
 
 		// Properties
-		data.angle   = thing->angle();
-		data.type    = thing->type();
-		data.flags   = thing->flags();
-		data.special = thing->special();
-		data.tid     = thing->id();
-		data.args[0] = thing->arg(0);
-		data.args[1] = thing->arg(1);
-		data.args[2] = thing->arg(2);
-		data.args[3] = thing->arg(3);
-		data.args[4] = thing->arg(4);
-
-		entry->write(&data, sizeof(Thing));
+		def.angle   = thing->angle();
+		def.type    = thing->type();
+		def.flags   = thing->flags();
+		def.special = thing->special();
+		def.tid     = thing->id();
+		def.args[0] = thing->arg(0);
+		def.args[1] = thing->arg(1);
+		def.args[2] = thing->arg(2);
+		def.args[3] = thing->arg(3);
+		def.args[4] = thing->arg(4);
 	}
 
-	return entry;
+	return maplump::encode("THINGS", data);
 }
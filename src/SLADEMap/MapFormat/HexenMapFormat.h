@@ -16,6 +16,8 @@ public:
 		uint8_t  args[5];
 		uint16_t side1;
 		uint16_t side2;
+
+		void convertByteOrder() { maplump::convertByteOrder(vertex1, vertex2, flags, side1, side2); }
 	};
 
 	struct Thing
@@ -29,6 +31,8 @@ public:
 		short   flags;
 		uint8_t special;
 		uint8_t args[5];
+
+		void convertByteOrder() { maplump::convertByteOrder(tid, x, y, z, angle, type, flags); }
 	};
 
 protected:
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Archive/ArchiveEntry.h"
+
+namespace slade
+{
+class MapSide;
+class MapVertex;
+} // namespace slade
+
+// Helpers for reading and writing binary map lumps (VERTEXES, LINEDEFS etc.)
+// in bulk. A lump is decoded to an array of packed structs in a single copy,
+// with byte order conversion done in one pass over the array. Lump structs
+// must be trivially copyable and provide a convertByteOrder() function that
+// converts all their multi-byte fields between little-endian and native order
+namespace slade::maplump
+{
+// Vertex and side objects referenced by a binary-format line
+struct LineRefs
+{
+	MapVertex* v1 = nullptr;
+	MapVertex* v2 = nullptr;
+	MapSide*   s1 = nullptr;
+	MapSide*   s2 = nullptr;
+};
+
+inline void convertField(int16_t& value)
+{
+	value = wxINT16_SWAP_ON_BE(value);
+}
+inline void convertField(uint16_t& value)
+{
+	value = wxUINT16_SWAP_ON_BE(value);
+}
+inline void convertField(int32_t& value)
+{
+	value = wxINT32_SWAP_ON_BE(value);
+}
+inline void convertField(uint32_t& value)
+{
+	value = wxUINT32_SWAP_ON_BE(value);
+}
+
+// Converts all given [fields] between little-endian and native byte order
+template<typename... Fields> void convertByteOrder(Fields&... fields)
+{
+	(convertField(fields), ...);
+}
+
+// Converts all [items] between little-endian and native byte order. Does
+// nothing on little-endian systems
+template<typename T> void convertByteOrder(vector<T>& items)
+{
+#if wxBYTE_ORDER == wxBIG_ENDIAN
+	for (auto& item : items)
+		item.convertByteOrder();
+#endif
+}
+
+// Returns the contents of [entry] as an array of [T] structs, in native byte
+// order. Any trailing partial struct is ignored
+template<typename T> vector<T> decode(ArchiveEntry* entry)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	vector<T> items;
+	if (!entry || entry->size() < sizeof(T))
+		return items;
+
+	items.resize(entry->size() / sizeof(T));
+	memcpy(items.data(), entry->rawData(true), items.size() * sizeof(T));
+	convertByteOrder(items);
+
+	return items;
+}
+
+// Creates and returns a new entry [name] containing [items]. The items are
+// converted to little-endian in place, so [items] can't be used afterwards
+template<typename T> unique_ptr<ArchiveEntry> encode(string_view name, vector<T>& items)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	convertByteOrder(items);
+
+	auto entry = std::make_unique<ArchiveEntry>(name);
+	entry->importMem(items.data(), items.size() * sizeof(T));
+
+	return entry;
+}
+
+// Resolves the vertex and side indices of all [lines] to the matching objects
+// in [map_data], in one pass. Indices out of range resolve to null
+template<typename LineDef, typename ObjectCollection>
+vector<LineRefs> resolveLineRefs(const vector<LineDef>& lines, const ObjectCollection& map_data)
+{
+	auto& vertices = map_data.vertices();
+	auto& sides    = map_data.sides();
+
+	vector<LineRefs> refs(lines.size());
+	for (size_t a = 0; a < lines.size(); ++a)
+	{
+		refs[a].v1 = vertices.at(lines[a].vertex1);
+		refs[a].v2 = vertices.at(lines[a].vertex2);
+		refs[a].s1 = sides.at(lines[a].side1);
+		refs[a].s2 = sides.at(lines[a].side2);
+	}
+
+	return refs;
+}
+
+// Copies texture [name] into the fixed-length lump field [field], padding with
+// zeros and truncating if it is too long
+template<size_t N> void writeName(char (&field)[N], string_view name)
+{
+	memset(field, 0, N);
+	memcpy(field, name.data(), std::min(name.size(), N));
+}
+} // namespace slade::maplump
@@ -0,0 +1,204 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapGeometrySnapshot.cpp
+// Description: MapGeometrySnapshot class - a struct-of-arrays copy of the map
+//              vertex, line, sector and thing geometry, kept up to date from
+//              the map's modified objects log
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapGeometrySnapshot.h"
+#include "SLADEMap.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// MapGeometrySnapshot Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Brings the snapshot up to date with the map. Object lists that have had
+// objects added or removed are re-read in full, otherwise only modified
+// objects are updated
+// -----------------------------------------------------------------------------
+void MapGeometrySnapshot::sync()
+{
+	auto& data = map_->mapData();
+	if (valid_ && data.generation() == synced_gen_)
+		return;
+
+	bool vertices_changed = !valid_ || listChanged(MapObject::Type::Vertex);
+	bool lines_changed    = !valid_ || listChanged(MapObject::Type::Line);
+	bool sectors_changed  = !valid_ || listChanged(MapObject::Type::Sector);
+	bool things_changed   = !valid_ || listChanged(MapObject::Type::Thing);
+
+	// Vertices
+	vector<MapSector*> dirty_sectors;
+	if (vertices_changed)
+		rebuildVertices();
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Vertex))
+		{
+			auto vertex                = dynamic_cast<MapVertex*>(object);
+			vertex_x_[vertex->index()] = vertex->xPos();
+			vertex_y_[vertex->index()] = vertex->yPos();
+
+			// Sectors around the vertex may have changed size
+			for (auto line : vertex->connectedLines())
+			{
+				dirty_sectors.push_back(line->frontSector());
+				dirty_sectors.push_back(line->backSector());
+			}
+		}
+	}
+
+	// Lines (vertex indices change if vertices are removed)
+	if (vertices_changed || lines_changed)
+		rebuildLines();
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Line))
+		{
+			auto line   = dynamic_cast<MapLine*>(object);
+			auto i      = line->index();
+			line_v1_[i] = line->v1() ? line->v1()->index() : NO_INDEX;
+			line_v2_[i] = line->v2() ? line->v2()->index() : NO_INDEX;
+			dirty_sectors.push_back(line->frontSector());
+			dirty_sectors.push_back(line->backSector());
+		}
+	}
+
+	// Sectors (changing a side's sector can change the size of sectors other
+	// than the modified ones, so just re-read them all)
+	if (vertices_changed || lines_changed || data.modifiedSinceGen(synced_gen_, MapObject::Type::Side))
+		sectors_changed = true;
+	if (sectors_changed)
+		rebuildSectors();
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Sector))
+			dirty_sectors.push_back(dynamic_cast<MapSector*>(object));
+
+		for (auto sector : dirty_sectors)
+			if (sector)
+				sector_bbox_[sector->index()] = sector->boundingBox();
+	}
+
+	// Things
+	if (things_changed)
+		rebuildThings();
+	else
+	{
+		for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Thing))
+		{
+			auto thing     = dynamic_cast<MapThing*>(object);
+			auto i         = thing->index();
+			thing_x_[i]    = thing->xPos();
+			thing_y_[i]    = thing->yPos();
+			thing_type_[i] = thing->type();
+		}
+	}
+
+	for (int a = 0; a < 6; a++)
+		list_gen_[a] = data.listGeneration(static_cast<MapObject::Type>(a));
+	synced_gen_ = data.generation();
+	valid_      = true;
+	version_++;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the map's list of objects of [type] has changed since the
+// last sync
+// -----------------------------------------------------------------------------
+bool MapGeometrySnapshot::listChanged(MapObject::Type type) const
+{
+	return map_->mapData().listGeneration(type) != list_gen_[static_cast<int>(type)];
+}
+
+// -----------------------------------------------------------------------------
+// Re-reads all vertex positions from the map
+// -----------------------------------------------------------------------------
+void MapGeometrySnapshot::rebuildVertices()
+{
+	auto& vertices = map_->vertices();
+	vertex_x_.resize(vertices.size());
+	vertex_y_.resize(vertices.size());
+	for (unsigned a = 0; a < vertices.size(); a++)
+	{
+		vertex_x_[a] = vertices[a]->xPos();
+		vertex_y_[a] = vertices[a]->yPos();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Re-reads all line vertex indices from the map
+// -----------------------------------------------------------------------------
+void MapGeometrySnapshot::rebuildLines()
+{
+	auto& lines = map_->lines();
+	line_v1_.resize(lines.size());
+	line_v2_.resize(lines.size());
+	for (unsigned a = 0; a < lines.size(); a++)
+	{
+		line_v1_[a] = lines[a]->v1() ? lines[a]->v1()->index() : NO_INDEX;
+		line_v2_[a] = lines[a]->v2() ? lines[a]->v2()->index() : NO_INDEX;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Re-reads all sector bounding boxes from the map
+// -----------------------------------------------------------------------------
+void MapGeometrySnapshot::rebuildSectors()
+{
+	auto& sectors = map_->sectors();
+	sector_bbox_.resize(sectors.size());
+	for (unsigned a = 0; a < sectors.size(); a++)
+		sector_bbox_[a] = sectors[a]->boundingBox();
+}
+
+// -----------------------------------------------------------------------------
+// Re-reads all thing positions and types from the map
+// -----------------------------------------------------------------------------
+void MapGeometrySnapshot::rebuildThings()
+{
+	auto& things = map_->things();
+	thing_x_.resize(things.size());
+	thing_y_.resize(things.size());
+	thing_type_.resize(things.size());
+	for (unsigned a = 0; a < things.size(); a++)
+	{
+		thing_x_[a]    = things[a]->xPos();
+		thing_y_[a]    = things[a]->yPos();
+		thing_type_[a] = things[a]->type();
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SLADEMap/MapObject/MapObject.h"
+
+namespace slade
+{
+class SLADEMap;
+
+// A read-only, struct-of-arrays copy of the map geometry, for passes over the
+// whole map that only need positions (rendering, culling, checks). Arrays are
+// indexed by object index, and lines refer to vertices by index, so bulk
+// passes can run over contiguous arrays rather than chasing object pointers.
+//
+// The snapshot is brought up to date with sync(), which only re-reads objects
+// modified since the last sync unless an object list itself has changed.
+// Once synced it can be read from worker threads, as long as nothing syncs it
+// again until they are done
+class MapGeometrySnapshot
+{
+public:
+	static constexpr unsigned NO_INDEX = 0xFFFFFFFF;
+
+	MapGeometrySnapshot(SLADEMap* map) : map_{ map } {}
+	~MapGeometrySnapshot() = default;
+
+	// Incremented whenever anything in the snapshot changes
+	unsigned long version() const { return version_; }
+
+	void invalidate() { valid_ = false; }
+	void sync();
+
+	// Vertices
+	unsigned              nVertices() const { return vertex_x_.size(); }
+	const vector<double>& vertexX() const { return vertex_x_; }
+	const vector<double>& vertexY() const { return vertex_y_; }
+
+	// Lines
+	unsigned                nLines() const { return line_v1_.size(); }
+	const vector<unsigned>& lineV1() const { return line_v1_; }
+	const vector<unsigned>& lineV2() const { return line_v2_; }
+
+	// Sectors
+	unsigned            nSectors() const { return sector_bbox_.size(); }
+	const vector<BBox>& sectorBBox() const { return sector_bbox_; }
+
+	// Things
+	unsigned              nThings() const { return thing_x_.size(); }
+	const vector<double>& thingX() const { return thing_x_; }
+	const vector<double>& thingY() const { return thing_y_; }
+	const vector<int>&    thingType() const { return thing_type_; }
+
+private:
+	SLADEMap*     map_;
+	bool          valid_      = false;
+	unsigned long synced_gen_ = 0;
+	unsigned long version_    = 0;
+	unsigned long list_gen_[6]{}; // List generations (see MapObjectCollection) at the last sync
+
+	vector<double>   vertex_x_;
+	vector<double>   vertex_y_;
+	vector<unsigned> line_v1_;
+	vector<unsigned> line_v2_;
+	vector<BBox>     sector_bbox_;
+	vector<double>   thing_x_;
+	vector<double>   thing_y_;
+	vector<int>      thing_type_;
+
+	bool listChanged(MapObject::Type type) const;
+	void rebuildVertices();
+	void rebuildLines();
+	void rebuildSectors();
+	void rebuildThings();
+};
+} // namespace slade
@@ -44,6 +44,10 @@ public:
 	MapLine(MapVertex* v1, MapVertex* v2, MapSide* s1, MapSide* s2, ParseTreeNode* udmf_def);
 	~MapLine() = default;
 
+	// Map objects are allocated from their map's arena (see MapObjectArena)
+	static void* operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void  operator delete(void* ptr) { MapObjectArena::release(ptr); }
+
 	bool isOk() const { return vertex1_ && vertex2_; }
 
 	MapVertex*    v1() const { return vertex1_; }
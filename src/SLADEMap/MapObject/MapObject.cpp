@@ -104,6 +104,10 @@ void MapObject::setModified()
 	}
 
 	modified_time_ = app::runTimer();
+
+	// Add to the parent map's modified objects list
+	if (parent_map_ && obj_id_ > 0)
+		parent_map_->objectModified(this);
 }
 
 // -----------------------------------------------------------------------------
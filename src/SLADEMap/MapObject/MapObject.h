@@ -4,6 +4,7 @@
 #pragma clang diagnostic ignored "-Wundefined-bool-conversion"
 #endif
 
+#include "MapObjectPool.h"
 #include "Utility/Property.h"
 #include <array>
 
@@ -60,15 +61,16 @@ public:
 	bool operator<(const MapObject& right) const { return (index_ < right.index_); }
 	bool operator>(const MapObject& right) const { return (index_ > right.index_); }
 
-	Type      objType() const { return type_; }
-	unsigned  index() const;
-	SLADEMap* parentMap() const { return parent_map_; }
-	bool      isFiltered() const { return filtered_; }
-	long      modifiedTime() const { return modified_time_; }
-	unsigned  objId() const { return obj_id_; }
-	string    typeName() const;
-	void      setModified();
-	void      setIndex(unsigned index) { index_ = index; }
+	Type          objType() const { return type_; }
+	unsigned      index() const;
+	SLADEMap*     parentMap() const { return parent_map_; }
+	bool          isFiltered() const { return filtered_; }
+	long          modifiedTime() const { return modified_time_; }
+	unsigned long modifiedGeneration() const { return modified_gen_; }
+	unsigned      objId() const { return obj_id_; }
+	string        typeName() const;
+	void          setModified();
+	void          setIndex(unsigned index) { index_ = index; }
 
 	PropertyList& props() { return properties_; }
 	bool          hasProp(string_view key);
@@ -114,6 +116,7 @@ protected:
 	PropertyList       properties_;
 	bool               filtered_      = false;
 	long               modified_time_ = 0;
+	unsigned long      modified_gen_  = 0;
 	unsigned           obj_id_        = 0;
 	unique_ptr<Backup> obj_backup_;
 
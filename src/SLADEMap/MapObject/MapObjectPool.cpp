@@ -0,0 +1,229 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapObjectPool.cpp
+// Description: MapObjectPool and MapObjectArena classes, slab allocation of map
+//              objects, per map object collection
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapObjectPool.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+thread_local MapObjectArena* MapObjectArena::current_ = nullptr;
+namespace
+{
+// Each allocation starts with a header holding the pool it came from (or null
+// if it came from the heap), padded to keep the object itself aligned
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapObjectPool Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapObjectPool class constructor
+// -----------------------------------------------------------------------------
+MapObjectPool::MapObjectPool(size_t slot_size) :
+	slot_size_{ slot_size },
+	slab_slots_{ std::max<size_t>(16, SLAB_BYTES / slot_size) },
+	slab_used_{ slab_slots_ }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Returns a free slot from the pool, adding a new slab if needed
+// -----------------------------------------------------------------------------
+void* MapObjectPool::allocate()
+{
+	std::lock_guard lock(mutex_);
+
+	n_allocated_++;
+
+	// Reuse a freed slot if possible
+	if (free_)
+	{
+		auto slot = free_;
+		free_     = *static_cast<void**>(slot);
+		return slot;
+	}
+
+	// Otherwise take the next slot in the current slab
+	if (slab_used_ == slab_slots_)
+	{
+		slabs_.emplace_back(new unsigned char[slab_slots_ * slot_size_]);
+		slab_used_ = 0;
+	}
+
+	return slabs_.back().get() + slot_size_ * slab_used_++;
+}
+
+// -----------------------------------------------------------------------------
+// Returns [slot] to the pool for reuse. If the pool has been detached from its
+// arena, it is deleted once its last slot is released
+// -----------------------------------------------------------------------------
+void MapObjectPool::release(void* slot)
+{
+	bool destroy;
+	{
+		std::lock_guard lock(mutex_);
+
+		*static_cast<void**>(slot) = free_;
+		free_                      = slot;
+		destroy                    = --n_allocated_ == 0 && detached_;
+	}
+
+	if (destroy)
+		delete this;
+}
+
+// -----------------------------------------------------------------------------
+// Releases all slabs in the pool. Returns false (and releases nothing) if any
+// slots are still in use
+// -----------------------------------------------------------------------------
+bool MapObjectPool::clear()
+{
+	std::lock_guard lock(mutex_);
+
+	if (n_allocated_ > 0)
+		return false;
+
+	slabs_.clear();
+	free_      = nullptr;
+	slab_used_ = slab_slots_;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Detaches the pool from its arena (when the arena is destroyed). The pool is
+// deleted immediately if no slots are in use, otherwise when the last one is
+// released
+// -----------------------------------------------------------------------------
+void MapObjectPool::detach()
+{
+	bool destroy;
+	{
+		std::lock_guard lock(mutex_);
+
+		detached_ = true;
+		destroy   = n_allocated_ == 0;
+	}
+
+	if (destroy)
+		delete this;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MapObjectArena Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapObjectArena class destructor
+// -----------------------------------------------------------------------------
+MapObjectArena::~MapObjectArena()
+{
+	for (auto pool : pools_)
+		if (pool)
+			pool->detach();
+}
+
+// -----------------------------------------------------------------------------
+// Releases the memory of all pools in the arena. Returns false if any pool
+// still had objects allocated (its memory is kept)
+// -----------------------------------------------------------------------------
+bool MapObjectArena::clear()
+{
+	bool cleared = true;
+	for (auto pool : pools_)
+		if (pool && !pool->clear())
+			cleared = false;
+
+	return cleared;
+}
+
+// -----------------------------------------------------------------------------
+// Allocates memory for an object of [size] bytes, from the current arena if
+// there is one (and it has a pool for the size), otherwise from the heap
+// -----------------------------------------------------------------------------
+void* MapObjectArena::allocate(size_t size)
+{
+	auto slot_size = HEADER_SIZE + (size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+
+	// Find (or create) the pool for the size in the current arena
+	MapObjectPool* pool = nullptr;
+	if (current_)
+	{
+		for (auto& arena_pool : current_->pools_)
+		{
+			if (!arena_pool)
+				arena_pool = new MapObjectPool(slot_size);
+
+			if (arena_pool->slotSize() == slot_size)
+			{
+				pool = arena_pool;
+				break;
+			}
+		}
+	}
+
+	auto slot                           = pool ? pool->allocate() : ::operator new(slot_size);
+	*static_cast<MapObjectPool**>(slot) = pool;
+	return static_cast<unsigned char*>(slot) + HEADER_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Releases the object memory at [ptr] back to the pool it came from (or the
+// heap)
+// -----------------------------------------------------------------------------
+void MapObjectArena::release(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	auto slot = static_cast<unsigned char*>(ptr) - HEADER_SIZE;
+	auto pool = *reinterpret_cast<MapObjectPool**>(slot);
+	if (pool)
+		pool->release(slot);
+	else
+		::operator delete(slot);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mutex>
+
+namespace slade
+{
+// Allocates fixed-size slots from large contiguous slabs rather than
+// individually from the heap. Freed slots are reused, and all slabs are
+// released together by clear() once no slots are in use
+class MapObjectPool
+{
+public:
+	MapObjectPool(size_t slot_size);
+	~MapObjectPool() = default;
+
+	size_t slotSize() const { return slot_size_; }
+
+	void* allocate();
+	void  release(void* slot);
+	bool  clear();
+	void  detach();
+
+private:
+	static constexpr size_t SLAB_BYTES = 256 * 1024;
+
+	std::mutex                          mutex_;
+	vector<unique_ptr<unsigned char[]>> slabs_;
+	void*                               free_        = nullptr;
+	size_t                              slot_size_   = 0;
+	size_t                              slab_slots_  = 0;
+	size_t                              slab_used_   = 0; // Slots used in the last slab
+	unsigned                            n_allocated_ = 0;
+	bool                                detached_    = false;
+};
+
+// A set of object pools (one per object size) belonging to a single
+// MapObjectCollection. Map object classes allocate via MapObjectArena in their
+// class-specific operator new/delete, from the arena of the current Scope on
+// the calling thread (or from the heap if there is none). This way the objects
+// of a map are laid out together in memory, separate from any other map, and
+// are released in bulk when the map is cleared
+class MapObjectArena
+{
+public:
+	// While a Scope exists, map objects created on the current thread are
+	// allocated from [arena]
+	class Scope
+	{
+	public:
+		Scope(MapObjectArena& arena) : previous_{ current_ } { current_ = &arena; }
+		~Scope() { current_ = previous_; }
+
+	private:
+		MapObjectArena* previous_;
+	};
+
+	MapObjectArena() = default;
+	~MapObjectArena();
+
+	// Not copyable, objects refer to their pools directly
+	MapObjectArena(const MapObjectArena&) = delete;
+	MapObjectArena& operator=(const MapObjectArena&) = delete;
+
+	bool clear();
+
+	static void* allocate(size_t size);
+	static void  release(void* ptr);
+
+private:
+	static constexpr int N_POOLS = 8;
+
+	MapObjectPool* pools_[N_POOLS] = {};
+
+	static thread_local MapObjectArena* current_;
+};
+} // namespace slade
@@ -159,9 +159,9 @@ void MapSector::setGeometryUpdated()
 string MapSector::stringProperty(string_view key)
 {
 	if (key == PROP_TEXFLOOR)
-		return floor_.texture;
+		return floor_.texture.str();
 	else if (key == PROP_TEXCEILING)
-		return ceiling_.texture;
+		return ceiling_.texture.str();
 	else
 		return MapObject::stringProperty(key);
 }
@@ -246,6 +246,14 @@ void MapSector::setIntProperty(string_view key, int value)
 // Sets the floor texture to [tex]
 // -----------------------------------------------------------------------------
 void MapSector::setFloorTexture(string_view tex)
+{
+	setFloorTexture(TextureName{ tex });
+}
+
+// -----------------------------------------------------------------------------
+// Sets the floor texture to [tex] (interned)
+// -----------------------------------------------------------------------------
+void MapSector::setFloorTexture(const TextureName& tex)
 {
 	setModified();
 	if (parent_map_)
@@ -259,6 +267,14 @@ void MapSector::setFloorTexture(string_view tex)
 // Sets the ceiling texture to [tex]
 // -----------------------------------------------------------------------------
 void MapSector::setCeilingTexture(string_view tex)
+{
+	setCeilingTexture(TextureName{ tex });
+}
+
+// -----------------------------------------------------------------------------
+// Sets the ceiling texture to [tex] (interned)
+// -----------------------------------------------------------------------------
+void MapSector::setCeilingTexture(const TextureName& tex)
 {
 	setModified();
 	if (parent_map_)
@@ -393,11 +409,8 @@ BBox MapSector::boundingBox()
 // -----------------------------------------------------------------------------
 Polygon2D* MapSector::polygon()
 {
-	if (poly_needsupdate_)
-	{
+	if (polygon_.geometryVersion() != geometry_version_)
 		polygon_.openSector(this);
-		poly_needsupdate_ = false;
-	}
 
 	return &polygon_;
 }
@@ -828,7 +841,7 @@ void MapSector::connectSide(MapSide* side)
 {
 	setModified();
 	connected_sides_.push_back(side);
-	poly_needsupdate_ = true;
+	resetPolygon();
 	bbox_.reset();
 	setGeometryUpdated();
 }
@@ -848,7 +861,7 @@ void MapSector::disconnectSide(MapSide* side)
 		}
 	}
 
-	poly_needsupdate_ = true;
+	resetPolygon();
 	bbox_.reset();
 	setGeometryUpdated();
 }
@@ -858,8 +871,8 @@ void MapSector::disconnectSide(MapSide* side)
 // -----------------------------------------------------------------------------
 void MapSector::writeBackup(Backup* backup)
 {
-	backup->props_internal[PROP_TEXFLOOR]      = floor_.texture;
-	backup->props_internal[PROP_TEXCEILING]    = ceiling_.texture;
+	backup->props_internal[PROP_TEXFLOOR]      = floor_.texture.str();
+	backup->props_internal[PROP_TEXCEILING]    = ceiling_.texture.str();
 	backup->props_internal[PROP_HEIGHTFLOOR]   = floor_.height;
 	backup->props_internal[PROP_HEIGHTCEILING] = ceiling_.height;
 	backup->props_internal[PROP_LIGHTLEVEL]    = light_;
@@ -876,8 +889,8 @@ void MapSector::readBackup(Backup* backup)
 	parent_map_->sectors().updateTexUsage(floor_.texture, -1);
 	parent_map_->sectors().updateTexUsage(ceiling_.texture, -1);
 
-	floor_.texture   = backup->props_internal.get<string>(PROP_TEXFLOOR);
-	ceiling_.texture = backup->props_internal.get<string>(PROP_TEXCEILING);
+	floor_.texture   = TextureName{ backup->props_internal.get<string>(PROP_TEXFLOOR) };
+	ceiling_.texture = TextureName{ backup->props_internal.get<string>(PROP_TEXCEILING) };
 	floor_.height    = backup->props_internal.get<int>(PROP_HEIGHTFLOOR);
 	ceiling_.height  = backup->props_internal.get<int>(PROP_HEIGHTCEILING);
 	floor_.plane.set(0, 0, 1, floor_.height);
@@ -891,7 +904,7 @@ void MapSector::readBackup(Backup* backup)
 	parent_map_->sectors().updateTexUsage(ceiling_.texture, 1);
 
 	// Update geometry info
-	poly_needsupdate_ = true;
+	resetPolygon();
 	bbox_.reset();
 	setGeometryUpdated();
 }
@@ -904,7 +917,7 @@ void MapSector::writeUDMF(string& def)
 	def = fmt::format("sector//#{}\n{{\n", index_);
 
 	// Basic properties
-	def += fmt::format("texturefloor=\"{}\";\ntextureceiling=\"{}\";\n", floor_.texture, ceiling_.texture);
+	def += fmt::format("texturefloor=\"{}\";\ntextureceiling=\"{}\";\n", floor_.texture.str(), ceiling_.texture.str());
 	if (floor_.height != 0)
 		def += fmt::format("heightfloor={};\n", floor_.height);
 	if (ceiling_.height != 0)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapObject.h"
+#include "SLADEMap/TextureName.h"
 #include "Utility/Colour.h"
 #include "Utility/Polygon2D.h"
 
@@ -20,9 +21,9 @@ public:
 
 	struct Surface
 	{
-		string texture;
-		int    height = 0;
-		Plane  plane  = { 0., 0., 1., 0. };
+		TextureName texture;
+		int         height = 0;
+		Plane       plane  = { 0., 0., 1., 0. };
 
 		Surface(string_view texture = "", int height = 0, const Plane& plane = { 0., 0., 1., 0. }) :
 			texture{ texture },
@@ -52,6 +53,10 @@ public:
 	MapSector(string_view f_tex, string_view c_tex, ParseTreeNode* udmf_def);
 	~MapSector() = default;
 
+	// Map objects are allocated from their map's arena (see MapObjectArena)
+	static void* operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void  operator delete(void* ptr) { MapObjectArena::release(ptr); }
+
 	void copy(MapObject* obj) override;
 
 	const Surface& floor() const { return floor_; }
@@ -70,6 +75,8 @@ public:
 
 	void setFloorTexture(string_view tex);
 	void setCeilingTexture(string_view tex);
+	void setFloorTexture(const TextureName& tex);
+	void setCeilingTexture(const TextureName& tex);
 	void setFloorHeight(short height);
 	void setCeilingHeight(short height);
 	void setFloorPlane(const Plane& p);
@@ -86,7 +93,7 @@ public:
 	void              resetBBox() { bbox_.reset(); }
 	BBox              boundingBox();
 	vector<MapSide*>& connectedSides() { return connected_sides_; }
-	void              resetPolygon() { poly_needsupdate_ = true; }
+	void              resetPolygon() { ++geometry_version_; }
 	Polygon2D*        polygon();
 	bool              containsPoint(Vec2d point);
 	double            distanceTo(Vec2d point, double maxdist = -1);
@@ -98,6 +105,7 @@ public:
 	ColRGBA           colourAt(int where = 0, bool fullbright = false);
 	ColRGBA           fogColour();
 	long              geometryUpdatedTime() const { return geometry_updated_; }
+	unsigned          geometryVersion() const { return geometry_version_; }
 	void              findTextPoint();
 
 	void connectSide(MapSide* side);
@@ -131,7 +139,7 @@ private:
 	vector<MapSide*> connected_sides_;
 	BBox             bbox_;
 	Polygon2D        polygon_;
-	bool             poly_needsupdate_ = true;
+	unsigned         geometry_version_ = 1; // Incremented when the polygon needs rebuilding
 	long             geometry_updated_ = 0;
 	Vec2d            text_point_;
 
@@ -85,11 +85,11 @@ MapSide::MapSide(MapSector* sector, ParseTreeNode* udmf_def) : MapObject{ Type::
 			continue;
 
 		if (prop->nameIsCI(PROP_TEXUPPER))
-			tex_upper_ = prop->stringValue();
+			tex_upper_ = TextureName{ prop->stringValue() };
 		else if (prop->nameIsCI(PROP_TEXMIDDLE))
-			tex_middle_ = prop->stringValue();
+			tex_middle_ = TextureName{ prop->stringValue() };
 		else if (prop->nameIsCI(PROP_TEXLOWER))
-			tex_lower_ = prop->stringValue();
+			tex_lower_ = TextureName{ prop->stringValue() };
 		else if (prop->nameIsCI(PROP_OFFSETX))
 			tex_offset_.x = prop->intValue();
 		else if (prop->nameIsCI(PROP_OFFSETY))
@@ -160,6 +160,14 @@ void MapSide::changeLight(int amount)
 // Sets the upper texture to [tex]
 // -----------------------------------------------------------------------------
 void MapSide::setTexUpper(string_view tex, bool modify)
+{
+	setTexUpper(TextureName{ tex }, modify);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the upper texture to [tex] (interned)
+// -----------------------------------------------------------------------------
+void MapSide::setTexUpper(const TextureName& tex, bool modify)
 {
 	if (modify)
 		setModified();
@@ -177,6 +185,14 @@ void MapSide::setTexUpper(string_view tex, bool modify)
 // Sets the middle texture to [tex]
 // -----------------------------------------------------------------------------
 void MapSide::setTexMiddle(string_view tex, bool modify)
+{
+	setTexMiddle(TextureName{ tex }, modify);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the middle texture to [tex] (interned)
+// -----------------------------------------------------------------------------
+void MapSide::setTexMiddle(const TextureName& tex, bool modify)
 {
 	if (modify)
 		setModified();
@@ -194,6 +210,14 @@ void MapSide::setTexMiddle(string_view tex, bool modify)
 // Sets the lower texture to [tex]
 // -----------------------------------------------------------------------------
 void MapSide::setTexLower(string_view tex, bool modify)
+{
+	setTexLower(TextureName{ tex }, modify);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the lower texture to [tex] (interned)
+// -----------------------------------------------------------------------------
+void MapSide::setTexLower(const TextureName& tex, bool modify)
 {
 	if (modify)
 		setModified();
@@ -289,11 +313,11 @@ void MapSide::setIntProperty(string_view key, int value)
 string MapSide::stringProperty(string_view key)
 {
 	if (key == PROP_TEXUPPER)
-		return tex_upper_;
+		return tex_upper_.str();
 	else if (key == PROP_TEXMIDDLE)
-		return tex_middle_;
+		return tex_middle_.str();
 	else if (key == PROP_TEXLOWER)
-		return tex_lower_;
+		return tex_lower_.str();
 	else
 		return MapObject::stringProperty(key);
 }
@@ -336,9 +360,9 @@ void MapSide::writeBackup(Backup* backup)
 		backup->props_internal[PROP_SECTOR] = 0;
 
 	// Textures
-	backup->props_internal[PROP_TEXUPPER]  = tex_upper_;
-	backup->props_internal[PROP_TEXMIDDLE] = tex_middle_;
-	backup->props_internal[PROP_TEXLOWER]  = tex_lower_;
+	backup->props_internal[PROP_TEXUPPER]  = tex_upper_.str();
+	backup->props_internal[PROP_TEXMIDDLE] = tex_middle_.str();
+	backup->props_internal[PROP_TEXLOWER]  = tex_lower_.str();
 
 	// Offsets
 	backup->props_internal[PROP_OFFSETX] = tex_offset_.x;
@@ -384,12 +408,12 @@ void MapSide::writeUDMF(string& def)
 
 	// Basic properties
 	def += fmt::format("sector={};\n", sector_->index());
-	if (tex_upper_ != "-")
-		def += fmt::format("texturetop=\"{}\";\n", tex_upper_);
-	if (tex_middle_ != "-")
-		def += fmt::format("texturemiddle=\"{}\";\n", tex_middle_);
-	if (tex_lower_ != "-")
-		def += fmt::format("texturebottom=\"{}\";\n", tex_lower_);
+	if (tex_upper_ != TEX_NONE_NAME)
+		def += fmt::format("texturetop=\"{}\";\n", tex_upper_.str());
+	if (tex_middle_ != TEX_NONE_NAME)
+		def += fmt::format("texturemiddle=\"{}\";\n", tex_middle_.str());
+	if (tex_lower_ != TEX_NONE_NAME)
+		def += fmt::format("texturebottom=\"{}\";\n", tex_lower_.str());
 	if (tex_offset_.x != 0)
 		def += fmt::format("offsetx={};\n", tex_offset_.x);
 	if (tex_offset_.y != 0)
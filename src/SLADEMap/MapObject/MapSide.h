@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapObject.h"
+#include "SLADEMap/TextureName.h"
 
 namespace slade
 {
@@ -11,7 +12,8 @@ class MapSide : public MapObject
 	friend class SideList;
 
 public:
-	inline static const string TEX_NONE = "-";
+	inline static const string      TEX_NONE = "-";
+	inline static const TextureName TEX_NONE_NAME{ "-" };
 
 	// UDMF property names
 	inline static const string PROP_SECTOR    = "sector";
@@ -30,25 +32,35 @@ public:
 	MapSide(MapSector* sector, ParseTreeNode* udmf_def);
 	~MapSide() = default;
 
+	// Map objects are allocated from their map's arena (see MapObjectArena)
+	static void* operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void  operator delete(void* ptr) { MapObjectArena::release(ptr); }
+
 	void copy(MapObject* c) override;
 
 	bool isOk() const { return !!sector_; }
 
 	MapSector*    sector() const { return sector_; }
 	MapLine*      parentLine() const { return parent_; }
-	const string& texUpper() const { return tex_upper_; }
-	const string& texMiddle() const { return tex_middle_; }
-	const string& texLower() const { return tex_lower_; }
-	short         texOffsetX() const { return tex_offset_.x; }
-	short         texOffsetY() const { return tex_offset_.y; }
-	Vec2i         texOffset() const { return tex_offset_; }
-	uint8_t       light();
+	const string&      texUpper() const { return tex_upper_.str(); }
+	const string&      texMiddle() const { return tex_middle_.str(); }
+	const string&      texLower() const { return tex_lower_.str(); }
+	const TextureName& texUpperName() const { return tex_upper_; }
+	const TextureName& texMiddleName() const { return tex_middle_; }
+	const TextureName& texLowerName() const { return tex_lower_; }
+	short              texOffsetX() const { return tex_offset_.x; }
+	short              texOffsetY() const { return tex_offset_.y; }
+	Vec2i              texOffset() const { return tex_offset_; }
+	uint8_t            light();
 
 	void setSector(MapSector* sector);
 	void changeLight(int amount);
 	void setTexUpper(string_view tex, bool modify = true);
 	void setTexMiddle(string_view tex, bool modify = true);
 	void setTexLower(string_view tex, bool modify = true);
+	void setTexUpper(const TextureName& tex, bool modify = true);
+	void setTexMiddle(const TextureName& tex, bool modify = true);
+	void setTexLower(const TextureName& tex, bool modify = true);
 	void setTexOffsetX(int offset);
 	void setTexOffsetY(int offset);
 
@@ -65,11 +77,11 @@ public:
 
 private:
 	// Basic data
-	MapSector* sector_     = nullptr;
-	MapLine*   parent_     = nullptr;
-	string     tex_upper_  = "-";
-	string     tex_middle_ = "-";
-	string     tex_lower_  = "-";
-	Vec2i      tex_offset_ = { 0, 0 };
+	MapSector*  sector_     = nullptr;
+	MapLine*    parent_     = nullptr;
+	TextureName tex_upper_  = TEX_NONE_NAME;
+	TextureName tex_middle_ = TEX_NONE_NAME;
+	TextureName tex_lower_  = TEX_NONE_NAME;
+	Vec2i       tex_offset_ = { 0, 0 };
 };
 } // namespace slade
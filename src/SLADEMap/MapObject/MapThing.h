@@ -35,6 +35,10 @@ public:
 	MapThing(const Vec3d& pos, short type, ParseTreeNode* def);
 	~MapThing() = default;
 
+	// Map objects are allocated from their map's arena (see MapObjectArena)
+	static void* operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void  operator delete(void* ptr) { MapObjectArena::release(ptr); }
+
 	double        xPos() const { return position_.x; }
 	double        yPos() const { return position_.y; }
 	double        zPos() const { return z_; }
@@ -19,6 +19,10 @@ public:
 	MapVertex(const Vec2d& pos, ParseTreeNode* udmf_def);
 	~MapVertex() = default;
 
+	// Map objects are allocated from their map's arena (see MapObjectArena)
+	static void* operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void  operator delete(void* ptr) { MapObjectArena::release(ptr); }
+
 	double xPos() const { return position_.x; }
 	double yPos() const { return position_.y; }
 	Vec2d  position() const { return position_; }
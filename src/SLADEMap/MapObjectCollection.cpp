@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapObjectCollection.h"
+#include "App.h"
 #include "Game/Configuration.h"
 #include "MapObject/MapLine.h"
 #include "MapObject/MapSector.h"
@@ -56,7 +57,13 @@ void MapObjectCollection::addMapObject(unique_ptr<MapObject> object)
 {
 	object->obj_id_     = objects_.size();
 	object->parent_map_ = parent_map_;
+	auto obj            = object.get();
 	objects_.emplace_back(std::move(object), true);
+
+	// Newly added objects count as modified
+	obj->modified_time_ = app::runTimer();
+	objectModified(obj);
+	list_gen_[static_cast<int>(obj->objType())] = generation_;
 }
 
 // -----------------------------------------------------------------------------
@@ -66,6 +73,10 @@ void MapObjectCollection::addMapObject(unique_ptr<MapObject> object)
 void MapObjectCollection::removeMapObject(MapObject* object)
 {
 	objects_[object->obj_id_].in_map = false;
+	list_gen_[static_cast<int>(object->objType())] = ++generation_;
+
+	if (parent_map_)
+		parent_map_->topology().objectRemoved(object);
 }
 
 // -----------------------------------------------------------------------------
@@ -106,6 +117,8 @@ void MapObjectCollection::putObjectIdList(MapObject::Type type, vector<unsigned>
 // -----------------------------------------------------------------------------
 void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsigned>& list)
 {
+	list_gen_[static_cast<int>(type)] = ++generation_;
+
 	if (type == MapObject::Type::Vertex)
 	{
 		// Clear
@@ -188,6 +201,10 @@ void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsig
 // -----------------------------------------------------------------------------
 void MapObjectCollection::refreshIndices()
 {
+	++generation_;
+	for (auto& gen : list_gen_)
+		gen = generation_;
+
 	// Vertex indices
 	for (unsigned a = 0; a < vertices_.size(); a++)
 		vertices_[a]->index_ = a;
@@ -221,8 +238,13 @@ void MapObjectCollection::clear()
 	sectors_.clear();
 	things_.clear();
 
-	// Clear map objects
+	// Clear map objects, and release the memory they were allocated from
 	objects_.clear();
+	modified_log_.clear();
+	arena_.clear();
+	++generation_;
+	for (auto& gen : list_gen_)
+		gen = generation_;
 
 	// Object id 0 is always null
 	objects_.emplace_back(nullptr, false);
@@ -478,6 +500,26 @@ bool MapObjectCollection::removeThing(unsigned index)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Reserves space for [count] more objects of [type], to avoid reallocations
+// when adding many objects at once (eg. when reading a map)
+// -----------------------------------------------------------------------------
+void MapObjectCollection::reserve(MapObject::Type type, unsigned count)
+{
+	objects_.reserve(objects_.size() + count);
+	modified_log_.reserve(modified_log_.size() + count);
+
+	switch (type)
+	{
+	case MapObject::Type::Vertex: vertices_.reserve(vertices_.size() + count); break;
+	case MapObject::Type::Line: lines_.reserve(lines_.size() + count); break;
+	case MapObject::Type::Side: sides_.reserve(sides_.size() + count); break;
+	case MapObject::Type::Sector: sectors_.reserve(sectors_.size() + count); break;
+	case MapObject::Type::Thing: things_.reserve(things_.size() + count); break;
+	default: break;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Adds [vertex] to the map
 // -----------------------------------------------------------------------------
@@ -541,7 +583,8 @@ MapSide* MapObjectCollection::duplicateSide(MapSide* side)
 	if (!side)
 		return nullptr;
 
-	auto ns = std::make_unique<MapSide>(side->sector());
+	MapObjectArena::Scope scope(arena_);
+	auto                  ns = std::make_unique<MapSide>(side->sector());
 	ns->copy(side);
 	addSide(std::move(ns));
 	return sides_.back();
@@ -555,16 +598,9 @@ vector<MapObject*> MapObjectCollection::modifiedObjects(long since, MapObject::T
 {
 	vector<MapObject*> modified_objects;
 
-	if (type == MapObject::Type::Object || type == MapObject::Type::Vertex)
-		vertices_.putModifiedObjects(since, modified_objects);
-	if (type == MapObject::Type::Object || type == MapObject::Type::Side)
-		sides_.putModifiedObjects(since, modified_objects);
-	if (type == MapObject::Type::Object || type == MapObject::Type::Line)
-		lines_.putModifiedObjects(since, modified_objects);
-	if (type == MapObject::Type::Object || type == MapObject::Type::Sector)
-		sectors_.putModifiedObjects(since, modified_objects);
-	if (type == MapObject::Type::Object || type == MapObject::Type::Thing)
-		things_.putModifiedObjects(since, modified_objects);
+	for (auto i = firstModifiedAt(since); i != modified_log_.end(); ++i)
+		if (isLive(*i) && matchesType(*i, type))
+			modified_objects.push_back(objects_[i->obj_id].object.get());
 
 	return modified_objects;
 }
@@ -576,11 +612,9 @@ vector<MapObject*> MapObjectCollection::allModifiedObjects(long since) const
 {
 	vector<MapObject*> modified_objects;
 
-	for (auto& holder : objects_)
-	{
-		if (holder.object && holder.object->modified_time_ >= since)
-			modified_objects.push_back(holder.object.get());
-	}
+	for (auto i = firstModifiedAt(since); i != modified_log_.end(); ++i)
+		if (isLive(*i))
+			modified_objects.push_back(objects_[i->obj_id].object.get());
 
 	return modified_objects;
 }
@@ -590,15 +624,8 @@ vector<MapObject*> MapObjectCollection::allModifiedObjects(long since) const
 // -----------------------------------------------------------------------------
 long MapObjectCollection::lastModifiedTime() const
 {
-	long mod_time = 0;
-
-	for (auto& holder : objects_)
-	{
-		if (holder.object && holder.object->modified_time_ > mod_time)
-			mod_time = holder.object->modified_time_;
-	}
-
-	return mod_time;
+	// The last entry in the log is always the most recently modified object
+	return modified_log_.empty() ? 0 : modified_log_.back().time;
 }
 
 // -----------------------------------------------------------------------------
@@ -606,16 +633,76 @@ long MapObjectCollection::lastModifiedTime() const
 // -----------------------------------------------------------------------------
 bool MapObjectCollection::modifiedSince(long since, MapObject::Type type) const
 {
-	switch (type)
-	{
-	case MapObject::Type::Object: return lastModifiedTime() > since;
-	case MapObject::Type::Vertex: return vertices_.modifiedSince(since);
-	case MapObject::Type::Line: return lines_.modifiedSince(since);
-	case MapObject::Type::Side: return sides_.modifiedSince(since);
-	case MapObject::Type::Sector: return sectors_.modifiedSince(since);
-	case MapObject::Type::Thing: return things_.modifiedSince(since);
-	default: return false;
-	}
+	if (type == MapObject::Type::Object)
+		return lastModifiedTime() > since;
+
+	for (auto i = firstModifiedAt(since + 1); i != modified_log_.end(); ++i)
+		if (isLive(*i) && matchesType(*i, type))
+			return true;
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Records [object] as modified, giving it the next modified generation.
+// Called from MapObject::setModified, so this only costs a single log entry
+// per modification
+// -----------------------------------------------------------------------------
+void MapObjectCollection::objectModified(MapObject* object)
+{
+	// Ignore objects that don't belong to this collection
+	if (object->obj_id_ >= objects_.size() || objects_[object->obj_id_].object.get() != object)
+		return;
+
+	object->modified_gen_ = ++generation_;
+	modified_log_.push_back({ generation_, object->modified_time_, object->obj_id_ });
+
+	// Clean out stale entries once they start to outnumber the objects
+	if (modified_log_.size() > objects_.size() * 2 + 64)
+		compactModifiedLog();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a list of objects of [type] that have been modified after
+// generation [gen] (see generation())
+// -----------------------------------------------------------------------------
+vector<MapObject*> MapObjectCollection::modifiedObjectsSinceGen(unsigned long gen, MapObject::Type type) const
+{
+	vector<MapObject*> modified_objects;
+
+	for (auto i = firstModifiedAfter(gen); i != modified_log_.end(); ++i)
+		if (isLive(*i) && matchesType(*i, type))
+			modified_objects.push_back(objects_[i->obj_id].object.get());
+
+	return modified_objects;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a list of all objects (including those no longer in the map) that
+// have been modified after generation [gen]
+// -----------------------------------------------------------------------------
+vector<MapObject*> MapObjectCollection::allModifiedObjectsSinceGen(unsigned long gen) const
+{
+	vector<MapObject*> modified_objects;
+
+	for (auto i = firstModifiedAfter(gen); i != modified_log_.end(); ++i)
+		if (isLive(*i))
+			modified_objects.push_back(objects_[i->obj_id].object.get());
+
+	return modified_objects;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if any objects of [type] have been modified after generation
+// [gen]
+// -----------------------------------------------------------------------------
+bool MapObjectCollection::modifiedSinceGen(unsigned long gen, MapObject::Type type) const
+{
+	for (auto i = firstModifiedAfter(gen); i != modified_log_.end(); ++i)
+		if (isLive(*i) && matchesType(*i, type))
+			return true;
+
+	return false;
 }
 
 // -----------------------------------------------------------------------------
@@ -753,3 +840,62 @@ void MapObjectCollection::rebuildConnectedSides()
 			side->sector()->connectSide(side);
 	}
 }
+
+// -----------------------------------------------------------------------------
+// Returns true if [entry] is the most recent modified log entry for its object
+// -----------------------------------------------------------------------------
+bool MapObjectCollection::isLive(const ModifiedEntry& entry) const
+{
+	auto& object = objects_[entry.obj_id].object;
+	return object && object->modified_gen_ == entry.gen;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the object for [entry] is in the map and is of [type]
+// (any type if [type] is MapObject::Type::Object)
+// -----------------------------------------------------------------------------
+bool MapObjectCollection::matchesType(const ModifiedEntry& entry, MapObject::Type type) const
+{
+	auto& holder = objects_[entry.obj_id];
+	return holder.in_map && (type == MapObject::Type::Object || holder.object->type_ == type);
+}
+
+// -----------------------------------------------------------------------------
+// Removes all stale (superseded) entries from the modified objects log
+// -----------------------------------------------------------------------------
+void MapObjectCollection::compactModifiedLog()
+{
+	modified_log_.erase(
+		std::remove_if(
+			modified_log_.begin(),
+			modified_log_.end(),
+			[this](const ModifiedEntry& entry) { return !isLive(entry); }),
+		modified_log_.end());
+}
+
+// -----------------------------------------------------------------------------
+// Returns an iterator to the first modified log entry with a generation later
+// than [gen]
+// -----------------------------------------------------------------------------
+vector<MapObjectCollection::ModifiedEntry>::const_iterator MapObjectCollection::firstModifiedAfter(
+	unsigned long gen) const
+{
+	return std::upper_bound(
+		modified_log_.begin(),
+		modified_log_.end(),
+		gen,
+		[](unsigned long g, const ModifiedEntry& entry) { return g < entry.gen; });
+}
+
+// -----------------------------------------------------------------------------
+// Returns an iterator to the first modified log entry with a modified time at
+// or later than [time]
+// -----------------------------------------------------------------------------
+vector<MapObjectCollection::ModifiedEntry>::const_iterator MapObjectCollection::firstModifiedAt(long time) const
+{
+	return std::lower_bound(
+		modified_log_.begin(),
+		modified_log_.end(),
+		time,
+		[](const ModifiedEntry& entry, long t) { return entry.time < t; });
+}
@@ -15,6 +15,7 @@ public:
 	MapObjectCollection(SLADEMap* parent_map = nullptr);
 
 	SLADEMap*         parentMap() const { return parent_map_; }
+	MapObjectArena&   arena() { return arena_; }
 	VertexList&       vertices() { return vertices_; }
 	SideList&         sides() { return sides_; }
 	LineList&         lines() { return lines_; }
@@ -39,6 +40,7 @@ public:
 	void clear();
 
 	// Object add
+	void       reserve(MapObject::Type type, unsigned count);
 	MapVertex* addVertex(unique_ptr<MapVertex> vertex);
 	MapSide*   addSide(unique_ptr<MapSide> side);
 	MapLine*   addLine(unique_ptr<MapLine> line);
@@ -66,6 +68,14 @@ public:
 	long               lastModifiedTime() const;
 	bool               modifiedSince(long since, MapObject::Type type) const;
 
+	// Modified generations (dirty set)
+	unsigned long      generation() const { return generation_; }
+	void               objectModified(MapObject* object);
+	vector<MapObject*> modifiedObjectsSinceGen(unsigned long gen, MapObject::Type type) const;
+	vector<MapObject*> allModifiedObjectsSinceGen(unsigned long gen) const;
+	bool               modifiedSinceGen(unsigned long gen, MapObject::Type type) const;
+	unsigned long      listGeneration(MapObject::Type type) const { return list_gen_[static_cast<int>(type)]; }
+
 	// Checks
 	int removeDetachedVertices();
 	int removeDetachedSides();
@@ -86,12 +96,32 @@ private:
 		MapObjectHolder(unique_ptr<MapObject> object, bool in_map) : object{ std::move(object) }, in_map{ in_map } {}
 	};
 
+	// A single entry in the modified objects log, an object is only 'live' in
+	// the log at the entry matching its current modified generation
+	struct ModifiedEntry
+	{
+		unsigned long gen;
+		long          time;
+		unsigned      obj_id;
+	};
+
 	SLADEMap*               parent_map_ = nullptr;
+	MapObjectArena          arena_; // Must outlive objects_
 	vector<MapObjectHolder> objects_;
+	vector<ModifiedEntry>   modified_log_;
+	unsigned long           generation_  = 0;
+	unsigned long           list_gen_[6] = {}; // Generation each object list was last added to/removed from
 	VertexList              vertices_;
 	SideList                sides_;
 	LineList                lines_;
 	SectorList              sectors_;
 	ThingList               things_;
+
+	bool isLive(const ModifiedEntry& entry) const;
+	bool matchesType(const ModifiedEntry& entry, MapObject::Type type) const;
+	void compactModifiedLog();
+
+	vector<ModifiedEntry>::const_iterator firstModifiedAfter(unsigned long gen) const;
+	vector<ModifiedEntry>::const_iterator firstModifiedAt(long time) const;
 };
 } // namespace slade
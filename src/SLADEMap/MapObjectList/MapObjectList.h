@@ -56,22 +56,7 @@ public:
 		objects_.pop_back();
 		--count_;
 	}
-
-	// Misc
-	void putModifiedObjects(long since, vector<MapObject*>& modified_objects) const
-	{
-		for (const auto& object : objects_)
-			if (object->modifiedTime() >= since)
-				modified_objects.push_back(object);
-	}
-	bool modifiedSince(long since) const
-	{
-		for (const auto& object : objects_)
-			if (object->modifiedTime() > since)
-				return true;
-
-		return false;
-	}
+	void reserve(unsigned count) { objects_.reserve(count); }
 
 protected:
 	vector<T*> objects_;
@@ -34,7 +34,8 @@
 #include "Main.h"
 #include "SectorList.h"
 #include "General/UI.h"
-#include "Utility/StringUtils.h"
+#include <atomic>
+#include <thread>
 
 using namespace slade;
 
@@ -61,8 +62,8 @@ void SectorList::clear()
 void SectorList::add(MapSector* sector)
 {
 	// Update texture counts
-	usage_tex_[strutil::upper(sector->floor().texture)] += 1;
-	usage_tex_[strutil::upper(sector->ceiling().texture)] += 1;
+	usage_tex_[sector->floor().texture.key()] += 1;
+	usage_tex_[sector->ceiling().texture.key()] += 1;
 
 	MapObjectList::add(sector);
 }
@@ -76,8 +77,8 @@ void SectorList::remove(unsigned index)
 		return;
 
 	// Update texture counts
-	usage_tex_[strutil::upper(objects_[index]->floor().texture)] -= 1;
-	usage_tex_[strutil::upper(objects_[index]->ceiling().texture)] -= 1;
+	usage_tex_[objects_[index]->floor().texture.key()] -= 1;
+	usage_tex_[objects_[index]->ceiling().texture.key()] -= 1;
 
 	MapObjectList::remove(index);
 }
@@ -130,17 +131,42 @@ BBox SectorList::allSectorBounds() const
 }
 
 // -----------------------------------------------------------------------------
-// Forces building of polygons for all sectors in the list
+// Forces building of polygons for all sectors in the list.
+// Sector triangulation only reads map geometry and writes to the sector's own
+// polygon, so sectors are split between a number of worker threads
 // -----------------------------------------------------------------------------
 void SectorList::initPolygons()
 {
 	ui::setSplashProgressMessage("Building sector polygons");
 	ui::setSplashProgress(0.0f);
-	for (unsigned i = 0; i < count_; ++i)
-	{
-		ui::setSplashProgress((float)i / (float)count_);
-		objects_[i]->polygon();
-	}
+
+	// Builds the polygon for the next sector not yet taken by another thread
+	std::atomic<unsigned> next_sector{ 0 };
+
+	auto build_next = [&]() {
+		auto index = next_sector++;
+		if (index >= count_)
+			return false;
+
+		objects_[index]->polygon();
+		return true;
+	};
+
+	// Start worker threads
+	unsigned            n_threads = std::min<unsigned>(std::thread::hardware_concurrency(), count_ / 64);
+	vector<std::thread> threads;
+	for (unsigned a = 1; a < n_threads; a++)
+		threads.emplace_back([&]() {
+			while (build_next()) {}
+		});
+
+	// Build on this thread too, updating progress as we go
+	while (build_next())
+		ui::setSplashProgress(std::min<float>(next_sector, count_) / (float)count_);
+
+	for (auto& thread : threads)
+		thread.join();
+
 	ui::setSplashProgress(1.0f);
 }
 
@@ -149,8 +175,31 @@ void SectorList::initPolygons()
 // -----------------------------------------------------------------------------
 void SectorList::initBBoxes()
 {
-	for (auto& sector : objects_)
-		sector->updateBBox();
+	// Updates the bbox for the next sector not yet taken by another thread
+	std::atomic<unsigned> next_sector{ 0 };
+
+	auto update_next = [&]() {
+		auto index = next_sector++;
+		if (index >= count_)
+			return false;
+
+		objects_[index]->updateBBox();
+		return true;
+	};
+
+	// Start worker threads
+	unsigned            n_threads = std::min<unsigned>(std::thread::hardware_concurrency(), count_ / 256);
+	vector<std::thread> threads;
+	for (unsigned a = 1; a < n_threads; a++)
+		threads.emplace_back([&]() {
+			while (update_next()) {}
+		});
+
+	// Update on this thread too
+	while (update_next()) {}
+
+	for (auto& thread : threads)
+		thread.join();
 }
 
 // -----------------------------------------------------------------------------
@@ -206,9 +255,9 @@ int SectorList::firstFreeId() const
 // -----------------------------------------------------------------------------
 // Adjusts the usage count of [tex] by [adjust]
 // -----------------------------------------------------------------------------
-void SectorList::updateTexUsage(string_view tex, int adjust) const
+void SectorList::updateTexUsage(const TextureName& tex, int adjust) const
 {
-	usage_tex_[strutil::upper(tex)] += adjust;
+	usage_tex_[tex.key()] += adjust;
 }
 
 // -----------------------------------------------------------------------------
@@ -216,5 +265,10 @@ void SectorList::updateTexUsage(string_view tex, int adjust) const
 // -----------------------------------------------------------------------------
 int SectorList::texUsageCount(string_view tex) const
 {
-	return usage_tex_[strutil::upper(tex)];
+	auto key = TextureName::findKey(tex);
+	if (!key)
+		return 0;
+
+	auto usage = usage_tex_.find(*key);
+	return usage != usage_tex_.end() ? usage->second : 0;
 }
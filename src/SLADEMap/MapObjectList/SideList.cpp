@@ -33,7 +33,6 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "SideList.h"
-#include "Utility/StringUtils.h"
 
 using namespace slade;
 
@@ -60,9 +59,9 @@ void SideList::clear()
 void SideList::add(MapSide* side)
 {
 	// Update texture counts
-	usage_tex_[strutil::upper(side->tex_upper_)] += 1;
-	usage_tex_[strutil::upper(side->tex_middle_)] += 1;
-	usage_tex_[strutil::upper(side->tex_lower_)] += 1;
+	usage_tex_[side->tex_upper_.key()] += 1;
+	usage_tex_[side->tex_middle_.key()] += 1;
+	usage_tex_[side->tex_lower_.key()] += 1;
 
 	MapObjectList::add(side);
 }
@@ -76,9 +75,9 @@ void SideList::remove(unsigned index)
 		return;
 
 	// Update texture counts
-	usage_tex_[strutil::upper(objects_[index]->tex_upper_)] -= 1;
-	usage_tex_[strutil::upper(objects_[index]->tex_middle_)] -= 1;
-	usage_tex_[strutil::upper(objects_[index]->tex_lower_)] -= 1;
+	usage_tex_[objects_[index]->tex_upper_.key()] -= 1;
+	usage_tex_[objects_[index]->tex_middle_.key()] -= 1;
+	usage_tex_[objects_[index]->tex_lower_.key()] -= 1;
 
 	MapObjectList::remove(index);
 }
@@ -86,9 +85,9 @@ void SideList::remove(unsigned index)
 // -----------------------------------------------------------------------------
 // Adjusts the usage count of [tex] by [adjust]
 // -----------------------------------------------------------------------------
-void SideList::updateTexUsage(string_view tex, int adjust) const
+void SideList::updateTexUsage(const TextureName& tex, int adjust) const
 {
-	usage_tex_[strutil::upper(tex)] += adjust;
+	usage_tex_[tex.key()] += adjust;
 }
 
 // -----------------------------------------------------------------------------
@@ -96,5 +95,10 @@ void SideList::updateTexUsage(string_view tex, int adjust) const
 // -----------------------------------------------------------------------------
 int SideList::texUsageCount(string_view tex) const
 {
-	return usage_tex_[strutil::upper(tex)];
+	auto key = TextureName::findKey(tex);
+	if (!key)
+		return 0;
+
+	auto usage = usage_tex_.find(*key);
+	return usage != usage_tex_.end() ? usage->second : 0;
 }
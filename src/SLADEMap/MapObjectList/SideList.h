@@ -2,6 +2,7 @@
 
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapSide.h"
+#include <unordered_map>
 
 namespace slade
 {
@@ -14,10 +15,10 @@ public:
 	void remove(unsigned index) override;
 
 	void clearTexUsage() const { usage_tex_.clear(); }
-	void updateTexUsage(string_view tex, int adjust) const;
+	void updateTexUsage(const TextureName& tex, int adjust) const;
 	int  texUsageCount(string_view tex) const;
 
 private:
-	mutable std::map<string, int> usage_tex_;
+	mutable std::unordered_map<unsigned, int> usage_tex_; // Keyed by TextureName key
 };
 } // namespace slade
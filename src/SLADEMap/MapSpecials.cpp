@@ -52,6 +52,40 @@ const double TAU = math::PI * 2; // Number of radians in the unit circle
 } // namespace
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if [type] is a thing type that affects slopes
+// -----------------------------------------------------------------------------
+bool isSlopeThing(int type)
+{
+	return (type >= 9500 && type <= 9503) || type == 9510 || type == 9511 || (type >= 1500 && type <= 1501)
+		   || type == 1504 || type == 1505;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [line], [thing] or [sector] is currently part of [map]
+// -----------------------------------------------------------------------------
+bool inMap(SLADEMap* map, MapLine* line)
+{
+	return map->line(line->index()) == line;
+}
+bool inMap(SLADEMap* map, MapThing* thing)
+{
+	return map->thing(thing->index()) == thing;
+}
+bool inMap(SLADEMap* map, MapSector* sector)
+{
+	return map->sector(sector->index()) == sector;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapSpecials Class Functions
@@ -66,19 +100,97 @@ void MapSpecials::reset()
 {
 	sector_colours_.clear();
 	sector_fadecolours_.clear();
+	sources_valid_ = false;
 }
 
 // -----------------------------------------------------------------------------
 // Process map specials, depending on the current game/port
 // -----------------------------------------------------------------------------
-void MapSpecials::processMapSpecials(SLADEMap* map) const
+void MapSpecials::processMapSpecials(SLADEMap* map)
 {
 	// ZDoom
 	if (game::configuration().currentPort() == "zdoom")
 		processZDoomMapSpecials(map);
 	// Eternity, currently no need for processEternityMapSpecials
 	else if (game::configuration().currentPort() == "eternity")
+	{
+		updateSlopeSources(map);
 		processEternitySlopes(map);
+	}
+
+	sources_gen_ = map->mapData().generation();
+}
+
+// -----------------------------------------------------------------------------
+// Re-processes map specials affected by any changes to the map since they were
+// last processed. Only sectors that have been modified, and any sectors linked
+// to them via slope specials, have their planes recalculated. If any slope
+// sources have changed, all specials are processed again
+// -----------------------------------------------------------------------------
+void MapSpecials::updateMapSpecials(SLADEMap* map)
+{
+	auto& port = game::configuration().currentPort();
+	if (port != "zdoom" && port != "eternity")
+		return;
+
+	if (!sources_valid_ || slopeSourcesChanged(map))
+	{
+		processMapSpecials(map);
+		return;
+	}
+
+	// Get sectors affected by changes
+	SectorSet sectors;
+	auto&     data = map->mapData();
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Sector))
+		sectors.insert(dynamic_cast<MapSector*>(object));
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Side))
+		if (auto sector = dynamic_cast<MapSide*>(object)->sector())
+			sectors.insert(sector);
+	vector<MapLine*> lines;
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Line))
+		lines.push_back(dynamic_cast<MapLine*>(object));
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Vertex))
+		for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+			lines.push_back(line);
+	for (auto line : lines)
+	{
+		if (line->frontSector())
+			sectors.insert(line->frontSector());
+		if (line->backSector())
+			sectors.insert(line->backSector());
+	}
+
+	// Add any sectors linked to them by slope specials
+	for (auto sector : SectorSet{ sectors })
+	{
+		auto group = sector_groups_.find(sector);
+		if (group != sector_groups_.end())
+			sectors.insert(groups_[group->second].begin(), groups_[group->second].end());
+	}
+
+	// Ignore any that have been removed from the map
+	for (auto i = sectors.begin(); i != sectors.end();)
+	{
+		if (inMap(map, *i))
+			++i;
+		else
+			i = sectors.erase(i);
+	}
+
+	// Process
+	if (port == "zdoom")
+	{
+		for (auto line : lines)
+			if (inMap(map, line))
+				processZDoomLineSpecial(line);
+		if (!sectors.empty())
+			processZDoomSlopes(map, &sectors);
+	}
+	else if (!sectors.empty())
+		processEternitySlopes(map, &sectors);
+
+	sources_gen_ = data.generation();
 }
 
 // -----------------------------------------------------------------------------
@@ -180,13 +292,14 @@ void MapSpecials::updateTaggedSectors(SLADEMap* map)
 // Process ZDoom map specials, mostly to convert hexen specials to UDMF
 // counterparts
 // -----------------------------------------------------------------------------
-void MapSpecials::processZDoomMapSpecials(SLADEMap* map) const
+void MapSpecials::processZDoomMapSpecials(SLADEMap* map)
 {
 	// Line specials
 	for (unsigned a = 0; a < map->nLines(); a++)
 		processZDoomLineSpecial(map->line(a));
 
 	// All slope specials, which must be done in a particular order
+	updateSlopeSources(map);
 	processZDoomSlopes(map);
 }
 
@@ -357,102 +470,338 @@ void MapSpecials::processACSScripts(ArchiveEntry* entry)
 }
 
 // -----------------------------------------------------------------------------
-// Process ZDoom slope specials
+// Rebuilds the lists of slope sources (lines and things with slope specials)
+// in [map], and groups together sectors that are linked by them
 // -----------------------------------------------------------------------------
-void MapSpecials::processZDoomSlopes(SLADEMap* map) const
+void MapSpecials::updateSlopeSources(SLADEMap* map)
 {
-	// ZDoom has a variety of slope mechanisms, which must be evaluated in a
-	// specific order.
-	//  - UDMF plane properties
-	//  - Plane_Align, in line order
-	//  - line slope + sector tilt + vavoom, in thing order
-	//  - slope copy things, in thing order
-	//  - overwrite vertex heights with vertex height things
-	//  - vertex triangle slopes, in sector order
-	//  - Plane_Copy, in line order
-
-	// First things first: reset every sector to flat planes
-	for (unsigned a = 0; a < map->nSectors(); a++)
-	{
-		auto target = map->sector(a);
-		target->setPlane<SurfaceType::Floor>(Plane::flat(target->planeHeight<SurfaceType::Floor>()));
-		target->setPlane<SurfaceType::Ceiling>(Plane::flat(target->planeHeight<SurfaceType::Ceiling>()));
-	}
-
-	// Floor/ceiling plane properties
-	for (unsigned a = 0; a < map->nSectors(); a++)
+	plane_align_lines_.clear();
+	plane_copy_lines_.clear();
+	slope_things_.clear();
+	copy_things_.clear();
+	vertex_height_things_.clear();
+	source_lines_.clear();
+	source_things_.clear();
+	thing_sectors_.clear();
+	tagged_sectors_.clear();
+	source_tags_.clear();
+	source_line_ids_.clear();
+	vavoom_tids_.clear();
+	vertex_floor_heights_.clear();
+	vertex_ceiling_heights_.clear();
+	sector_groups_.clear();
+	groups_.clear();
+
+	// Sectors linked by slope sources are joined into groups (union-find)
+	std::map<MapSector*, MapSector*> parents;
+
+	auto find = [&](MapSector* sector) {
+		auto parent = parents.emplace(sector, sector).first;
+		while (parent->second != parent->first)
+			parent = parents.find(parent->second);
+		return parent->second;
+	};
+	auto join = [&](MapSector* sector1, MapSector* sector2) {
+		if (!sector1 || !sector2)
+			return;
+		parents[find(sector1)] = find(sector2);
+	};
+	auto tagged = [&](int tag) {
+		auto sector = map->sectors().firstWithId(tag);
+		source_tags_.insert(tag);
+		if (sector)
+			tagged_sectors_[sector] = tag;
+		return sector;
+	};
+
+	// Plane_Align (181) and Plane_Copy (118) lines
+	for (unsigned a = 0; a < map->nLines(); a++)
 	{
-		auto target        = map->sector(a);
-		auto floorplane    = Plane::flat(target->floor().height);
-		bool hasFloorplane = false;
-		// Check for floor plane.
-		// Note that these properties will only work in GZDoom if all of them are present.
-		// Set A, B, and C negative to compensate for the calculation
-		// differences between SLADE and GZDoom.
-		if (target->hasProp("floorplane_a"))
-		{
-			floorplane.a  = -target->floatProperty("floorplane_a");
-			hasFloorplane = true;
-		}
-		if (target->hasProp("floorplane_b"))
-		{
-			floorplane.b  = -target->floatProperty("floorplane_b");
-			hasFloorplane = true;
-		}
-		if (target->hasProp("floorplane_c"))
-		{
-			floorplane.c  = -target->floatProperty("floorplane_c");
-			hasFloorplane = true;
-		}
-		if (target->hasProp("floorplane_d"))
+		auto line = map->line(a);
+		if (line->special() == 181)
 		{
-			floorplane.d  = target->floatProperty("floorplane_d");
-			hasFloorplane = true;
+			plane_align_lines_.push_back(line);
+			join(line->frontSector(), line->backSector());
 		}
-		if (hasFloorplane && !(floorplane.a == 0 && floorplane.b == 0 && floorplane.c == -1 && floorplane.d == 0))
+		else if (line->special() == 118)
 		{
-			target->setFloorPlane(floorplane);
+			plane_copy_lines_.push_back(line);
+			join(line->frontSector(), line->backSector());
+			for (unsigned arg = 0; arg < 4; arg++)
+				if (line->arg(arg))
+					join(line->frontSector(), tagged(line->arg(arg)));
 		}
+		else
+			continue;
 
-		// Check for ceiling plane
-		auto ceilingplane    = Plane::flat(target->ceiling().height);
-		bool hasCeilingplane = false;
-		if (target->hasProp("ceilingplane_a"))
-		{
-			ceilingplane.a  = -target->floatProperty("ceilingplane_a");
-			hasCeilingplane = true;
-		}
-		if (target->hasProp("ceilingplane_b"))
+		source_lines_.insert(line);
+	}
+
+	// Slope things
+	for (unsigned a = 0; a < map->nThings(); a++)
+	{
+		auto thing = map->thing(a);
+		int  type  = thing->type();
+		if (!isSlopeThing(type))
+			continue;
+
+		source_things_.insert(thing);
+
+		// Vertex height things
+		if (type == 1504 || type == 1505)
 		{
-			ceilingplane.b  = -target->floatProperty("ceilingplane_b");
-			hasCeilingplane = true;
+			vertex_height_things_.push_back(thing);
+
+			// TODO there could be more than one vertex at this point
+			auto vertex = map->vertices().vertexAt(thing->xPos(), thing->yPos());
+			if (vertex)
+			{
+				if (type == 1504)
+					vertex_floor_heights_[vertex] = thing->zPos();
+				else
+					vertex_ceiling_heights_[vertex] = thing->zPos();
+			}
+
+			continue;
 		}
-		if (target->hasProp("ceilingplane_c"))
+
+		auto sector           = map->sectors().atPos(thing->position());
+		thing_sectors_[thing] = sector;
+		join(sector, sector);
+
+		// Slope copy things
+		if (type == 9510 || type == 9511)
 		{
-			ceilingplane.c  = -target->floatProperty("ceilingplane_c");
-			hasCeilingplane = true;
+			copy_things_.push_back(thing);
+			if (thing->arg(0))
+				join(sector, tagged(thing->arg(0)));
+			continue;
 		}
-		if (target->hasProp("ceilingplane_d"))
+
+		slope_things_.push_back(thing);
+
+		// Line slope things affect the sectors on either side of lines with
+		// the given id
+		if (type == 9500 || type == 9501)
 		{
-			ceilingplane.d  = target->floatProperty("ceilingplane_d");
-			hasCeilingplane = true;
+			source_line_ids_.insert(thing->arg(0));
+			for (auto& line : map->lines().allWithId(thing->arg(0)))
+			{
+				join(sector, line->frontSector());
+				join(sector, line->backSector());
+				source_lines_.insert(line);
+			}
 		}
-		if (hasCeilingplane
-			&& !(ceilingplane.a == 0 && ceilingplane.b == 0 && ceilingplane.c == -1 && ceilingplane.d == 0))
+
+		// Vavoom things use a line in their sector with first arg matching
+		// the thing id
+		else if (type == 1500 || type == 1501)
 		{
-			target->setCeilingPlane(ceilingplane);
+			vavoom_tids_.insert(thing->id());
+			if (sector)
+				for (auto side : sector->connectedSides())
+					if (side->parentLine()->arg(0) == thing->id())
+						source_lines_.insert(side->parentLine());
 		}
 	}
 
-	// Plane_Align (line special 181)
-	for (unsigned a = 0; a < map->nLines(); a++)
+	// Build sector groups
+	std::map<MapSector*, unsigned> group_index;
+	for (auto& parent : parents)
 	{
-		auto line = map->line(a);
-		if (line->special() != 181)
-			continue;
+		auto root  = find(parent.first);
+		auto index = group_index.emplace(root, groups_.size());
+		if (index.second)
+			groups_.emplace_back();
+
+		groups_[index.first->second].push_back(parent.first);
+		sector_groups_[parent.first] = index.first->second;
+	}
+
+	sources_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if any changes to [map] since specials were last processed
+// could affect the slope sources or how sectors are linked by them
+// -----------------------------------------------------------------------------
+bool MapSpecials::slopeSourcesChanged(SLADEMap* map) const
+{
+	// Check for removed sources
+	for (auto line : source_lines_)
+		if (!inMap(map, line))
+			return true;
+	for (auto thing : source_things_)
+		if (!inMap(map, thing))
+			return true;
+	for (auto& group : sector_groups_)
+		if (!inMap(map, group.first))
+			return true;
+
+	// Check for changed tags of sectors referenced by slope sources
+	for (auto& sector : tagged_sectors_)
+		if (sector.first->tag() != sector.second)
+			return true;
+
+	auto& data = map->mapData();
+
+	// Lines
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Line))
+	{
+		auto line = dynamic_cast<MapLine*>(object);
+		if (line->special() == 181 || line->special() == 118 || source_lines_.count(line) > 0
+			|| source_line_ids_.count(line->id()) > 0 || vavoom_tids_.count(line->arg(0)) > 0)
+			return true;
+
+		// Line geometry changes in linked sectors could change the sectors
+		// containing slope things
+		if (inSlopeGroup(line->frontSector()) || inSlopeGroup(line->backSector()))
+			return true;
+	}
+
+	// Things
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Thing))
+	{
+		auto thing = dynamic_cast<MapThing*>(object);
+		if (isSlopeThing(thing->type()) || source_things_.count(thing) > 0)
+			return true;
+	}
+
+	// Sectors (tag changes)
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Sector))
+	{
+		auto sector = dynamic_cast<MapSector*>(object);
+		if (source_tags_.count(sector->tag()) > 0 && tagged_sectors_.count(sector) == 0)
+			return true;
+	}
+
+	// Vertices (moved onto/off vertex height things, or within linked sectors)
+	for (auto object : data.modifiedObjectsSinceGen(sources_gen_, MapObject::Type::Vertex))
+	{
+		auto vertex = dynamic_cast<MapVertex*>(object);
+		if (vertex_floor_heights_.count(vertex) > 0 || vertex_ceiling_heights_.count(vertex) > 0)
+			return true;
+		for (auto thing : vertex_height_things_)
+			if (thing->xPos() == vertex->xPos() && thing->yPos() == vertex->yPos())
+				return true;
+		for (auto line : vertex->connectedLines())
+			if (inSlopeGroup(line->frontSector()) || inSlopeGroup(line->backSector()))
+				return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Resets [target]'s planes to flat, then applies any UDMF plane properties
+// -----------------------------------------------------------------------------
+void MapSpecials::applyPlaneProperties(MapSector* target) const
+{
+	target->setPlane<SurfaceType::Floor>(Plane::flat(target->planeHeight<SurfaceType::Floor>()));
+	target->setPlane<SurfaceType::Ceiling>(Plane::flat(target->planeHeight<SurfaceType::Ceiling>()));
+
+	auto floorplane    = Plane::flat(target->floor().height);
+	bool hasFloorplane = false;
+	// Check for floor plane.
+	// Note that these properties will only work in GZDoom if all of them are present.
+	// Set A, B, and C negative to compensate for the calculation
+	// differences between SLADE and GZDoom.
+	if (target->hasProp("floorplane_a"))
+	{
+		floorplane.a  = -target->floatProperty("floorplane_a");
+		hasFloorplane = true;
+	}
+	if (target->hasProp("floorplane_b"))
+	{
+		floorplane.b  = -target->floatProperty("floorplane_b");
+		hasFloorplane = true;
+	}
+	if (target->hasProp("floorplane_c"))
+	{
+		floorplane.c  = -target->floatProperty("floorplane_c");
+		hasFloorplane = true;
+	}
+	if (target->hasProp("floorplane_d"))
+	{
+		floorplane.d  = target->floatProperty("floorplane_d");
+		hasFloorplane = true;
+	}
+	if (hasFloorplane && !(floorplane.a == 0 && floorplane.b == 0 && floorplane.c == -1 && floorplane.d == 0))
+	{
+		target->setFloorPlane(floorplane);
+	}
+
+	// Check for ceiling plane
+	auto ceilingplane    = Plane::flat(target->ceiling().height);
+	bool hasCeilingplane = false;
+	if (target->hasProp("ceilingplane_a"))
+	{
+		ceilingplane.a  = -target->floatProperty("ceilingplane_a");
+		hasCeilingplane = true;
+	}
+	if (target->hasProp("ceilingplane_b"))
+	{
+		ceilingplane.b  = -target->floatProperty("ceilingplane_b");
+		hasCeilingplane = true;
+	}
+	if (target->hasProp("ceilingplane_c"))
+	{
+		ceilingplane.c  = -target->floatProperty("ceilingplane_c");
+		hasCeilingplane = true;
+	}
+	if (target->hasProp("ceilingplane_d"))
+	{
+		ceilingplane.d  = target->floatProperty("ceilingplane_d");
+		hasCeilingplane = true;
+	}
+	if (hasCeilingplane
+		&& !(ceilingplane.a == 0 && ceilingplane.b == 0 && ceilingplane.c == -1 && ceilingplane.d == 0))
+	{
+		target->setCeilingPlane(ceilingplane);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Process ZDoom slope specials. If [sectors] is given, only planes of sectors
+// in it are recalculated
+// -----------------------------------------------------------------------------
+void MapSpecials::processZDoomSlopes(SLADEMap* map, const SectorSet* sectors) const
+{
+	// ZDoom has a variety of slope mechanisms, which must be evaluated in a
+	// specific order.
+	//  - UDMF plane properties
+	//  - Plane_Align, in line order
+	//  - line slope + sector tilt + vavoom, in thing order
+	//  - slope copy things, in thing order
+	//  - overwrite vertex heights with vertex height things
+	//  - vertex triangle slopes, in sector order
+	//  - Plane_Copy, in line order
+
+	// Since sectors linked by slope sources are always processed together,
+	// a source only needs to be applied if any of its sectors are
+	auto process = [&](MapSector* sector) { return !sectors || (sector && sectors->count(sector) > 0); };
+
+	// First things first: reset every sector to flat planes, and apply any
+	// floor/ceiling plane properties
+	if (sectors)
+	{
+		for (auto target : *sectors)
+			applyPlaneProperties(target);
+	}
+	else
+	{
+		for (unsigned a = 0; a < map->nSectors(); a++)
+			applyPlaneProperties(map->sector(a));
+	}
 
+	// Plane_Align (line special 181)
+	for (auto line : plane_align_lines_)
+	{
 		auto sector1 = line->frontSector();
 		auto sector2 = line->backSector();
+		if (sectors && !process(sector1) && !process(sector2))
+			continue;
+
 		if (!sector1 || !sector2)
 		{
 			log::warning("Ignoring Plane_Align on one-sided line {}", line->index());
@@ -479,9 +828,10 @@ void MapSpecials::processZDoomSlopes(SLADEMap* map) const
 
 	// Line slope things (9500/9501), sector tilt things (9502/9503), and
 	// vavoom things (1500/1501), all in the same pass
-	for (unsigned a = 0; a < map->nThings(); a++)
+	for (auto thing : slope_things_)
 	{
-		auto thing = map->thing(a);
+		if (sectors && !process(thing_sectors_.at(thing)))
+			continue;
 
 		// Line slope things
 		if (thing->type() == 9500)
@@ -501,88 +851,70 @@ void MapSpecials::processZDoomSlopes(SLADEMap* map) const
 	}
 
 	// Slope copy things (9510/9511)
-	for (unsigned a = 0; a < map->nThings(); a++)
+	for (auto thing : copy_things_)
 	{
-		auto thing = map->thing(a);
+		auto target = thing_sectors_.at(thing);
+		if (!target || !process(target))
+			continue;
 
-		if (thing->type() == 9510 || thing->type() == 9511)
+		// First argument is the tag of a sector whose slope should be copied
+		int tag = thing->arg(0);
+		if (!tag)
 		{
-			auto target = map->sectors().atPos(thing->position());
-			if (!target)
-				continue;
-
-			// First argument is the tag of a sector whose slope should be copied
-			int tag = thing->arg(0);
-			if (!tag)
-			{
-				log::warning("Ignoring slope copy thing in sector {} with no argument", target->index());
-				continue;
-			}
-
-			auto tagged_sector = map->sectors().firstWithId(tag);
-			if (!tagged_sector)
-			{
-				log::warning(
-					"Ignoring slope copy thing in sector {}; no sectors have target tag {}", target->index(), tag);
-				continue;
-			}
-
-			if (thing->type() == 9510)
-				target->setFloorPlane(tagged_sector->floor().plane);
-			else
-				target->setCeilingPlane(tagged_sector->ceiling().plane);
+			log::warning("Ignoring slope copy thing in sector {} with no argument", target->index());
+			continue;
 		}
-	}
 
-	// Vertex height things
-	// These only affect the calculation of slopes and shouldn't be stored in
-	// the map data proper, so instead of actually changing vertex properties,
-	// we store them in a hashmap.
-	VertexHeightMap vertex_floor_heights;
-	VertexHeightMap vertex_ceiling_heights;
-	for (unsigned a = 0; a < map->nThings(); a++)
-	{
-		auto thing = map->thing(a);
-		if (thing->type() == 1504 || thing->type() == 1505)
+		auto tagged_sector = map->sectors().firstWithId(tag);
+		if (!tagged_sector)
 		{
-			// TODO there could be more than one vertex at this point
-			auto vertex = map->vertices().vertexAt(thing->xPos(), thing->yPos());
-			if (vertex)
-			{
-				if (thing->type() == 1504)
-					vertex_floor_heights[vertex] = thing->zPos();
-				else if (thing->type() == 1505)
-					vertex_ceiling_heights[vertex] = thing->zPos();
-			}
+			log::warning("Ignoring slope copy thing in sector {}; no sectors have target tag {}", target->index(), tag);
+			continue;
 		}
+
+		if (thing->type() == 9510)
+			target->setFloorPlane(tagged_sector->floor().plane);
+		else
+			target->setCeilingPlane(tagged_sector->ceiling().plane);
 	}
 
 	// Vertex heights -- only applies for sectors with exactly three vertices.
 	// Heights may be set by UDMF properties, or by a vertex height thing
 	// placed exactly on the vertex (which takes priority over the prop).
+	// Vertex height things only affect the calculation of slopes and shouldn't
+	// be stored in the map data proper, so instead of actually changing vertex
+	// properties they are kept in a hashmap (see updateSlopeSources)
 	vector<MapVertex*> vertices;
-	for (unsigned a = 0; a < map->nSectors(); a++)
-	{
-		auto target = map->sector(a);
+
+	auto apply_vertex_heights = [&](MapSector* target) {
 		vertices.clear();
 		target->putVertices(vertices);
 		if (vertices.size() != 3)
-			continue;
+			return;
 
-		applyVertexHeightSlope<SurfaceType::Floor>(target, vertices, vertex_floor_heights);
-		applyVertexHeightSlope<SurfaceType::Ceiling>(target, vertices, vertex_ceiling_heights);
+		applyVertexHeightSlope<SurfaceType::Floor>(target, vertices, vertex_floor_heights_);
+		applyVertexHeightSlope<SurfaceType::Ceiling>(target, vertices, vertex_ceiling_heights_);
+	};
+	if (sectors)
+	{
+		for (auto target : *sectors)
+			apply_vertex_heights(target);
+	}
+	else
+	{
+		for (unsigned a = 0; a < map->nSectors(); a++)
+			apply_vertex_heights(map->sector(a));
 	}
 
 	// Plane_Copy
-	for (unsigned a = 0; a < map->nLines(); a++)
+	for (auto line : plane_copy_lines_)
 	{
-		auto line = map->line(a);
-		if (line->special() != 118)
-			continue;
-
 		int  tag;
 		auto front = line->frontSector();
 		auto back  = line->backSector();
+		if (sectors && !process(front) && !process(back))
+			continue;
+
 		if ((tag = line->arg(0)) && front)
 		{
 			if (auto sector = map->sectors().firstWithId(tag))
@@ -624,9 +956,10 @@ void MapSpecials::processZDoomSlopes(SLADEMap* map) const
 }
 
 // -----------------------------------------------------------------------------
-// Process Eternity slope specials
+// Process Eternity slope specials. If [sectors] is given, only planes of
+// sectors in it are recalculated
 // -----------------------------------------------------------------------------
-void MapSpecials::processEternitySlopes(SLADEMap* map) const
+void MapSpecials::processEternitySlopes(SLADEMap* map, const SectorSet* sectors) const
 {
 	// Eternity plans on having a few slope mechanisms,
 	// which must be evaluated in a specific order.
@@ -634,23 +967,32 @@ void MapSpecials::processEternitySlopes(SLADEMap* map) const
 	//  - vertex triangle slopes, in sector order (wip)
 	//  - Plane_Copy, in line order
 
+	auto process = [&](MapSector* sector) { return !sectors || (sector && sectors->count(sector) > 0); };
+
 	// First things first: reset every sector to flat planes
-	for (unsigned a = 0; a < map->nSectors(); a++)
-	{
-		auto target = map->sector(a);
+	auto reset = [](MapSector* target) {
 		target->setPlane<SurfaceType::Floor>(Plane::flat(target->planeHeight<SurfaceType::Floor>()));
 		target->setPlane<SurfaceType::Ceiling>(Plane::flat(target->planeHeight<SurfaceType::Ceiling>()));
+	};
+	if (sectors)
+	{
+		for (auto target : *sectors)
+			reset(target);
+	}
+	else
+	{
+		for (unsigned a = 0; a < map->nSectors(); a++)
+			reset(map->sector(a));
 	}
 
 	// Plane_Align (line special 181)
-	for (unsigned a = 0; a < map->nLines(); a++)
+	for (auto line : plane_align_lines_)
 	{
-		auto line = map->line(a);
-		if (line->special() != 181)
-			continue;
-
 		auto sector1 = line->frontSector();
 		auto sector2 = line->backSector();
+		if (sectors && !process(sector1) && !process(sector2))
+			continue;
+
 		if (!sector1 || !sector2)
 		{
 			log::warning("Ignoring Plane_Align on one-sided line {}", line->index());
@@ -676,16 +1018,14 @@ void MapSpecials::processEternitySlopes(SLADEMap* map) const
 	}
 
 	// Plane_Copy
-	vector<MapSector*> sectors;
-	for (unsigned a = 0; a < map->nLines(); a++)
+	for (auto line : plane_copy_lines_)
 	{
-		auto line = map->line(a);
-		if (line->special() != 118)
-			continue;
-
 		int  tag;
 		auto front = line->frontSector();
 		auto back  = line->backSector();
+		if (sectors && !process(front) && !process(back))
+			continue;
+
 		if ((tag = line->arg(0)) && front)
 		{
 			if (auto sector = map->sectors().firstWithId(tag))
@@ -923,12 +1263,14 @@ template<SurfaceType T> double MapSpecials::vertexHeight(MapVertex* vertex, MapS
 // (triangular sectors only)
 // -----------------------------------------------------------------------------
 template<SurfaceType T>
-void MapSpecials::applyVertexHeightSlope(MapSector* target, vector<MapVertex*>& vertices, VertexHeightMap& heights)
-	const
+void MapSpecials::applyVertexHeightSlope(
+	MapSector*             target,
+	vector<MapVertex*>&    vertices,
+	const VertexHeightMap& heights) const
 {
-	double z1 = heights.count(vertices[0]) ? heights[vertices[0]] : vertexHeight<T>(vertices[0], target);
-	double z2 = heights.count(vertices[1]) ? heights[vertices[1]] : vertexHeight<T>(vertices[1], target);
-	double z3 = heights.count(vertices[2]) ? heights[vertices[2]] : vertexHeight<T>(vertices[2], target);
+	double z1 = heights.count(vertices[0]) ? heights.at(vertices[0]) : vertexHeight<T>(vertices[0], target);
+	double z2 = heights.count(vertices[1]) ? heights.at(vertices[1]) : vertexHeight<T>(vertices[1], target);
+	double z3 = heights.count(vertices[2]) ? heights.at(vertices[2]) : vertexHeight<T>(vertices[2], target);
 
 	Vec3d p1(vertices[0]->xPos(), vertices[0]->yPos(), z1);
 	Vec3d p2(vertices[1]->xPos(), vertices[1]->yPos(), z2);
@@ -15,8 +15,10 @@ class MapSpecials
 public:
 	void reset();
 
-	void processMapSpecials(SLADEMap* map) const;
+	void processMapSpecials(SLADEMap* map);
+	void updateMapSpecials(SLADEMap* map);
 	void processLineSpecial(MapLine* line) const;
+	void invalidateSlopeSources() { sources_valid_ = false; }
 
 	bool tagColour(int tag, ColRGBA* colour);
 	bool tagFadeColour(int tag, ColRGBA* colour);
@@ -25,7 +27,7 @@ public:
 	void updateTaggedSectors(SLADEMap* map);
 
 	// ZDoom
-	void processZDoomMapSpecials(SLADEMap* map) const;
+	void processZDoomMapSpecials(SLADEMap* map);
 	void processZDoomLineSpecial(MapLine* line) const;
 	void updateZDoomSector(MapSector* line);
 	void processACSScripts(ArchiveEntry* entry);
@@ -39,12 +41,40 @@ private:
 	};
 
 	typedef std::map<MapVertex*, double> VertexHeightMap;
+	typedef std::set<MapSector*>         SectorSet;
 
 	vector<SectorColour> sector_colours_;
 	vector<SectorColour> sector_fadecolours_;
 
-	void processZDoomSlopes(SLADEMap* map) const;
-	void processEternitySlopes(SLADEMap* map) const;
+	// Slope sources (lines and things with slope specials) in the order they
+	// are applied, and the groups of sectors they link together. Sectors in a
+	// group must have their planes recalculated together
+	bool                            sources_valid_ = false;
+	unsigned long                   sources_gen_   = 0;
+	vector<MapLine*>                plane_align_lines_;
+	vector<MapLine*>                plane_copy_lines_;
+	vector<MapThing*>               slope_things_;
+	vector<MapThing*>               copy_things_;
+	vector<MapThing*>               vertex_height_things_;
+	std::set<MapLine*>              source_lines_;
+	std::set<MapThing*>             source_things_;
+	std::map<MapThing*, MapSector*> thing_sectors_;
+	std::map<MapSector*, int>       tagged_sectors_;
+	std::set<int>                   source_tags_;
+	std::set<int>                   source_line_ids_;
+	std::set<int>                   vavoom_tids_;
+	VertexHeightMap                 vertex_floor_heights_;
+	VertexHeightMap                 vertex_ceiling_heights_;
+	std::map<MapSector*, unsigned>  sector_groups_;
+	vector<vector<MapSector*>>      groups_;
+
+	void updateSlopeSources(SLADEMap* map);
+	bool slopeSourcesChanged(SLADEMap* map) const;
+	bool inSlopeGroup(MapSector* sector) const { return sector && sector_groups_.count(sector) > 0; }
+
+	void processZDoomSlopes(SLADEMap* map, const SectorSet* sectors = nullptr) const;
+	void processEternitySlopes(SLADEMap* map, const SectorSet* sectors = nullptr) const;
+	void applyPlaneProperties(MapSector* target) const;
 
 	template<MapSector::SurfaceType>
 	void applyPlaneAlign(MapLine* line, MapSector* target, MapSector* model_sector) const;
@@ -53,6 +83,6 @@ private:
 	template<MapSector::SurfaceType> void   applyVavoomSlopeThing(SLADEMap* map, MapThing* thing) const;
 	template<MapSector::SurfaceType> double vertexHeight(MapVertex* vertex, MapSector* sector) const;
 	template<MapSector::SurfaceType>
-	void applyVertexHeightSlope(MapSector* target, vector<MapVertex*>& vertices, VertexHeightMap& heights) const;
+	void applyVertexHeightSlope(MapSector* target, vector<MapVertex*>& vertices, const VertexHeightMap& heights) const;
 };
 } // namespace slade
@@ -0,0 +1,580 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapTopology.cpp
+// Description: MapTopology class - a half-edge view of the map lines and
+//              vertices, for walking sector outlines and locating points
+//              without scanning the whole map.
+//
+//              Each line is a pair of half-edges, and each vertex keeps its
+//              outgoing half-edges sorted by angle, so the next edge around a
+//              face is found locally. Lines and vertices are also kept in a
+//              grid for spatial queries. Both are updated incrementally from
+//              the map's modified objects log, so only geometry that has
+//              changed since the last query is re-processed
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapTopology.h"
+#include "SLADEMap.h"
+#include "Utility/MathStuff.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+int cellCoord(double value, double cell_size)
+{
+	return static_cast<int>(std::floor(value / cell_size));
+}
+
+int64_t cellKey(int x, int y)
+{
+	return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+template<typename T> void removeFromCell(vector<T*>& cell, T* object)
+{
+	for (unsigned a = 0; a < cell.size(); a++)
+	{
+		if (cell[a] == object)
+		{
+			cell[a] = cell.back();
+			cell.pop_back();
+			return;
+		}
+	}
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTopology::HalfEdge Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the vertex the half-edge starts at
+// -----------------------------------------------------------------------------
+MapVertex* MapTopology::HalfEdge::origin() const
+{
+	return front ? line->v1() : line->v2();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the vertex the half-edge ends at
+// -----------------------------------------------------------------------------
+MapVertex* MapTopology::HalfEdge::target() const
+{
+	return front ? line->v2() : line->v1();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the sector on the right of the half-edge (if any)
+// -----------------------------------------------------------------------------
+MapSector* MapTopology::HalfEdge::sector() const
+{
+	return front ? line->frontSector() : line->backSector();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTopology Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears all topology info, it will be rebuilt on the next query.
+// Must be called whenever map objects are added or removed without going
+// through the usual MapObjectCollection functions (eg. undo/redo)
+// -----------------------------------------------------------------------------
+void MapTopology::invalidate()
+{
+	fans_.clear();
+	line_cells_.clear();
+	vertex_cells_.clear();
+	line_ranges_.clear();
+	vertex_keys_.clear();
+	large_lines_.clear();
+	extent_ = { 0, 0, -1, -1 };
+	valid_  = false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the outgoing half-edges of [vertex], sorted anticlockwise by angle.
+// Zero-length lines are ignored
+// -----------------------------------------------------------------------------
+const vector<MapTopology::HalfEdge>& MapTopology::outgoing(MapVertex* vertex)
+{
+	auto& fan = fans_[vertex];
+
+	// Check if the fan needs (re)sorting - either the vertex's lines have
+	// changed or any of the vertices involved have moved
+	bool sorted = fan.origin == vertex->position() && fan.lines == vertex->connectedLines();
+	for (unsigned a = 0; sorted && a < fan.edges.size(); a++)
+		if (fan.edges[a].target()->position() != fan.targets[a])
+			sorted = false;
+	if (sorted)
+		return fan.edges;
+
+	// Build list of outgoing half-edges
+	fan.origin = vertex->position();
+	fan.lines  = vertex->connectedLines();
+	fan.edges.clear();
+	for (auto line : fan.lines)
+	{
+		if (line->v1() == line->v2())
+			continue;
+
+		fan.edges.emplace_back(line, line->v1() == vertex);
+	}
+
+	// Sort by angle
+	auto angle = [&](const HalfEdge& edge) {
+		auto dir = edge.target()->position() - fan.origin;
+		return std::atan2(dir.y, dir.x);
+	};
+	std::sort(fan.edges.begin(), fan.edges.end(), [&](const HalfEdge& l, const HalfEdge& r) {
+		double al = angle(l);
+		double ar = angle(r);
+		if (al != ar)
+			return al < ar;
+		if (l.line != r.line)
+			return l.line->index() < r.line->index();
+		return l.front && !r.front;
+	});
+
+	fan.targets.clear();
+	for (auto& edge : fan.edges)
+		fan.targets.push_back(edge.target()->position());
+
+	return fan.edges;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the half-edge following [edge] around the face on its right side
+// (ie. the sharpest right turn at its target vertex). If [edge] ends at a
+// vertex with no other lines, this will be its twin
+// -----------------------------------------------------------------------------
+MapTopology::HalfEdge MapTopology::next(const HalfEdge& edge)
+{
+	auto& fan  = outgoing(edge.target());
+	auto  twin = edge.twin();
+	for (unsigned a = 0; a < fan.size(); a++)
+		if (fan[a] == twin)
+			return fan[(a + 1) % fan.size()];
+
+	return {};
+}
+
+// -----------------------------------------------------------------------------
+// Returns the half-edge preceding [edge] around the face on its right side
+// -----------------------------------------------------------------------------
+MapTopology::HalfEdge MapTopology::prev(const HalfEdge& edge)
+{
+	auto& fan = outgoing(edge.origin());
+	for (unsigned a = 0; a < fan.size(); a++)
+		if (fan[a] == edge)
+			return fan[(a + fan.size() - 1) % fan.size()].twin();
+
+	return {};
+}
+
+// -----------------------------------------------------------------------------
+// Traces the face on the right side of [start], adding its half-edges to
+// [face]. Returns false if the face couldn't be closed
+// -----------------------------------------------------------------------------
+bool MapTopology::traceFace(const HalfEdge& start, vector<HalfEdge>& face)
+{
+	face.clear();
+	if (!start)
+		return false;
+
+	auto   edge  = start;
+	size_t limit = map_->nLines() * 2;
+	while (face.size() <= limit)
+	{
+		face.push_back(edge);
+
+		edge = next(edge);
+		if (!edge)
+			return false;
+		if (edge == start)
+			return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Fires a ray east from [point] and returns the half-edge of the first line it
+// crosses that faces [point].
+// In the case of the ray hitting a vertex exactly, the line closest to
+// [point] is used
+// -----------------------------------------------------------------------------
+MapTopology::HalfEdge MapTopology::edgeRightOf(Vec2d point)
+{
+	sync();
+
+	double   min_dist = 0;
+	MapLine* nearest  = nullptr;
+
+	auto test = [&](MapLine* line) {
+		if (!inMap(line))
+			return;
+
+		// Ignore if the line is completely left of the point
+		if (line->x1() <= point.x && line->x2() <= point.x)
+			return;
+
+		// Ignore horizontal lines
+		if (line->y1() == line->y2())
+			return;
+
+		// Ignore if the line doesn't intersect the y value
+		if ((line->y1() < point.y && line->y2() < point.y) || (line->y1() > point.y && line->y2() > point.y))
+			return;
+
+		// Get x intercept
+		double int_frac = (point.y - line->y1()) / (line->y2() - line->y1());
+		double int_x    = line->x1() + ((line->x2() - line->x1()) * int_frac);
+		double dist     = std::fabs(int_x - point.x);
+
+		// Check if closest
+		if (!nearest || dist < min_dist)
+		{
+			min_dist = dist;
+			nearest  = line;
+		}
+		else if (std::fabs(dist - min_dist) < 0.001 && line != nearest)
+		{
+			// Tie (the ray hits a vertex shared by both lines), use the
+			// line closest to the point
+			if (math::distanceToLineFast(point, line->seg()) < math::distanceToLineFast(point, nearest->seg()))
+			{
+				min_dist = dist;
+				nearest  = line;
+			}
+		}
+	};
+
+	for (auto line : large_lines_)
+		test(line);
+
+	// Go through grid cells east of the point, until we've passed the nearest
+	// intersection found so far
+	int cy = cellCoord(point.y, CELL_SIZE);
+	for (int cx = cellCoord(point.x, CELL_SIZE); cx <= extent_.x2; cx++)
+	{
+		if (nearest && point.x + min_dist < cx * CELL_SIZE)
+			break;
+
+		auto cell = line_cells_.find(cellKey(cx, cy));
+		if (cell == line_cells_.end())
+			continue;
+
+		for (auto line : cell->second)
+			test(line);
+	}
+
+	if (!nearest)
+		return {};
+
+	return { nearest, math::lineSide(point, nearest->seg()) >= 0 };
+}
+
+// -----------------------------------------------------------------------------
+// Returns the sector containing [point], or nullptr if it isn't in a sector
+// -----------------------------------------------------------------------------
+MapSector* MapTopology::sectorAt(Vec2d point)
+{
+	auto edge = edgeRightOf(point);
+	return edge ? edge.sector() : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Adds all vertices within [bbox] to [list]
+// -----------------------------------------------------------------------------
+void MapTopology::putVerticesWithin(const BBox& bbox, vector<MapVertex*>& list)
+{
+	sync();
+
+	int x1 = std::max(extent_.x1, cellCoord(bbox.min.x, CELL_SIZE));
+	int y1 = std::max(extent_.y1, cellCoord(bbox.min.y, CELL_SIZE));
+	int x2 = std::min(extent_.x2, cellCoord(bbox.max.x, CELL_SIZE));
+	int y2 = std::min(extent_.y2, cellCoord(bbox.max.y, CELL_SIZE));
+	for (int cx = x1; cx <= x2; cx++)
+	{
+		for (int cy = y1; cy <= y2; cy++)
+		{
+			auto cell = vertex_cells_.find(cellKey(cx, cy));
+			if (cell == vertex_cells_.end())
+				continue;
+
+			for (auto vertex : cell->second)
+				if (inMap(vertex) && bbox.contains(vertex->position()))
+					list.push_back(vertex);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds all lines with a bounding box intersecting [bbox] to [list]
+// -----------------------------------------------------------------------------
+void MapTopology::putLinesWithin(const BBox& bbox, vector<MapLine*>& list)
+{
+	sync();
+
+	auto intersects = [&](MapLine* line) {
+		return inMap(line) && std::max(line->x1(), line->x2()) >= bbox.min.x
+			   && std::min(line->x1(), line->x2()) <= bbox.max.x && std::max(line->y1(), line->y2()) >= bbox.min.y
+			   && std::min(line->y1(), line->y2()) <= bbox.max.y;
+	};
+
+	auto first = list.size();
+	for (auto line : large_lines_)
+		if (intersects(line))
+			list.push_back(line);
+
+	int x1 = std::max(extent_.x1, cellCoord(bbox.min.x, CELL_SIZE));
+	int y1 = std::max(extent_.y1, cellCoord(bbox.min.y, CELL_SIZE));
+	int x2 = std::min(extent_.x2, cellCoord(bbox.max.x, CELL_SIZE));
+	int y2 = std::min(extent_.y2, cellCoord(bbox.max.y, CELL_SIZE));
+	for (int cx = x1; cx <= x2; cx++)
+	{
+		for (int cy = y1; cy <= y2; cy++)
+		{
+			auto cell = line_cells_.find(cellKey(cx, cy));
+			if (cell == line_cells_.end())
+				continue;
+
+			for (auto line : cell->second)
+				if (intersects(line))
+					list.push_back(line);
+		}
+	}
+
+	// Lines can be in multiple cells, remove duplicates
+	std::sort(list.begin() + first, list.end());
+	list.erase(std::unique(list.begin() + first, list.end()), list.end());
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [line] is currently part of the map
+// -----------------------------------------------------------------------------
+bool MapTopology::inMap(MapLine* line) const
+{
+	return line->index() < map_->nLines() && map_->line(line->index()) == line;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [vertex] is currently part of the map
+// -----------------------------------------------------------------------------
+bool MapTopology::inMap(MapVertex* vertex) const
+{
+	return vertex->index() < map_->nVertices() && map_->vertex(vertex->index()) == vertex;
+}
+
+// -----------------------------------------------------------------------------
+// Brings the spatial grid up to date with any lines or vertices modified since
+// the last update. Removed objects are purged via objectRemoved, since removal
+// of map objects doesn't mark them as modified
+// -----------------------------------------------------------------------------
+void MapTopology::sync()
+{
+	if (!valid_)
+	{
+		rebuild();
+		return;
+	}
+
+	auto& data = map_->mapData();
+	if (data.generation() == synced_gen_)
+		return;
+
+	for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Vertex))
+	{
+		auto vertex = dynamic_cast<MapVertex*>(object);
+		updateVertex(vertex);
+		for (auto line : vertex->connectedLines())
+			updateLine(line);
+	}
+
+	for (auto object : data.modifiedObjectsSinceGen(synced_gen_, MapObject::Type::Line))
+		updateLine(dynamic_cast<MapLine*>(object));
+
+	synced_gen_ = data.generation();
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from the spatial grid (and its fan if it is a vertex).
+// Must be called whenever a line or vertex is removed from the map
+// -----------------------------------------------------------------------------
+void MapTopology::objectRemoved(MapObject* object)
+{
+	if (!valid_)
+		return;
+
+	if (object->objType() == MapObject::Type::Line)
+		removeLine(dynamic_cast<MapLine*>(object));
+	else if (object->objType() == MapObject::Type::Vertex)
+	{
+		auto vertex = dynamic_cast<MapVertex*>(object);
+		removeVertex(vertex);
+		fans_.erase(vertex);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the spatial grid from scratch
+// -----------------------------------------------------------------------------
+void MapTopology::rebuild()
+{
+	invalidate();
+
+	for (auto vertex : map_->vertices())
+		updateVertex(vertex);
+	for (auto line : map_->lines())
+		updateLine(line);
+
+	synced_gen_ = map_->mapData().generation();
+	valid_      = true;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the grid cells [line] is in
+// -----------------------------------------------------------------------------
+void MapTopology::updateLine(MapLine* line)
+{
+	removeLine(line);
+
+	if (!inMap(line) || !line->v1() || !line->v2())
+		return;
+
+	CellRange range{ cellCoord(std::min(line->x1(), line->x2()), CELL_SIZE),
+					 cellCoord(std::min(line->y1(), line->y2()), CELL_SIZE),
+					 cellCoord(std::max(line->x1(), line->x2()), CELL_SIZE),
+					 cellCoord(std::max(line->y1(), line->y2()), CELL_SIZE) };
+
+	extendGrid(range);
+
+	// Very long diagonal lines would take up too many cells
+	if (static_cast<int64_t>(range.x2 - range.x1 + 1) * (range.y2 - range.y1 + 1) > MAX_LINE_CELLS)
+	{
+		large_lines_.push_back(line);
+		line_ranges_[line] = { 0, 0, -1, -1 };
+		return;
+	}
+
+	for (int cx = range.x1; cx <= range.x2; cx++)
+		for (int cy = range.y1; cy <= range.y2; cy++)
+			line_cells_[cellKey(cx, cy)].push_back(line);
+
+	line_ranges_[line] = range;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the grid cell [vertex] is in
+// -----------------------------------------------------------------------------
+void MapTopology::updateVertex(MapVertex* vertex)
+{
+	removeVertex(vertex);
+
+	if (!inMap(vertex))
+		return;
+
+	int cx = cellCoord(vertex->xPos(), CELL_SIZE);
+	int cy = cellCoord(vertex->yPos(), CELL_SIZE);
+
+	extendGrid({ cx, cy, cx, cy });
+
+	auto key = cellKey(cx, cy);
+	vertex_cells_[key].push_back(vertex);
+	vertex_keys_[vertex] = key;
+}
+
+// -----------------------------------------------------------------------------
+// Extends the known extent of the grid to include [range]
+// -----------------------------------------------------------------------------
+void MapTopology::extendGrid(const CellRange& range)
+{
+	if (extent_.x2 < extent_.x1)
+	{
+		extent_ = range;
+		return;
+	}
+
+	extent_.x1 = std::min(extent_.x1, range.x1);
+	extent_.y1 = std::min(extent_.y1, range.y1);
+	extent_.x2 = std::max(extent_.x2, range.x2);
+	extent_.y2 = std::max(extent_.y2, range.y2);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [line] from any grid cells it is in
+// -----------------------------------------------------------------------------
+void MapTopology::removeLine(MapLine* line)
+{
+	auto current = line_ranges_.find(line);
+	if (current == line_ranges_.end())
+		return;
+
+	auto& range = current->second;
+	if (range.x2 < range.x1)
+		removeFromCell(large_lines_, line);
+	else
+	{
+		for (int cx = range.x1; cx <= range.x2; cx++)
+			for (int cy = range.y1; cy <= range.y2; cy++)
+				removeFromCell(line_cells_[cellKey(cx, cy)], line);
+	}
+
+	line_ranges_.erase(current);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [vertex] from the grid cell it is in
+// -----------------------------------------------------------------------------
+void MapTopology::removeVertex(MapVertex* vertex)
+{
+	auto current = vertex_keys_.find(vertex);
+	if (current == vertex_keys_.end())
+		return;
+
+	removeFromCell(vertex_cells_[current->second], vertex);
+	vertex_keys_.erase(current);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <unordered_map>
+
+namespace slade
+{
+class MapLine;
+class MapObject;
+class MapSector;
+class MapVertex;
+class SLADEMap;
+
+class MapTopology
+{
+public:
+	// One direction of a line. The front half-edge runs from v1 to v2 with the
+	// front side on its right, the back half-edge runs the other way
+	struct HalfEdge
+	{
+		MapLine* line  = nullptr;
+		bool     front = true;
+
+		HalfEdge(MapLine* line = nullptr, bool front = true) : line{ line }, front{ front } {}
+
+		MapVertex* origin() const;
+		MapVertex* target() const;
+		MapSector* sector() const;
+		HalfEdge   twin() const { return { line, !front }; }
+
+		bool operator==(const HalfEdge& rhs) const { return line == rhs.line && front == rhs.front; }
+		bool operator!=(const HalfEdge& rhs) const { return !(*this == rhs); }
+		explicit operator bool() const { return line != nullptr; }
+	};
+
+	MapTopology(SLADEMap* map) : map_{ map } {}
+	~MapTopology() = default;
+
+	void invalidate();
+	void sync();
+	void objectRemoved(MapObject* object);
+
+	// Half-edge navigation
+	const vector<HalfEdge>& outgoing(MapVertex* vertex);
+	HalfEdge                next(const HalfEdge& edge);
+	HalfEdge                prev(const HalfEdge& edge);
+	bool                    traceFace(const HalfEdge& start, vector<HalfEdge>& face);
+
+	// Spatial queries
+	HalfEdge   edgeRightOf(Vec2d point);
+	MapSector* sectorAt(Vec2d point);
+	void       putVerticesWithin(const BBox& bbox, vector<MapVertex*>& list);
+	void       putLinesWithin(const BBox& bbox, vector<MapLine*>& list);
+
+private:
+	// Outgoing half-edges around a vertex, sorted anticlockwise. The positions
+	// the fan was sorted with are kept to detect when it needs re-sorting
+	struct Fan
+	{
+		Vec2d            origin;
+		vector<MapLine*> lines;
+		vector<Vec2d>    targets;
+		vector<HalfEdge> edges;
+	};
+
+	struct CellRange
+	{
+		int x1, y1, x2, y2;
+	};
+
+	static constexpr double CELL_SIZE      = 256.;
+	static constexpr int    MAX_LINE_CELLS = 1024; // Lines covering more cells than this go in large_lines_
+
+	SLADEMap*                                       map_;
+	std::unordered_map<MapVertex*, Fan>             fans_;
+	std::unordered_map<int64_t, vector<MapLine*>>   line_cells_;
+	std::unordered_map<int64_t, vector<MapVertex*>> vertex_cells_;
+	std::unordered_map<MapLine*, CellRange>         line_ranges_;
+	std::unordered_map<MapVertex*, int64_t>         vertex_keys_;
+	vector<MapLine*>                                large_lines_;
+	CellRange                                       extent_{ 0, 0, -1, -1 };
+	unsigned long                                   synced_gen_ = 0;
+	bool                                            valid_      = false;
+
+	bool inMap(MapLine* line) const;
+	bool inMap(MapVertex* vertex) const;
+
+	void rebuild();
+	void updateLine(MapLine* line);
+	void updateVertex(MapVertex* vertex);
+	void removeLine(MapLine* line);
+	void removeVertex(MapVertex* vertex);
+	void extendGrid(const CellRange& range);
+};
+} // namespace slade
@@ -37,6 +37,8 @@
 #include "MapEditor/SectorBuilder.h"
 #include "MapFormat/MapFormatHandler.h"
 #include "Utility/MathStuff.h"
+#include <thread>
+#include <unordered_set>
 
 using namespace slade;
 
@@ -49,6 +51,36 @@ using namespace slade;
 CVAR(Bool, map_split_auto_offset, true, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns a bounding box covering [min] to [max], expanded by [margin] on each
+// side
+// -----------------------------------------------------------------------------
+BBox marginBBox(Vec2d min, Vec2d max, double margin = 0.)
+{
+	BBox bbox;
+	bbox.min.set(std::min(min.x, max.x) - margin, std::min(min.y, max.y) - margin);
+	bbox.max.set(std::max(min.x, max.x) + margin, std::max(min.y, max.y) + margin);
+	return bbox;
+}
+
+// -----------------------------------------------------------------------------
+// Sorts [objects] by index, so that spatial query results are processed in
+// the same order as a full scan of the map would
+// -----------------------------------------------------------------------------
+template<typename T> void sortByIndex(vector<T*>& objects)
+{
+	std::sort(objects.begin(), objects.end(), [](T* l, T* r) { return l->index() < r->index(); });
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // SLADEMap Class Functions
@@ -89,6 +121,16 @@ MapObject* SLADEMap::object(MapObject::Type type, unsigned index) const
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Returns the struct-of-arrays geometry snapshot of the map, bringing it up to
+// date first if needed
+// -----------------------------------------------------------------------------
+const MapGeometrySnapshot& SLADEMap::geometry()
+{
+	geometry_.sync();
+	return geometry_;
+}
+
 // -----------------------------------------------------------------------------
 // Sets the geometry last updated time to now
 // -----------------------------------------------------------------------------
@@ -112,6 +154,13 @@ bool SLADEMap::readMap(const Archive::MapDesc& map)
 {
 	auto omap = map;
 
+	// Records the time taken by an open stage
+	open_stages_.clear();
+	sf::Clock clock;
+	auto      end_stage = [&](string_view name) {
+		open_stages_.push_back({ string{ name }, clock.restart().asMicroseconds() / 1000., false });
+	};
+
 	// Check for map archive
 	WadArchive tempwad;
 	auto       m_head = map.head.lock();
@@ -128,6 +177,9 @@ bool SLADEMap::readMap(const Archive::MapDesc& map)
 	bool ok = false;
 	if (omap.head.lock())
 	{
+		// Map objects are allocated from the map's arena
+		MapObjectArena::Scope scope(data_.arena());
+
 		auto map_handler = MapFormatHandler::get(omap.format);
 		ok               = map_handler->readMap(omap, data_, udmf_props_);
 		udmf_namespace_  = map_handler->udmfNamespace();
@@ -139,6 +191,8 @@ bool SLADEMap::readMap(const Archive::MapDesc& map)
 	for (auto& entry : omap.unk)
 		udmf_extra_entries_.push_back(new ArchiveEntry(*entry));
 
+	end_stage("Read map data");
+
 	// Set map info
 	name_ = map.name;
 
@@ -154,11 +208,45 @@ bool SLADEMap::readMap(const Archive::MapDesc& map)
 			udmf_namespace_ = game::configuration().udmfNamespace();
 	}
 
+	topology_.invalidate();
 	mapOpenChecks();
+	end_stage("Map open checks");
+
+	// Runs [task] on a separate thread, recording its time taken as a
+	// stage concurrent with whatever the main thread is doing meanwhile
+	OpenStage concurrent_stage;
+	auto      run_concurrent = [&](string_view name, const std::function<void()>& task) {
+		return std::thread([&concurrent_stage, name, task]() {
+			sf::Clock task_clock;
+			task();
+			concurrent_stage = { string{ name }, task_clock.getElapsedTime().asMicroseconds() / 1000., true };
+		});
+	};
 
+	// Sector bounding boxes, while counting thing type usage
+	auto thread = run_concurrent("Count thing types", [&]() { countThingTypeUsage(); });
 	data_.sectors().initBBoxes();
+	thread.join();
+	end_stage("Sector bounding boxes");
+	open_stages_.push_back(concurrent_stage);
+
+	// Sector polygons (spread across worker threads)
 	data_.sectors().initPolygons();
+	end_stage("Sector polygons");
+
+	// Map topology and specials (slopes). These aren't run alongside the
+	// polygons since specials modify sectors and the map itself
+	topology_.sync();
 	recomputeSpecials();
+	end_stage("Map topology & specials");
+
+	// Log total time (main thread stages include time waiting for any
+	// concurrent stages to finish)
+	double total = 0.;
+	for (auto& stage : open_stages_)
+		if (!stage.concurrent)
+			total += stage.duration_ms;
+	log::info(2, "Map opened in {:1.2f}ms", total);
 
 	opened_time_ = app::runTimer() + 10;
 
@@ -174,6 +262,8 @@ void SLADEMap::clearMap()
 
 	// Clear map objects
 	data_.clear();
+	topology_.invalidate();
+	geometry_.invalidate();
 
 	// Clear usage counts
 	usage_thing_type_.clear();
@@ -205,28 +295,26 @@ BBox SLADEMap::bounds(bool include_things)
 // -----------------------------------------------------------------------------
 void SLADEMap::updateGeometryInfo(long modified_time)
 {
-	for (auto& vertex : data_.vertices())
+	for (auto* object : data_.modifiedObjects(modified_time + 1, MapObject::Type::Vertex))
 	{
-		if (vertex->modifiedTime() > modified_time)
+		auto vertex = dynamic_cast<MapVertex*>(object);
+		for (auto* line : vertex->connected_lines_)
 		{
-			for (auto* line : vertex->connected_lines_)
-			{
-				// Update line geometry
-				line->resetInternals();
+			// Update line geometry
+			line->resetInternals();
 
-				// Update front sector
-				if (line->frontSector())
-				{
-					line->frontSector()->resetPolygon();
-					line->frontSector()->updateBBox();
-				}
+			// Update front sector
+			if (line->frontSector())
+			{
+				line->frontSector()->resetPolygon();
+				line->frontSector()->updateBBox();
+			}
 
-				// Update back sector
-				if (line->backSector())
-				{
-					line->backSector()->resetPolygon();
-					line->backSector()->updateBBox();
-				}
+			// Update back sector
+			if (line->backSector())
+			{
+				line->backSector()->resetPolygon();
+				line->backSector()->updateBBox();
 			}
 		}
 	}
@@ -492,10 +580,11 @@ void SLADEMap::setOpenedTime()
 // this just means ZDoom slopes).
 // Since this needs to be done anytime the map changes, it's called whenever a
 // map is read, an undo record ends, or an undo/redo is performed.
+// Only specials affected by changes since the last call are re-applied
 // -----------------------------------------------------------------------------
 void SLADEMap::recomputeSpecials()
 {
-	map_specials_.processMapSpecials(this);
+	map_specials_.updateMapSpecials(this);
 }
 
 // -----------------------------------------------------------------------------
@@ -541,7 +630,8 @@ MapVertex* SLADEMap::createVertex(Vec2d pos, double split_dist)
 		return overlap;
 
 	// Create the vertex
-	auto* nv = data_.addVertex(std::make_unique<MapVertex>(pos));
+	MapObjectArena::Scope scope(data_.arena());
+	auto*                 nv = data_.addVertex(std::make_unique<MapVertex>(pos));
 
 	// Check if this vertex splits any lines (if needed)
 	if (split_dist >= 0)
@@ -616,7 +706,8 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 			return existing;
 
 	// Create new line between vertices
-	auto* nl = data_.addLine(std::make_unique<MapLine>(vertex1, vertex2, nullptr, nullptr));
+	MapObjectArena::Scope scope(data_.arena());
+	auto*                 nl = data_.addLine(std::make_unique<MapLine>(vertex1, vertex2, nullptr, nullptr));
 
 	// Connect line to vertices
 	vertex1->connectLine(nl);
@@ -634,6 +725,7 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 MapThing* SLADEMap::createThing(Vec2d pos, int type)
 {
 	// Create the thing
+	MapObjectArena::Scope scope(data_.arena());
 	return data_.addThing(std::make_unique<MapThing>(pos, type));
 }
 
@@ -642,6 +734,7 @@ MapThing* SLADEMap::createThing(Vec2d pos, int type)
 // -----------------------------------------------------------------------------
 MapSector* SLADEMap::createSector()
 {
+	MapObjectArena::Scope scope(data_.arena());
 	return data_.addSector(std::make_unique<MapSector>());
 }
 
@@ -654,6 +747,7 @@ MapSide* SLADEMap::createSide(MapSector* sector)
 	if (!sector)
 		return nullptr;
 
+	MapObjectArena::Scope scope(data_.arena());
 	return data_.addSide(std::make_unique<MapSide>(sector));
 }
 
@@ -715,30 +809,22 @@ void SLADEMap::mergeVertices(unsigned vertex1, unsigned vertex2)
 // -----------------------------------------------------------------------------
 MapVertex* SLADEMap::mergeVerticesPoint(const Vec2d& pos)
 {
-	// Go through all vertices
-	int merge = -1;
-	for (unsigned a = 0; a < vertices().size(); a++)
-	{
-		// Skip if vertex isn't on the point
-		if (vertex(a)->position_.x != pos.x || vertex(a)->position_.y != pos.y)
-			continue;
-
-		// Set as the merge target vertex if we don't have one already
-		if (merge < 0)
-		{
-			merge = a;
-			continue;
-		}
+	// Get all vertices on the point
+	vector<MapVertex*> point_vertices;
+	topology_.putVerticesWithin(marginBBox(pos, pos), point_vertices);
+	if (point_vertices.empty())
+		return nullptr;
 
-		// Otherwise, merge this vertex with the merge target
-		mergeVertices(merge, a);
-		a--;
-	}
+	// Merge them all into the first (lowest index) vertex
+	sortByIndex(point_vertices);
+	auto* merge = point_vertices[0];
+	for (unsigned a = 1; a < point_vertices.size(); a++)
+		mergeVertices(merge->index(), point_vertices[a]->index());
 
 	geometry_updated_ = app::runTimer();
 
 	// Return the final merged vertex
-	return vertex(merge);
+	return merge;
 }
 
 // -----------------------------------------------------------------------------
@@ -780,7 +866,8 @@ MapLine* SLADEMap::splitLine(MapLine* line, MapVertex* vertex)
 	}
 
 	// Create and add new line
-	auto* nl = data_.addLine(std::make_unique<MapLine>(vertex, v2, s1, s2));
+	MapObjectArena::Scope scope(data_.arena());
+	auto*                 nl = data_.addLine(std::make_unique<MapLine>(vertex, v2, s1, s2));
 	nl->copy(line);
 	nl->setModified();
 
@@ -803,19 +890,26 @@ MapLine* SLADEMap::splitLine(MapLine* line, MapVertex* vertex)
 // -----------------------------------------------------------------------------
 void SLADEMap::splitLinesAt(MapVertex* vertex, double split_dist)
 {
+	// Get lines near the vertex
+	vector<MapLine*> near_lines;
+	topology_.putLinesWithin(marginBBox(vertex->position_, vertex->position_, split_dist), near_lines);
+	sortByIndex(near_lines);
+
 	// Check if this vertex splits any lines (if needed)
-	auto nlines = data_.lines().size();
-	for (unsigned i = 0; i < nlines; ++i)
+	for (auto* line : near_lines)
 	{
-		auto* line = this->line(i);
-
 		// Skip line if it shares the vertex
 		if (line->v1() == vertex || line->v2() == vertex)
 			continue;
 
 		if (line->distanceTo(vertex->position()) < split_dist)
 		{
-			log::info(2, "Vertex at ({:1.2f},{:1.2f}) splits line {}", vertex->position_.x, vertex->position_.y, i);
+			log::info(
+				2,
+				"Vertex at ({:1.2f},{:1.2f}) splits line {}",
+				vertex->position_.x,
+				vertex->position_.y,
+				line->index_);
 			splitLine(line, vertex);
 		}
 	}
@@ -993,20 +1087,23 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 	auto*    last_line   = lines().last();
 
 	// Merge vertices
-	vector<MapVertex*> merged_vertices;
+	vector<MapVertex*>             merged_vertices;
+	std::unordered_set<MapVertex*> merged_set;
 	for (auto& vertex : vertices)
 	{
 		auto* v = mergeVerticesPoint(vertex->position_);
-		if (v)
-			VECTOR_ADD_UNIQUE(merged_vertices, v);
+		if (v && merged_set.insert(v).second)
+			merged_vertices.push_back(v);
 	}
 
 	// Get all connected lines
-	vector<MapLine*> connected_lines_;
+	vector<MapLine*>             connected_lines_;
+	std::unordered_set<MapLine*> connected_set;
 	for (auto& vertex : merged_vertices)
 	{
 		for (auto* connected_line : vertex->connected_lines_)
-			VECTOR_ADD_UNIQUE(connected_lines_, connected_line);
+			if (connected_set.insert(connected_line).second)
+				connected_lines_.push_back(connected_line);
 	}
 
 	// Split lines (by vertices)
@@ -1016,13 +1113,16 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 		splitLinesAt(merged_vertice, split_dist);
 
 	// Split lines that moved onto existing vertices
+	vector<MapVertex*> near_vertices;
 	for (unsigned a = 0; a < connected_lines_.size(); a++)
 	{
-		unsigned nvertices = nVertices();
-		for (unsigned b = 0; b < nvertices; b++)
-		{
-			auto* vertex = this->vertex(b);
+		auto* line = connected_lines_[a];
+		near_vertices.clear();
+		topology_.putVerticesWithin(marginBBox(line->start(), line->end(), split_dist), near_vertices);
+		sortByIndex(near_vertices);
 
+		for (auto* vertex : near_vertices)
+		{
 			// Skip line if it shares the vertex
 			if (connected_lines_[a]->v1() == vertex || connected_lines_[a]->v2() == vertex)
 				continue;
@@ -1030,23 +1130,26 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 			if (connected_lines_[a]->distanceTo(vertex->position()) < split_dist)
 			{
 				connected_lines_.push_back(splitLine(connected_lines_[a], vertex));
-				VECTOR_ADD_UNIQUE(merged_vertices, vertex);
+				if (merged_set.insert(vertex).second)
+					merged_vertices.push_back(vertex);
 			}
 		}
 	}
 
 	// Split lines (by lines)
-	Seg2d seg1;
+	Seg2d            seg1;
+	vector<MapLine*> near_lines;
 	for (unsigned a = 0; a < connected_lines_.size(); a++)
 	{
 		auto* line1 = connected_lines_[a];
 		seg1        = line1->seg();
 
-		unsigned n_lines = nLines();
-		for (unsigned b = 0; b < n_lines; b++)
-		{
-			auto* line2 = line(b);
+		near_lines.clear();
+		topology_.putLinesWithin(marginBBox(line1->start(), line1->end()), near_lines);
+		sortByIndex(near_lines);
 
+		for (auto* line2 : near_lines)
+		{
 			// Can't intersect if they share a vertex
 			if (line1->vertex1_ == line2->vertex1_ || line1->vertex1_ == line2->vertex2_
 				|| line2->vertex1_ == line1->vertex2_ || line2->vertex2_ == line1->vertex2_)
@@ -1059,6 +1162,7 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 				// Create split vertex
 				auto* nv = createVertex(intersection);
 				merged_vertices.push_back(nv);
+				merged_set.insert(nv);
 
 				// Split lines
 				splitLine(line1, nv);
@@ -1076,20 +1180,23 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 
 	// Refresh connected lines
 	connected_lines_.clear();
+	connected_set.clear();
 	for (auto& vertex : merged_vertices)
 	{
 		for (auto* connected_line : vertex->connected_lines_)
-			VECTOR_ADD_UNIQUE(connected_lines_, connected_line);
+			if (connected_set.insert(connected_line).second)
+				connected_lines_.push_back(connected_line);
 	}
 
 	// Find overlapping lines
-	vector<MapLine*> remove_lines;
+	vector<MapLine*>             remove_lines;
+	std::unordered_set<MapLine*> remove_set;
 	for (unsigned a = 0; a < connected_lines_.size(); a++)
 	{
 		auto* line1 = connected_lines_[a];
 
 		// Skip if removing already
-		if (VECTOR_EXISTS(remove_lines, line1))
+		if (remove_set.count(line1) > 0)
 			continue;
 
 		for (unsigned l = a + 1; l < connected_lines_.size(); l++)
@@ -1097,14 +1204,15 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 			auto* line2 = connected_lines_[l];
 
 			// Skip if removing already
-			if (VECTOR_EXISTS(remove_lines, line2))
+			if (remove_set.count(line2) > 0)
 				continue;
 
 			if ((line1->vertex1_ == line2->vertex1_ && line1->vertex2_ == line2->vertex2_)
 				|| (line1->vertex1_ == line2->vertex2_ && line1->vertex2_ == line2->vertex1_))
 			{
 				auto* remove_line = mergeOverlappingLines(line2, line1);
-				VECTOR_ADD_UNIQUE(remove_lines, remove_line);
+				if (remove_set.insert(remove_line).second)
+					remove_lines.push_back(remove_line);
 
 				// Don't check against any more lines if we just decided to remove this one
 				if (remove_line == line1)
@@ -1121,7 +1229,7 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 	}
 	for (unsigned a = 0; a < connected_lines_.size(); a++)
 	{
-		if (VECTOR_EXISTS(remove_lines, connected_lines_[a]))
+		if (remove_set.count(connected_lines_[a]) > 0)
 		{
 			connected_lines_[a] = connected_lines_.back();
 			connected_lines_.pop_back();
@@ -1253,11 +1361,16 @@ void SLADEMap::correctSectors(vector<MapLine*> lines, bool existing_only)
 		{
 			edges.emplace_back(line, true);
 			auto mid = line->getPoint(MapObject::Point::Mid);
-			if (sectors().atPos(mid))
+			if (topology_.sectorAt(mid))
 				edges.emplace_back(line, false);
 		}
 	}
 
+	// Index edges by line side, for quick lookup of traced edges below
+	std::map<std::pair<MapLine*, bool>, unsigned> edge_index;
+	for (unsigned a = 0; a < edges.size(); a++)
+		edge_index.emplace(std::make_pair(edges[a].line, edges[a].front), a);
+
 	vector<MapSide*> sides_correct;
 	for (auto& edge : edges)
 	{
@@ -1297,19 +1410,10 @@ void SLADEMap::correctSectors(vector<MapLine*> lines, bool existing_only)
 			auto* line     = builder.edgeLine(b);
 			bool  is_front = builder.edgeIsFront(b);
 
-			bool line_is_ours = false;
-			for (unsigned e = 0; e < edges.size(); e++)
-			{
-				if (edges[e].line == line)
-				{
-					line_is_ours = true;
-					if (edges[e].front == is_front)
-					{
-						edges_in_sector.push_back(e);
-						break;
-					}
-				}
-			}
+			auto edge = edge_index.find({ line, is_front });
+			if (edge != edge_index.end())
+				edges_in_sector.push_back(edge->second);
+			bool line_is_ours = edge != edge_index.end() || edge_index.count({ line, !is_front }) > 0;
 
 			if (line_is_ours)
 			{
@@ -1613,3 +1717,13 @@ int SLADEMap::thingTypeUsageCount(int type)
 {
 	return usage_thing_type_[type];
 }
+
+// -----------------------------------------------------------------------------
+// Recounts the usage of each thing type in the map
+// -----------------------------------------------------------------------------
+void SLADEMap::countThingTypeUsage()
+{
+	usage_thing_type_.clear();
+	for (auto* thing : data_.things())
+		usage_thing_type_[thing->type()]++;
+}
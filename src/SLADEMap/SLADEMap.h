@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include "MapGeometrySnapshot.h"
 #include "MapObjectCollection.h"
 #include "MapSpecials.h"
+#include "MapTopology.h"
 
 namespace slade
 {
@@ -15,6 +17,14 @@ namespace Game
 class SLADEMap
 {
 public:
+	// Time taken by a stage of opening the map
+	struct OpenStage
+	{
+		string name;
+		double duration_ms;
+		bool   concurrent; // Ran at the same time as the previous stage
+	};
+
 	// Map entry ordering
 	enum MapEntries
 	{
@@ -35,9 +45,13 @@ public:
 	long                       geometryUpdated() const { return geometry_updated_; }
 	long                       thingsUpdated() const { return things_updated_; }
 	const MapObjectCollection& mapData() const { return data_; }
+	const vector<OpenStage>&   openStages() const { return open_stages_; }
+	MapTopology&               topology() { return topology_; }
+	const MapGeometrySnapshot& geometry();
 
 	void setGeometryUpdated();
 	void setThingsUpdated();
+	void objectModified(MapObject* object) { data_.objectModified(object); }
 
 	// MapObject access
 	MapVertex*        vertex(unsigned index) const { return data_.vertices().at(index); }
@@ -125,7 +139,12 @@ public:
 	// Misc. map data access
 	void rebuildConnectedLines() { data_.rebuildConnectedLines(); }
 	void rebuildConnectedSides() { data_.rebuildConnectedSides(); }
-	void restoreObjectIdList(MapObject::Type type, vector<unsigned>& list) { data_.restoreObjectIdList(type, list); }
+	void restoreObjectIdList(MapObject::Type type, vector<unsigned>& list)
+	{
+		data_.restoreObjectIdList(type, list);
+		topology_.invalidate();
+		map_specials_.invalidateSlopeSources();
+	}
 
 	// Convert
 	bool convertToHexen() const;
@@ -135,15 +154,19 @@ public:
 	void clearThingTypeUsage() { usage_thing_type_.clear(); }
 	void updateThingTypeUsage(int type, int adjust);
 	int  thingTypeUsageCount(int type);
+	void countThingTypeUsage();
 
 private:
 	MapObjectCollection data_;
+	MapTopology         topology_{ this };
+	MapGeometrySnapshot geometry_{ this };
 	string              udmf_namespace_;
 	PropertyList        udmf_props_;
 	string              name_;
 	MapFormat           current_format_;
 	long                opened_time_ = 0;
 	MapSpecials         map_specials_;
+	vector<OpenStage>   open_stages_;
 
 	vector<ArchiveEntry*> udmf_extra_entries_; // UDMF Extras
 
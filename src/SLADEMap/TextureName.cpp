@@ -0,0 +1,193 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureName.cpp
+// Description: TextureName class - a texture/flat name interned in a global
+//              atom table, so map sides and sectors can store and compare
+//              texture names as compact ids rather than strings
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureName.h"
+#include "Utility/StringUtils.h"
+#include <mutex>
+#include <unordered_map>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+struct Atom
+{
+	string   name;
+	unsigned key = 0;
+};
+
+constexpr unsigned CHUNK_SIZE = 4096;
+constexpr unsigned MAX_CHUNKS = 4096;
+
+// Atoms are stored in fixed-size chunks that are never moved or freed, so a
+// name can be looked up from its id without locking. Only interning a new
+// name needs the lock
+struct AtomTable
+{
+	std::mutex                                mutex;
+	std::unordered_map<string_view, unsigned> ids; // Views into the atom names
+	unique_ptr<Atom[]>                        chunks[MAX_CHUNKS];
+	unsigned                                  count = 0;
+
+	AtomTable() { add("", 0); }
+
+	Atom& atom(unsigned id) const { return chunks[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+	unsigned add(string_view name, unsigned key)
+	{
+		if (count == CHUNK_SIZE * MAX_CHUNKS)
+		{
+			log::error("Texture name table is full, can't add \"{}\"", name);
+			return 0;
+		}
+
+		auto& chunk = chunks[count / CHUNK_SIZE];
+		if (!chunk)
+			chunk.reset(new Atom[CHUNK_SIZE]);
+
+		auto  id    = count;
+		auto& entry = chunk[id % CHUNK_SIZE];
+		entry.name  = name;
+		entry.key   = key;
+
+		ids[entry.name] = id;
+		++count;
+
+		return id;
+	}
+
+	unsigned find(string_view name) const
+	{
+		auto i = ids.find(name);
+		return i != ids.end() ? i->second : count;
+	}
+};
+
+// The table is never destroyed, since texture names may outlive any static
+// object it could be destroyed with
+AtomTable& atomTable()
+{
+	static auto table = new AtomTable;
+	return *table;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureName Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the key of the name (the id of its upper-case version), for
+// case-insensitive comparisons
+// -----------------------------------------------------------------------------
+unsigned TextureName::key() const
+{
+	return atomTable().atom(id_).key;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the name as a string
+// -----------------------------------------------------------------------------
+const string& TextureName::str() const
+{
+	return atomTable().atom(id_).name;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the id of [name] in the atom table, adding it (and its upper-case
+// version) if it isn't already there
+// -----------------------------------------------------------------------------
+unsigned TextureName::intern(string_view name)
+{
+	if (name.empty())
+		return 0;
+
+	auto& table = atomTable();
+
+	std::lock_guard lock(table.mutex);
+
+	auto id = table.find(name);
+	if (id < table.count)
+		return id;
+
+	// Add the upper-case version first so the key is known
+	auto upper = strutil::upper(name);
+	auto key   = table.find(upper);
+	if (key == table.count)
+		key = table.add(upper, table.count);
+
+	return upper == name ? key : table.add(name, key);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the key of [name] if it (in any case) is in the atom table, without
+// adding it. Returns nothing if the name has never been interned
+// -----------------------------------------------------------------------------
+std::optional<unsigned> TextureName::findKey(string_view name)
+{
+	if (name.empty())
+		return 0;
+
+	auto  upper = strutil::upper(name);
+	auto& table = atomTable();
+
+	std::lock_guard lock(table.mutex);
+
+	auto key = table.find(upper);
+	if (key == table.count)
+		return std::nullopt;
+
+	return key;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of names in the atom table
+// -----------------------------------------------------------------------------
+unsigned TextureName::count()
+{
+	auto& table = atomTable();
+
+	std::lock_guard lock(table.mutex);
+	return table.count;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace slade
+{
+// An interned texture/flat name. Each distinct name is stored once in a global
+// table and referred to by a compact id, so copying and comparing names is an
+// integer operation. Names keep their original case, and each also has a key
+// (the id of the upper-case name) for case-insensitive comparisons and lookups
+class TextureName
+{
+public:
+	TextureName() = default;
+	explicit TextureName(string_view name) : id_{ intern(name) } {}
+
+	unsigned      id() const { return id_; }
+	unsigned      key() const;
+	const string& str() const;
+	bool          empty() const { return id_ == 0; }
+
+	bool equalCI(const TextureName& other) const { return key() == other.key(); }
+
+	bool operator==(const TextureName& rhs) const { return id_ == rhs.id_; }
+	bool operator!=(const TextureName& rhs) const { return id_ != rhs.id_; }
+
+	static unsigned                intern(string_view name);
+	static unsigned                keyOf(string_view name) { return TextureName{ name }.key(); }
+	static std::optional<unsigned> findKey(string_view name);
+	static unsigned                count();
+
+private:
+	unsigned id_ = 0; // 0 is always the empty name
+};
+} // namespace slade
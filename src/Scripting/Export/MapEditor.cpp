@@ -33,6 +33,9 @@
 #include "Main.h"
 #include "Game/Configuration.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/Renderer/MapRenderer3D.h"
+#include "MapEditor/Renderer/Renderer.h"
+#include "MapEditor/UI/MapCanvas.h"
 #include "SLADEMap/MapObject/MapObject.h"
 #include "Scripting/Lua.h"
 #include "thirdparty/sol/sol.hpp"
@@ -136,6 +139,44 @@ void setEditMode(
 		self.setSectorEditMode(sector_mode);
 }
 
+// -----------------------------------------------------------------------------
+// Casts a ray from [x,y,z] in direction [dx,dy,dz] in the 3d mode view of the
+// map editor [self]. Returns the object hit (side, sector or thing), the part
+// of it that was hit and the distance to it, or nil if nothing was hit
+// -----------------------------------------------------------------------------
+std::tuple<MapObject*, string, double> castRay3d(
+	MapEditContext& self,
+	double          x,
+	double          y,
+	double          z,
+	double          dx,
+	double          dy,
+	double          dz,
+	sol::this_state state)
+{
+	using mapeditor::ItemType;
+
+	if (dx == 0. && dy == 0. && dz == 0.)
+		luaL_error(state, "CastRay3d: direction can't be zero length");
+
+	// Picking can update the 3d renderer's cached walls and things, which may
+	// create textures, so the map canvas' GL context must be current
+	if (!self.canvas() || !self.canvas()->setActive())
+		return { nullptr, "", -1. };
+
+	auto hit = self.renderer().renderer3D().castRay({ x, y, z }, { dx, dy, dz });
+	switch (hit.item.type)
+	{
+	case ItemType::WallTop: return { hit.item.asSide(self.map()), "upper", hit.distance };
+	case ItemType::WallMiddle: return { hit.item.asSide(self.map()), "middle", hit.distance };
+	case ItemType::WallBottom: return { hit.item.asSide(self.map()), "lower", hit.distance };
+	case ItemType::Floor: return { hit.item.asSector(self.map()), "floor", hit.distance };
+	case ItemType::Ceiling: return { hit.item.asSector(self.map()), "ceiling", hit.distance };
+	case ItemType::Thing: return { hit.item.asThing(self.map()), "thing", hit.distance };
+	default: return { nullptr, "", -1. };
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Registers the MapEditor type with lua
 // -----------------------------------------------------------------------------
@@ -184,6 +225,7 @@ void registerMapEditor(sol::state& lua)
 		[](MapEditContext& self, mapeditor::Mode mode, mapeditor::SectorMode sector_mode) {
 			setEditMode(self, mode, sector_mode);
 		});
+	lua_mapeditor["CastRay3d"] = &castRay3d;
 }
 
 // -----------------------------------------------------------------------------
@@ -294,8 +336,8 @@ void registerMapSector(sol::state& lua)
 
 	// Properties
 	// -------------------------------------------------------------------------
-	lua_sector["textureFloor"]   = sol::property([](MapSector& self) { return self.floor().texture; });
-	lua_sector["textureCeiling"] = sol::property([](MapSector& self) { return self.ceiling().texture; });
+	lua_sector["textureFloor"]   = sol::property([](MapSector& self) { return self.floor().texture.str(); });
+	lua_sector["textureCeiling"] = sol::property([](MapSector& self) { return self.ceiling().texture.str(); });
 	lua_sector["heightFloor"]    = sol::property([](MapSector& self) { return self.floor().height; });
 	lua_sector["heightCeiling"]  = sol::property([](MapSector& self) { return self.ceiling().height; });
 	lua_sector["lightLevel"]     = sol::property(&MapSector::lightLevel);
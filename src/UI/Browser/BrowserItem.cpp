@@ -140,8 +140,9 @@ void BrowserItem::draw(
 	if (blank_)
 		return;
 
-	// Try to load image if it isn't already
-	if (!image_tex_ || (image_tex_ && !gl::Texture::isLoaded(image_tex_)))
+	// Try to load image if it isn't already (or is still loading)
+	if (!image_tex_ || (image_tex_ && !gl::Texture::isLoaded(image_tex_))
+		|| image_tex_ == gl::Texture::loadingTexture())
 		loadImage();
 
 	// If it still isn't just draw a red box with an X
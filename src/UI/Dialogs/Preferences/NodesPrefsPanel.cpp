@@ -45,6 +45,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 EXTERN_CVAR(String, nodebuilder_id)
 EXTERN_CVAR(String, nodebuilder_options)
+EXTERN_CVAR(Bool, nodebuilder_builtin_test_run)
 
 
 // -----------------------------------------------------------------------------
@@ -89,6 +90,10 @@ NodesPrefsPanel::NodesPrefsPanel(wxWindow* parent, bool useframe) : PrefsPanelBa
 	clb_options_ = new wxCheckListBox(this, -1, wxDefaultPosition, wxDefaultSize);
 	sizer->Add(wxutil::createLabelVBox(this, "Options:", clb_options_), { 2, 0 }, { 1, 3 }, wxEXPAND);
 
+	// Use built-in nodebuilder for test runs
+	cb_builtin_test_run_ = new wxCheckBox(this, -1, "Use the built-in node builder (fast mode) when running maps");
+	sizer->Add(cb_builtin_test_run_, { 3, 0 }, { 1, 3 }, wxEXPAND);
+
 	sizer->AddGrowableCol(1, 1);
 	sizer->AddGrowableRow(2, 1);
 
@@ -99,6 +104,7 @@ NodesPrefsPanel::NodesPrefsPanel(wxWindow* parent, bool useframe) : PrefsPanelBa
 	// Init
 	choice_nodebuilder_->Select(sel);
 	populateOptions(nodebuilder_options);
+	cb_builtin_test_run_->SetValue(nodebuilder_builtin_test_run);
 }
 
 // -----------------------------------------------------------------------------
@@ -117,6 +123,7 @@ void NodesPrefsPanel::init()
 	}
 	choice_nodebuilder_->Select(sel);
 	populateOptions(nodebuilder_options);
+	cb_builtin_test_run_->SetValue(nodebuilder_builtin_test_run);
 }
 
 // -----------------------------------------------------------------------------
@@ -127,7 +134,7 @@ void NodesPrefsPanel::populateOptions(const wxString& options) const
 {
 	// Get current builder
 	auto& builder = nodebuilders::builder(choice_nodebuilder_->GetSelection());
-	btn_browse_path_->Enable(builder.id != "none");
+	btn_browse_path_->Enable(builder.id != "none" && builder.id != "builtin");
 
 	// Set builder path
 	text_path_->SetValue(builder.path);
@@ -163,7 +170,8 @@ void NodesPrefsPanel::applyPreferences()
 			opt += " ";
 		}
 	}
-	nodebuilder_options = opt;
+	nodebuilder_options          = opt;
+	nodebuilder_builtin_test_run = cb_builtin_test_run_->GetValue();
 }
 
 
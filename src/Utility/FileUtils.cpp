@@ -35,6 +35,14 @@
 #include "FileUtils.h"
 #include <filesystem>
 #include <fstream>
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace slade;
 namespace fs = std::filesystem;
@@ -324,3 +332,101 @@ bool SFile::writeStr(string_view str) const
 
 	return false;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Maps the file at [path] into memory (read-only).
+// Returns false if the file couldn't be opened or mapped, or is empty
+// -----------------------------------------------------------------------------
+bool MappedFile::open(const string& path)
+{
+	// Needs to be closed first if already open
+	if (data_)
+		return false;
+
+#ifdef __WXMSW__
+	file_ = CreateFileW(
+		fs::path{ path }.wstring().c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		file_ = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart == 0 || file_size.HighPart != 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_)
+		data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_)
+	{
+		close();
+		return false;
+	}
+
+	size_ = file_size.LowPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// The mapping stays valid after the file descriptor is closed
+	auto mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	data_ = static_cast<const uint8_t*>(mapped);
+	size_ = file_stat.st_size;
+#endif
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Unmaps and closes the file
+// -----------------------------------------------------------------------------
+void MappedFile::close()
+{
+#ifdef __WXMSW__
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_)
+		CloseHandle(file_);
+	mapping_ = nullptr;
+	file_    = nullptr;
+#else
+	if (data_)
+		munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
@@ -55,4 +55,31 @@ private:
 	FILE*       handle_ = nullptr;
 	struct stat stat_;
 };
+
+// Read-only view of a whole file mapped into memory
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const string& path) { open(path); }
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&)            = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool           isOpen() const { return data_ != nullptr; }
+	const uint8_t* data() const { return data_; }
+	unsigned       size() const { return size_; }
+
+	bool open(const string& path);
+	void close();
+
+private:
+	const uint8_t* data_ = nullptr;
+	unsigned       size_ = 0;
+#ifdef __WXMSW__
+	void* file_    = nullptr;
+	void* mapping_ = nullptr;
+#endif
+};
 } // namespace slade
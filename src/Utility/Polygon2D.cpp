@@ -7,8 +7,8 @@
 // Web:         http://slade.mancubus.net
 // Filename:    Polygon2D.cpp
 // Description: Polygon2D and related classes for representing and handling a
-//              2-dimensional polygon, including PolygonSplitter class which
-//              splits a polygon into multiple convex sub-polygons
+//              2-dimensional polygon, including Triangulator class which
+//              splits a sector's outlines into an indexed triangle list
 //
 // This program is free software; you can redistribute it and/or modify it
 // under the terms of the GNU General Public License as published by the Free
@@ -41,6 +41,38 @@
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Cross products with a magnitude below this are treated as collinear
+constexpr double COLLINEAR_EPSILON = 1e-9;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+double cross(const Vec2d& a, const Vec2d& b, const Vec2d& c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+bool pointInTriangle(const Vec2d& p, const Vec2d& a, const Vec2d& b, const Vec2d& c)
+{
+	// Triangle [a,b,c] is counter-clockwise, points on an edge count as inside
+	return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Polygon2D Class Functions
@@ -58,62 +90,25 @@ void Polygon2D::setColour(float r, float g, float b, float a)
 
 void Polygon2D::setZ(float z)
 {
-	// Go through all sub-polys
-	for (auto& subpoly : subpolys_)
-	{
-		// Set all vertex z values
-		for (auto& v : subpoly.vertices)
-			v.z = z;
-	}
+	for (auto& v : vertices_)
+		v.z = z;
 }
 
 void Polygon2D::setZ(Plane plane)
 {
-	// Go through all sub-polys
-	for (auto& subpoly : subpolys_)
-	{
-		// Set all vertex z values
-		for (auto& v : subpoly.vertices)
-			v.z = plane.heightAt(v.x, v.y);
-	}
-}
-
-void Polygon2D::addSubPoly()
-{
-	subpolys_.emplace_back();
-	vbo_update_ = 2;
-}
-
-Polygon2D::SubPoly* Polygon2D::subPoly(unsigned index)
-{
-	return index >= subpolys_.size() ? nullptr : &subpolys_[index];
-}
-
-void Polygon2D::removeSubPoly(unsigned index)
-{
-	if (index >= subpolys_.size())
-		return;
-
-	subpolys_.erase(subpolys_.begin() + index);
-
-	vbo_update_ = 2;
+	for (auto& v : vertices_)
+		v.z = plane.heightAt(v.x, v.y);
 }
 
 void Polygon2D::clear()
 {
-	subpolys_.clear();
+	vertices_.clear();
+	indices_.clear();
+	vbo_indices_.clear();
 	vbo_update_ = 2;
 	texture_    = 0;
 }
 
-unsigned Polygon2D::totalVertices()
-{
-	unsigned total = 0;
-	for (auto& subpoly : subpolys_)
-		total += subpoly.vertices.size();
-	return total;
-}
-
 bool Polygon2D::openSector(MapSector* sector)
 {
 	// Check sector was given
@@ -121,31 +116,21 @@ bool Polygon2D::openSector(MapSector* sector)
 		return false;
 
 	// Init
-	PolygonSplitter splitter;
 	clear();
+	geometry_version_ = sector->geometryVersion();
 
-	// Get list of sides connected to this sector
-	auto& sides = sector->connectedSides();
-
-	// Go through sides
-	MapLine* line;
-	for (auto& side : sides)
-	{
-		line = side->parentLine();
+	// Triangulate the sector outlines
+	Triangulator triangulator;
+	triangulator.addSectorEdges(sector);
+	bool ok = triangulator.triangulate();
 
-		// Ignore this side if its parent line has the same sector on both sides
-		if (!line || line->doubleSector())
-			continue;
+	// Copy triangle list
+	vertices_.reserve(triangulator.vertices().size());
+	for (auto& v : triangulator.vertices())
+		vertices_.emplace_back(v.x, v.y, 0.0f);
+	indices_ = triangulator.indices();
 
-		// Add the edge to the splitter (direction depends on what side of the line this is)
-		if (line->s1() == side)
-			splitter.addEdge(line->v1()->xPos(), line->v1()->yPos(), line->v2()->xPos(), line->v2()->yPos());
-		else
-			splitter.addEdge(line->v2()->xPos(), line->v2()->yPos(), line->v1()->xPos(), line->v1()->yPos());
-	}
-
-	// Split the polygon into convex sub-polygons
-	return splitter.doSplitting(this);
+	return ok;
 }
 
 void Polygon2D::updateTextureCoords(double scale_x, double scale_y, double offset_x, double offset_y, double rotation)
@@ -173,71 +158,56 @@ void Polygon2D::updateTextureCoords(double scale_x, double scale_y, double offse
 
 	// Set texture coordinates
 	double x, y;
-	for (auto& subpoly : subpolys_)
+	for (auto& v : vertices_)
 	{
-		for (auto& v : subpoly.vertices)
-		{
-			x = v.x;
-			y = v.y;
+		x = v.x;
+		y = v.y;
 
-			// Apply rotation if any
-			if (rotation != 0)
-			{
-				Vec2d np = math::rotatePoint(Vec2d(0, 0), Vec2d(x, y), rotation);
-				x        = np.x;
-				y        = np.y;
-			}
+		// Apply rotation if any
+		if (rotation != 0)
+		{
+			Vec2d np = math::rotatePoint(Vec2d(0, 0), Vec2d(x, y), rotation);
+			x        = np.x;
+			y        = np.y;
+		}
 
-			x = (scale_x * offset_x) + x;
-			y = (scale_y * offset_y) - y;
+		x = (scale_x * offset_x) + x;
+		y = (scale_y * offset_y) - y;
 
-			// Set texture coordinate for vertex
-			v.tx = x * owidth;
-			v.ty = y * oheight;
-		}
+		// Set texture coordinate for vertex
+		v.tx = x * owidth;
+		v.ty = y * oheight;
 	}
 
 	// Update variables
 	vbo_update_ = 1;
 }
 
-unsigned Polygon2D::vboDataSize()
+// Appends the polygon vertex data to [buffer], which is to be uploaded as-is
+// to a VBO, and returns the number of vertices in [buffer] afterwards
+unsigned Polygon2D::writeToBuffer(vector<Vertex>& buffer)
 {
-	unsigned total = 0;
-	for (auto& subpoly : subpolys_)
-		total += subpoly.vertices.size() * 20;
-	return total;
-}
+	// Update the vbo location
+	unsigned index = buffer.size();
+	vbo_offset_    = index * sizeof(Vertex);
 
-unsigned Polygon2D::writeToVBO(unsigned offset, unsigned index)
-{
-	// Go through subpolys
-	unsigned ofs = offset;
-	unsigned i   = index;
-	for (auto& subpoly : subpolys_)
-	{
-		// Write subpoly data to VBO at the correct offset
-		glBufferSubData(GL_ARRAY_BUFFER, ofs, subpoly.vertices.size() * 20, subpoly.vertices.data());
-
-		// Update the subpoly vbo offset
-		subpoly.vbo_offset = ofs;
-		subpoly.vbo_index  = i;
-		ofs += subpoly.vertices.size() * 20;
-		i += subpoly.vertices.size();
-	}
+	// Offset triangle indices to the polygon's location in the VBO
+	vbo_indices_.resize(indices_.size());
+	for (unsigned a = 0; a < indices_.size(); a++)
+		vbo_indices_[a] = indices_[a] + index;
+
+	// Add vertex data
+	buffer.insert(buffer.end(), vertices_.begin(), vertices_.end());
 
 	// Update variables
 	vbo_update_ = 0;
 
-	// Return the offset to the end of the data
-	return ofs;
+	return buffer.size();
 }
 
 void Polygon2D::updateVBOData()
 {
-	// Go through subpolys
-	for (auto& subpoly : subpolys_)
-		glBufferSubData(GL_ARRAY_BUFFER, subpoly.vbo_offset, subpoly.vertices.size() * 20, subpoly.vertices.data());
+	glBufferSubData(GL_ARRAY_BUFFER, vbo_offset_, vboDataSize(), vertices_.data());
 
 	// Update variables
 	vbo_update_ = 0;
@@ -245,48 +215,45 @@ void Polygon2D::updateVBOData()
 
 void Polygon2D::render()
 {
-	// Go through sub-polys
-	for (auto& poly : subpolys_)
+	glBegin(GL_TRIANGLES);
+	for (auto i : indices_)
 	{
-		glBegin(GL_TRIANGLE_FAN);
-		for (auto& v : poly.vertices)
-		{
-			glTexCoord2f(v.tx, v.ty);
-			glVertex3d(v.x, v.y, v.z);
-		}
-		glEnd();
+		auto& v = vertices_[i];
+		glTexCoord2f(v.tx, v.ty);
+		glVertex3d(v.x, v.y, v.z);
 	}
+	glEnd();
 }
 
 void Polygon2D::renderWireframe()
 {
-	// Go through sub-polys
-	for (auto& poly : subpolys_)
+	// Draw each triangle's edges
+	glBegin(GL_LINES);
+	for (unsigned a = 0; a + 2 < indices_.size(); a += 3)
 	{
-		glBegin(GL_LINE_LOOP);
-		for (auto& v : poly.vertices)
+		for (unsigned e = 0; e < 3; e++)
 		{
-			glTexCoord2f(v.tx, v.ty);
-			glVertex2d(v.x, v.y);
+			auto& v1 = vertices_[indices_[a + e]];
+			auto& v2 = vertices_[indices_[a + (e + 1) % 3]];
+			glVertex2d(v1.x, v1.y);
+			glVertex2d(v2.x, v2.y);
 		}
-		glEnd();
 	}
+	glEnd();
 }
 
 void Polygon2D::renderVBO(bool colour)
 {
-	// Render
-	// glColor4f(this->colour[0], this->colour[1], this->colour[2], this->colour[3]);
-	for (const auto& subpoly : subpolys_)
-		glDrawArrays(GL_TRIANGLE_FAN, subpoly.vbo_index, subpoly.vertices.size());
+	if (!vbo_indices_.empty())
+		glDrawElements(GL_TRIANGLES, vbo_indices_.size(), GL_UNSIGNED_INT, vbo_indices_.data());
 }
 
 void Polygon2D::renderWireframeVBO(bool colour) const {}
 
 void Polygon2D::setupVBOPointers()
 {
-	glVertexPointer(3, GL_FLOAT, 20, nullptr);
-	glTexCoordPointer(2, GL_FLOAT, 20, ((char*)nullptr + 12));
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), nullptr);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), ((char*)nullptr + 12));
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	glDisableClientState(GL_COLOR_ARRAY);
@@ -295,787 +262,510 @@ void Polygon2D::setupVBOPointers()
 
 // -----------------------------------------------------------------------------
 //
-// PolygonSplitter Class Functions
+// Triangulator Class Functions
+//
+// Builds a triangle list from a set of directed edges with the polygon interior
+// on their right (as with the sides of a sector). The edges are traced into
+// closed loops, which are classified as outer boundaries (clockwise) or holes
+// (anticlockwise). Each hole is bridged into the outer boundary containing it
+// and the resulting simple polygon is ear-clipped.
 //
 // -----------------------------------------------------------------------------
 
 
-void PolygonSplitter::clear()
+void Triangulator::clear()
 {
 	vertices_.clear();
+	edges_out_.clear();
 	edges_.clear();
-	polygon_outlines_.clear();
+	vertex_map_.clear();
+	edge_set_.clear();
+	indices_.clear();
 }
 
-int PolygonSplitter::addVertex(double x, double y)
+int Triangulator::addVertex(double x, double y)
 {
 	// Check vertex doesn't exist
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		if (vertices_[a].x == x && vertices_[a].y == y)
-			return a;
-	}
+	auto existing = vertex_map_.find({ x, y });
+	if (existing != vertex_map_.end())
+		return existing->second;
 
 	// Add vertex
 	vertices_.emplace_back(x, y);
-	vertices_.back().distance = 999999;
+	edges_out_.emplace_back();
+	vertex_map_[{ x, y }] = vertices_.size() - 1;
 	return vertices_.size() - 1;
 }
 
-int PolygonSplitter::addEdge(double x1, double y1, double x2, double y2)
+void Triangulator::addEdge(double x1, double y1, double x2, double y2)
 {
 	// Add edge vertices
 	int v1 = addVertex(x1, y1);
 	int v2 = addVertex(x2, y2);
 
-	// Add edge
-	return addEdge(v1, v2);
-}
-
-int PolygonSplitter::addEdge(int v1, int v2)
-{
-	// Check for duplicate edge
-	for (unsigned a = 0; a < edges_.size(); a++)
-	{
-		if (edges_[a].v1 == v1 && edges_[a].v2 == v2)
-			return a;
-	}
+	// Ignore zero-length and duplicate edges
+	if (v1 == v2 || !edge_set_.insert({ v1, v2 }).second)
+		return;
 
-	// Create edge
-	Edge edge;
-	edge.v1     = v1;
-	edge.v2     = v2;
-	edge.ok     = true;
-	edge.done   = false;
-	edge.inpoly = false;
-	edge.sister = -1;
-
-	// Add edge to list
-	edges_.push_back(edge);
-
-	// Add edge to its vertices' edge lists (heh)
-	int index = edges_.size() - 1;
-	vertices_[v1].edges_out.push_back(index);
-	vertices_[v2].edges_in.push_back(index);
-
-	// Return edge index
-	return index;
+	// Add edge
+	edges_.push_back({ v1, v2, false });
+	edges_out_[v1].push_back(edges_.size() - 1);
 }
 
-int PolygonSplitter::findNextEdge(int edge, bool ignore_done, bool only_convex, bool ignore_inpoly)
+void Triangulator::addSectorEdges(MapSector* sector)
 {
-	auto& e  = edges_[edge];
-	auto& v2 = vertices_[e.v2];
-	auto& v1 = vertices_[e.v1];
+	// Check sector was given
+	if (!sector)
+		return;
 
-	// Go through all edges starting from the end of this one
-	double min_angle = 2 * math::PI;
-	int    next      = -1;
-	for (unsigned a = 0; a < v2.edges_out.size(); a++)
+	// Go through sides
+	for (auto& side : sector->connectedSides())
 	{
-		auto& out = edges_[v2.edges_out[a]];
-
-		// Ignore 'done' edges
-		if (ignore_done && edges_[v2.edges_out[a]].done)
-			continue;
+		auto line = side->parentLine();
 
-		// Ignore 'inpoly' edges
-		if (ignore_inpoly && edges_[v2.edges_out[a]].inpoly)
-			continue;
-
-		// Ignore edges on the reverse-side of this
-		if (out.v1 == e.v2 && out.v2 == e.v1)
-			continue;
-
-		// Ignore invalid edges
-		if (!out.ok)
+		// Ignore this side if its parent line has the same sector on both sides
+		if (!line || line->doubleSector())
 			continue;
 
-		// Determine angle between edges
-		double angle = math::angle2DRad(
-			Vec2d(v1.x, v1.y), Vec2d(v2.x, v2.y), Vec2d(vertices_[out.v2].x, vertices_[out.v2].y));
-		if (angle < min_angle)
-		{
-			min_angle = angle;
-			next      = v2.edges_out[a];
-		}
+		// Add the edge (direction depends on what side of the line this is)
+		if (line->s1() == side)
+			addEdge(line->v1()->xPos(), line->v1()->yPos(), line->v2()->xPos(), line->v2()->yPos());
+		else
+			addEdge(line->v2()->xPos(), line->v2()->yPos(), line->v1()->xPos(), line->v1()->yPos());
 	}
-
-	last_angle_ = min_angle;
-	return only_convex && min_angle > math::PI ? -1 : next;
 }
 
-void PolygonSplitter::flipEdge(int edge)
+bool Triangulator::triangulate()
 {
-	auto& e  = edges_[edge];
-	auto& v1 = vertices_[e.v1];
-	auto& v2 = vertices_[e.v2];
+	indices_.clear();
 
-	// Remove the edge from its vertices' edge lists
-	for (unsigned a = 0; a < v1.edges_out.size(); a++)
+	// Trace edges into closed loops
+	vector<Loop> loops;
+	traceLoops(loops);
+
+	// Sort loops into outer boundaries and holes
+	vector<Loop>   outers;
+	vector<double> outer_areas;
+	vector<Loop>   holes;
+	for (auto& loop : loops)
 	{
-		if (v1.edges_out[a] == edge)
+		double area = signedArea(loop);
+		if (area < -COLLINEAR_EPSILON)
 		{
-			v1.edges_out.erase(v1.edges_out.begin() + a);
-			break;
+			// Clockwise - outer boundary, reverse to anticlockwise for clipping
+			std::reverse(loop.begin(), loop.end());
+			outers.push_back(loop);
+			outer_areas.push_back(-area);
 		}
-	}
-	for (unsigned a = 0; a < v2.edges_in.size(); a++)
-	{
-		if (v2.edges_in[a] == edge)
+		else if (area > COLLINEAR_EPSILON)
 		{
-			v2.edges_in.erase(v2.edges_in.begin() + a);
-			break;
+			// Anticlockwise - hole, reverse to clockwise for bridging
+			std::reverse(loop.begin(), loop.end());
+			holes.push_back(loop);
 		}
 	}
 
-	// Flip the edge
-	int temp = e.v2;
-	e.v2     = e.v1;
-	e.v1     = temp;
-
-	// Add the edge to its new vertices' edge lists
-	v1.edges_in.push_back(edge);
-	v2.edges_out.push_back(edge);
-}
-
-void PolygonSplitter::detectConcavity()
-{
-	concave_edges_.clear();
-
-	// Go through all edges
-	for (unsigned a = 0; a < edges_.size(); a++)
+	// If there are no outer boundaries the sector sides are most likely the
+	// wrong way around, so treat the holes as outer boundaries instead
+	if (outers.empty())
 	{
-		if (!edges_[a].ok)
-			continue;
-
-		// Find the next edge with the lowest angle (ignore edges with angle > 180)
-		int next = findNextEdge(a, false);
-		if (next < 0)
+		for (auto& hole : holes)
 		{
-			// If no edge with an angle < 180 was found, this edge is concave
-			concave_edges_.push_back(a);
+			std::reverse(hole.begin(), hole.end());
+			outers.push_back(hole);
+			outer_areas.push_back(signedArea(hole));
 		}
-	}
-}
-
-bool PolygonSplitter::detectUnclosed()
-{
-	vector<int> end_verts;
-	vector<int> start_verts;
-
-	// Go through all vertices
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		// If the vertex has no outgoing edges, we have an unclosed polygon
-		if (vertices_[a].edges_out.empty())
-			end_verts.push_back(a);
-		// Same if it has no incoming
-		else if (vertices_[a].edges_in.empty())
-			start_verts.push_back(a);
+		holes.clear();
 	}
 
-	// If there are no end/start vertices, the polygon is closed
-	if (end_verts.empty() && start_verts.empty())
-		return false;
-	else if (verbose_)
+	// Assign each hole to the smallest outer boundary containing it
+	vector<vector<unsigned>> outer_holes(outers.size());
+	for (unsigned h = 0; h < holes.size(); h++)
 	{
-		// Print invalid vertices info if verbose
-		string info = "Vertices with no outgoing edges: ";
-		for (int end_vert : end_verts)
-		{
-			info += fmt::format("{:1.2f}", vertices_[end_vert].x);
-			info += ",";
-			info += fmt::format("{:1.2f}", vertices_[end_vert].y);
-			info += " ";
-		}
-		log::info(info);
-		info = "Vertices with no incoming edges: ";
-		for (int start_vert : start_verts)
+		double hole_area = -signedArea(holes[h]);
+		int    best      = -1;
+		for (unsigned o = 0; o < outers.size(); o++)
 		{
-			info += fmt::format("{:1.2f}", vertices_[start_vert].x);
-			info += ",";
-			info += fmt::format("{:1.2f}", vertices_[start_vert].y);
-			info += " ";
+			if (outer_areas[o] <= hole_area || (best >= 0 && outer_areas[o] >= outer_areas[best]))
+				continue;
+
+			if (loopContains(outers[o], holes[h]))
+				best = o;
 		}
-		log::info(info);
+
+		if (best >= 0)
+			outer_holes[best].push_back(h);
+		else if (verbose_)
+			log::info("Triangulator: Hole {} is not within any outer boundary, ignoring", h);
 	}
 
-	// Check if any of this is caused by flipped edges
-	for (int end_vert : end_verts)
+	// Bridge holes and clip each outer boundary
+	for (unsigned o = 0; o < outers.size(); o++)
 	{
-		auto& ev = vertices_[end_vert];
+		auto& ring = outers[o];
 
-		// Check all the edges coming out of this vertex,
-		// and see if any go into another 'unattacted' vertex
-		for (int e : ev.edges_in)
+		// Bridge holes, rightmost first
+		auto& hole_list = outer_holes[o];
+		vector<std::pair<double, unsigned>> hole_order;
+		for (auto h : hole_list)
 		{
-			auto& edge = edges_[e];
-
-			bool flipped = false;
-			for (int start_vert : start_verts)
-			{
-				auto& sv = vertices_[start_vert];
-
-				if (edge.v1 == start_vert && edge.v2 == end_vert)
-					flipEdge(e); // Flip the edge
-			}
+			double max_x = vertices_[holes[h][0]].x;
+			for (auto v : holes[h])
+				max_x = std::max(max_x, vertices_[v].x);
+			hole_order.emplace_back(max_x, h);
 		}
-	}
+		std::sort(hole_order.begin(), hole_order.end(), std::greater<>());
+		for (auto& hole : hole_order)
+			bridgeHole(ring, holes[hole.second]);
 
-	// Re-check vertices
-	end_verts.clear();
-	start_verts.clear();
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		if (!vertices_[a].ok)
-			continue;
-
-		// If the vertex has no outgoing edges, we have an unclosed polygon
-		if (vertices_[a].edges_out.empty())
-			end_verts.push_back(a);
-		else if (vertices_[a].edges_in.empty())
-			start_verts.push_back(a);
+		earClip(ring);
 	}
 
-	// If there are no end/start vertices, the polygon is closed
-	if (end_verts.empty() && start_verts.empty())
-		return false;
+	if (verbose_)
+		log::info(
+			"Triangulator: {} outer boundaries, {} holes, {} triangles",
+			outers.size(),
+			holes.size(),
+			indices_.size() / 3);
 
-	// If it still isn't closed, check for completely detached edges and 'remove' them
-	for (auto& edge : edges_)
-	{
-		if (vertices_[edge.v1].edges_in.empty() && vertices_[edge.v2].edges_out.empty())
-		{
-			// Invalidate edge
-			edge.ok = false;
+	compact();
 
-			// Invalidate vertices
-			vertices_[edge.v1].ok = false;
-			vertices_[edge.v2].ok = false;
-		}
-	}
+	return !indices_.empty();
+}
 
-	// Re-check vertices
-	end_verts.clear();
-	start_verts.clear();
-	for (unsigned a = 0; a < vertices_.size(); a++)
+int Triangulator::nextEdge(int edge) const
+{
+	auto& e    = edges_[edge];
+	auto& v    = vertices_[e.v2];
+	auto  back = vertices_[e.v1] - v;
+
+	// Find the unused outgoing edge making the sharpest right turn, which keeps
+	// the traced loop as tight as possible around the interior
+	double min_angle = 0;
+	int    next      = -1;
+	for (auto out : edges_out_[e.v2])
 	{
-		if (!vertices_[a].ok)
+		if (edges_[out].done)
 			continue;
 
-		// If the vertex has no outgoing edges, we have an unclosed polygon
-		if (vertices_[a].edges_out.empty())
-			end_verts.push_back(a);
-		else if (vertices_[a].edges_in.empty())
-			start_verts.push_back(a);
-	}
+		// Get anticlockwise angle from the reverse of this edge to the outgoing
+		// edge (doubling back along the same edge is the last resort)
+		auto   dir   = vertices_[edges_[out].v2] - v;
+		double angle = std::atan2(back.x * dir.y - back.y * dir.x, back.x * dir.x + back.y * dir.y);
+		if (angle <= 0)
+			angle += 2 * math::PI;
 
-	// If there are no end/start vertices, the polygon is closed
-	if (end_verts.empty() && start_verts.empty())
-		return false;
+		if (next < 0 || angle < min_angle)
+		{
+			min_angle = angle;
+			next      = out;
+		}
+	}
 
-	// Not closed
-	return true;
+	return next;
 }
 
-bool PolygonSplitter::tracePolyOutline(int edge_start)
+void Triangulator::traceLoops(vector<Loop>& loops)
 {
-	polygon_outlines_.emplace_back();
-	auto& poly      = polygon_outlines_.back();
-	poly.convex     = true;
-	double edge_sum = 0;
-
-	int edge = edge_start;
-	int v1, v2, next;
-	// while (true) {
-	unsigned a = 0;
-	for (a = 0; a < 100000; a++)
+	for (unsigned a = 0; a < edges_.size(); a++)
 	{
-		v1   = edges_[edge].v1;
-		v2   = edges_[edge].v2;
-		next = -1;
-
-		// Add current edge
-		poly.edges.push_back(edge);
-		if (edge == edge_start)
-			poly.bbox.extend(vertices_[v1].x, vertices_[v1].y);
-		else
-			edges_[edge].inpoly = true;
-		poly.bbox.extend(vertices_[v2].x, vertices_[v2].y);
-		edge_sum += vertices_[v1].x * vertices_[v2].y - vertices_[v2].x * vertices_[v1].y;
-
-		// Find the next edge with the lowest angle
-		next = findNextEdge(edge, true, false, true);
+		if (edges_[a].done)
+			continue;
 
-		// Abort if no next edge was found
-		if (next < 0)
+		// Follow edges until we get back to the start
+		int  start     = edges_[a].v1;
+		Loop loop      = { start };
+		int  edge      = a;
+		bool closed    = false;
+		edges_[a].done = true;
+		while (true)
 		{
-			for (int ei : poly.edges)
-				edges_[ei].inpoly = false;
+			int v = edges_[edge].v2;
+			if (v == start)
+			{
+				closed = true;
+				break;
+			}
+			loop.push_back(v);
 
-			polygon_outlines_.pop_back();
-			return false;
+			edge = nextEdge(edge);
+			if (edge < 0)
+				break;
+			edges_[edge].done = true;
 		}
 
-		// Check for concavity
-		if (last_angle_ > math::PI)
-			poly.convex = false;
-
-		// Stop if we're back at the start
-		if (next == edge_start)
-			break;
+		// An unclosed loop (from a broken sector) is closed implicitly
+		if (!closed && verbose_)
+			log::info("Triangulator: Unclosed loop starting at ({}, {})", vertices_[start].x, vertices_[start].y);
 
-		// Continue loop
-		edge = next;
+		if (loop.size() >= 3)
+			loops.push_back(loop);
 	}
+}
 
-	if (a >= 99999)
+double Triangulator::signedArea(const Loop& loop) const
+{
+	double area = 0;
+	for (unsigned a = 0; a < loop.size(); a++)
 	{
-		if (verbose_)
-			log::info("Possible infinite loop in tracePolyOutline");
-		return false;
+		auto& v1 = vertices_[loop[a]];
+		auto& v2 = vertices_[loop[(a + 1) % loop.size()]];
+		area += v1.x * v2.y - v2.x * v1.y;
 	}
 
-	// Determine if this is an 'outer' (clockwise) or 'inner' (anti-clockwise) polygon
-	poly.clockwise = (edge_sum < 0);
-
-	// Set all polygon edges 'inpoly' to true (so they are ignored when tracing future polylines
-	edges_[edge_start].inpoly = true;
-	// for (unsigned a = 0; a < poly.edges.size(); a++)
-	//	edges[poly.edges[a]].inpoly = true;
+	return area * 0.5;
+}
 
-	if (verbose_)
+bool Triangulator::pointInLoop(const Vec2d& point, const Loop& loop) const
+{
+	bool inside = false;
+	for (unsigned a = 0, b = loop.size() - 1; a < loop.size(); b = a++)
 	{
-		string info = "Traced polygon outline: ";
-		info += fmt::format("{} edges, ", poly.edges.size());
-		if (poly.convex)
-			info += "convex, ";
-		else
-			info += "concave, ";
-		if (poly.clockwise)
-			info += "clockwise";
-		else
-			info += "anticlockwise";
-		log::info(info);
+		auto& v1 = vertices_[loop[a]];
+		auto& v2 = vertices_[loop[b]];
+		if ((v1.y > point.y) != (v2.y > point.y)
+			&& point.x < (v2.x - v1.x) * (point.y - v1.y) / (v2.y - v1.y) + v1.x)
+			inside = !inside;
 	}
 
-	return true;
+	return inside;
 }
 
-bool PolygonSplitter::testTracePolyOutline(int edge_start)
+bool Triangulator::loopContains(const Loop& outer, const Loop& inner) const
 {
-	int      edge = edge_start;
-	int      v1, v2, next;
-	unsigned a = 0;
-	for (a = 0; a < 100000; a++)
-	{
-		v1 = edges_[edge].v1;
-		v2 = edges_[edge].v2;
+	// Test the first vertex of [inner] that isn't shared with [outer]
+	for (auto v : inner)
+		if (std::find(outer.begin(), outer.end(), v) == outer.end())
+			return pointInLoop(vertices_[v], outer);
 
-		// Find the next convex edge with the lowest angle
-		next = findNextEdge(edge, false, true);
-
-		// Abort if no next edge was found
-		if (next < 0)
-			return false;
-
-		// Stop if we're back at the start
-		if (next == edge_start)
-			break;
+	// All vertices are shared, test the middle of the first edge
+	auto& v1 = vertices_[inner[0]];
+	auto& v2 = vertices_[inner[1]];
+	return pointInLoop({ (v1.x + v2.x) * 0.5, (v1.y + v2.y) * 0.5 }, outer);
+}
 
-		// Continue loop
-		edge = next;
-	}
+void Triangulator::bridgeHole(Loop& outer, const Loop& hole) const
+{
+	// Find the rightmost hole vertex
+	unsigned hole_start = 0;
+	for (unsigned a = 1; a < hole.size(); a++)
+		if (vertices_[hole[a]].x > vertices_[hole[hole_start]].x)
+			hole_start = a;
+	auto& m = vertices_[hole[hole_start]];
 
-	if (a >= 99999)
+	// Cast a ray to the right from it and find the nearest outer edge it hits,
+	// the bridge will go to that edge's rightmost vertex
+	int    bridge = -1;
+	double hit_x  = 0;
+	for (unsigned a = 0; a < outer.size(); a++)
 	{
-		if (verbose_)
-			log::info("Possible infinite loop in tracePolyOutline");
-		return false;
-	}
-
-	return true;
-}
+		unsigned b  = (a + 1) % outer.size();
+		auto&    v1 = vertices_[outer[a]];
+		auto&    v2 = vertices_[outer[b]];
+		// The outer loop is anticlockwise, so only upward edges can be hit
+		// from the inside
+		if (v1.y > m.y || v2.y < m.y || v1.y == v2.y)
+			continue;
 
+		double x = v1.x + (m.y - v1.y) * (v2.x - v1.x) / (v2.y - v1.y);
+		if (x < m.x || (bridge >= 0 && x >= hit_x))
+			continue;
 
-struct VDist
-{
-	int    index;
-	double distance;
-	VDist(int index, double distance)
-	{
-		this->index    = index;
-		this->distance = distance;
-	}
-	bool operator<(const VDist& right) const { return distance < right.distance; }
-};
-bool PolygonSplitter::splitFromEdge(int splitter_edge)
-{
-	// Get vertices
-	int v1 = edges_[splitter_edge].v1;
-	int v2 = edges_[splitter_edge].v2;
-
-	// First up, find the closest vertex on the front side of the edge
-	double min_dist = 999999;
-	int    closest  = -1;
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		if (math::lineSide(vertices_[a], Seg2d(vertices_[v1], vertices_[v2])) > 0 && vertices_[a].ok)
+		hit_x  = x;
+		bridge = v1.x > v2.x ? a : b;
+	}
+
+	// Checks if the hole vertex is on the inside of the outer loop at [pos]
+	auto locally_inside = [&](unsigned pos) {
+		auto& v    = vertices_[outer[pos]];
+		auto& prev = vertices_[outer[(pos + outer.size() - 1) % outer.size()]];
+		auto& next = vertices_[outer[(pos + 1) % outer.size()]];
+		if (cross(prev, v, next) > 0)
+			return cross(v, m, next) <= 0 && cross(v, prev, m) <= 0;
+		return cross(v, m, prev) > 0 || cross(v, next, m) > 0;
+	};
+
+	if (bridge >= 0 && vertices_[outer[bridge]].y != m.y)
+	{
+		// If any outer vertices are within the triangle formed by the hole vertex,
+		// the hit point and the bridge vertex, bridge to the one closest in angle
+		// to the ray instead
+		Vec2d  hit(hit_x, m.y);
+		auto   p         = vertices_[outer[bridge]];
+		bool   ccw       = cross(m, hit, p) > 0;
+		double min_angle = -1;
+		for (unsigned a = 0; a < outer.size(); a++)
 		{
-			vertices_[a].distance = math::distance(vertices_[v2], vertices_[a]);
-			if (vertices_[a].distance < min_dist)
+			auto& v = vertices_[outer[a]];
+			if (outer[a] == outer[bridge] || v.x < m.x || !locally_inside(a))
+				continue;
+			if (ccw ? !pointInTriangle(v, m, hit, p) : !pointInTriangle(v, m, p, hit))
+				continue;
+
+			double angle = std::abs(std::atan2(v.y - m.y, v.x - m.x));
+			if (min_angle < 0 || angle < min_angle)
 			{
-				min_dist = vertices_[a].distance;
-				closest  = a;
+				min_angle = angle;
+				bridge    = a;
 			}
 		}
-		else
-			vertices_[a].distance = 999999;
 	}
-
-	// If there's nothing on the front side, something is wrong
-	if (closest == -1)
-		return false;
-
-	// See if we can split to here without crossing anything
-	// (this will be the case most of the time)
-	bool  intersect = false;
-	Vec2d pointi;
-	for (auto& edge : edges_)
+	else
 	{
-		// Ignore edge if adjacent to the vertices we are looking at
-		if (edge.v1 == closest || edge.v2 == closest || edge.v1 == v2 || edge.v2 == v2 || !edge.ok)
-			continue;
-
-		// Intersection test
-		if (math::linesIntersect(
-				Seg2d(vertices_[v2], vertices_[closest]), Seg2d(vertices_[edge.v1], vertices_[edge.v2]), pointi))
+		// Ray didn't hit anything (shouldn't happen), bridge to the nearest vertex
+		double min_dist = 0;
+		for (unsigned a = 0; a < outer.size(); a++)
 		{
-			intersect = true;
-			break;
+			auto   diff = vertices_[outer[a]] - m;
+			double dist = diff.x * diff.x + diff.y * diff.y;
+			if (bridge < 0 || dist < min_dist)
+			{
+				min_dist = dist;
+				bridge   = a;
+			}
 		}
 	}
-	if (!intersect)
-	{
-		// No edge intersections, create split
-		int e1            = addEdge(v2, closest);
-		int e2            = addEdge(closest, v2);
-		edges_[e1].sister = e2;
-		edges_[e2].sister = e1;
-
-		return true;
-	}
-
 
-	// Otherwise, we'll have to find the next closest vertex
-	vector<VDist> sorted_verts;
-
-	// Build a list of potential vertices, ordered by distance
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	// The bridge vertex may appear more than once in the outer loop (if other
+	// holes were already bridged to it), so make sure the right one is used
+	if (!locally_inside(bridge))
 	{
-		if (vertices_[a].distance < 999999)
-			sorted_verts.emplace_back(a, vertices_[a].distance);
-	}
-
-	// Go through potential split vertices, closest first
-	std::sort(sorted_verts.begin(), sorted_verts.end());
-	for (auto& sorted_vertex : sorted_verts)
-	{
-		int   index = sorted_vertex.index;
-		auto& vert  = vertices_[index];
-
-		// Check if a split from the edge to this vertex would cross any other edges
-		intersect = false;
-		for (auto& edge : edges_)
-		{
-			// Ignore edge if adjacent to the vertices we are looking at
-			if (edge.v1 == index || edge.v2 == index || edge.v1 == v2 || edge.v2 == v2 || !edge.ok)
-				continue;
-
-			// Intersection test
-			if (math::linesIntersect(Seg2d(vertices_[v2], vert), Seg2d(vertices_[edge.v1], vertices_[edge.v2]), pointi))
+		for (unsigned a = 0; a < outer.size(); a++)
+			if (outer[a] == outer[bridge] && locally_inside(a))
 			{
-				intersect = true;
+				bridge = a;
 				break;
 			}
-		}
-
-		if (!intersect)
-		{
-			// No edge intersections, create split
-			int e1            = addEdge(v2, index);
-			int e2            = addEdge(index, v2);
-			edges_[e1].sister = e2;
-			edges_[e2].sister = e1;
-
-			return true;
-		}
 	}
 
-	// No split created
-	return false;
+	// Splice the hole into the outer loop at the bridge vertex:
+	// ... bridge, hole[start] ... hole[start - 1], hole[start], bridge ...
+	Loop spliced;
+	spliced.reserve(hole.size() + 2);
+	for (unsigned a = 0; a <= hole.size(); a++)
+		spliced.push_back(hole[(hole_start + a) % hole.size()]);
+	spliced.push_back(outer[bridge]);
+	outer.insert(outer.begin() + bridge + 1, spliced.begin(), spliced.end());
 }
 
-bool PolygonSplitter::buildSubPoly(int edge_start, Polygon2D::SubPoly* poly)
+void Triangulator::earClip(const Loop& ring)
 {
-	// Check polygon was given
-	if (!poly)
-		return false;
+	unsigned remaining = ring.size();
+	if (remaining < 3)
+		return;
 
-	// Loop of death
-	int edge = edge_start;
-	// int v1 = edges[edge].v1;
-	// int v = 0;
-	vector<int> verts;
-	for (unsigned a = 0; a < 1000; a++)
+	// Build linked list of ring positions
+	vector<unsigned> prev(ring.size());
+	vector<unsigned> next(ring.size());
+	for (unsigned a = 0; a < ring.size(); a++)
 	{
-		// Add vertex
-		verts.push_back(edges_[edge].v1);
-
-		// Fill triangle
-		// (doesn't seem to be any kind of performance increase using triangles over
-		//	just rendering a GL_TRIANGLE_FAN polygon, not worth the memory usage increase)
-		// v++;
-		// if (v > 2) {
-		//	verts.push_back(v1);
-		//	verts.push_back(edges[edge].v1);
-		//}
-
-		// Add edge to 'valid' edges list, so it is ignored when building further polygons
-		if (edge != edge_start)
-			edges_[edge].done = true;
-
-		// Get 'next' edge
-		edge = findNextEdge(edge);
-
-		// If no next edge is found, something is wrong, so abort building the polygon
-		if (edge < 0)
-			return false;
-
-		// If we're back at the start, finish
-		if (edge == edge_start)
-			break;
+		prev[a] = a == 0 ? ring.size() - 1 : a - 1;
+		next[a] = a == ring.size() - 1 ? 0 : a + 1;
 	}
 
-	// Set starting edge to valid
-	edges_[edge_start].done = true;
+	auto remove = [&](unsigned pos) {
+		next[prev[pos]] = next[pos];
+		prev[next[pos]] = prev[pos];
+		remaining--;
+	};
 
-	// Check if the polygon is valid
-	if (verts.size() >= 3)
-	{
-		// Allocate polygon vertex data
-		poly->vertices.resize(verts.size());
+	auto is_ear = [&](unsigned p, unsigned c, unsigned n) {
+		auto& a = vertices_[ring[p]];
+		auto& b = vertices_[ring[c]];
+		auto& d = vertices_[ring[n]];
 
-		// Add vertex data to polygon
-		for (unsigned a = 0; a < verts.size(); a++)
+		// Check no other (reflex) vertex is within the triangle
+		for (unsigned pos = next[n]; pos != p; pos = next[pos])
 		{
-			poly->vertices[a].x = vertices_[verts[a]].x;
-			poly->vertices[a].y = vertices_[verts[a]].y;
-		}
-
-		return true;
-	}
-	else
-		return false;
-}
-
-bool PolygonSplitter::doSplitting(Polygon2D* poly)
-{
-	// Init
-	split_edges_start_ = edges_.size();
-
-	// Trace polygon outlines
-	for (unsigned a = 0; a < edges_.size(); a++)
-	{
-		if (edges_[a].inpoly || !edges_[a].ok)
-			continue;
-		tracePolyOutline(a);
-	}
-	if (verbose_)
-		log::info("{} Polygon outlines detected", polygon_outlines_.size());
-
-	// Check if any edges are not part of a polygon outline
-	for (auto& edge : edges_)
-	{
-		if (!edge.inpoly)
-			edge.ok = false; // Invalidate it
-	}
+			int v = ring[pos];
+			if (v == ring[p] || v == ring[c] || v == ring[n])
+				continue;
 
-	// Let's check for some cases where we can 'throw away' edges/vertices from further consideration
-	for (unsigned a = 0; a < polygon_outlines_.size(); a++)
-	{
-		// Check if this polygon intersects with any others
-		bool separate = true;
-		for (unsigned b = 0; b < polygon_outlines_.size(); b++)
-		{
-			if (b == a)
+			auto& pv = vertices_[v];
+			if (cross(vertices_[ring[prev[pos]]], pv, vertices_[ring[next[pos]]]) > 0)
 				continue;
-			auto& bb1 = polygon_outlines_[a].bbox;
-			auto& bb2 = polygon_outlines_[b].bbox;
-			if (!(bb2.min.x > bb1.max.x || bb2.max.x < bb1.min.x || bb2.min.y > bb1.max.y || bb2.max.y < bb1.min.y))
-			{
-				separate = false;
-				break;
-			}
+			if (pointInTriangle(pv, a, b, d))
+				return false;
 		}
 
-		// If the polygon didn't intersect, and is convex and clockwise ('outer')
-		if (separate && polygon_outlines_[a].clockwise && polygon_outlines_[a].convex)
+		return true;
+	};
+
+	// Clip ears until only a triangle is left. If no ear can be found in a
+	// full pass (due to self-intersection or other bad geometry), relax the
+	// rules so that clipping always terminates: first allow clipping any
+	// convex vertex, and finally just drop a vertex
+	unsigned pos   = 0;
+	unsigned stall = 0;
+	unsigned mode  = 0;
+	while (remaining > 3)
+	{
+		unsigned p = prev[pos];
+		unsigned n = next[pos];
+		double   c = cross(vertices_[ring[p]], vertices_[ring[pos]], vertices_[ring[n]]);
+
+		// Drop collinear vertices
+		if (std::abs(c) <= COLLINEAR_EPSILON)
 		{
-			if (verbose_)
-				log::info("Separate, convex polygon exists, cutting (valid)");
-			for (int edge : polygon_outlines_[a].edges)
-			{
-				// Set the edge to 'done' so it is ignored, but still used to build polygons
-				edges_[edge].done = true;
-
-				// If the edge's vertices aren't attached to anything else, also preclude these from later calculations
-				int v1 = edges_[edge].v1;
-				if (vertices_[v1].edges_in.size() == 1 && vertices_[v1].edges_out.size() == 1)
-					vertices_[v1].ok = false;
-
-				int v2 = edges_[edge].v2;
-				if (vertices_[v2].edges_in.size() == 1 && vertices_[v2].edges_out.size() == 1)
-					vertices_[v2].ok = false;
-			}
+			remove(pos);
+			pos   = p;
+			stall = 0;
+			continue;
 		}
 
-		// If the polygon didn't intersect, and is anticlockwise (inner), it is invalid
-		else if (separate && !polygon_outlines_[a].clockwise)
+		if ((c > 0 && (mode > 0 || is_ear(p, pos, n))) || mode > 1)
 		{
-			if (verbose_)
-				log::info("Separate, anticlockwise polygon exists, cutting (invalid)");
-			for (int edge : polygon_outlines_[a].edges)
+			if (c > 0)
 			{
-				// Set the edge to 'done' so it is ignored, but still used to build polygons
-				edges_[edge].ok = false;
-
-				// If the edge's vertices aren't attached to anything else, also preclude these from later calculations
-				int v1 = edges_[edge].v1;
-				if (vertices_[v1].edges_in.size() == 1 && vertices_[v1].edges_out.size() == 1)
-					vertices_[v1].ok = false;
-
-				int v2 = edges_[edge].v2;
-				if (vertices_[v2].edges_in.size() == 1 && vertices_[v2].edges_out.size() == 1)
-					vertices_[v2].ok = false;
+				indices_.push_back(ring[p]);
+				indices_.push_back(ring[pos]);
+				indices_.push_back(ring[n]);
 			}
-		}
-	}
 
-	// Detect concave edges/vertices
-	detectConcavity();
-
-	// Keep splitting until we have no concave edges left
-	// (we'll limit the number of rounds to 100 to avoid infinite loops, just in case)
-	for (unsigned loop = 0; loop < 100; loop++)
-	{
-		for (int concave_edge : concave_edges_)
-			splitFromEdge(concave_edge);
-
-		detectConcavity();
-		if (concave_edges_.empty())
-			break;
-	}
-
-	// Remove unnecessary splits
-	for (unsigned a = split_edges_start_; a < edges_.size(); a++)
-	{
-		if (!edges_[a].ok)
+			remove(pos);
+			pos   = n;
+			stall = 0;
+			mode  = 0;
 			continue;
+		}
 
-		// Invalidate split
-		edges_[a].ok                = false;
-		edges_[edges_[a].sister].ok = false;
-
-		// Check poly is still convex without split
-		int next = findNextEdge(a, false, true);
-		if (next >= 0)
+		pos = n;
+		if (++stall >= remaining)
 		{
-			if (testTracePolyOutline(next))
-				continue;
+			mode++;
+			stall = 0;
 		}
-
-		// Not convex, split is needed
-		edges_[a].ok                = true;
-		edges_[edges_[a].sister].ok = true;
-	}
-
-	// Reset edge 'done' status
-	for (auto& edge : edges_)
-		edge.done = false;
-
-	// Build polygons
-	for (unsigned a = 0; a < edges_.size(); a++)
-	{
-		if (edges_[a].done || !edges_[a].ok)
-			continue;
-
-		poly->addSubPoly();
-		if (!buildSubPoly(a, poly->subPoly(poly->nSubPolys() - 1)))
-			poly->removeSubPoly(poly->nSubPolys() - 1);
 	}
 
-	return true;
-}
-
-void PolygonSplitter::openSector(MapSector* sector)
-{
-	// Check sector was given
-	if (!sector)
-		return;
-
-	// Init
-	clear();
-
-	// Get list of sides connected to this sector
-	auto& sides = sector->connectedSides();
-
-	// Go through sides
-	MapLine* line;
-	for (auto& side : sides)
+	// Add final triangle
+	unsigned p = prev[pos];
+	unsigned n = next[pos];
+	if (cross(vertices_[ring[p]], vertices_[ring[pos]], vertices_[ring[n]]) > COLLINEAR_EPSILON)
 	{
-		line = side->parentLine();
-
-		// Ignore this side if its parent line has the same sector on both sides
-		if (!line || line->doubleSector())
-			continue;
-
-		// Add the edge to the splitter (direction depends on what side of the line this is)
-		if (line->s1() == side)
-			addEdge(line->v1()->xPos(), line->v1()->yPos(), line->v2()->xPos(), line->v2()->yPos());
-		else
-			addEdge(line->v2()->xPos(), line->v2()->yPos(), line->v1()->xPos(), line->v1()->yPos());
+		indices_.push_back(ring[p]);
+		indices_.push_back(ring[pos]);
+		indices_.push_back(ring[n]);
 	}
 }
 
-void PolygonSplitter::testRender()
+void Triangulator::compact()
 {
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	// Draw vertices
-	gl::setColour(255, 255, 255, 255, gl::Blend::Normal);
-	glBegin(GL_POINTS);
-	for (auto& vertex : vertices_)
-		glVertex2d(vertex.x, vertex.y);
-	glEnd();
-
-	// Draw original edges
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glBegin(GL_LINES);
-	for (int a = 0; a < split_edges_start_; a++)
+	// Remove vertices not referenced by any triangle and remap indices
+	vector<int>   remap(vertices_.size(), -1);
+	vector<Vec2d> used;
+	for (auto& index : indices_)
 	{
-		glVertex2d(vertices_[edges_[a].v1].x, vertices_[edges_[a].v1].y);
-		glVertex2d(vertices_[edges_[a].v2].x, vertices_[edges_[a].v2].y);
+		if (remap[index] < 0)
+		{
+			remap[index] = used.size();
+			used.push_back(vertices_[index]);
+		}
+		index = remap[index];
 	}
-	glEnd();
 
-	// Draw split edges
-	glColor3f(0.0f, 1.0f, 0.0f);
-	glBegin(GL_LINES);
-	for (unsigned a = split_edges_start_; a < edges_.size(); a++)
-	{
-		glVertex2d(vertices_[edges_[a].v1].x, vertices_[edges_[a].v1].y);
-		glVertex2d(vertices_[edges_[a].v2].x, vertices_[edges_[a].v2].y);
-	}
-	glEnd();
+	vertices_.swap(used);
+	vertex_map_.clear();
+	edges_out_.clear();
+	edges_.clear();
+	edge_set_.clear();
 }
@@ -14,13 +14,6 @@ public:
 		Vertex(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x{ x }, y{ y }, z{ z } {}
 	};
 
-	struct SubPoly
-	{
-		vector<Vertex> vertices;
-		unsigned       vbo_offset = 0;
-		unsigned       vbo_index  = 0;
-	};
-
 	Polygon2D() = default;
 	~Polygon2D() { clear(); }
 
@@ -32,17 +25,17 @@ public:
 
 	void setTexture(unsigned tex) { texture_ = tex; }
 	void setColour(float r, float g, float b, float a);
-	bool hasPolygon() const { return !subpolys_.empty(); }
+	bool hasPolygon() const { return !indices_.empty(); }
 	int  vboUpdate() const { return vbo_update_; }
 	void setZ(float z);
 	void setZ(Plane plane);
 
-	unsigned nSubPolys() const { return subpolys_.size(); }
-	void     addSubPoly();
-	SubPoly* subPoly(unsigned index);
-	void     removeSubPoly(unsigned index);
-	void     clear();
-	unsigned totalVertices();
+	const vector<Vertex>&   vertices() const { return vertices_; }
+	const vector<unsigned>& indices() const { return indices_; }
+	unsigned                nTriangles() const { return indices_.size() / 3; }
+	unsigned                totalVertices() const { return vertices_.size(); }
+	unsigned                geometryVersion() const { return geometry_version_; }
+	void                    clear();
 
 	bool openSector(MapSector* sector);
 	void updateTextureCoords(
@@ -52,8 +45,8 @@ public:
 		double offset_y = 0,
 		double rotation = 0);
 
-	unsigned vboDataSize();
-	unsigned writeToVBO(unsigned offset, unsigned index);
+	unsigned vboDataSize() const { return vertices_.size() * sizeof(Vertex); }
+	unsigned writeToBuffer(vector<Vertex>& buffer);
 	void     updateVBOData();
 
 	void render();
@@ -65,82 +58,62 @@ public:
 
 private:
 	// Polygon data
-	vector<SubPoly> subpolys_;
-	unsigned        texture_   = 0;
-	float           colour_[4] = { 1.f, 1.f, 1.f, 1.f };
-
-	int vbo_update_ = 2;
+	vector<Vertex>   vertices_;
+	vector<unsigned> indices_; // Triangle list
+	unsigned         texture_          = 0;
+	float            colour_[4]        = { 1.f, 1.f, 1.f, 1.f };
+	unsigned         geometry_version_ = 0;
+
+	// VBO
+	vector<unsigned> vbo_indices_; // Triangle list, offset to the polygon's location in the VBO
+	unsigned         vbo_offset_ = 0;
+	int              vbo_update_ = 2;
 };
 
 
-class PolygonSplitter
+class Triangulator
 {
-	friend class Polygon2D;
-
 public:
-	PolygonSplitter()  = default;
-	~PolygonSplitter() = default;
+	Triangulator()  = default;
+	~Triangulator() = default;
+
+	const vector<Vec2d>&    vertices() const { return vertices_; }
+	const vector<unsigned>& indices() const { return indices_; }
 
 	void clear();
 	void setVerbose(bool v) { verbose_ = v; }
 
-	int addVertex(double x, double y);
-	int addEdge(double x1, double y1, double x2, double y2);
-	int addEdge(int v1, int v2);
-
-	int  findNextEdge(int edge, bool ignore_done = true, bool only_convex = true, bool ignore_inpoly = false);
-	void flipEdge(int edge);
-
-	void detectConcavity();
-	bool detectUnclosed();
+	int  addVertex(double x, double y);
+	void addEdge(double x1, double y1, double x2, double y2);
+	void addSectorEdges(MapSector* sector);
 
-	bool tracePolyOutline(int edge_start);
-	bool testTracePolyOutline(int edge_start);
-
-	bool splitFromEdge(int splitter_edge);
-	bool buildSubPoly(int edge_start, Polygon2D::SubPoly* poly);
-	bool doSplitting(Polygon2D* poly);
-
-	// Testing
-	void openSector(MapSector* sector);
-	void testRender();
+	bool triangulate();
 
 private:
-	// Structs
 	struct Edge
 	{
-		int  v1, v2;
-		bool ok;
+		int  v1;
+		int  v2;
 		bool done;
-		bool inpoly;
-		int  sister;
-	};
-	struct Vertex
-	{
-		double      x, y;
-		vector<int> edges_in;
-		vector<int> edges_out;
-		bool        ok       = true;
-		double      distance = 0;
-		Vertex(double x = 0, double y = 0) : x{ x }, y{ y } {}
-
-		operator Vec2d() const { return { x, y }; }
-	};
-	struct Outline
-	{
-		vector<int> edges;
-		BBox        bbox;
-		bool        clockwise;
-		bool        convex;
 	};
 
-	// Splitter data
-	vector<Vertex>  vertices_;
-	vector<Edge>    edges_;
-	vector<int>     concave_edges_;
-	vector<Outline> polygon_outlines_;
-	int             split_edges_start_ = 0;
-	bool            verbose_           = false;
-	double          last_angle_        = 0.;
+	using Loop = vector<int>;
+
+	vector<Vec2d>                            vertices_;
+	vector<vector<int>>                      edges_out_;
+	vector<Edge>                             edges_;
+	std::map<std::pair<double, double>, int> vertex_map_;
+	std::set<std::pair<int, int>>            edge_set_;
+	vector<unsigned>                         indices_;
+	bool                                     verbose_ = false;
+
+	int    nextEdge(int edge) const;
+	void   traceLoops(vector<Loop>& loops);
+	double signedArea(const Loop& loop) const;
+	bool   pointInLoop(const Vec2d& point, const Loop& loop) const;
+	bool   loopContains(const Loop& outer, const Loop& inner) const;
+	void   bridgeHole(Loop& outer, const Loop& hole) const;
+	void   earClip(const Loop& ring);
+	void   compact();
 };
 } // namespace slade